@@ -0,0 +1,11 @@
+// VSInput and its getters for the vertex layout of the pipeline. The mesh pipelines exist once per EVertexLayout (see
+// Engine::getMeshPipelineName) and get USE_OCTAHEDRAL_VERTEX, the other ones default to the half layout of common.hlsl.
+#ifndef USE_OCTAHEDRAL_VERTEX
+#define USE_OCTAHEDRAL_VERTEX 0
+#endif
+
+#if USE_PACKED_VERTEX && USE_OCTAHEDRAL_VERTEX
+#include "common/vertexOctahedral.hlsl"
+#else
+#include "common/common.hlsl"
+#endif
@@ -0,0 +1,51 @@
+// VertexOctahedral of Mesh.h, same getters as the packed vertex of common.hlsl. Included by common/vertex.hlsl.
+// The positions are 16 bits unorm in the AABB of the group: getPosition returns them in [0, 65535],
+// Mesh::getDequantization is folded in the matrix of each draw to bring them back to the local space.
+
+struct VSInput
+{
+    uint2 Position : ATTRIB0; // x = x | y << 16, y = z | tangent << 16
+    uint2 NormalUV : ATTRIB1; // x = normal | bitangent sign << 30, y = uv in half
+};
+
+// Same as decodeOctahedral in VertexQuantization.cpp
+float3 octDecode(float2 _encoded)
+{
+    float3 direction = float3(_encoded, 1.0f - abs(_encoded.x) - abs(_encoded.y));
+    const float fold = saturate(-direction.z);
+    direction.xy += select(direction.xy >= 0.0f, -fold, fold);
+    return normalize(direction);
+}
+
+float3 unpackOctahedral(uint _packed, uint _bits)
+{
+    const uint mask = (1u << _bits) - 1u;
+    const float2 encoded = float2(_packed & mask, (_packed >> _bits) & mask) / float(mask);
+    return octDecode(encoded * 2.0f - 1.0f);
+}
+
+float4 getPosition(VSInput _input)
+{
+    return float4(_input.Position.x & 0xffff, _input.Position.x >> 16, _input.Position.y & 0xffff, 1.0f);
+}
+
+float2 getUV(VSInput _input)
+{
+    return float2(f16tof32(_input.NormalUV.y >> 16), f16tof32(_input.NormalUV.y));
+}
+
+float3 getNormal(VSInput _input)
+{
+    return unpackOctahedral(_input.NormalUV.x & 0x3fffffff, 15);
+}
+
+float3 getTangent(VSInput _input)
+{
+    return unpackOctahedral(_input.Position.y >> 16, 8);
+}
+
+// cross(tangent, normal) is the bitangent, flipped for mirrored uvs
+float getBitangentSign(VSInput _input)
+{
+    return (_input.NormalUV.x >> 30) & 1u ? -1.0f : 1.0f;
+}
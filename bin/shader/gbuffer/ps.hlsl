@@ -38,13 +38,15 @@ void main(in  PSInput  PSIn,
     PSOut.Color = pow(g_TextureAlbedo.Sample(g_TextureAlbedo_sampler, PSIn.UV), 2.2);
     float3 normal;
 #if defined(USE_NORMAL_MAP)
-    normal = g_TextureNormal.Sample(g_TextureAlbedo_sampler, PSIn.UV).xyz;
+    // cooked normal maps are BC5, only xy are stored
+    normal.xy = g_TextureNormal.Sample(g_TextureAlbedo_sampler, PSIn.UV).xy * 2.0 - 1.0;
+    normal.z = sqrt(saturate(1.0 - dot(normal.xy, normal.xy)));
     #else
     // todo mul by model
         normal = float4(mul(g_model, PSIn.Normal), 0.0);
+        normal = (normal * 2.0 - 1.0);
     #endif
     // get the tbn and transform the normal 
-    normal = (normal * 2.0 - 1.0);
     normal = normalize(mul( normal, PSIn.TBN ));
    //normal = float3(0, 1, 0);
 
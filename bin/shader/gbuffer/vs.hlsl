@@ -1,4 +1,4 @@
-#include "common/common.hlsl"
+#include "common/vertex.hlsl"
 
 cbuffer Constants
 {
@@ -29,6 +29,9 @@ void main(in  VSInput VSIn,
     T = normalize(T - dot(T, N) * N);
 
     float3 B = cross(T, N);
+#if USE_PACKED_VERTEX && USE_OCTAHEDRAL_VERTEX
+    B *= getBitangentSign(VSIn);
+#endif
 
     PSIn.TBN = float3x3(T, B, N);
 }
\ No newline at end of file
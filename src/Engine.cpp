@@ -20,7 +20,9 @@
 #include "EngineFactoryD3D12.h"
 #include "Graphics/GraphicsTools/interface/MapHelper.hpp"
 #include <array>
+#include <limits>
 #include <memory>
+#include <EASTL/sort.h>
 #include <EASTL/unique_ptr.h>
 #include <stb_image.h>
 #include <glm/ext/matrix_transform.hpp>
@@ -33,10 +35,16 @@
 #include "im3d/im3d_math.h"
 #include "assimp/DefaultLogger.hpp"
 #include "FrameGraph.hpp"
+#include "ImportTelemetry.hpp"
+#include "JobSystem.hpp"
+#include "SceneArchive.hpp"
+#include "StreamingManager.hpp"
+#include "TextureCache.hpp"
 #include "tracy/Tracy.hpp"
 #include "GPUMarkerScoped.hpp"
 #include "Mesh.h"
 #include "debug/DebugShape.hpp"
+#include "util/ProcessMemory.hpp"
 #include "util/UIProgressingBars.hpp"
 #include "FirstPersonCamera.hpp"
 #include "../external/QuikMafs/Matrix4x4.hpp"
@@ -178,56 +186,64 @@ void Engine::createResources()
     Assimp::DefaultLogger::create();
     Assimp::DefaultLogger::get()->setLogSeverity(severity);
 
-    for (int i = 0; i < 1; ++i)
-    {
-        m_executor.silent_async([&]()
-                                {
-                                    Mesh *m = new Mesh(m_device, "mesh/Bunny/stanford-bunny.obj");
-                                    m->setTransparent(true);
-                                    m->addTexture("redTransparent16x16.png", 0);
-                                    AddMesh(m);
-                                });
-        m_executor.silent_async([&]()
-                                {
-                                    auto *m = new Mesh(m_device, "mesh/Bunny/stanford-bunny.obj");
-                                    m->setTransparent(true);
-                                    m->addTexture("blueTransparent16x16.png", 0);
-
-                                    AddMesh(m);
-                                });
+    m_sceneLoadStart = std::chrono::steady_clock::now();
 
-        m_executor.silent_async([&]()
-                                {
-                                    auto *m = new Mesh(m_device, "mesh/Bunny/stanford-bunny.obj");
-                                    m->setTransparent(true);
-                                    m->addTexture("greenTransparent16x16.png", 0);
-
-                                    AddMesh(m);
-                                });
-
-        m_executor.silent_async([&]()
-                                {
-                                    auto *m = new Mesh(m_device, "mesh/cerberus/Cerberus_LP.fbx", true, float3(0, 0, 0),
-                                                       1.0f);
+    // written by AssetCooker <mesh directory> --pak, without it every mesh opens its own .mesh
+    m_isScenePacked = SceneArchive::mount("mesh/scene.pak");
+    m_streaming = new StreamingManager(m_device);
 
-                                    m->addTexture("textures/Cerberus_N.tga", 0);
-                                    m->setIsLoaded(true);
+    // the meshes are uploaded on the render thread as they arrive, SortMeshes adds them to the scene
+    const char* transparentTextures[] = {"redTransparent16x16.png", "blueTransparent16x16.png", "greenTransparent16x16.png"};
+    for (const char* texture : transparentTextures)
+    {
+        StreamingManager::Request request;
+        request.m_path = "mesh/Bunny/stanford-bunny.obj";
+        request.m_onLoaded = [texture](Mesh& _mesh)
+        {
+            _mesh.setTransparent(true);
+            _mesh.addTexture(texture, 0);
+        };
+        request.m_onReady = [this](Mesh* _mesh) { AddMesh(_mesh); };
+        m_streaming->request(eastl::move(request));
+    }
 
-                                    AddMesh(m);
-                                    m_clickedMesh = m;
-                                });
+    {
+        StreamingManager::Request request;
+        request.m_path = "mesh/cerberus/Cerberus_LP.fbx";
+        request.m_needsAfterLoadedActions = true;
+        request.m_onLoaded = [](Mesh& _mesh)
+        {
+            _mesh.addTexture("textures/Cerberus_N.tga", 0);
+            _mesh.setIsLoaded(true);
+        };
+        request.m_onReady = [this](Mesh* _mesh)
+        {
+            AddMesh(_mesh);
+            m_clickedMesh = _mesh;
+        };
+        m_streaming->request(eastl::move(request));
     }
 
-    m_executor.silent_async([&](){
-         auto* m = new Mesh(m_device, "mesh/Sponza/Sponza.gltf");
-         AddMesh(m);
-         m_raytracing->addMeshToRayTrace(m);
-       });
+    // The biggest one goes first, it's the one we wait the most for
+    {
+        StreamingManager::Request request;
+        request.m_path = "mesh/Sponza/Sponza.gltf";
+        request.m_isCritical = true;
+        request.m_isRayTraced = true;
+        request.m_onReady = [this](Mesh* _mesh)
+        {
+            AddMesh(_mesh);
+            m_raytracing->addMeshToRayTrace(_mesh);
+        };
+        m_streaming->request(eastl::move(request));
+    }
 
-   m_executor.silent_async([&](){
-        auto* m = new Mesh(m_device, "mesh/Floor/floor.obj");
-        AddMesh(m);
-    });
+    {
+        StreamingManager::Request request;
+        request.m_path = "mesh/Floor/floor.obj";
+        request.m_onReady = [this](Mesh* _mesh) { AddMesh(_mesh); };
+        m_streaming->request(eastl::move(request));
+    }
 
     struct Data
     {
@@ -262,8 +278,24 @@ void Engine::createResources()
 
 void Engine::render()
 {
+    {
+        // with the camera of the last frame, good enough to prioritize
+        ViewFrustum viewFrustum;
+        ExtractViewFrustumPlanesFromMatrix(m_camera.GetViewMatrix() * m_camera.GetProjMatrix(), viewFrustum, false);
+        m_streaming->update(m_camera.GetPos(), viewFrustum);
+    }
+
     SortMeshes();
 
+    m_drawCallCountLastFrame = m_drawCallCount;
+    m_groupBindCountLastFrame = m_groupBindCount;
+    m_drawCallCount = 0;
+    m_groupBindCount = 0;
+    m_boundsTransformCountLastFrame = m_boundsTransformCount;
+    m_boundsReadCountLastFrame = m_boundsReadCount;
+    m_boundsTransformCount = 0;
+    m_boundsReadCount = 0;
+
     const auto now = std::chrono::high_resolution_clock::now();
     m_deltaTime =
             std::chrono::duration_cast<std::chrono::milliseconds>(now - m_tickLastFrame).count() * 0.01; //0.16 format
@@ -301,23 +333,29 @@ void Engine::render()
 
             float3 rayWorldDir = m_camera.GetViewMatrix().Inverse() * rayEye;
 
-            float enterDist = 0;
-            float exitDist = 0;
-
-            const float4x4& mvp = m_camera.GetWorldMatrix();
-
+            // the BVH of the scene store has to see the meshes where they are now
             for (auto& mesh: m_meshes)
             {
-                if (mesh && mesh->isClicked(mvp, m_camera.GetPos(), rayWorldDir, enterDist, exitDist))
+                if (mesh)
                 {
-                    m_clickedMesh = mesh;
-                    std::cout << m_clickedMesh->getName() << "found ! " << std::endl;
-                    break;
+                    m_boundsTransformCount += updateWorldBounds(mesh);
                 }
             }
+
+            // the closest group along the ray, not the first mesh that has one on it
+            uint32_t instance = 0;
+            float hitDistance = 0.0f;
+            if (m_sceneStore.raycast(m_camera.GetPos(), rayWorldDir, instance, hitDistance))
+            {
+                m_clickedMesh = m_sceneStore.getOwner(instance);
+                std::cout << m_clickedMesh->getName() << "found ! " << std::endl;
+            }
         }
     }
 
+    // before the culling so it uses the camera the passes will render with
+    m_camera.Update(m_inputController, m_deltaTime);
+
     {
         ZoneScopedN("Sort&Cull");
         std::scoped_lock mut(m_mutexAddMesh);
@@ -327,8 +365,6 @@ void Engine::render()
 
     ZoneScopedN("Render");
 
-    m_camera.Update(m_inputController, m_deltaTime);
-
     startCollectingStats();
 
     {
@@ -375,8 +411,9 @@ void Engine::render()
         {
             DebugShape::ShapeParams params;
             params.m_position = mesh->getTranslation();
-            const auto aabb = mesh->getBoundingBox();
+            const auto& aabb = mesh->getBoundingBox();
             params.m_size = aabb.Max * mesh->getScale();
+            m_boundsReadCount += static_cast<uint32_t>(mesh->getGroups().size());
 
             m_debugShape->addCubeAt(params);
         }
@@ -602,6 +639,62 @@ void Engine::showStats()
         {
             ImGui::TextDisabled("Queries are not supported by this device");
         }
+
+        size_t meshCpuBytes = 0;
+        for (Mesh* mesh : m_meshes)
+        {
+            meshCpuBytes += mesh->getCpuBytes();
+        }
+        ImGui::Text("Meshes CPU data: %.1fMB", ProcessMemory::toMB(meshCpuBytes));
+
+        size_t groupCount = 0;
+        size_t groupCount32 = 0;
+        size_t groupCountOctahedral = 0;
+        for (Mesh* mesh : m_meshes)
+        {
+            for (const Mesh::Group& group : mesh->getGroups())
+            {
+                groupCount++;
+                groupCount32 += group.m_indexType == VT_UINT32;
+                groupCountOctahedral += group.m_vertexLayout == EVertexLayout::Octahedral;
+            }
+        }
+        ImGui::Text("Groups: %zu (%zu with 32 bits indices)", groupCount, groupCount32);
+        ImGui::Text("Mesh draw calls: %u, group binds: %u", m_drawCallCountLastFrame, m_groupBindCountLastFrame);
+        ImGui::Text("Vertex layout: %zu groups half (%zu bytes), %zu octahedral (%zu bytes)", groupCount - groupCountOctahedral,
+                    Mesh::getVertexSize(EVertexLayout::Half), groupCountOctahedral, Mesh::getVertexSize(EVertexLayout::Octahedral));
+
+        ImGui::Checkbox("Meshlet culling", &m_isMeshletCullingEnabled);
+        ImGui::Text("Meshlets: %u culled / %u", m_meshletCulledCount, m_meshletCount);
+
+        ImGui::Checkbox("Occlusion culling", &m_isOcclusionCullingEnabled);
+        ImGui::Text("Occlusion: %zu occluders, %u triangles, %u draws culled in %.3fms (%s)", m_occluders.size(), m_occlusionCulling.getTriangleCount(),
+                    m_occludedCount, m_occlusionTimeMs, FrustumCulling::getName(FrustumCulling::getBestKernel()));
+        if (ImGui::Button("Dump occlusion depth"))
+        {
+            m_occlusionCulling.dumpDepth("occlusion_depth.pgm");
+        }
+
+        ImGui::Checkbox("LODs", &m_isLodEnabled);
+        ImGui::DragFloat("LOD max pixel error", &m_lodPixelError, 0.1f, 0.1f, 32.0f);
+        ImGui::DragFloat("Shadow LOD error scale", &m_shadowLodErrorScale, 0.1f, 1.0f, 32.0f);
+        ImGui::Text("Triangles saved by LODs: %u camera, %u cascades", m_lodTrianglesSaved, m_lodShadowTrianglesSaved);
+
+        ImGui::Text("World bounds: %u transformed, %u avoided", m_boundsTransformCountLastFrame,
+                    m_boundsReadCountLastFrame - eastl::min(m_boundsReadCountLastFrame, m_boundsTransformCountLastFrame));
+        ImGui::Text("Scene store: %u instances, %u BVH nodes, %zu views culled in %.3fms (%s)", m_sceneStore.getCount(),
+                    m_sceneStore.getHierarchy().getNodeCount(), m_cullViews.size(), m_sceneCullTimeMs,
+                    FrustumCulling::getName(FrustumCulling::getBestKernel()));
+        for (uint32_t i = 0; i < m_cullViews.size(); ++i)
+        {
+            const char *names[] = {"Camera opaque", "Camera transparent"};
+            const CullView &view = m_cullViews[i];
+            const char *method = view.m_method == SceneStore::ECullMethod::Hierarchy ? "BVH" : "linear";
+            if (i < CULL_VIEW_CASCADE_0)
+                ImGui::Text("    %s: %zu visible, %.3fms %s", names[i], view.m_drawList.size(), view.m_timeMs, method);
+            else
+                ImGui::Text("    Cascade %u: %zu visible, %.3fms %s", i - CULL_VIEW_CASCADE_0, view.m_drawList.size(), view.m_timeMs, method);
+        }
     }
     ImGui::End();
 }
@@ -733,6 +826,9 @@ Engine::~Engine()
 {
     m_immediateContext->Flush();
 
+    // waits for the meshes still loading
+    delete m_streaming;
+    SceneArchive::unmount();
     delete m_gbuffer;
     delete m_renderdoc;
     delete m_raytracing;
@@ -859,20 +955,21 @@ void Engine::createTransparencyPipeline()
         //desc.BlendDesc.RenderTargets[1].DestBlendAlpha = Diligent::BLEND_FACTOR_INV_SRC1_ALPHA;
         //desc.BlendDesc.RenderTargets[1].SrcBlendAlpha = Diligent::BLEND_FACTOR_ZERO;
 
-        eastl::vector<LayoutElement> layoutElementsVertexPacked = layoutElementsPacked;
-
         eastl::vector<PipelineState::VarStruct> staticVars = {{SHADER_TYPE_VERTEX, "Constants", m_bufferMatrixMesh}};
 
         eastl::vector<PipelineState::VarStruct> dynamicVars =
                 {{SHADER_TYPE_PIXEL, "g_TextureAlbedo",
                   m_defaultTextures["redTransparent"]->GetDefaultView(Diligent::TEXTURE_VIEW_SHADER_RESOURCE)}};
 
-        m_pipelines[PSO_TRANSPARENCY] = eastl::make_unique<PipelineState>(m_device, "Transparency PSO",
-                                                                          PIPELINE_TYPE_GRAPHICS, "transparency",
-                                                                          eastl::vector<eastl::pair<eastl::string, eastl::string>>(),
-                                                                          staticVars,
-                                                                          dynamicVars, desc,
-                                                                          layoutElementsVertexPacked);
+        for (EVertexLayout layout : getMeshLayouts())
+        {
+            m_pipelines[getMeshPipelineName(PSO_TRANSPARENCY, layout)] = eastl::make_unique<PipelineState>(m_device,
+                                                                              layout == EVertexLayout::Octahedral ? "Transparency PSO - Octahedral" : "Transparency PSO",
+                                                                              PIPELINE_TYPE_GRAPHICS, "transparency", getMeshMacros(layout),
+                                                                              staticVars,
+                                                                              dynamicVars, desc,
+                                                                              getMeshLayoutElements(layout));
+        }
     }
 
     GraphicsPipelineDesc desc;
@@ -925,67 +1022,75 @@ void Engine::renderTransparency()
         m_immediateContext->ClearRenderTarget(pRTV[1], clearValue[0].Data(), RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
         m_immediateContext->ClearRenderTarget(pRTV[0], clearValue[1].Data(), RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
 
-        m_immediateContext->SetPipelineState(m_pipelines[PSO_TRANSPARENCY]->getPipeline());
-
-        auto &psoTransparency = m_pipelines[PSO_TRANSPARENCY];
+        const MeshPipelines psosTransparency = getMeshPipelines(PSO_TRANSPARENCY);
+        PipelineState* psoTransparency = nullptr;
 
         GPUScopedMarker("Draw");
 
-        ViewFrustum viewFrustum;
-        ExtractViewFrustumPlanesFromMatrix(m_camera.GetViewMatrix() * m_camera.GetProjMatrix(), viewFrustum, false);
-
         std::scoped_lock mut(m_mutexAddMesh);
-        for (auto& mesh: m_meshes)
+        const Mesh* mappedMesh = nullptr;
+        for (const SceneStore::DrawItem &item: m_cullViews[CULL_VIEW_CAMERA_TRANSPARENT].m_drawList)
         {
-            if (mesh->isTransparent())
+            Mesh *mesh = m_sceneStore.getOwner(item.m_instance);
+            Mesh::Group &grp = mesh->getGroups()[m_sceneStore.getGroup(item.m_instance)];
+            const auto &model = m_sceneStore.getWorldMatrix(item.m_instance);
+
+            // each group was cooked with its own vertex layout, the pipeline only changes with it
+            PipelineState* pso = psosTransparency[static_cast<size_t>(grp.m_vertexLayout)];
+            if (pso != psoTransparency)
             {
-                auto &groups = mesh->getGroups();
-                const auto &model = mesh->getModel();
-                {
-                    // Map the buffer and write current world-view-projection matrix
-                    MapHelper<float4x4> CBConstants(m_immediateContext, m_bufferMatrixMesh, MAP_WRITE,
-                                                    MAP_FLAG_DISCARD);
-                    *CBConstants = (model * m_camera.GetViewMatrix() * m_camera.GetProjMatrix()).Transpose();
-                }
+                psoTransparency = pso;
+                m_immediateContext->SetPipelineState(psoTransparency->getPipeline());
+            }
 
-                for (Mesh::Group &grp: groups)
-                {
-                    if (GetBoxVisibility(viewFrustum, grp.m_aabb.Transform(model)) == Diligent::BoxVisibility::Invisible)
-                    {
-                        continue;
-                    }
+            if (grp.m_vertexLayout == EVertexLayout::Octahedral)
+            {
+                // the positions are quantized in the AABB of the group
+                MapHelper<float4x4> CBConstants(m_immediateContext, m_bufferMatrixMesh, MAP_WRITE,
+                                                MAP_FLAG_DISCARD);
+                *CBConstants = (Mesh::getDequantization(grp) * model * m_camera.GetViewMatrix() * m_camera.GetProjMatrix()).Transpose();
+                mappedMesh = nullptr;
+            }
+            else if (mesh != mappedMesh)
+            {
+                // Map the buffer and write current world-view-projection matrix
+                MapHelper<float4x4> CBConstants(m_immediateContext, m_bufferMatrixMesh, MAP_WRITE,
+                                                MAP_FLAG_DISCARD);
+                *CBConstants = (model * m_camera.GetViewMatrix() * m_camera.GetProjMatrix()).Transpose();
+                mappedMesh = mesh;
+            }
 
-                    if (grp.m_textures.empty())
-                    {
-                        psoTransparency->getSRB().GetVariableByName(SHADER_TYPE_PIXEL, "g_TextureAlbedo")->
-                                Set(m_defaultTextures["redTransparent"]->GetDefaultView(
-                                Diligent::TEXTURE_VIEW_SHADER_RESOURCE));
-                    }
-                    else
-                    {
-                        psoTransparency->getSRB().GetVariableByName(SHADER_TYPE_PIXEL, "g_TextureAlbedo")->
-                                Set(grp.m_textures[0]->GetDefaultView(TEXTURE_VIEW_SHADER_RESOURCE));
-                    }
-
-                    Uint64 offset = 0;
-                    IBuffer *pBuffs[] = {grp.m_meshVertexBuffer};
-                    m_immediateContext->SetVertexBuffers(0, 1, pBuffs, &offset,
-                                                         RESOURCE_STATE_TRANSITION_MODE_TRANSITION,
-                                                         SET_VERTEX_BUFFERS_FLAG_RESET);
-                    m_immediateContext->SetIndexBuffer(grp.m_meshIndexBuffer, 0,
-                                                       RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
-                    m_immediateContext->CommitShaderResources(&psoTransparency->getSRB(),
-                                                              RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
-
-                    DrawIndexedAttribs DrawAttrs; // This is an indexed draw call
-                    DrawAttrs.IndexType = VT_UINT16; // Index type
-                    DrawAttrs.NumIndices = grp.m_indices.size();
-                    // Verify the state of vertex and index buffers as well as consistence of
-                    // render targets and correctness of draw command arguments
-                    DrawAttrs.Flags = DRAW_FLAG_VERIFY_ALL;
-                    m_immediateContext->DrawIndexed(DrawAttrs);
-                }
+            if (grp.m_textures.empty())
+            {
+                psoTransparency->getSRB().GetVariableByName(SHADER_TYPE_PIXEL, "g_TextureAlbedo")->
+                        Set(m_defaultTextures["redTransparent"]->GetDefaultView(
+                        Diligent::TEXTURE_VIEW_SHADER_RESOURCE));
             }
+            else
+            {
+                psoTransparency->getSRB().GetVariableByName(SHADER_TYPE_PIXEL, "g_TextureAlbedo")->
+                        Set(grp.m_textures[0]->GetDefaultView(TEXTURE_VIEW_SHADER_RESOURCE));
+            }
+
+            Uint64 offset = 0;
+            IBuffer *pBuffs[] = {grp.m_meshVertexBuffer};
+            m_immediateContext->SetVertexBuffers(0, 1, pBuffs, &offset,
+                                                 RESOURCE_STATE_TRANSITION_MODE_TRANSITION,
+                                                 SET_VERTEX_BUFFERS_FLAG_RESET);
+            m_immediateContext->SetIndexBuffer(grp.m_meshIndexBuffer, 0,
+                                               RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+            m_groupBindCount++;
+            m_immediateContext->CommitShaderResources(&psoTransparency->getSRB(),
+                                                      RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+
+            DrawIndexedAttribs DrawAttrs; // This is an indexed draw call
+            DrawAttrs.IndexType = grp.m_indexType; // 16 or 32 bits, depends on the vertex count of the group
+            DrawAttrs.NumIndices = grp.m_indexCount;
+            // Verify the state of vertex and index buffers as well as consistence of
+            // render targets and correctness of draw command arguments
+            DrawAttrs.Flags = DRAW_FLAG_VERIFY_ALL;
+            m_immediateContext->DrawIndexed(DrawAttrs);
+            m_drawCallCount++;
         }
     }
 
@@ -1244,29 +1349,69 @@ void Engine::createZprepassPipeline()
     desc.RasterizerDesc.CullMode = Diligent::CULL_MODE_BACK;
 
     //m_registeredTexturesForDebug.emplace_back(m_swapChain->GetDepthBufferDSV()->GetTexture());
-    eastl::vector<LayoutElement> layoutElements;
-    if (m_isVertexPacked)
+    eastl::vector<PipelineState::VarStruct> vars = {{SHADER_TYPE_VERTEX, "Constants", m_bufferMatrixMesh}};
+
+    for (EVertexLayout layout : getMeshLayouts())
     {
-        layoutElements = layoutElementsPacked;
+        m_pipelines[getMeshPipelineName(PSO_ZPREPASS, layout)] = eastl::make_unique<PipelineState>(m_device,
+                                                                      layout == EVertexLayout::Octahedral ? "Z Prepass - Octahedral" : "Z Prepass",
+                                                                      PIPELINE_TYPE_GRAPHICS, "zprepass", getMeshMacros(layout),
+                                                                      vars,
+                                                                      eastl::vector<PipelineState::VarStruct>(), desc,
+                                                                      getMeshLayoutElements(layout));
     }
-    else
+
+}
+
+eastl::string Engine::getMeshPipelineName(const char* _pso, EVertexLayout _layout)
+{
+    eastl::string name(_pso);
+    if (_layout == EVertexLayout::Octahedral)
     {
-        layoutElements = {
+        name += "_octahedral";
+    }
+    return name;
+}
+
+eastl::vector<EVertexLayout> Engine::getMeshLayouts()
+{
+    eastl::vector<EVertexLayout> layouts;
+    for (size_t i = 0; i < static_cast<size_t>(EVertexLayout::Count); ++i)
+    {
+        if (Mesh::isVertexLayoutDrawable(static_cast<EVertexLayout>(i)))
+        {
+            layouts.push_back(static_cast<EVertexLayout>(i));
+        }
+    }
+    return layouts;
+}
+
+Engine::MeshPipelines Engine::getMeshPipelines(const char* _pso)
+{
+    MeshPipelines pipelines{};
+    for (EVertexLayout layout : getMeshLayouts())
+    {
+        pipelines[static_cast<size_t>(layout)] = m_pipelines[getMeshPipelineName(_pso, layout)].get();
+    }
+    return pipelines;
+}
+
+eastl::vector<LayoutElement> Engine::getMeshLayoutElements(EVertexLayout _layout) const
+{
+    if (!m_isVertexPacked)
+    {
+        return {
                 LayoutElement(0, 0, 3, VT_FLOAT32, False),
                 LayoutElement(1, 0, 3, VT_FLOAT32, True),
                 LayoutElement(2, 0, 2, VT_FLOAT32, False)
         };
     }
+    return _layout == EVertexLayout::Octahedral ? layoutElementsOctahedral : layoutElementsHalf;
+}
 
-    eastl::vector<PipelineState::VarStruct> vars = {{SHADER_TYPE_VERTEX, "Constants", m_bufferMatrixMesh}};
-
-    m_pipelines[PSO_ZPREPASS] = eastl::make_unique<PipelineState>(m_device, "Z Prepass", PIPELINE_TYPE_GRAPHICS,
-                                                                  "zprepass",
-                                                                  eastl::vector<eastl::pair<eastl::string, eastl::string>>(),
-                                                                  vars,
-                                                                  eastl::vector<PipelineState::VarStruct>(), desc,
-                                                                  layoutElements);
-
+eastl::vector<eastl::pair<eastl::string, eastl::string>> Engine::getMeshMacros(EVertexLayout _layout)
+{
+    return {{"USE_OCTAHEDRAL_VERTEX", _layout == EVertexLayout::Octahedral ? "1" : "0"}};
 }
 
 void Engine::Im3dNewFrame()
@@ -1354,34 +1499,23 @@ void Engine::createGBufferPipeline()
     desc.DepthStencilDesc.DepthWriteEnable = False;
     desc.DepthStencilDesc.DepthFunc = Diligent::COMPARISON_FUNC_EQUAL;
 
-    eastl::vector<LayoutElement> layoutElements;
-    if (m_isVertexPacked)
-    {
-        layoutElements = layoutElementsPacked;
-    }
-    else
-    {
-        layoutElements = {
-                LayoutElement(0, 0, 3, VT_FLOAT32, False),
-                LayoutElement(1, 0, 3, VT_FLOAT32, True),
-                LayoutElement(2, 0, 2, VT_FLOAT32, False)
-        };
-    }
-
     eastl::vector<PipelineState::VarStruct> vars = {{SHADER_TYPE_VERTEX, "Constants", m_bufferMatrixMesh}};
 
-    m_pipelines[PSO_GBUFFER] = eastl::make_unique<PipelineState>(m_device, "Simple Mesh PSO", PIPELINE_TYPE_GRAPHICS,
-                                                                 "gbuffer",
-                                                                 eastl::vector<eastl::pair<eastl::string, eastl::string>>(),
-                                                                 vars, eastl::vector<PipelineState::VarStruct>(), desc,
-                                                                 layoutElements);
+    for (EVertexLayout layout : getMeshLayouts())
+    {
+        m_pipelines[getMeshPipelineName(PSO_GBUFFER, layout)] = eastl::make_unique<PipelineState>(m_device,
+                                                                     layout == EVertexLayout::Octahedral ? "Simple Mesh PSO - Octahedral" : "Simple Mesh PSO",
+                                                                     PIPELINE_TYPE_GRAPHICS, "gbuffer", getMeshMacros(layout),
+                                                                     vars, eastl::vector<PipelineState::VarStruct>(), desc,
+                                                                     getMeshLayoutElements(layout));
+    }
 }
 
 void Engine::renderGBuffer()
 {
     GPUScopedMarker("GBuffer");
-    const auto &psoGBuffer = m_pipelines[PSO_GBUFFER];
-    m_immediateContext->SetPipelineState(psoGBuffer->getPipeline());
+    const MeshPipelines psosGBuffer = getMeshPipelines(PSO_GBUFFER);
+    PipelineState* psoGBuffer = nullptr;
 
     ITextureView *pRTV[] = {m_gbuffer->getTextureOfType(GBuffer::EGBufferType::Albedo)->GetDefaultView(
             Diligent::TEXTURE_VIEW_RENDER_TARGET),
@@ -1401,86 +1535,112 @@ void Engine::renderGBuffer()
     m_immediateContext->ClearRenderTarget(pRTV[2], ClearColorNormal, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
 
     std::scoped_lock mut(m_mutexAddMesh);
-    for (Mesh *m: m_meshOpaque)
+    const Mesh* mappedMesh = nullptr;
+    for (const SceneStore::DrawItem &item: m_cullViews[CULL_VIEW_CAMERA_OPAQUE].m_drawList)
     {
-        if(m->isLoaded())
+        Mesh *m = m_sceneStore.getOwner(item.m_instance);
+        Mesh::Group &grp = m->getGroups()[m_sceneStore.getGroup(item.m_instance)];
+        if (!m->isLoaded() || grp.m_visibleRanges.empty())
+        {
+            continue;
+        }
+
+        const auto &model = m_sceneStore.getWorldMatrix(item.m_instance);
+
+        struct ConstantsGBuffer {
+            float4x4 g_WorldViewProj;
+            float4x4 g_model;
+        };
+
+        // each group was cooked with its own vertex layout, the pipeline only changes with it
+        PipelineState* pso = psosGBuffer[static_cast<size_t>(grp.m_vertexLayout)];
+        if (pso != psoGBuffer)
+        {
+            psoGBuffer = pso;
+            m_immediateContext->SetPipelineState(psoGBuffer->getPipeline());
+        }
+
+        if (grp.m_vertexLayout == EVertexLayout::Octahedral)
         {
-            auto &groups = m->getGroups();
-            const auto &model = m->getModel();
+            // the positions are quantized in the AABB of the group, g_model only turns the normals
+            MapHelper<ConstantsGBuffer> CBConstants(m_immediateContext, m_bufferMatrixMesh, MAP_WRITE, MAP_FLAG_DISCARD);
+            CBConstants->g_WorldViewProj = (Mesh::getDequantization(grp) * model * m_camera.GetViewMatrix() * m_camera.GetProjMatrix()).Transpose();
+            CBConstants->g_model = (model).Transpose();
+            mappedMesh = nullptr;
+        }
+        // the groups of a mesh are mostly next to each other in the draw list, its matrix is only mapped when it changes
+        else if (m != mappedMesh)
+        {
+            // Map the buffer and write current world-view-projection matrix
+            MapHelper<ConstantsGBuffer> CBConstants(m_immediateContext, m_bufferMatrixMesh, MAP_WRITE, MAP_FLAG_DISCARD);
+            CBConstants->g_WorldViewProj = (model * m_camera.GetViewMatrix() * m_camera.GetProjMatrix()).Transpose();
+            CBConstants->g_model = (model).Transpose();
+            mappedMesh = m;
+        }
+
+        if (grp.m_textures.empty())
+        {
+            psoGBuffer->getSRB().GetVariableByName(SHADER_TYPE_PIXEL, "g_TextureAlbedo")->
+                    Set(m_defaultTextures["albedo"]->GetDefaultView(Diligent::TEXTURE_VIEW_SHADER_RESOURCE));
 
+            if (auto *pVar = psoGBuffer->getSRB().GetVariableByName(SHADER_TYPE_PIXEL, "g_TextureNormal"))
             {
-                struct ConstantsGBuffer {
-                    float4x4 g_WorldViewProj;
-                    float4x4 g_model;
-                };
+                pVar->Set(m_defaultTextures["normal"]->GetDefaultView(Diligent::TEXTURE_VIEW_SHADER_RESOURCE));
+            }
 
-                // Map the buffer and write current world-view-projection matrix
-                MapHelper<ConstantsGBuffer> CBConstants(m_immediateContext, m_bufferMatrixMesh, MAP_WRITE, MAP_FLAG_DISCARD);
-                CBConstants->g_WorldViewProj = (model * m_camera.GetViewMatrix() * m_camera.GetProjMatrix()).Transpose();
-                CBConstants->g_model = (model).Transpose();
+            if (auto *pVar = psoGBuffer->getSRB().GetVariableByName(SHADER_TYPE_PIXEL, "g_TextureRoughness"))
+            {
+                pVar->Set(m_defaultTextures["roughness"]->GetDefaultView(Diligent::TEXTURE_VIEW_SHADER_RESOURCE));
             }
+        }
+        else
+        {
+            psoGBuffer->getSRB().GetVariableByName(SHADER_TYPE_PIXEL, "g_TextureAlbedo")->
+                    Set(grp.m_textures[0]->GetDefaultView(TEXTURE_VIEW_SHADER_RESOURCE));
 
-            for (Mesh::Group &grp: groups)
+            if (grp.m_textures.size() > 1)
             {
-                if (grp.m_textures.empty())
+                if(auto * normal = psoGBuffer->getSRB().GetVariableByName(SHADER_TYPE_PIXEL, "g_TextureNormal"))
                 {
-                    psoGBuffer->getSRB().GetVariableByName(SHADER_TYPE_PIXEL, "g_TextureAlbedo")->
-                            Set(m_defaultTextures["albedo"]->GetDefaultView(Diligent::TEXTURE_VIEW_SHADER_RESOURCE));
-
-                    if (auto *pVar = psoGBuffer->getSRB().GetVariableByName(SHADER_TYPE_PIXEL, "g_TextureNormal"))
-                    {
-                        pVar->Set(m_defaultTextures["normal"]->GetDefaultView(Diligent::TEXTURE_VIEW_SHADER_RESOURCE));
-                    }
-
-                    if (auto *pVar = psoGBuffer->getSRB().GetVariableByName(SHADER_TYPE_PIXEL, "g_TextureRoughness"))
-                    {
-                        pVar->Set(m_defaultTextures["roughness"]->GetDefaultView(Diligent::TEXTURE_VIEW_SHADER_RESOURCE));
-                    }
+                    normal->Set(grp.m_textures[1]->GetDefaultView(TEXTURE_VIEW_SHADER_RESOURCE));
                 }
-                else
+                if(auto * roughness = psoGBuffer->getSRB().GetVariableByName(SHADER_TYPE_PIXEL, "g_TextureRoughness"))
                 {
-                    psoGBuffer->getSRB().GetVariableByName(SHADER_TYPE_PIXEL, "g_TextureAlbedo")->
-                            Set(grp.m_textures[0]->GetDefaultView(TEXTURE_VIEW_SHADER_RESOURCE));
-
-                    if (grp.m_textures.size() > 1)
-                    {
-                        if(auto * normal = psoGBuffer->getSRB().GetVariableByName(SHADER_TYPE_PIXEL, "g_TextureNormal"))
-                        {
-                            normal->Set(grp.m_textures[1]->GetDefaultView(TEXTURE_VIEW_SHADER_RESOURCE));
-                        }
-                        if(auto * roughness = psoGBuffer->getSRB().GetVariableByName(SHADER_TYPE_PIXEL, "g_TextureRoughness"))
-                        {
-                            roughness->Set(m_defaultTextures["roughness"]->GetDefaultView(Diligent::TEXTURE_VIEW_SHADER_RESOURCE));
-                            //roughness->Set(grp.m_textures[2]->GetDefaultView(TEXTURE_VIEW_SHADER_RESOURCE));
-                        }
-                    }
+                    roughness->Set(m_defaultTextures["roughness"]->GetDefaultView(Diligent::TEXTURE_VIEW_SHADER_RESOURCE));
+                    //roughness->Set(grp.m_textures[2]->GetDefaultView(TEXTURE_VIEW_SHADER_RESOURCE));
                 }
-
-                Uint64 offset = 0;
-                IBuffer *pBuffs[] = {grp.m_meshVertexBuffer};
-                m_immediateContext->SetVertexBuffers(0, 1, pBuffs, &offset, RESOURCE_STATE_TRANSITION_MODE_TRANSITION,
-                                                     SET_VERTEX_BUFFERS_FLAG_RESET);
-                m_immediateContext->SetIndexBuffer(grp.m_meshIndexBuffer, 0, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
-                m_immediateContext->CommitShaderResources(&psoGBuffer->getSRB(),
-                                                          RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
-
-                DrawIndexedAttribs DrawAttrs; // This is an indexed draw call
-                DrawAttrs.IndexType = VT_UINT16; // Index type
-                DrawAttrs.NumIndices = grp.m_indices.size();
-                // Verify the state of vertex and index buffers as well as consistence of
-                // render targets and correctness of draw command arguments
-                DrawAttrs.Flags = DRAW_FLAG_VERIFY_ALL;
-                m_immediateContext->DrawIndexed(DrawAttrs);
             }
         }
+
+        Uint64 offset = 0;
+        IBuffer *pBuffs[] = {grp.m_meshVertexBuffer};
+        m_immediateContext->SetVertexBuffers(0, 1, pBuffs, &offset, RESOURCE_STATE_TRANSITION_MODE_TRANSITION,
+                                             SET_VERTEX_BUFFERS_FLAG_RESET);
+        m_immediateContext->SetIndexBuffer(grp.m_meshIndexBuffer, 0, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+        m_groupBindCount++;
+        m_immediateContext->CommitShaderResources(&psoGBuffer->getSRB(),
+                                                  RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+
+        for (const Mesh::IndexRange &range: grp.m_visibleRanges)
+        {
+            DrawIndexedAttribs DrawAttrs; // This is an indexed draw call
+            DrawAttrs.IndexType = grp.m_indexType; // 16 or 32 bits, depends on the vertex count of the group
+            DrawAttrs.NumIndices = range.m_indexCount;
+            DrawAttrs.FirstIndexLocation = range.m_firstIndex;
+            // Verify the state of vertex and index buffers as well as consistence of
+            // render targets and correctness of draw command arguments
+            DrawAttrs.Flags = DRAW_FLAG_VERIFY_ALL;
+            m_immediateContext->DrawIndexed(DrawAttrs);
+            m_drawCallCount++;
+        }
     }
 }
 
 void Engine::renderZPrepass()
 {
     GPUScopedMarker("Z prepass");
-    const auto &psoZPrepass = m_pipelines[PSO_ZPREPASS];
-    m_immediateContext->SetPipelineState(psoZPrepass->getPipeline());
+    const MeshPipelines psosZPrepass = getMeshPipelines(PSO_ZPREPASS);
+    PipelineState* psoZPrepass = nullptr;
 
     auto pDSV = m_gbuffer->getTextureOfType(GBuffer::EGBufferType::Depth);// m_swapChain-
     m_immediateContext->SetRenderTargets(0, nullptr, pDSV->GetDefaultView(Diligent::TEXTURE_VIEW_DEPTH_STENCIL),
@@ -1488,62 +1648,73 @@ void Engine::renderZPrepass()
     m_immediateContext->ClearDepthStencil(pDSV->GetDefaultView(Diligent::TEXTURE_VIEW_DEPTH_STENCIL),
                                           Diligent::CLEAR_DEPTH_FLAG, 1, 0, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
 
-    ViewFrustum viewFrustum;
-    ExtractViewFrustumPlanesFromMatrix(m_camera.GetViewMatrix() * m_camera.GetProjMatrix(),
-                                       viewFrustum, false);
-
+    // the draw list only has what the frustum of the camera sees, see frustrumCulling
     std::scoped_lock mut(m_mutexAddMesh);
-    for (Mesh *m: m_meshOpaque)
+    const Mesh* mappedMesh = nullptr;
+    for (const SceneStore::DrawItem &item: m_cullViews[CULL_VIEW_CAMERA_OPAQUE].m_drawList)
     {
-        auto &groups = m->getGroups();
-        const auto &model = m->getModel();
+        Mesh *m = m_sceneStore.getOwner(item.m_instance);
+        Mesh::Group &grp = m->getGroups()[m_sceneStore.getGroup(item.m_instance)];
+        if (grp.m_visibleRanges.empty())
+        {
+            continue;
+        }
+
+        const auto &model = m_sceneStore.getWorldMatrix(item.m_instance);
+
+        // each group was cooked with its own vertex layout, the pipeline only changes with it
+        PipelineState* pso = psosZPrepass[static_cast<size_t>(grp.m_vertexLayout)];
+        if (pso != psoZPrepass)
+        {
+            psoZPrepass = pso;
+            m_immediateContext->SetPipelineState(psoZPrepass->getPipeline());
+        }
 
+        if (grp.m_vertexLayout == EVertexLayout::Octahedral)
+        {
+            // the positions are quantized in the AABB of the group
+            MapHelper<float4x4> CBConstants(m_immediateContext, m_bufferMatrixMesh, MAP_WRITE, MAP_FLAG_DISCARD);
+            *CBConstants = (Mesh::getDequantization(grp) * model * m_camera.GetViewMatrix() * m_camera.GetProjMatrix()).Transpose();
+            mappedMesh = nullptr;
+        }
+        else if (m != mappedMesh)
         {
             // Map the buffer and write current world-view-projection matrix
             MapHelper<float4x4> CBConstants(m_immediateContext, m_bufferMatrixMesh, MAP_WRITE, MAP_FLAG_DISCARD);
             *CBConstants = (model * m_camera.GetViewMatrix() * m_camera.GetProjMatrix()).Transpose();
+            mappedMesh = m;
         }
 
-        for (Mesh::Group &grp: groups)
-        {
-            if (GetBoxVisibility(viewFrustum, grp.m_aabb.Transform(model)) == Diligent::BoxVisibility::Invisible)
-            {
-                continue;
-            }
-
-            Uint64 offset = 0;
-            IBuffer *pBuffs[] = {grp.m_meshVertexBuffer};
-            m_immediateContext->SetVertexBuffers(0, 1, pBuffs, &offset, RESOURCE_STATE_TRANSITION_MODE_TRANSITION,
-                                                 SET_VERTEX_BUFFERS_FLAG_RESET);
-            m_immediateContext->SetIndexBuffer(grp.m_meshIndexBuffer, 0, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
-            m_immediateContext->CommitShaderResources(&psoZPrepass->getSRB(),
-                                                      RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+        Uint64 offset = 0;
+        IBuffer *pBuffs[] = {grp.m_meshVertexBuffer};
+        m_immediateContext->SetVertexBuffers(0, 1, pBuffs, &offset, RESOURCE_STATE_TRANSITION_MODE_TRANSITION,
+                                             SET_VERTEX_BUFFERS_FLAG_RESET);
+        m_immediateContext->SetIndexBuffer(grp.m_meshIndexBuffer, 0, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+        m_groupBindCount++;
+        m_immediateContext->CommitShaderResources(&psoZPrepass->getSRB(),
+                                                  RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
 
+        for (const Mesh::IndexRange &range: grp.m_visibleRanges)
+        {
             DrawIndexedAttribs DrawAttrs; // This is an indexed draw call
-            DrawAttrs.IndexType = VT_UINT16; // Index type
-            DrawAttrs.NumIndices = grp.m_indices.size();
+            DrawAttrs.IndexType = grp.m_indexType; // 16 or 32 bits, depends on the vertex count of the group
+            DrawAttrs.NumIndices = range.m_indexCount;
+            DrawAttrs.FirstIndexLocation = range.m_firstIndex;
             // Verify the state of vertex and index buffers as well as consistence of
             // render targets and correctness of draw command arguments
             //DrawAttrs.Flags = DRAW_FLAG_VERIFY_ALL;
             m_immediateContext->DrawIndexed(DrawAttrs);
+            m_drawCallCount++;
         }
     }
 }
 
 void Engine::renderCSM()
 {
-    const auto &psoCsm = m_pipelines[PSO_CSM];
-    m_immediateContext->SetPipelineState(psoCsm->getPipeline());
-
-    //These are not transposed for GPU consumption
-    eastl::array<float4x4, 3> slicesVP = m_camera.getSliceViewProjMatrix(normalize(m_lightPos));
+    const MeshPipelines psosCsm = getMeshPipelines(PSO_CSM);
 
     GPUScopedMarker("CSM");
 
-    ViewFrustum viewFrustum;
-    ExtractViewFrustumPlanesFromMatrix(m_camera.GetViewMatrix() * m_camera.GetProjMatrix(),
-                                       viewFrustum, false);
-
     for (int i = 0; i < Diligent::FirstPersonCamera::getNbCascade(); ++i)
     {
         eastl::string cascadeName = eastl::string("Cascade ");
@@ -1557,38 +1728,60 @@ void Engine::renderCSM()
 
         std::scoped_lock mut(m_mutexAddMesh);
 
-        m_immediateContext->CommitShaderResources(&psoCsm->getSRB(), RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
-        for (Mesh *m: m_meshOpaque)
+        PipelineState* psoCsm = nullptr;
+
+        // only the casters inside the box of this cascade, with the LOD picked for it, see frustrumCulling
+        const Mesh* mappedMesh = nullptr;
+        for (const SceneStore::DrawItem &item: m_cullViews[CULL_VIEW_CASCADE_0 + i].m_drawList)
         {
-            auto &groups = m->getGroups();
-            const auto &model = m->getModel();
+            Mesh *m = m_sceneStore.getOwner(item.m_instance);
+            Mesh::Group &grp = m->getGroups()[m_sceneStore.getGroup(item.m_instance)];
+            const auto &model = m_sceneStore.getWorldMatrix(item.m_instance);
+
+            // each group was cooked with its own vertex layout, the pipeline only changes with it
+            PipelineState* pso = psosCsm[static_cast<size_t>(grp.m_vertexLayout)];
+            if (pso != psoCsm)
+            {
+                psoCsm = pso;
+                m_immediateContext->SetPipelineState(psoCsm->getPipeline());
+                m_immediateContext->CommitShaderResources(&psoCsm->getSRB(), RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+            }
 
+            if (grp.m_vertexLayout == EVertexLayout::Octahedral)
+            {
+                // the positions are quantized in the AABB of the group
+                MapHelper<float4x4> CBConstants(m_immediateContext, m_bufferMatrixMesh, MAP_WRITE, MAP_FLAG_DISCARD);
+                *CBConstants = (Mesh::getDequantization(grp) * model * m_cascadeViewProj[i]).Transpose();
+                mappedMesh = nullptr;
+            }
+            else if (m != mappedMesh)
             {
                 // Map the buffer and write current world-view-projection matrix
                 MapHelper<float4x4> CBConstants(m_immediateContext, m_bufferMatrixMesh, MAP_WRITE, MAP_FLAG_DISCARD);
-                *CBConstants = (model * slicesVP[i]).Transpose();
+                *CBConstants = (model * m_cascadeViewProj[i]).Transpose();
+                mappedMesh = m;
             }
+            Uint64 offset = 0;
+            IBuffer *pBuffs[] = {grp.m_meshVertexBuffer};
+            m_immediateContext->SetVertexBuffers(0, 1, pBuffs, &offset, RESOURCE_STATE_TRANSITION_MODE_TRANSITION,
+                                                 SET_VERTEX_BUFFERS_FLAG_RESET);
+            m_immediateContext->SetIndexBuffer(grp.m_meshIndexBuffer, 0, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
+            m_groupBindCount++;
 
-            for (Mesh::Group &grp: groups)
+            DrawIndexedAttribs DrawAttrs; // This is an indexed draw call
+            DrawAttrs.IndexType = grp.m_indexType; // 16 or 32 bits, depends on the vertex count of the group
+            DrawAttrs.NumIndices = grp.m_indexCount;
+            if (item.m_lod > 0)
             {
-                /*if (GetBoxVisibility(viewFrustum, grp.m_aabb.Transform(model)) == Diligent::BoxVisibility::Invisible)
-                {
-                   continue;
-                }*/
-                Uint64 offset = 0;
-                IBuffer *pBuffs[] = {grp.m_meshVertexBuffer};
-                m_immediateContext->SetVertexBuffers(0, 1, pBuffs, &offset, RESOURCE_STATE_TRANSITION_MODE_TRANSITION,
-                                                     SET_VERTEX_BUFFERS_FLAG_RESET);
-                m_immediateContext->SetIndexBuffer(grp.m_meshIndexBuffer, 0, RESOURCE_STATE_TRANSITION_MODE_TRANSITION);
-
-                DrawIndexedAttribs DrawAttrs; // This is an indexed draw call
-                DrawAttrs.IndexType = VT_UINT16; // Index type
-                DrawAttrs.NumIndices = grp.m_indices.size();
-                // Verify the state of vertex and index buffers as well as consistence of
-                // render targets and correctness of draw command arguments
-                DrawAttrs.Flags = DRAW_FLAG_VERIFY_ALL;
-                m_immediateContext->DrawIndexed(DrawAttrs);
+                DrawAttrs.NumIndices = grp.m_lods[item.m_lod].m_indexCount;
+                DrawAttrs.FirstIndexLocation = grp.m_lods[item.m_lod].m_firstIndex;
+                m_lodShadowTrianglesSaved += (grp.m_indexCount - grp.m_lods[item.m_lod].m_indexCount) / 3;
             }
+            // Verify the state of vertex and index buffers as well as consistence of
+            // render targets and correctness of draw command arguments
+            DrawAttrs.Flags = DRAW_FLAG_VERIFY_ALL;
+            m_immediateContext->DrawIndexed(DrawAttrs);
+            m_drawCallCount++;
         }
     }
 }
@@ -1623,28 +1816,17 @@ void Engine::createCSMPipeline()
     desc.PrimitiveTopology = PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
     desc.RasterizerDesc.CullMode = Diligent::CULL_MODE_FRONT;
 
-    eastl::vector<LayoutElement> layoutElements;
-    if (m_isVertexPacked)
-    {
-        layoutElements = layoutElementsPacked;
-    }
-    else
-    {
-        layoutElements = {
-                LayoutElement(0, 0, 3, VT_FLOAT32, False),
-                LayoutElement(1, 0, 3, VT_FLOAT32, True),
-                LayoutElement(2, 0, 2, VT_FLOAT32, False)
-        };
-    }
-
     eastl::vector<PipelineState::VarStruct> vars = {{SHADER_TYPE_VERTEX, "Constants", m_bufferMatrixMesh}};
 
-    m_pipelines[PSO_CSM] = eastl::make_unique<PipelineState>(m_device, "CSM", PIPELINE_TYPE_GRAPHICS,
-                                                             "csm",
-                                                             eastl::vector<eastl::pair<eastl::string, eastl::string>>(),
-                                                             vars,
-                                                             eastl::vector<PipelineState::VarStruct>(), desc,
-                                                             layoutElements);
+    for (EVertexLayout layout : getMeshLayouts())
+    {
+        m_pipelines[getMeshPipelineName(PSO_CSM, layout)] = eastl::make_unique<PipelineState>(m_device,
+                                                                 layout == EVertexLayout::Octahedral ? "CSM - Octahedral" : "CSM",
+                                                                 PIPELINE_TYPE_GRAPHICS, "csm", getMeshMacros(layout),
+                                                                 vars,
+                                                                 eastl::vector<PipelineState::VarStruct>(), desc,
+                                                                 getMeshLayoutElements(layout));
+    }
 }
 
 uint32_t Engine::addImportProgress(const char *_name)
@@ -1669,6 +1851,51 @@ void Engine::showProgressIndicators()
 {
     ImGui::Begin("Progress Indicators");
 
+    if (m_streaming->isIdle())
+    {
+        if (m_sceneLoadTimeMs < 0.0f)
+        {
+            m_sceneLoadTimeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_sceneLoadStart).count();
+            std::cout << "Scene loaded in " << m_sceneLoadTimeMs << "ms on " << JobSystem::get().getWorkerCount() << " worker threads"
+                      << (m_isScenePacked ? " from the scene archive" : " from separate .mesh files") << std::endl;
+            ImportTelemetry::dumpJson("import_telemetry.json");
+        }
+        ImGui::Text("Scene loaded in %.1fms on %zu worker threads (%s)", m_sceneLoadTimeMs, JobSystem::get().getWorkerCount(),
+                    m_isScenePacked ? SceneArchive::FILE_NAME : "separate .mesh files");
+    }
+    else
+    {
+        ImGui::Text("Loading scene on %zu worker threads", JobSystem::get().getWorkerCount());
+    }
+
+    const StreamingManager::Stats& streaming = m_streaming->getStats();
+    ImGui::Text("Streaming: %u pending, %u loading, %u uploading, %u ready, %u cancelled", streaming.m_pendingCount, streaming.m_loadingCount,
+                streaming.m_uploadingCount, streaming.m_readyCount, streaming.m_cancelledCount);
+    ImGui::Text("Streaming memory: %.1f/%.1fMB", ProcessMemory::toMB(streaming.m_residentBytes), ProcessMemory::toMB(m_streaming->m_memoryBudget));
+    ImGui::Text("Uploaded last frame: %u groups, %.2fMB in %.2fms", streaming.m_uploadedGroupsLastFrame,
+                ProcessMemory::toMB(streaming.m_uploadedBytesLastFrame), streaming.m_uploadTimeMsLastFrame);
+
+    int uploadBudgetMB = static_cast<int>(m_streaming->m_uploadBudgetPerFrame >> 20);
+    if (ImGui::SliderInt("Upload budget per frame (MB)", &uploadBudgetMB, 1, 256))
+    {
+        m_streaming->m_uploadBudgetPerFrame = static_cast<size_t>(uploadBudgetMB) << 20;
+    }
+    int memoryBudgetMB = static_cast<int>(m_streaming->m_memoryBudget >> 20);
+    if (ImGui::SliderInt("Streaming memory budget (MB)", &memoryBudgetMB, 16, 4096))
+    {
+        m_streaming->m_memoryBudget = static_cast<size_t>(memoryBudgetMB) << 20;
+    }
+
+    for (int i = 0; i < static_cast<int>(JobSystem::ESubsystem::Max); ++i)
+    {
+        const auto subsystem = static_cast<JobSystem::ESubsystem>(i);
+        ImGui::Text("%s jobs: %u/%u", JobSystem::getName(subsystem), JobSystem::get().getRunningCount(subsystem),
+                    JobSystem::get().getConcurrencyCap(subsystem));
+    }
+
+    ImGui::Text("Texture cache: %zu live, %u hits, %u misses", TextureCache::get().getLiveCount(),
+                TextureCache::get().getHitCount(), TextureCache::get().getMissCount());
+
     const ImU32 col = ImGui::GetColorU32(ImGuiCol_ButtonHovered);
     const ImU32 bg = ImGui::GetColorU32(ImGuiCol_Button);
     for (auto &nameAndProgress: m_importProgressMap)
@@ -1686,26 +1913,234 @@ void Engine::frustrumCulling()
 {
     m_meshesSortedAndCulled.clear();
 
-    ViewFrustum viewFrustum;
-    ExtractViewFrustumPlanesFromMatrix(m_camera.GetViewMatrix() * m_camera.GetProjMatrix(),
-                                       viewFrustum, false);
+    const float4x4 viewProj = m_camera.GetViewMatrix() * m_camera.GetProjMatrix();
+
+    const float projectionScale = m_camera.GetProjMatrix().m11 * static_cast<float>(m_height) * 0.5f;
 
+    // the ranges visible from the camera are shared by the z prepass and the gbuffer so both draw the same triangles
+    m_meshletCount = 0;
+    m_meshletCulledCount = 0;
+    m_lodTrianglesSaved = 0;
+    m_lodShadowTrianglesSaved = 0;
+
+    // every view reads the world bounds, only the meshes that moved transform theirs
     for(Mesh* m : m_meshes)
     {
-        if(m && m->isLoaded())
+        if(m)
         {
-            auto &groups = m->getGroups();
-            const auto &model = m->getModel();
-            for(Mesh::Group& grp : groups)
+            m_boundsTransformCount += updateWorldBounds(m);
+        }
+    }
+
+    // the camera and every cascade, the rasterizer clips the cascades against the same box so their near plane culls too
+    m_cascadeViewProj = m_camera.getSliceViewProjMatrix(normalize(m_lightPos));
+    ExtractViewFrustumPlanesFromMatrix(viewProj, m_cullViews[CULL_VIEW_CAMERA_OPAQUE].m_frustum, false);
+    m_cullViews[CULL_VIEW_CAMERA_OPAQUE].m_flags = SceneStore::FLAG_OPAQUE;
+    m_cullViews[CULL_VIEW_CAMERA_OPAQUE].m_lodPixelError = m_isLodEnabled ? m_lodPixelError : 0.0f;
+    m_cullViews[CULL_VIEW_CAMERA_TRANSPARENT].m_frustum = m_cullViews[CULL_VIEW_CAMERA_OPAQUE].m_frustum;
+    m_cullViews[CULL_VIEW_CAMERA_TRANSPARENT].m_flags = SceneStore::FLAG_TRANSPARENT;
+    for(uint32_t i = 0; i < m_cascadeViewProj.size(); ++i)
+    {
+        // shadows hide the details, the further cascades even more
+        CullView& view = m_cullViews[CULL_VIEW_CASCADE_0 + i];
+        ExtractViewFrustumPlanesFromMatrix(m_cascadeViewProj[i], view.m_frustum, false);
+        view.m_flags = SceneStore::FLAG_CAST_SHADOW;
+        view.m_lodPixelError = m_isLodEnabled ? m_lodPixelError * m_shadowLodErrorScale * static_cast<float>(i + 1) : 0.0f;
+    }
+
+    const auto cullStart = std::chrono::steady_clock::now();
+
+    // the views only read the scene store, each one writes its own lists. The meshlets are in the local space of each mesh
+    // and aren't in the store, they are culled next to them
+    tf::Taskflow taskflow;
+    const float3 cameraPosition = m_camera.GetPos();
+    eastl::array<tf::Task, CULL_VIEW_COUNT> viewTasks;
+    for(uint32_t i = 0; i < m_cullViews.size(); ++i)
+    {
+        CullView& view = m_cullViews[i];
+        viewTasks[i] = taskflow.emplace([this, &view, cameraPosition, projectionScale]() { cullView(view, cameraPosition, projectionScale); });
+    }
+    m_occludedCount = 0;
+    if(m_isOcclusionCullingEnabled)
+    {
+        // the cascades are still culled meanwhile
+        tf::Task occlusion = taskflow.emplace([this, &viewProj, cameraPosition]() { occlusionCulling(viewProj, cameraPosition); });
+        occlusion.succeed(viewTasks[CULL_VIEW_CAMERA_OPAQUE], viewTasks[CULL_VIEW_CAMERA_TRANSPARENT]);
+    }
+    else
+    {
+        m_occluders.clear();
+        m_occlusionTimeMs = 0.0f;
+    }
+    if(m_isMeshletCullingEnabled)
+    {
+        taskflow.emplace([this, &viewProj, cameraPosition]()
+        {
+            ZoneScopedN("Meshlet Culling");
+            for(Mesh* m : m_meshOpaque)
             {
-                if (GetBoxVisibility(viewFrustum, grp.m_aabb.Transform(model)) == Diligent::BoxVisibility::Invisible)
-                {
-                    continue;
-                }
+                m_meshletCulledCount += m->cullMeshlets(viewProj, cameraPosition);
             }
+        });
+    }
+    JobSystem::get().run(taskflow);
+
+    m_sceneCullTimeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - cullStart).count();
+
+    for(Mesh* m : m_meshOpaque)
+    {
+        for(const Mesh::Group& grp : m->getGroups())
+        {
+            m_meshletCount += static_cast<uint32_t>(grp.m_meshlets.size());
+        }
+    }
+
+    for(const CullView& view : m_cullViews)
+    {
+        m_boundsReadCount += (view.m_method == SceneStore::ECullMethod::Linear ? m_sceneStore.getCount() : 0)
+                             + (view.m_lods.empty() ? 0 : static_cast<uint32_t>(view.m_visible.size()));
+    }
+
+    for(const SceneStore::DrawItem& item : m_cullViews[CULL_VIEW_CAMERA_OPAQUE].m_drawList)
+    {
+        Mesh::Group& grp = m_sceneStore.getOwner(item.m_instance)->getGroups()[m_sceneStore.getGroup(item.m_instance)];
+        if(!m_isMeshletCullingEnabled)
+        {
+            grp.m_visibleRanges.clear();
+            grp.m_visibleRanges.push_back({0, grp.m_indexCount});
         }
 
+        // meshlets only exist for the full detail, a coarser LOD is drawn whole
+        if(item.m_lod > 0 && !grp.m_visibleRanges.empty())
+        {
+            grp.m_visibleRanges.clear();
+            grp.m_visibleRanges.push_back({grp.m_lods[item.m_lod].m_firstIndex, grp.m_lods[item.m_lod].m_indexCount});
+            m_lodTrianglesSaved += (grp.m_indexCount - grp.m_lods[item.m_lod].m_indexCount) / 3;
+        }
+    }
+}
+
+void Engine::cullView(CullView& _view, const float3& _cameraPosition, float _projectionScale)
+{
+    ZoneScopedN("Cull View");
+    const auto start = std::chrono::steady_clock::now();
+
+    // the BVH only pays off when it skips most of the scene, last frame is a good guess of how much this view sees
+    const uint32_t instanceCount = m_sceneStore.getCount();
+    _view.m_method = instanceCount >= HIERARCHY_CULL_MIN_COUNT && _view.m_visible.size() * HIERARCHY_CULL_MAX_VISIBLE_RATIO < instanceCount
+                     ? SceneStore::ECullMethod::Hierarchy : SceneStore::ECullMethod::Linear;
+    m_sceneStore.cull(_view.m_frustum, _view.m_flags, _view.m_visible, _view.m_method);
+    if(_view.m_lodPixelError > 0.0f)
+    {
+        m_sceneStore.selectLods(_view.m_visible, _cameraPosition, _projectionScale, _view.m_lodPixelError, _view.m_lods);
     }
+    else
+    {
+        _view.m_lods.clear();
+    }
+    m_sceneStore.buildDrawList(_view.m_visible, _view.m_lods, _view.m_drawList);
+
+    _view.m_timeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Engine::occlusionCulling(const float4x4& _viewProj, const float3& _cameraPosition)
+{
+    ZoneScopedN("Occlusion Culling");
+    const auto start = std::chrono::steady_clock::now();
+
+    // the biggest on screen first, they hide the most and are mostly the closest, the masked depth works best front to back
+    m_occluderCandidates.clear();
+    for(uint32_t instance : m_cullViews[CULL_VIEW_CAMERA_OPAQUE].m_visible)
+    {
+        const Mesh::Group& grp = m_sceneStore.getOwner(instance)->getGroups()[m_sceneStore.getGroup(instance)];
+        if(grp.m_occluderIndices.empty())
+            continue;
+
+        const BoundBox bounds = m_sceneStore.getWorldBounds(instance);
+        const float radius = length(bounds.Max - bounds.Min) * 0.5f;
+        const float distance = length((bounds.Min + bounds.Max) * 0.5f - _cameraPosition) - radius;
+        const float size = distance > 0.0f ? radius / distance : std::numeric_limits<float>::max();
+        if(size >= OCCLUDER_MIN_SIZE)
+        {
+            m_occluderCandidates.push_back({size, instance});
+        }
+    }
+    eastl::sort(m_occluderCandidates.begin(), m_occluderCandidates.end(),
+                [](const eastl::pair<float, uint32_t>& _a, const eastl::pair<float, uint32_t>& _b) { return _a.first > _b.first; });
+
+    m_occluders.clear();
+    uint32_t triangleCount = 0;
+    for(const auto& [size, instance] : m_occluderCandidates)
+    {
+        if(m_occluders.size() == OCCLUDER_MAX_COUNT)
+            break;
+
+        const Mesh::Group& grp = m_sceneStore.getOwner(instance)->getGroups()[m_sceneStore.getGroup(instance)];
+        const uint32_t groupTriangleCount = static_cast<uint32_t>(grp.m_occluderIndices.size() / 3);
+        if(triangleCount + groupTriangleCount > OCCLUDER_MAX_TRIANGLES)
+            continue;
+
+        triangleCount += groupTriangleCount;
+        m_occluders.push_back({grp.m_occluderVertices.data(), grp.m_occluderIndices.data(), static_cast<uint32_t>(grp.m_occluderVertices.size()),
+                               static_cast<uint32_t>(grp.m_occluderIndices.size()), m_sceneStore.getWorldMatrix(instance)});
+    }
+    m_occlusionCulling.render(_viewProj, m_occluders);
+
+    // only the draw lists lose the hidden instances, m_visible stays what the frustum sees to pick the cull method of the next frame
+    for(CullView* view : {&m_cullViews[CULL_VIEW_CAMERA_OPAQUE], &m_cullViews[CULL_VIEW_CAMERA_TRANSPARENT]})
+    {
+        eastl::vector<SceneStore::DrawItem>& drawList = view->m_drawList;
+        m_occludedDraws.resize(drawList.size());
+        JobSystem::get().parallelFor(JobSystem::ESubsystem::Engine, JobSystem::EPriority::High, static_cast<uint32_t>(drawList.size()), 64,
+                                     [this, &drawList](uint32_t _begin, uint32_t _end)
+        {
+            for(uint32_t i = _begin; i < _end; ++i)
+            {
+                m_occludedDraws[i] = m_occlusionCulling.isOccluded(m_sceneStore.getWorldBounds(drawList[i].m_instance));
+            }
+        });
+
+        // in place and in order, the draw list stays sorted by material
+        size_t keptCount = 0;
+        for(size_t i = 0; i < drawList.size(); ++i)
+        {
+            if(!m_occludedDraws[i])
+            {
+                drawList[keptCount++] = drawList[i];
+            }
+        }
+        m_occludedCount += static_cast<uint32_t>(drawList.size() - keptCount);
+        drawList.resize(keptCount);
+    }
+
+    m_occlusionTimeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+uint32_t Engine::updateWorldBounds(Mesh* _mesh)
+{
+    const uint32_t transformedCount = _mesh->updateWorldBounds();
+    if(transformedCount > 0)
+    {
+        for(const Mesh::Group& grp : _mesh->getGroups())
+        {
+            m_sceneStore.setTransform(grp.m_instance, _mesh->getModel(), _mesh->getScale());
+        }
+    }
+    return transformedCount;
+}
+
+uint32_t Engine::getMaterialId(const Mesh::Group& _group)
+{
+    if(_group.m_textures.empty())
+        return 0;
+
+    auto it = m_materialIds.find(_group.m_textures[0].RawPtr());
+    if(it != m_materialIds.end())
+        return it->second;
+
+    const uint32_t id = static_cast<uint32_t>(m_materialIds.size()) + 1;
+    m_materialIds[_group.m_textures[0].RawPtr()] = id;
+    return id;
 }
 
 void Engine::createSkydomeTexturePipeline()
@@ -2162,9 +2597,13 @@ void Engine::SortMeshes()
                 m_meshTransparent.insert(mesh);
             }
 
+            // the transform is pushed by the culling, the mesh is dirty until its first updateWorldBounds
+            const uint8_t flags = mesh->isTransparent() ? SceneStore::FLAG_TRANSPARENT : SceneStore::FLAG_OPAQUE | SceneStore::FLAG_CAST_SHADOW;
             auto &groups = mesh->getGroups();
-            for (auto &group: groups)
+            for (uint32_t i = 0; i < groups.size(); ++i)
             {
+                auto &group = groups[i];
+                group.m_instance = m_sceneStore.create(mesh, i, group.m_aabb, Mesh::getLodInfo(group), getMaterialId(group), flags);
                 //m_raytracing->addMesh(m_device, m_immediateContext, group, mesh->getName());
                 m_heapTextures.insert(m_heapTextures.end(), group.m_textures.begin(), group.m_textures.end());
             }
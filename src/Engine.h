@@ -9,6 +9,7 @@
 #include <Windows.h>
 
 #include <EASTL/allocator.h>
+#include <EASTL/array.h>
 #include <EASTL/unique_ptr.h>
 #include <EASTL/vector_set.h>
 #include <EASTL/unordered_map.h>
@@ -26,10 +27,13 @@
 #include "Common/interface/RefCntAutoPtr.hpp"
 #include "GBuffer.hpp"
 #include "Mesh.h"
+#include "OcclusionCulling.hpp"
 #include "RenderDocHook.hpp"
+#include "SceneStore.hpp"
 #include "Graphics/GraphicsTools/interface/ScopedQueryHelper.hpp"
 #include "Graphics/GraphicsTools/interface/DurationQueryHelper.hpp"
 #include "PipelineState.hpp"
+#include "JobSystem.hpp"
 
 using namespace Diligent;
 
@@ -51,13 +55,21 @@ struct SPDConstants
     float2      invInputSize;
 };
 
-static eastl::vector<LayoutElement> layoutElementsPacked{
+// Matches VertexHalf in Mesh.h
+static eastl::vector<LayoutElement> layoutElementsHalf{
         {LayoutElement(0, 0, 2, Diligent::VT_UINT32, False),
          LayoutElement(1, 0, 2, Diligent::VT_UINT32, False),
          LayoutElement(2, 0, 1, Diligent::VT_UINT32, False),
          }
 };
 
+// Matches VertexOctahedral in Mesh.h
+static eastl::vector<LayoutElement> layoutElementsOctahedral{
+        {LayoutElement(0, 0, 2, Diligent::VT_UINT32, False),
+         LayoutElement(1, 0, 2, Diligent::VT_UINT32, False),
+         }
+};
+
 struct CSMProperties
 {
     eastl::array<float4x4, FirstPersonCamera::getNbCascade()> VP;
@@ -74,6 +86,7 @@ struct spdConstants
 
 class RayTracing;
 class FrameGraph;
+class StreamingManager;
 
 struct Group;
 
@@ -205,6 +218,75 @@ private:
 
     eastl::vector<Mesh*> m_meshesSortedAndCulled;
 
+    // one instance per group of the meshes in the scene, what the culling and the passes walk every frame
+    SceneStore m_sceneStore;
+    eastl::hash_map<ITexture*, uint32_t> m_materialIds; // by albedo, 0 is the default textures
+
+    // Every view the scene is drawn from, culled in parallel once per frame by frustrumCulling and drawn from their draw list by the passes
+    // below this the SIMD pass over every instance costs next to nothing anyway
+    static constexpr uint32_t HIERARCHY_CULL_MIN_COUNT = 4096;
+    // a view goes down the BVH while it sees less than 1 instance out of this many, see AssetCooker --benchmark-bvh
+    static constexpr uint32_t HIERARCHY_CULL_MAX_VISIBLE_RATIO = 32;
+
+    enum ECullView : uint32_t
+    {
+        CULL_VIEW_CAMERA_OPAQUE = 0, // shared by the z prepass and the gbuffer
+        CULL_VIEW_CAMERA_TRANSPARENT,
+        CULL_VIEW_CASCADE_0, // one per shadow cascade from here
+        CULL_VIEW_COUNT = CULL_VIEW_CASCADE_0 + Diligent::FirstPersonCamera::getNbCascade()
+    };
+
+    struct CullView
+    {
+        ViewFrustum m_frustum;
+        uint8_t m_flags = 0; // SceneStore::EFlags of the instances drawn
+        float m_lodPixelError = 0.0f; // 0 for the full detail everywhere
+        eastl::vector<uint32_t> m_visible;
+        eastl::vector<uint8_t> m_lods;
+        eastl::vector<SceneStore::DrawItem> m_drawList;
+        SceneStore::ECullMethod m_method = SceneStore::ECullMethod::Linear; // picked from how much of the scene it saw last frame
+        float m_timeMs = 0.0f;
+    };
+
+    eastl::array<CullView, CULL_VIEW_COUNT> m_cullViews;
+    eastl::array<float4x4, Diligent::FirstPersonCamera::getNbCascade()> m_cascadeViewProj; // the ones the cascades are culled with
+    float m_sceneCullTimeMs = 0.0f; // the whole graph, wall clock
+
+    bool m_isMeshletCullingEnabled = true;
+    uint32_t m_meshletCount = 0;
+    uint32_t m_meshletCulledCount = 0;
+
+    // The biggest occluders the camera sees go through the software occlusion culling, which then removes the draws of both camera views
+    // hidden behind them. Occluders are picked by their bounding sphere: its radius over the distance to it.
+    static constexpr float OCCLUDER_MIN_SIZE = 0.1f;
+    static constexpr uint32_t OCCLUDER_MAX_COUNT = 64;
+    static constexpr uint32_t OCCLUDER_MAX_TRIANGLES = 8192; // keeps the rasterization around 1ms, see AssetCooker --benchmark-occlusion
+    bool m_isOcclusionCullingEnabled = true;
+    OcclusionCulling m_occlusionCulling;
+    eastl::vector<eastl::pair<float, uint32_t>> m_occluderCandidates; // size and instance
+    eastl::vector<OcclusionCulling::Occluder> m_occluders;
+    eastl::vector<uint8_t> m_occludedDraws; // of the draw list being filtered
+    uint32_t m_occludedCount = 0;
+    float m_occlusionTimeMs = 0.0f;
+
+    bool m_isLodEnabled = true;
+    float m_lodPixelError = 1.0f; // a coarser LOD is used as long as its error projects under this
+    float m_shadowLodErrorScale = 4.0f; // multiplied by the cascade index + 1
+    uint32_t m_lodTrianglesSaved = 0;
+    uint32_t m_lodShadowTrianglesSaved = 0;
+
+    // World bounds of the groups, cached in the meshes: transforms done when a mesh moved, and reads that used to transform
+    uint32_t m_boundsTransformCount = 0;
+    uint32_t m_boundsReadCount = 0;
+    uint32_t m_boundsTransformCountLastFrame = 0;
+    uint32_t m_boundsReadCountLastFrame = 0;
+
+    // DrawIndexed and vertex/index buffer + SRB binds of the mesh passes, one bind per group drawn
+    uint32_t m_drawCallCount = 0;
+    uint32_t m_groupBindCount = 0;
+    uint32_t m_drawCallCountLastFrame = 0;
+    uint32_t m_groupBindCountLastFrame = 0;
+
     FirstPersonCamera m_camera;
 
     RefCntAutoPtr<IBuffer> m_bufferLighting;
@@ -237,8 +319,10 @@ private:
     //TODO: we *could* hash the string to have a faster search, but since it's a few elements it shouldn't matter
     eastl::unordered_map<eastl::string, RefCntAutoPtr<ITexture>> m_defaultTextures;
 
-    tf::Executor m_executor;
-    tf::Taskflow m_taskflow;
+    StreamingManager* m_streaming = nullptr;
+    std::chrono::time_point<std::chrono::steady_clock> m_sceneLoadStart;
+    float m_sceneLoadTimeMs = -1.0f;
+    bool m_isScenePacked = false;
 
     Mesh* m_clickedMesh = nullptr;
 
@@ -281,6 +365,16 @@ private:
 
     void createZprepassPipeline();
 
+    // The mesh pipelines (z prepass, gbuffer, CSM, transparency) exist once per drawable EVertexLayout (see Mesh::isVertexLayoutDrawable),
+    // the half one under _pso and the others suffixed by their layout. Their shaders get USE_OCTAHEDRAL_VERTEX, see common/vertex.hlsl.
+    // getMeshPipelines is null for the layouts without one.
+    static eastl::string getMeshPipelineName(const char* _pso, EVertexLayout _layout);
+    static eastl::vector<EVertexLayout> getMeshLayouts();
+    using MeshPipelines = eastl::array<PipelineState*, static_cast<size_t>(EVertexLayout::Count)>;
+    MeshPipelines getMeshPipelines(const char* _pso);
+    eastl::vector<LayoutElement> getMeshLayoutElements(EVertexLayout _layout) const;
+    static eastl::vector<eastl::pair<eastl::string, eastl::string>> getMeshMacros(EVertexLayout _layout);
+
     void Im3dNewFrame();
 
     void AddMesh(Mesh* _mesh);
@@ -298,6 +392,13 @@ private:
     void showProgressIndicators();
 
     void frustrumCulling();
+    void cullView(CullView& _view, const float3& _cameraPosition, float _projectionScale);
+    // Once both camera views are culled, removes the draws hidden behind the occluders from their draw lists
+    void occlusionCulling(const float4x4& _viewProj, const float3& _cameraPosition);
+
+    // Mesh::updateWorldBounds, and the new transform to the scene store when the mesh moved
+    uint32_t updateWorldBounds(Mesh* _mesh);
+    uint32_t getMaterialId(const Mesh::Group& _group);
 
     void createSkydomeTexturePipeline();
 
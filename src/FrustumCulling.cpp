@@ -0,0 +1,193 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#include "FrustumCulling.hpp"
+
+#include <array>
+#include <cstring>
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+#include "tracy/Tracy.hpp"
+#include "util/CpuFeatures.hpp"
+
+namespace FrustumCulling
+{
+namespace
+{
+    constexpr uint32_t MAX_BLOCK_SIZE = 8;
+
+    // The lanes set in a visibility mask, packed to the front, so a whole block is stored at once and only the visible ones are kept
+    struct CompactedLanes
+    {
+        uint32_t m_lanes[MAX_BLOCK_SIZE];
+        uint32_t m_count;
+    };
+
+    constexpr std::array<CompactedLanes, 1 << MAX_BLOCK_SIZE> makeCompactedLanes()
+    {
+        std::array<CompactedLanes, 1 << MAX_BLOCK_SIZE> table{};
+        for (uint32_t mask = 0; mask < table.size(); ++mask)
+        {
+            for (uint32_t lane = 0; lane < MAX_BLOCK_SIZE; ++lane)
+            {
+                if ((mask & (1 << lane)) != 0)
+                {
+                    table[mask].m_lanes[table[mask].m_count++] = lane;
+                }
+            }
+        }
+        return table;
+    }
+
+    constexpr std::array<CompactedLanes, 1 << MAX_BLOCK_SIZE> COMPACTED_LANES = makeCompactedLanes();
+
+    // One plane of the frustum and the arrays of its farthest corner along the normal, picked the way GetBoxVisibilityAgainstPlane does
+    struct PlaneTest
+    {
+        float m_normal[3];
+        float m_distance;
+        const float* m_x;
+        const float* m_y;
+        const float* m_z;
+    };
+
+    void getPlaneTests(const ViewFrustum& _frustum, const Boxes& _boxes, PlaneTest (&_tests)[ViewFrustum::NUM_PLANES])
+    {
+        for (uint32_t i = 0; i < ViewFrustum::NUM_PLANES; ++i)
+        {
+            const Plane3D& plane = _frustum.GetPlane(static_cast<ViewFrustum::PLANE_IDX>(i));
+            _tests[i] = {{plane.Normal.x, plane.Normal.y, plane.Normal.z}, plane.Distance,
+                         plane.Normal.x > 0 ? _boxes.m_maxX : _boxes.m_minX,
+                         plane.Normal.y > 0 ? _boxes.m_maxY : _boxes.m_minY,
+                         plane.Normal.z > 0 ? _boxes.m_maxZ : _boxes.m_minZ};
+        }
+    }
+
+    uint32_t cullScalar(const ViewFrustum& _frustum, const Boxes& _boxes, uint8_t _flags, uint32_t _first, uint32_t* _visible)
+    {
+        uint32_t visibleCount = 0;
+        for (uint32_t i = _first; i < _boxes.m_count; ++i)
+        {
+            if ((_boxes.m_flags[i] & _flags) == 0)
+                continue;
+
+            const BoundBox box{float3(_boxes.m_minX[i], _boxes.m_minY[i], _boxes.m_minZ[i]), float3(_boxes.m_maxX[i], _boxes.m_maxY[i], _boxes.m_maxZ[i])};
+            if (GetBoxVisibility(_frustum, box) != BoxVisibility::Invisible)
+            {
+                _visible[visibleCount++] = i;
+            }
+        }
+        return visibleCount;
+    }
+
+    uint32_t cullSSE2(const ViewFrustum& _frustum, const Boxes& _boxes, uint8_t _flags, uint32_t* _visible)
+    {
+        PlaneTest tests[ViewFrustum::NUM_PLANES];
+        getPlaneTests(_frustum, _boxes, tests);
+
+        const __m128i flags = _mm_set1_epi32(_flags);
+        const __m128i zero = _mm_setzero_si128();
+        uint32_t visibleCount = 0;
+        uint32_t i = 0;
+        for (; i + 4 <= _boxes.m_count; i += 4)
+        {
+            int32_t boxFlags;
+            memcpy(&boxFlags, _boxes.m_flags + i, sizeof(boxFlags));
+            const __m128i laneFlags = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(boxFlags), zero), zero);
+            __m128 isVisible = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(laneFlags, flags), zero));
+            isVisible = _mm_xor_ps(isVisible, _mm_castsi128_ps(_mm_cmpeq_epi32(zero, zero)));
+
+            // dot(corner, normal) + distance like Diligent, a NaN distance keeps the box as the scalar test does
+            for (const PlaneTest& test : tests)
+            {
+                __m128 distance = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(test.m_x + i), _mm_set1_ps(test.m_normal[0])),
+                                             _mm_mul_ps(_mm_loadu_ps(test.m_y + i), _mm_set1_ps(test.m_normal[1])));
+                distance = _mm_add_ps(distance, _mm_mul_ps(_mm_loadu_ps(test.m_z + i), _mm_set1_ps(test.m_normal[2])));
+                distance = _mm_add_ps(distance, _mm_set1_ps(test.m_distance));
+                isVisible = _mm_and_ps(isVisible, _mm_cmpnlt_ps(distance, _mm_setzero_ps()));
+            }
+
+            const CompactedLanes& lanes = COMPACTED_LANES[_mm_movemask_ps(isVisible)];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(_visible + visibleCount),
+                             _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lanes.m_lanes)), _mm_set1_epi32(static_cast<int32_t>(i))));
+            visibleCount += lanes.m_count;
+        }
+        return visibleCount + cullScalar(_frustum, _boxes, _flags, i, _visible + visibleCount);
+    }
+
+    TARGET_AVX2 uint32_t cullAVX2(const ViewFrustum& _frustum, const Boxes& _boxes, uint8_t _flags, uint32_t* _visible)
+    {
+        PlaneTest tests[ViewFrustum::NUM_PLANES];
+        getPlaneTests(_frustum, _boxes, tests);
+
+        const __m256i flags = _mm256_set1_epi32(_flags);
+        const __m256i zero = _mm256_setzero_si256();
+        uint32_t visibleCount = 0;
+        uint32_t i = 0;
+        for (; i + 8 <= _boxes.m_count; i += 8)
+        {
+            const __m256i laneFlags = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(_boxes.m_flags + i)));
+            __m256 isVisible = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(laneFlags, flags), zero));
+            isVisible = _mm256_xor_ps(isVisible, _mm256_castsi256_ps(_mm256_cmpeq_epi32(zero, zero)));
+
+            // separate mul and add, an FMA rounds once and would disagree with GetBoxVisibility on the boxes touching a plane
+            for (const PlaneTest& test : tests)
+            {
+                __m256 distance = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(test.m_x + i), _mm256_set1_ps(test.m_normal[0])),
+                                                _mm256_mul_ps(_mm256_loadu_ps(test.m_y + i), _mm256_set1_ps(test.m_normal[1])));
+                distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_loadu_ps(test.m_z + i), _mm256_set1_ps(test.m_normal[2])));
+                distance = _mm256_add_ps(distance, _mm256_set1_ps(test.m_distance));
+                isVisible = _mm256_and_ps(isVisible, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_NLT_UQ));
+            }
+
+            const CompactedLanes& lanes = COMPACTED_LANES[_mm256_movemask_ps(isVisible)];
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(_visible + visibleCount),
+                                _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes.m_lanes)), _mm256_set1_epi32(static_cast<int32_t>(i))));
+            visibleCount += lanes.m_count;
+        }
+        return visibleCount + cullScalar(_frustum, _boxes, _flags, i, _visible + visibleCount);
+    }
+}
+
+EKernel getBestKernel()
+{
+    static const EKernel best = CpuFeatures::hasAVX2() ? EKernel::AVX2 : EKernel::SSE2;
+    return best;
+}
+
+bool isSupported(EKernel _kernel)
+{
+    return _kernel != EKernel::AVX2 || getBestKernel() == EKernel::AVX2;
+}
+
+const char* getName(EKernel _kernel)
+{
+    switch (_kernel)
+    {
+        case EKernel::Scalar: return "scalar";
+        case EKernel::SSE2: return "SSE2";
+        case EKernel::AVX2: return "AVX2";
+    }
+    return "unknown";
+}
+
+void cull(const ViewFrustum& _frustum, const Boxes& _boxes, uint8_t _flags, eastl::vector<uint32_t>& _visible, EKernel _kernel)
+{
+    ZoneScopedN("Frustum Culling");
+
+    // every block is stored whole, the lanes past the visible ones are overwritten by the next block or cut below
+    _visible.resize(_boxes.m_count + MAX_BLOCK_SIZE);
+
+    uint32_t visibleCount = 0;
+    switch (_kernel)
+    {
+        case EKernel::Scalar: visibleCount = cullScalar(_frustum, _boxes, _flags, 0, _visible.data()); break;
+        case EKernel::SSE2: visibleCount = cullSSE2(_frustum, _boxes, _flags, _visible.data()); break;
+        case EKernel::AVX2: visibleCount = cullAVX2(_frustum, _boxes, _flags, _visible.data()); break;
+    }
+    _visible.resize(visibleCount);
+}
+}
@@ -0,0 +1,50 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#ifndef GRAPHICSPLAYGROUND_FRUSTUMCULLING_HPP
+#define GRAPHICSPLAYGROUND_FRUSTUMCULLING_HPP
+
+#include <cstdint>
+
+#include <EASTL/vector.h>
+
+#include "Common/interface/AdvancedMath.hpp"
+
+using namespace Diligent;
+
+// Batched frustum culling of world space AABBs kept as separate arrays of min and max coordinates.
+// The SIMD kernels test 4 or 8 boxes against the 6 planes at once and compact the survivors straight into an index list.
+// A box is kept exactly when GetBoxVisibility doesn't find it Invisible: same corner per plane, same order of the operations, no FMA.
+namespace FrustumCulling
+{
+    enum class EKernel : uint8_t
+    {
+        Scalar = 0, // GetBoxVisibility per box, the reference
+        SSE2,
+        AVX2
+    };
+
+    // The fastest kernel this CPU runs
+    EKernel getBestKernel();
+    bool isSupported(EKernel _kernel);
+    const char* getName(EKernel _kernel);
+
+    // m_count boxes, box i is [m_minX[i], m_maxX[i]] x ... and is only tested if one of its m_flags is asked for
+    struct Boxes
+    {
+        const float* m_minX;
+        const float* m_minY;
+        const float* m_minZ;
+        const float* m_maxX;
+        const float* m_maxY;
+        const float* m_maxZ;
+        const uint8_t* m_flags;
+        uint32_t m_count;
+    };
+
+    // Indices of the boxes with one of _flags that touch the frustum, in increasing order
+    void cull(const ViewFrustum& _frustum, const Boxes& _boxes, uint8_t _flags, eastl::vector<uint32_t>& _visible, EKernel _kernel = getBestKernel());
+}
+
+#endif //GRAPHICSPLAYGROUND_FRUSTUMCULLING_HPP
@@ -0,0 +1,35 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#include "GeometryCodec.hpp"
+
+#include "meshoptimizer.h"
+#include "tracy/Tracy.hpp"
+
+namespace GeometryCodec
+{
+Encoded encode(const void* _vertices, size_t _vertexCount, size_t _vertexSize, const uint32_t* _indices, size_t _indexCount)
+{
+    ZoneScopedN("Encode Geometry");
+    Encoded encoded;
+
+    encoded.m_vertices.resize(meshopt_encodeVertexBufferBound(_vertexCount, _vertexSize));
+    encoded.m_vertices.resize(meshopt_encodeVertexBuffer(encoded.m_vertices.data(), encoded.m_vertices.size(), _vertices, _vertexCount, _vertexSize));
+
+    encoded.m_indices.resize(meshopt_encodeIndexBufferBound(_indexCount, _vertexCount));
+    encoded.m_indices.resize(meshopt_encodeIndexBuffer(encoded.m_indices.data(), encoded.m_indices.size(), _indices, _indexCount));
+
+    return encoded;
+}
+
+bool decode(const uint8_t* _vertices, size_t _verticesSize, size_t _vertexCount, size_t _vertexSize, const uint8_t* _indices, size_t _indicesSize,
+            size_t _indexCount, void* _outVertices, void* _outIndices, size_t _indexSize)
+{
+    ZoneScopedN("Decode Geometry");
+    // no need to split the work any further than one group per job
+    const int vertexResult = meshopt_decodeVertexBuffer(_outVertices, _vertexCount, _vertexSize, _vertices, _verticesSize);
+    const int indexResult = meshopt_decodeIndexBuffer(_outIndices, _indexCount, _indexSize, _indices, _indicesSize);
+    return vertexResult == 0 && indexResult == 0;
+}
+}
@@ -0,0 +1,32 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#ifndef GRAPHICSPLAYGROUND_GEOMETRYCODEC_HPP
+#define GRAPHICSPLAYGROUND_GEOMETRYCODEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include <EASTL/vector.h>
+
+// Lossless meshoptimizer codec of the cooked vertices and indices. It works best on geometry that went through
+// meshopt_optimizeVertexCache and meshopt_optimizeVertexFetch, the decoders use SSE/NEON when available.
+namespace GeometryCodec
+{
+    struct Encoded
+    {
+        eastl::vector<uint8_t> m_vertices;
+        eastl::vector<uint8_t> m_indices;
+    };
+
+    // _vertexSize is a multiple of 4 up to 256 bytes, _indexCount a multiple of 3
+    Encoded encode(const void* _vertices, size_t _vertexCount, size_t _vertexSize, const uint32_t* _indices, size_t _indexCount);
+
+    // The encoded indices don't depend on their width, _indexSize (2 or 4) is the one they're decoded to.
+    // False when the data is corrupted or doesn't hold that many vertices or indices.
+    bool decode(const uint8_t* _vertices, size_t _verticesSize, size_t _vertexCount, size_t _vertexSize, const uint8_t* _indices, size_t _indicesSize,
+                size_t _indexCount, void* _outVertices, void* _outIndices, size_t _indexSize);
+}
+
+#endif //GRAPHICSPLAYGROUND_GEOMETRYCODEC_HPP
@@ -0,0 +1,172 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#include "ImportTelemetry.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+
+#include <EASTL/map.h>
+#include <EASTL/vector.h>
+
+#include "JobSystem.hpp"
+#include "tracy/Tracy.hpp"
+
+namespace ImportTelemetry
+{
+namespace
+{
+    // Tracy keys the plots by pointer, they have to be literals
+    constexpr const char* PLOT_NAMES[] = {"Import ms: file read", "Import ms: assimp read", "Import ms: remap", "Import ms: vertex cache",
+                                          "Import ms: overdraw", "Import ms: meshlets", "Import ms: LODs", "Import ms: occluder",
+                                          "Import ms: quantization",
+                                          "Import ms: texture decode", "Import ms: flatbuffer build", "Import ms: decode", "Import ms: GPU upload"};
+    static_assert(std::size(PLOT_NAMES) == static_cast<size_t>(EStage::Count), "One plot per stage");
+
+    struct State
+    {
+        std::mutex m_mutex;
+        eastl::map<eastl::string, eastl::vector<Record>> m_assets; // sorted so the dumps diff nicely
+    };
+
+    // at static init, before any record can start
+    const std::chrono::steady_clock::time_point PROCESS_START = std::chrono::steady_clock::now();
+
+    State& getState()
+    {
+        static State state;
+        return state;
+    }
+
+    float toMs(std::chrono::steady_clock::duration _duration)
+    {
+        return std::chrono::duration<float, std::milli>(_duration).count();
+    }
+}
+
+const char* getName(EStage _stage)
+{
+    switch (_stage)
+    {
+        case EStage::FileRead: return "file read";
+        case EStage::AssimpRead: return "assimp read";
+        case EStage::Remap: return "remap";
+        case EStage::VertexCache: return "vertex cache";
+        case EStage::Overdraw: return "overdraw";
+        case EStage::Meshlets: return "meshlets";
+        case EStage::Lods: return "LODs";
+        case EStage::Occluder: return "occluder";
+        case EStage::Quantization: return "quantization";
+        case EStage::TextureDecode: return "texture decode";
+        case EStage::FlatbufferBuild: return "flatbuffer build";
+        case EStage::Decode: return "decode";
+        case EStage::GpuUpload: return "GPU upload";
+        case EStage::Count: break;
+    }
+    return "unknown";
+}
+
+void record(const eastl::string& _asset, EStage _stage, std::chrono::steady_clock::time_point _start, uint64_t _bytesIn, uint64_t _bytesOut)
+{
+    State& state = getState();
+
+    Record record;
+    record.m_stage = _stage;
+    record.m_thread = JobSystem::get().getExecutor().this_worker_id();
+    record.m_startMs = toMs(_start - PROCESS_START);
+    record.m_timeMs = toMs(std::chrono::steady_clock::now() - _start);
+    record.m_bytesIn = _bytesIn;
+    record.m_bytesOut = _bytesOut;
+
+    TracyPlot(PLOT_NAMES[static_cast<size_t>(_stage)], record.m_timeMs);
+
+    std::scoped_lock lock(state.m_mutex);
+    state.m_assets[_asset].push_back(record);
+}
+
+bool dumpJson(const char* _path)
+{
+    ZoneScopedN("Dump Import Telemetry");
+    State& state = getState();
+    std::scoped_lock lock(state.m_mutex);
+
+    std::ofstream file(_path);
+    if (!file.good())
+    {
+        std::cout << "Could not write the import telemetry to " << _path << std::endl;
+        return false;
+    }
+
+    // asset names are paths, only the windows separators need escaping
+    auto writeString = [&file](const eastl::string& _string)
+    {
+        file << '"';
+        for (char c : _string)
+        {
+            if (c == '"' || c == '\\')
+                file << '\\';
+            file << c;
+        }
+        file << '"';
+    };
+
+    file << "{\n  \"assets\": [";
+    bool isFirstAsset = true;
+    for (const auto& [asset, records] : state.m_assets)
+    {
+        struct Total
+        {
+            uint32_t m_count = 0;
+            float m_timeMs = 0.0f;
+            uint64_t m_bytesIn = 0;
+            uint64_t m_bytesOut = 0;
+        };
+        Total totals[static_cast<size_t>(EStage::Count)];
+        float assetTimeMs = 0.0f;
+        for (const Record& record : records)
+        {
+            Total& total = totals[static_cast<size_t>(record.m_stage)];
+            total.m_count++;
+            total.m_timeMs += record.m_timeMs;
+            total.m_bytesIn += record.m_bytesIn;
+            total.m_bytesOut += record.m_bytesOut;
+            assetTimeMs += record.m_timeMs;
+        }
+
+        file << (isFirstAsset ? "\n" : ",\n") << "    {\n      \"asset\": ";
+        writeString(asset);
+        file << ",\n      \"timeMs\": " << assetTimeMs << ",\n      \"stages\": [";
+        isFirstAsset = false;
+
+        bool isFirst = true;
+        for (size_t stage = 0; stage < static_cast<size_t>(EStage::Count); ++stage)
+        {
+            const Total& total = totals[stage];
+            if (total.m_count == 0)
+                continue;
+
+            file << (isFirst ? "\n" : ",\n") << "        {\"stage\": \"" << getName(static_cast<EStage>(stage)) << "\", \"count\": " << total.m_count
+                 << ", \"timeMs\": " << total.m_timeMs << ", \"bytesIn\": " << total.m_bytesIn << ", \"bytesOut\": " << total.m_bytesOut << "}";
+            isFirst = false;
+        }
+
+        file << "\n      ],\n      \"records\": [";
+        isFirst = true;
+        for (const Record& record : records)
+        {
+            file << (isFirst ? "\n" : ",\n") << "        {\"stage\": \"" << getName(record.m_stage) << "\", \"thread\": " << record.m_thread
+                 << ", \"startMs\": " << record.m_startMs << ", \"timeMs\": " << record.m_timeMs << ", \"bytesIn\": " << record.m_bytesIn
+                 << ", \"bytesOut\": " << record.m_bytesOut << "}";
+            isFirst = false;
+        }
+        file << "\n      ]\n    }";
+    }
+    file << "\n  ]\n}\n";
+
+    std::cout << "Import telemetry of " << state.m_assets.size() << " assets written to " << _path << std::endl;
+    return file.good();
+}
+}
@@ -0,0 +1,79 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#ifndef GRAPHICSPLAYGROUND_IMPORTTELEMETRY_HPP
+#define GRAPHICSPLAYGROUND_IMPORTTELEMETRY_HPP
+
+#include <chrono>
+#include <cstdint>
+
+#include <EASTL/string.h>
+
+// Time and bytes of every stage a mesh goes through from its file to the GPU, kept per asset.
+// Dumped as JSON once the scene is loaded (or by AssetCooker once everything is cooked) and plotted in Tracy as they come,
+// to see where the startup goes without having a profiler attached.
+namespace ImportTelemetry
+{
+    enum class EStage : uint8_t
+    {
+        FileRead = 0, // the cooked .mesh or the source file
+        AssimpRead, // Importer::ReadFile and its post processing
+        Remap,
+        VertexCache,
+        Overdraw,
+        Meshlets,
+        Lods,
+        Occluder,
+        Quantization,
+        TextureDecode,
+        FlatbufferBuild, // the sections of the .mesh and their compression
+        Decode, // a cooked .mesh back into groups
+        GpuUpload,
+        Count
+    };
+
+    const char* getName(EStage _stage);
+
+    struct Record
+    {
+        EStage m_stage;
+        int32_t m_thread; // job system worker, -1 for the other threads
+        float m_startMs; // since the start of the process
+        float m_timeMs;
+        uint64_t m_bytesIn;
+        uint64_t m_bytesOut;
+    };
+
+    // Thread safe
+    void record(const eastl::string& _asset, EStage _stage, std::chrono::steady_clock::time_point _start, uint64_t _bytesIn, uint64_t _bytesOut);
+
+    // Records the stage when it goes out of scope, the output is often only known at the end
+    class Scope
+    {
+    public:
+        Scope(const eastl::string& _asset, EStage _stage, uint64_t _bytesIn = 0)
+            : m_asset(_asset), m_start(std::chrono::steady_clock::now()), m_bytesIn(_bytesIn), m_stage(_stage)
+        {
+        }
+        ~Scope() { record(m_asset, m_stage, m_start, m_bytesIn, m_bytesOut); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        void setBytesIn(uint64_t _bytes) { m_bytesIn = _bytes; }
+        void setBytesOut(uint64_t _bytes) { m_bytesOut = _bytes; }
+
+    private:
+        const eastl::string& m_asset;
+        std::chrono::steady_clock::time_point m_start;
+        uint64_t m_bytesIn = 0;
+        uint64_t m_bytesOut = 0;
+        EStage m_stage;
+    };
+
+    // Every record so far, grouped by asset with the totals per stage, false if the file can't be written
+    bool dumpJson(const char* _path);
+}
+
+#endif //GRAPHICSPLAYGROUND_IMPORTTELEMETRY_HPP
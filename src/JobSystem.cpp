@@ -0,0 +1,180 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#include "tracy/Tracy.hpp"
+
+JobSystem& JobSystem::get()
+{
+    static JobSystem jobSystem;
+    return jobSystem;
+}
+
+JobSystem::JobSystem() : m_executor(std::max(1u, std::thread::hardware_concurrency()))
+{
+    const uint32_t workers = static_cast<uint32_t>(m_executor.num_workers());
+
+    for (auto& running : m_running)
+    {
+        running = 0;
+    }
+
+    m_caps[static_cast<size_t>(ESubsystem::Engine)] = workers;
+    // Leave room for the texture decoding spawned by the meshes themselves
+    m_caps[static_cast<size_t>(ESubsystem::Mesh)] = std::max(1u, workers / 2);
+    m_caps[static_cast<size_t>(ESubsystem::Texture)] = workers;
+    // Only creates resources on the device, more would just contend on it
+    m_caps[static_cast<size_t>(ESubsystem::RayTracing)] = 1;
+}
+
+void JobSystem::submit(ESubsystem _subsystem, EPriority _priority, std::function<void()> _job, Counter* _counter)
+{
+    if (_counter)
+    {
+        _counter->m_pending.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    {
+        std::scoped_lock lock(m_mutex);
+        m_queues[static_cast<size_t>(_priority)].push_back({eastl::move(_job), _subsystem, _counter});
+    }
+
+    schedule();
+}
+
+void JobSystem::parallelFor(ESubsystem _subsystem, EPriority _priority, uint32_t _count, uint32_t _grain,
+                            const std::function<void(uint32_t _begin, uint32_t _end)>& _func)
+{
+    // a few ranges per worker so one slow range doesn't hold everything
+    const uint32_t rangeSize = std::max(std::max(1u, _grain), _count / static_cast<uint32_t>(getWorkerCount() * 4));
+    if (rangeSize >= _count)
+    {
+        _func(0, _count);
+        return;
+    }
+
+    Counter counter;
+    for (uint32_t begin = 0; begin < _count; begin += rangeSize)
+    {
+        const uint32_t end = std::min(begin + rangeSize, _count);
+        submit(_subsystem, _priority, [&_func, begin, end]() { _func(begin, end); }, &counter);
+    }
+
+    wait(counter);
+}
+
+void JobSystem::wait(Counter& _counter)
+{
+    ZoneScopedN("JobSystem - Wait");
+    while (!_counter.isDone())
+    {
+        Job job;
+        bool hasJob;
+        {
+            std::scoped_lock lock(m_mutex);
+            // caps are ignored, a waiting worker already holds a slot so running a job inline doesn't add concurrency.
+            // Respecting them here would deadlock when every slot of a subsystem waits on jobs of the same subsystem.
+            hasJob = popNextJob(job, true);
+        }
+
+        if (hasJob)
+        {
+            execute(job);
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::run(tf::Taskflow& _taskflow)
+{
+    ZoneScopedN("JobSystem - Run Graph");
+    if (m_executor.this_worker_id() >= 0)
+    {
+        m_executor.corun(_taskflow);
+    }
+    else
+    {
+        m_executor.run(_taskflow).wait();
+    }
+}
+
+void JobSystem::setConcurrencyCap(ESubsystem _subsystem, uint32_t _cap)
+{
+    {
+        std::scoped_lock lock(m_mutex);
+        m_caps[static_cast<size_t>(_subsystem)] = std::max(1u, _cap);
+    }
+
+    schedule();
+}
+
+bool JobSystem::popNextJob(Job& _job, bool _ignoreCaps)
+{
+    for (auto& queue : m_queues)
+    {
+        for (auto it = queue.begin(); it != queue.end(); ++it)
+        {
+            const auto subsystem = static_cast<size_t>(it->m_subsystem);
+            if (_ignoreCaps || m_running[subsystem] < m_caps[subsystem])
+            {
+                _job = eastl::move(*it);
+                queue.erase(it);
+                ++m_running[subsystem];
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void JobSystem::schedule()
+{
+    std::scoped_lock lock(m_mutex);
+
+    while (m_inFlight < m_executor.num_workers())
+    {
+        Job job;
+        if (!popNextJob(job))
+            break;
+
+        ++m_inFlight;
+        m_executor.silent_async([this, job = eastl::move(job)]() mutable
+        {
+            execute(job);
+            {
+                std::scoped_lock lock(m_mutex);
+                --m_inFlight;
+            }
+            schedule();
+        });
+    }
+}
+
+void JobSystem::execute(Job& _job)
+{
+    {
+        ZoneScopedN("Job");
+        ZoneText(getName(_job.m_subsystem), strlen(getName(_job.m_subsystem)));
+        _job.m_func();
+    }
+
+    // the subsystem slot is given back before signaling, waiters can then pick the next job right away
+    --m_running[static_cast<size_t>(_job.m_subsystem)];
+
+    if (_job.m_counter)
+    {
+        _job.m_counter->m_pending.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    schedule();
+}
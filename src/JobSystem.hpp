@@ -0,0 +1,118 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#ifndef GRAPHICSPLAYGROUND_JOBSYSTEM_HPP
+#define GRAPHICSPLAYGROUND_JOBSYSTEM_HPP
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+#include <EASTL/array.h>
+#include <EASTL/deque.h>
+
+#include "taskflow/taskflow.hpp"
+
+// One worker pool for the whole engine, everything (mesh import, texture decoding, raytracing setup...) goes through it.
+// Jobs are kept in our own priority queues and only handed to the executor when a worker is free,
+// this way priorities and the per subsystem caps are respected.
+class JobSystem
+{
+public:
+    enum class EPriority
+    {
+        High = 0,
+        Normal,
+        Low,
+        Max
+    };
+
+    enum class ESubsystem
+    {
+        Engine = 0,
+        Mesh,
+        Texture,
+        RayTracing,
+        Max
+    };
+
+    // Tracks a batch of jobs, wait on it with JobSystem::wait
+    class Counter
+    {
+    public:
+        [[nodiscard]] bool isDone() const { return m_pending.load(std::memory_order_acquire) == 0; }
+
+    private:
+        friend class JobSystem;
+        std::atomic<uint32_t> m_pending = 0;
+    };
+
+    static JobSystem& get();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    void submit(ESubsystem _subsystem, EPriority _priority, std::function<void()> _job, Counter* _counter = nullptr);
+
+    // Splits [0, _count) in ranges of at least _grain items, runs them on the workers and returns once they're all done.
+    // Fine to call from a worker, it helps while waiting.
+    void parallelFor(ESubsystem _subsystem, EPriority _priority, uint32_t _count, uint32_t _grain,
+                     const std::function<void(uint32_t _begin, uint32_t _end)>& _func);
+
+    // Runs pending jobs on the calling thread while waiting, so it is fine to call it from a worker
+    void wait(Counter& _counter);
+
+    void setConcurrencyCap(ESubsystem _subsystem, uint32_t _cap);
+    [[nodiscard]] uint32_t getConcurrencyCap(ESubsystem _subsystem) const { return m_caps[static_cast<size_t>(_subsystem)]; }
+    [[nodiscard]] uint32_t getRunningCount(ESubsystem _subsystem) const { return m_running[static_cast<size_t>(_subsystem)]; }
+
+    [[nodiscard]] size_t getWorkerCount() const { return m_executor.num_workers(); }
+
+    // Runs a taskflow graph on the shared workers and returns once it's done.
+    // From a worker the graph is co-run so the calling worker keeps executing tasks instead of blocking.
+    void run(tf::Taskflow& _taskflow);
+
+    // For taskflow graphs, they share the same workers as the jobs
+    tf::Executor& getExecutor() { return m_executor; }
+
+    static const char* getName(ESubsystem _subsystem)
+    {
+        switch (_subsystem)
+        {
+            case ESubsystem::Engine: return "Engine";
+            case ESubsystem::Mesh: return "Mesh";
+            case ESubsystem::Texture: return "Texture";
+            case ESubsystem::RayTracing: return "RayTracing";
+            case ESubsystem::Max: return "";
+        }
+
+        return "";
+    }
+
+private:
+    JobSystem();
+
+    struct Job
+    {
+        std::function<void()> m_func;
+        ESubsystem m_subsystem;
+        Counter* m_counter;
+    };
+
+    tf::Executor m_executor;
+
+    std::mutex m_mutex;
+    eastl::array<eastl::deque<Job>, static_cast<size_t>(EPriority::Max)> m_queues;
+    eastl::array<uint32_t, static_cast<size_t>(ESubsystem::Max)> m_caps;
+    eastl::array<std::atomic<uint32_t>, static_cast<size_t>(ESubsystem::Max)> m_running;
+    uint32_t m_inFlight = 0; // jobs handed to the executor
+
+    // needs m_mutex locked
+    bool popNextJob(Job& _job, bool _ignoreCaps = false);
+
+    void schedule();
+    void execute(Job& _job);
+};
+
+#endif //GRAPHICSPLAYGROUND_JOBSYSTEM_HPP
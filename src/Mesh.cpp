@@ -2,202 +2,1519 @@
 // Created by FanyMontpell on 03/09/2021.
 //
 #define FORCE_LOADING_FROM_DISK 0
+// 1 maps the cooked .mesh and uploads from the mapping, 0 reads the whole file in memory first.
+// Only the default, AssetCooker --benchmark-load switches it at runtime to compare both (see Mesh::setLoadMode)
+#define USE_MAPPED_MESH_LOADING 1
+// 1 saves the .mesh as zstd compressed sections (see MeshContainer), 0 as a raw flatbuffer. Both can be loaded.
+// Only the default, see Mesh::CookSettings
+#define USE_COMPRESSED_MESH_CONTAINER 1
+#define MESH_COMPRESSION_LEVEL 9
+// 1 stores the vertices and indices encoded with the meshoptimizer codec, 0 raw. Both can be loaded.
+// Only the default, see Mesh::CookSettings
+#define USE_MESHOPT_GEOMETRY_CODEC 1
+// 1 cooks the albedo as BC7 (twice the size of BC1 but way better quality), 0 as BC1 or BC3 when it has transparency.
+// Only the default, see Mesh::CookSettings
+#define USE_BC7_FOR_ALBEDO 0
 
 #define WIN32_LEAN_AND_MEAN
 #define NOMINMAX
 
 #include "Mesh.h"
-#include "imgui.h"
 #include "meshoptimizer.h"
 #include "assimp/DefaultLogger.hpp"
 #include "tracy/Tracy.hpp"
+#if !defined(HEADLESS_COOKER)
+#include "imgui.h"
 #include "Engine.h"
+#endif
+#include "JobSystem.hpp"
 #include "assimp/ProgressHandler.hpp"
+#include <algorithm>
 #include <fstream>
 #include <assimp/Importer.hpp>
+#include <assimp/DefaultIOSystem.h>
 #include <assimp/postprocess.h>
 #include <stb/stb_image.h>
 #include <filesystem>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <EASTL/algorithm.h>
+#include <EASTL/map.h>
 #include "Common/interface/BasicMath.hpp"
 #include "../bin/flatbuffers/generated/mesh_generated.h"
+#include "util/MappedFile.hpp"
+#include "util/ProcessMemory.hpp"
+#include "TextureCompression.hpp"
+#include "TextureMips.hpp"
+#include "ImportTelemetry.hpp"
+#include "MeshContainer.hpp"
+#include "SceneArchive.hpp"
+#include "VertexQuantization.hpp"
+#include "GeometryCodec.hpp"
+
+
+using namespace Diligent;
+
+namespace
+{
+    Mesh::ELoadMode loadMode = USE_MAPPED_MESH_LOADING == 1 ? Mesh::ELoadMode::Mapped : Mesh::ELoadMode::Read;
+    Mesh::CookSettings cookSettings = {USE_COMPRESSED_MESH_CONTAINER == 1, MESH_COMPRESSION_LEVEL, USE_MESHOPT_GEOMETRY_CODEC == 1, USE_BC7_FOR_ALBEDO == 1,
+                                       EVertexLayout::Half};
+
+    Mesh::ETextureType getTextureTypeFromPath(const eastl::string& _path)
+    {
+        if(_path.find("_N") != eastl::string::npos)
+            return Mesh::ETextureType::Normal;
+        if(_path.find("_R") != eastl::string::npos)
+            return Mesh::ETextureType::Roughness;
+        return Mesh::ETextureType::Albedo;
+    }
+
+    Mesh::ETextureType getTextureType(aiTextureType _type, const eastl::string& _path)
+    {
+        switch (_type)
+        {
+            case aiTextureType_NORMALS:
+            case aiTextureType_NORMAL_CAMERA:
+                return Mesh::ETextureType::Normal;
+            case aiTextureType_SHININESS:
+            case aiTextureType_DIFFUSE_ROUGHNESS:
+                return Mesh::ETextureType::Roughness;
+            default:
+                return getTextureTypeFromPath(_path);
+        }
+    }
+
+    TEXTURE_FORMAT toTextureFormat(FlatBuffers::TextureFormat _format)
+    {
+        switch (_format)
+        {
+            case FlatBuffers::TextureFormat_RGBA8: return TEX_FORMAT_RGBA8_UNORM;
+            case FlatBuffers::TextureFormat_RGBA8_SRGB: return TEX_FORMAT_RGBA8_UNORM_SRGB;
+            case FlatBuffers::TextureFormat_R8: return TEX_FORMAT_R8_UNORM;
+            case FlatBuffers::TextureFormat_BC1: return TEX_FORMAT_BC1_UNORM;
+            case FlatBuffers::TextureFormat_BC1_SRGB: return TEX_FORMAT_BC1_UNORM_SRGB;
+            case FlatBuffers::TextureFormat_BC3: return TEX_FORMAT_BC3_UNORM;
+            case FlatBuffers::TextureFormat_BC3_SRGB: return TEX_FORMAT_BC3_UNORM_SRGB;
+            case FlatBuffers::TextureFormat_BC4: return TEX_FORMAT_BC4_UNORM;
+            case FlatBuffers::TextureFormat_BC5: return TEX_FORMAT_BC5_UNORM;
+            case FlatBuffers::TextureFormat_BC7: return TEX_FORMAT_BC7_UNORM;
+            case FlatBuffers::TextureFormat_BC7_SRGB: return TEX_FORMAT_BC7_UNORM_SRGB;
+        }
+
+        return TEX_FORMAT_UNKNOWN;
+    }
+
+    // Bytes between two rows of pixels, or of blocks for compressed formats
+    Uint64 getRowStride(TEXTURE_FORMAT _format, Uint32 _width)
+    {
+        const auto& attribs = GetTextureFormatAttribs(_format);
+        if(attribs.ComponentType == COMPONENT_TYPE_COMPRESSED)
+            return static_cast<Uint64>((_width + attribs.BlockWidth - 1) / attribs.BlockWidth) * attribs.ComponentSize;
+
+        return static_cast<Uint64>(_width) * attribs.ComponentSize * attribs.NumComponents;
+    }
+
+    Uint64 getLevelSize(TEXTURE_FORMAT _format, Uint32 _width, Uint32 _height)
+    {
+        const auto& attribs = GetTextureFormatAttribs(_format);
+        const Uint32 rows = attribs.ComponentType == COMPONENT_TYPE_COMPRESSED ? (_height + attribs.BlockHeight - 1) / attribs.BlockHeight : _height;
+        return getRowStride(_format, _width) * rows;
+    }
+
+    TextureMips::EFilter getMipFilter(Mesh::ETextureType _type)
+    {
+        switch (_type)
+        {
+            case Mesh::ETextureType::Albedo: return TextureMips::EFilter::SRGB; // gamma encoded even when not sampled as SRGB
+            case Mesh::ETextureType::Normal: return TextureMips::EFilter::Normal;
+            case Mesh::ETextureType::Roughness: return TextureMips::EFilter::Linear;
+        }
+
+        return TextureMips::EFilter::Linear;
+    }
+
+    struct CookedTexture
+    {
+        eastl::vector<uint8_t> m_data; // every level back to back, biggest first
+        FlatBuffers::TextureFormat m_format;
+        uint32_t m_mipCount;
+    };
+
+    CookedTexture cookTexture(const TextureCache::Entry& _entry, Mesh::ETextureType _type, const char* _name)
+    {
+        ZoneScopedN("Cook Texture");
+        ZoneText(_name, strlen(_name));
+
+        const uint8_t* pixels = _entry.m_pixels;
+        const size_t pixelCount = static_cast<size_t>(_entry.m_width) * _entry.m_height;
+        const bool isSRGB = _entry.m_format == TEX_FORMAT_RGBA8_UNORM_SRGB;
+
+        eastl::vector<uint8_t> mipChain;
+        const eastl::vector<TextureMips::Level> levels = TextureMips::generate(getMipFilter(_type), pixels, _entry.m_width, _entry.m_height, mipChain);
+
+        CookedTexture cooked;
+        cooked.m_mipCount = static_cast<uint32_t>(levels.size());
+
+        if(!TextureCompression::canCompress(_entry.m_width, _entry.m_height))
+        {
+            const bool isSingleChannel = _type == Mesh::ETextureType::Roughness;
+            cooked.m_format = isSingleChannel ? FlatBuffers::TextureFormat_R8 : isSRGB ? FlatBuffers::TextureFormat_RGBA8_SRGB : FlatBuffers::TextureFormat_RGBA8;
+
+            for(const TextureMips::Level& level : levels)
+            {
+                const size_t levelPixelCount = static_cast<size_t>(level.m_width) * level.m_height;
+                if(isSingleChannel)
+                {
+                    for(size_t i = 0; i < levelPixelCount; ++i)
+                    {
+                        cooked.m_data.push_back(level.m_pixels[i * 4]);
+                    }
+                }
+                else
+                {
+                    cooked.m_data.insert(cooked.m_data.end(), level.m_pixels, level.m_pixels + levelPixelCount * 4);
+                }
+            }
+
+            return cooked;
+        }
+
+        TextureCompression::EFormat format;
+        switch (_type)
+        {
+            case Mesh::ETextureType::Albedo:
+                if(cookSettings.m_isAlbedoBC7)
+                {
+                    format = TextureCompression::EFormat::BC7;
+                    cooked.m_format = isSRGB ? FlatBuffers::TextureFormat_BC7_SRGB : FlatBuffers::TextureFormat_BC7;
+                }
+                else if(TextureCompression::isOpaque(pixels, pixelCount))
+                {
+                    format = TextureCompression::EFormat::BC1;
+                    cooked.m_format = isSRGB ? FlatBuffers::TextureFormat_BC1_SRGB : FlatBuffers::TextureFormat_BC1;
+                }
+                else
+                {
+                    format = TextureCompression::EFormat::BC3;
+                    cooked.m_format = isSRGB ? FlatBuffers::TextureFormat_BC3_SRGB : FlatBuffers::TextureFormat_BC3;
+                }
+                break;
+            case Mesh::ETextureType::Normal:
+                format = TextureCompression::EFormat::BC5;
+                cooked.m_format = FlatBuffers::TextureFormat_BC5;
+                break;
+            case Mesh::ETextureType::Roughness:
+                format = TextureCompression::EFormat::BC4;
+                cooked.m_format = FlatBuffers::TextureFormat_BC4;
+                break;
+        }
+
+        size_t compressedSize = 0;
+        for(const TextureMips::Level& level : levels)
+        {
+            compressedSize += TextureCompression::getCompressedSize(format, level.m_width, level.m_height);
+        }
+        cooked.m_data.resize(compressedSize);
+
+        // the small levels are partial blocks, the compressor repeats their border
+        uint8_t* blocks = cooked.m_data.data();
+        for(const TextureMips::Level& level : levels)
+        {
+            TextureCompression::compress(format, level.m_pixels, level.m_width, level.m_height, blocks);
+            blocks += TextureCompression::getCompressedSize(format, level.m_width, level.m_height);
+        }
+
+        // only the regressions are reported, AssetCooker --test-textures measures the quality
+        const float psnr = TextureCompression::computePSNR(format, pixels, cooked.m_data.data(), _entry.m_width, _entry.m_height);
+        if(psnr < TextureCompression::MIN_PSNR)
+        {
+            std::cout << "Warning: " << _name << " lost a lot of quality when compressed to " << TextureCompression::getName(format) << " (PSNR " << psnr << "dB)" << std::endl;
+        }
+
+        return cooked;
+    }
+
+    static_assert(sizeof(Mesh::Meshlet) == sizeof(FlatBuffers::Meshlet), "Mesh::Meshlet and FlatBuffers::Meshlet must match");
+    static_assert(sizeof(Mesh::Lod) == sizeof(FlatBuffers::Lod), "Mesh::Lod and FlatBuffers::Lod must match");
+    static_assert(sizeof(float3) == sizeof(FlatBuffers::Vec3), "float3 and FlatBuffers::Vec3 must match");
+
+    // Every LOD targets LOD_REDUCTION of the triangles of the previous one while its error stays under its target
+    // (relative to the group extents), tweak them to trade quality for triangles.
+    constexpr float LOD_TARGET_ERRORS[Mesh::LOD_MAX_COUNT - 1] = {0.005f, 0.01f, 0.02f, 0.05f};
+    constexpr float LOD_REDUCTION = 0.5f;
+    // a LOD keeping more than this of the previous one isn't worth it, the sloppy simplifier is tried then
+    constexpr float LOD_MIN_REDUCTION = 0.85f;
+    constexpr size_t LOD_MIN_INDEX_COUNT = 3 * 32;
+
+    // Splits the group in meshlets, the index buffer is rewritten in meshlet order so every meshlet is a contiguous range of it
+    // and the same buffer is still drawn
+    void buildMeshlets(Mesh::Group& _group, const float* _positions, size_t _vertexCount, size_t _stride)
+    {
+        const size_t indexCount = _group.m_indices.size();
+        const size_t maxMeshlets = meshopt_buildMeshletsBound(indexCount, Mesh::MESHLET_MAX_VERTICES, Mesh::MESHLET_MAX_TRIANGLES);
+        eastl::vector<meshopt_Meshlet> clusters(maxMeshlets);
+        eastl::vector<unsigned int> clusterVertices(maxMeshlets * Mesh::MESHLET_MAX_VERTICES);
+        eastl::vector<unsigned char> clusterTriangles(maxMeshlets * Mesh::MESHLET_MAX_TRIANGLES * 3);
+        const size_t clusterCount = meshopt_buildMeshlets(clusters.data(), clusterVertices.data(), clusterTriangles.data(), _group.m_indices.data(), indexCount,
+                                                          _positions, _vertexCount, _stride, Mesh::MESHLET_MAX_VERTICES, Mesh::MESHLET_MAX_TRIANGLES, 0.25f);
+
+        eastl::vector<uint32_t> indices;
+        indices.reserve(indexCount);
+        _group.m_meshlets.clear();
+        _group.m_meshlets.reserve(clusterCount);
+        for(size_t i = 0; i < clusterCount; ++i)
+        {
+            const meshopt_Meshlet& cluster = clusters[i];
+            const meshopt_Bounds bounds = meshopt_computeMeshletBounds(&clusterVertices[cluster.vertex_offset], &clusterTriangles[cluster.triangle_offset],
+                                                                       cluster.triangle_count, _positions, _vertexCount, _stride);
+
+            Mesh::Meshlet meshlet{};
+            meshlet.m_center = float3(bounds.center[0], bounds.center[1], bounds.center[2]);
+            meshlet.m_radius = bounds.radius;
+            meshlet.m_coneApex = float3(bounds.cone_apex[0], bounds.cone_apex[1], bounds.cone_apex[2]);
+            meshlet.m_coneAxis = float3(bounds.cone_axis[0], bounds.cone_axis[1], bounds.cone_axis[2]);
+            meshlet.m_coneCutoff = bounds.cone_cutoff;
+            meshlet.m_firstIndex = static_cast<uint32_t>(indices.size());
+            meshlet.m_indexCount = cluster.triangle_count * 3;
+            _group.m_meshlets.push_back(meshlet);
+
+            for(uint32_t j = 0; j < cluster.triangle_count * 3; ++j)
+            {
+                indices.push_back(clusterVertices[cluster.vertex_offset + clusterTriangles[cluster.triangle_offset + j]]);
+            }
+        }
+        _group.m_indices = eastl::move(indices);
+    }
+
+    // Appends the coarser LODs after the full detail, which must be the only thing in the index buffer
+    void buildLods(Mesh::Group& _group, const float* _positions, size_t _vertexCount, size_t _stride)
+    {
+        const float errorScale = meshopt_simplifyScale(_positions, _vertexCount, _stride);
+
+        _group.m_lods.clear();
+        _group.m_lods.push_back({0, static_cast<uint32_t>(_group.m_indices.size()), 0.0f});
+
+        // every LOD is simplified from the previous one, cheaper than starting again from the full detail
+        eastl::vector<uint32_t> previous = _group.m_indices;
+        float error = 0.0f;
+        for(size_t level = 1; level < Mesh::LOD_MAX_COUNT; ++level)
+        {
+            const size_t targetCount = static_cast<size_t>(previous.size() * LOD_REDUCTION) / 3 * 3;
+            if(targetCount < LOD_MIN_INDEX_COUNT)
+                break;
+
+            const float targetError = LOD_TARGET_ERRORS[level - 1];
+            eastl::vector<uint32_t> lod(previous.size());
+            float lodError = 0.0f;
+            size_t count = meshopt_simplify(lod.data(), previous.data(), previous.size(), _positions, _vertexCount, _stride,
+                                            targetCount, targetError, 0, &lodError);
+
+            // seams and borders can stop the simplifier early, the sloppy one ignores the topology
+            if(count > previous.size() * LOD_MIN_REDUCTION)
+            {
+                count = meshopt_simplifySloppy(lod.data(), previous.data(), previous.size(), _positions, _vertexCount, _stride,
+                                               targetCount, targetError, &lodError);
+            }
+
+            if(count == 0 || count > previous.size() * LOD_MIN_REDUCTION)
+                break;
+
+            lod.resize(count);
+            meshopt_optimizeVertexCache(lod.data(), lod.data(), count, _vertexCount);
+
+            // errors are relative to the previous LOD, summing them keeps it conservative
+            error += lodError * errorScale;
+            _group.m_lods.push_back({static_cast<uint32_t>(_group.m_indices.size()), static_cast<uint32_t>(count), error});
+            _group.m_indices.insert(_group.m_indices.end(), lod.begin(), lod.end());
+            previous = eastl::move(lod);
+        }
+    }
+
+    // An occluder is only drawn by the software occlusion culling, a few of them every frame. Their error is relative to the size of the group
+    constexpr size_t OCCLUDER_MAX_TRIANGLES = 512;
+    constexpr float OCCLUDER_MAX_ERROR = 0.01f;
+
+    // A coarse copy of the group from its raytracing streams, with only the vertices it still uses. At cook time, the load only reads it
+    void buildOccluder(Mesh::Group& _group)
+    {
+        _group.m_occluderVertices.clear();
+        _group.m_occluderIndices.clear();
+
+        const eastl::vector<float3>& positions = _group.m_verticesPosRaytrace;
+        eastl::vector<uint32_t> indices = _group.m_indicesRaytrace;
+        if(indices.empty())
+            return;
+
+        if(indices.size() > OCCLUDER_MAX_TRIANGLES * 3)
+        {
+            // the sloppy simplifier would fit any budget but can bulge out of the group, it would then hide what is behind its edges
+            eastl::vector<uint32_t> simplified(indices.size());
+            const size_t count = meshopt_simplify(simplified.data(), indices.data(), indices.size(), &positions[0].x, positions.size(), sizeof(float3),
+                                                  OCCLUDER_MAX_TRIANGLES * 3, OCCLUDER_MAX_ERROR, 0, nullptr);
+            if(count == 0 || count > OCCLUDER_MAX_TRIANGLES * 3)
+                return;
+            simplified.resize(count);
+            indices = eastl::move(simplified);
+        }
+
+        eastl::vector<uint32_t> remap(positions.size());
+        const size_t vertexCount = meshopt_optimizeVertexFetchRemap(remap.data(), indices.data(), indices.size(), positions.size());
+        _group.m_occluderVertices.resize(vertexCount);
+        meshopt_remapVertexBuffer(_group.m_occluderVertices.data(), positions.data(), positions.size(), sizeof(float3), remap.data());
+        _group.m_occluderIndices.resize(indices.size());
+        meshopt_remapIndexBuffer(_group.m_occluderIndices.data(), indices.data(), indices.size(), remap.data());
+    }
+
+    GeometryCodec::Encoded encodeGeometry(const Mesh::Group& _group)
+    {
+        const size_t vertexCount = Mesh::getVertexCount(_group);
+        const size_t indexCount = _group.m_indices.size();
+
+        // the vertices went through meshopt_optimizeVertexFetch so they are in the order the codec likes, AssetCooker --test-codec checks its round trip
+        return GeometryCodec::encode(_group.m_vertices.data(), vertexCount, Mesh::getVertexSize(_group.m_vertexLayout), _group.m_indices.data(), indexCount);
+    }
+
+    using CookedTextures = eastl::map<eastl::pair<const TextureCache::Entry*, Mesh::ETextureType>, CookedTexture>;
+
+    flatbuffers::Offset<FlatBuffers::Mesh> buildGroup(flatbuffers::FlatBufferBuilder& _builder, Mesh::Group& _group, CookedTextures& _cookedTextures)
+    {
+        auto vecVerticesUnpacked = _builder.CreateVectorOfStructs(reinterpret_cast<FlatBuffers::Vertex*>(_group.m_verticesPosRaytrace.data()), _group.m_verticesPosRaytrace.size());
+        auto vecIndicesUnpacked = _builder.CreateVector(_group.m_indicesRaytrace.data(), _group.m_indicesRaytrace.size());
+        // null offsets aren't added to the table, only one of the geometry layouts ends up in the file
+        flatbuffers::Offset<flatbuffers::Vector<uint8_t>> vecVerticesEncoded;
+        flatbuffers::Offset<flatbuffers::Vector<uint8_t>> vecIndicesEncoded;
+        flatbuffers::Offset<flatbuffers::Vector<const FlatBuffers::VertexPacked*>> vecVertices;
+        flatbuffers::Offset<flatbuffers::Vector<const FlatBuffers::VertexOctahedral*>> vecVerticesOctahedral;
+        flatbuffers::Offset<flatbuffers::Vector<uint16_t>> vecIndices;
+        flatbuffers::Offset<flatbuffers::Vector<uint32_t>> vecIndices32;
+        if(cookSettings.m_isGeometryEncoded)
+        {
+            const GeometryCodec::Encoded encoded = encodeGeometry(_group);
+            vecVerticesEncoded = _builder.CreateVector(encoded.m_vertices.data(), encoded.m_vertices.size());
+            vecIndicesEncoded = _builder.CreateVector(encoded.m_indices.data(), encoded.m_indices.size());
+        }
+        else
+        {
+            if(_group.m_vertexLayout == EVertexLayout::Octahedral)
+                vecVerticesOctahedral = _builder.CreateVectorOfStructs(reinterpret_cast<const FlatBuffers::VertexOctahedral*>(_group.m_vertices.data()), Mesh::getVertexCount(_group));
+            else
+                vecVertices = _builder.CreateVectorOfStructs(reinterpret_cast<const FlatBuffers::VertexPacked*>(_group.m_vertices.data()), Mesh::getVertexCount(_group));
+            if(_group.m_indexType == VT_UINT16)
+            {
+                const eastl::vector<uint16_t> indices(_group.m_indices.begin(), _group.m_indices.end());
+                vecIndices = _builder.CreateVector(indices.data(), indices.size());
+            }
+            else
+            {
+                vecIndices32 = _builder.CreateVector(_group.m_indices.data(), _group.m_indices.size());
+            }
+        }
+        auto vecMeshlets = _builder.CreateVectorOfStructs(reinterpret_cast<const FlatBuffers::Meshlet*>(_group.m_meshlets.data()), _group.m_meshlets.size());
+        auto vecLods = _builder.CreateVectorOfStructs(reinterpret_cast<const FlatBuffers::Lod*>(_group.m_lods.data()), _group.m_lods.size());
+        auto vecOccluderVertices = _builder.CreateVectorOfStructs(reinterpret_cast<const FlatBuffers::Vec3*>(_group.m_occluderVertices.data()), _group.m_occluderVertices.size());
+        auto vecOccluderIndices = _builder.CreateVector(_group.m_occluderIndices.data(), _group.m_occluderIndices.size());
+        auto vecTexture = eastl::vector<flatbuffers::Offset<FlatBuffers::Texture>>();
+        // the entries, not the textures: when cooking without a device there is no texture
+        for (int texIndex = 0; texIndex < _group.m_textureEntries.size(); ++texIndex)
+        {
+            const Mesh::ETextureType type = _group.m_textureTypes[texIndex];
+            const TextureCache::Entry* entry = _group.m_textureEntries[texIndex].get();
+
+            // textures shared by several groups are only compressed once
+            auto cookedIt = _cookedTextures.find({entry, type});
+            if(cookedIt == _cookedTextures.end())
+            {
+                cookedIt = _cookedTextures.insert(eastl::make_pair(eastl::make_pair(entry, type), cookTexture(*entry, type, entry->m_name.c_str()))).first;
+            }
+            const CookedTexture& cooked = cookedIt->second;
+
+            auto vecTexData = _builder.CreateVector(cooked.m_data.data(), cooked.m_data.size());
+            auto nameTex = _builder.CreateString(entry->m_name.c_str());
+            auto texType = static_cast<FlatBuffers::TextureType>(type);
+            auto dims = FlatBuffers::uint2(entry->m_width, entry->m_height);
+
+            auto textureFbs = FlatBuffers::TextureBuilder(_builder);
+            textureFbs.add_data(vecTexData);
+            textureFbs.add_name(nameTex);
+            textureFbs.add_type(texType);
+            textureFbs.add_dims(&dims);
+            textureFbs.add_format(cooked.m_format);
+            textureFbs.add_mip_count(static_cast<uint8_t>(cooked.m_mipCount));
+
+            vecTexture.push_back(textureFbs.Finish());
+        }
+
+        auto vecTexFbs = _builder.CreateVector(vecTexture.data(), vecTexture.size());
+        auto aabbMin = FlatBuffers::Vec3(_group.m_aabb.Min.x, _group.m_aabb.Min.y, _group.m_aabb.Min.z);
+        auto aabbMax = FlatBuffers::Vec3(_group.m_aabb.Max.x, _group.m_aabb.Max.y, _group.m_aabb.Max.z);
+        auto nameFbs = _builder.CreateString(_group.m_name.c_str());
+        auto meshFbs = FlatBuffers::MeshBuilder(_builder);
+        meshFbs.add_textures(vecTexFbs);
+
+        meshFbs.add_version(VERSION);
+        meshFbs.add_vertex_unpacked(vecVerticesUnpacked);
+        meshFbs.add_indices_unpacked(vecIndicesUnpacked);
+        meshFbs.add_vertex_encoded(vecVerticesEncoded);
+        meshFbs.add_indices_encoded(vecIndicesEncoded);
+        meshFbs.add_vertex(vecVertices);
+        meshFbs.add_vertex_octahedral(vecVerticesOctahedral);
+        meshFbs.add_indices(vecIndices);
+        meshFbs.add_indices32(vecIndices32);
+        meshFbs.add_index_size(static_cast<uint8_t>(Mesh::getIndexSize(_group.m_indexType)));
+        meshFbs.add_vertex_layout(static_cast<FlatBuffers::VertexLayout>(_group.m_vertexLayout));
+        meshFbs.add_meshlets(vecMeshlets);
+        meshFbs.add_lods(vecLods);
+        meshFbs.add_occluder_vertices(vecOccluderVertices);
+        meshFbs.add_occluder_indices(vecOccluderIndices);
+        meshFbs.add_vertex_count(static_cast<uint32_t>(Mesh::getVertexCount(_group)));
+        meshFbs.add_index_count(static_cast<uint32_t>(_group.m_indices.size()));
+        meshFbs.add_aabb_min(&aabbMin);
+        meshFbs.add_aabb_max(&aabbMax);
+
+        meshFbs.add_name(nameFbs);
+
+        return meshFbs.Finish();
+    }
+
+    flatbuffers::Offset<FlatBuffers::StaticMesh> buildStaticMesh(flatbuffers::FlatBufferBuilder& _builder,
+                                                                 const eastl::vector<flatbuffers::Offset<FlatBuffers::Mesh>>& _meshes, float _scale)
+    {
+        FlatBuffers::Vec3 aabbMinStaticMesh(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+        FlatBuffers::Vec3 aabbMaxStaticMesh(std::numeric_limits<float>::min(), std::numeric_limits<float>::min(), std::numeric_limits<float>::min());
+
+        auto meshVectorFbs = _builder.CreateVector(_meshes.data(), _meshes.size());
+        auto staticMeshBuilder = FlatBuffers::StaticMeshBuilder(_builder);
+        staticMeshBuilder.add_meshes(meshVectorFbs);
+        staticMeshBuilder.add_aabb_max(&aabbMaxStaticMesh);
+        staticMeshBuilder.add_aabb_min(&aabbMinStaticMesh);
+        staticMeshBuilder.add_scale(_scale);
+
+        return staticMeshBuilder.Finish();
+    }
+
+    // Positions of the packed vertices, what the meshoptimizer steps of the upgrades work on
+    eastl::vector<float3> dequantizePositions(const Mesh::Group& _group)
+    {
+        eastl::vector<float3> positions(Mesh::getVertexCount(_group));
+        for(size_t i = 0; i < positions.size(); ++i)
+        {
+            positions[i] = VertexQuantization::unpack(_group.m_vertexLayout, _group.m_vertices.data(), i, _group.m_aabb).m_position;
+        }
+        return positions;
+    }
+
+    // False for a layout this build doesn't know or can't draw (see Mesh::isVertexLayoutDrawable), the group is imported again
+    bool getVertexLayout(const FlatBuffers::Mesh* _mesh, EVertexLayout& _layout)
+    {
+        static_assert(static_cast<uint8_t>(EVertexLayout::Half) == FlatBuffers::VertexLayout_Half
+                      && static_cast<uint8_t>(EVertexLayout::Octahedral) == FlatBuffers::VertexLayout_Octahedral, "EVertexLayout and FlatBuffers::VertexLayout must match");
+        _layout = static_cast<EVertexLayout>(_mesh->vertex_layout());
+        return _layout < EVertexLayout::Count && Mesh::isVertexLayoutDrawable(_layout);
+    }
+
+    // The raw vertices of the group when they aren't encoded, in the stream of its layout
+    const uint8_t* getRawVertices(const FlatBuffers::Mesh* _mesh, EVertexLayout _layout, size_t& _count)
+    {
+        if(_layout == EVertexLayout::Octahedral)
+        {
+            const auto* vertices = _mesh->vertex_octahedral();
+            _count = vertices ? vertices->size() : 0;
+            return vertices ? reinterpret_cast<const uint8_t*>(vertices->data()) : nullptr;
+        }
+
+        const auto* vertices = _mesh->vertex();
+        _count = vertices ? vertices->size() : 0;
+        return vertices ? reinterpret_cast<const uint8_t*>(vertices->data()) : nullptr;
+    }
+
+    // The CPU geometry of a cooked group: its packed vertices and indices and the raytracing streams
+    bool unpackGeometry(const FlatBuffers::Mesh* _mesh, Mesh::Group& _group)
+    {
+        if(!getVertexLayout(_mesh, _group.m_vertexLayout))
+            return false;
+        const size_t vertexSize = Mesh::getVertexSize(_group.m_vertexLayout);
+
+        _group.m_verticesPosRaytrace.assign(reinterpret_cast<const float3*>(_mesh->vertex_unpacked()->data()),
+                                            reinterpret_cast<const float3*>(_mesh->vertex_unpacked()->data()) + _mesh->vertex_unpacked()->size());
+        _group.m_indicesRaytrace.assign(_mesh->indices_unpacked()->data(), _mesh->indices_unpacked()->data() + _mesh->indices_unpacked()->size());
+
+        _group.m_indexType = _mesh->index_size() == sizeof(uint32_t) ? VT_UINT32 : VT_UINT16;
+
+        if(_mesh->vertex_encoded() && _mesh->indices_encoded())
+        {
+            _group.m_vertices.resize(_mesh->vertex_count() * vertexSize);
+            _group.m_indices.resize(_mesh->index_count());
+            if(!GeometryCodec::decode(_mesh->vertex_encoded()->data(), _mesh->vertex_encoded()->size(), _mesh->vertex_count(), vertexSize,
+                                      _mesh->indices_encoded()->data(), _mesh->indices_encoded()->size(), _group.m_indices.size(),
+                                      _group.m_vertices.data(), _group.m_indices.data(), sizeof(uint32_t)))
+                return false;
+        }
+        else if(size_t vertexCount; getRawVertices(_mesh, _group.m_vertexLayout, vertexCount) && (_mesh->indices() || _mesh->indices32()))
+        {
+            const uint8_t* vertices = getRawVertices(_mesh, _group.m_vertexLayout, vertexCount);
+            _group.m_vertices.assign(vertices, vertices + vertexCount * vertexSize);
+            if(_mesh->indices32())
+                _group.m_indices.assign(_mesh->indices32()->data(), _mesh->indices32()->data() + _mesh->indices32()->size());
+            else
+                _group.m_indices.assign(_mesh->indices()->data(), _mesh->indices()->data() + _mesh->indices()->size());
+        }
+        else
+        {
+            return false;
+        }
+
+        return true;
+    }
+
+    // Unpacks a cooked group on the CPU so it can be modified then saved with buildGroup.
+    // Its textures are already cooked, they are registered in _cookedTextures under placeholder entries so they are saved as is.
+    bool unpackGroup(const FlatBuffers::Mesh* _mesh, Mesh::Group& _group, CookedTextures& _cookedTextures)
+    {
+        _group.m_name = _mesh->name()->c_str();
+        _group.m_aabb.Min = float3(_mesh->aabb_min()->x(), _mesh->aabb_min()->y(), _mesh->aabb_min()->z());
+        _group.m_aabb.Max = float3(_mesh->aabb_max()->x(), _mesh->aabb_max()->y(), _mesh->aabb_max()->z());
+
+        if(!unpackGeometry(_mesh, _group))
+            return false;
+
+        if(_mesh->meshlets())
+        {
+            _group.m_meshlets.assign(reinterpret_cast<const Mesh::Meshlet*>(_mesh->meshlets()->data()),
+                                     reinterpret_cast<const Mesh::Meshlet*>(_mesh->meshlets()->data()) + _mesh->meshlets()->size());
+        }
+
+        if(_mesh->lods())
+        {
+            _group.m_lods.assign(reinterpret_cast<const Mesh::Lod*>(_mesh->lods()->data()),
+                                 reinterpret_cast<const Mesh::Lod*>(_mesh->lods()->data()) + _mesh->lods()->size());
+        }
+
+        if(_mesh->occluder_vertices() && _mesh->occluder_indices())
+        {
+            _group.m_occluderVertices.assign(reinterpret_cast<const float3*>(_mesh->occluder_vertices()->data()),
+                                             reinterpret_cast<const float3*>(_mesh->occluder_vertices()->data()) + _mesh->occluder_vertices()->size());
+            _group.m_occluderIndices.assign(_mesh->occluder_indices()->data(), _mesh->occluder_indices()->data() + _mesh->occluder_indices()->size());
+        }
+
+        for(const FlatBuffers::Texture* texture : *_mesh->textures())
+        {
+            auto entry = eastl::make_shared<TextureCache::Entry>();
+            entry->m_name = texture->name()->c_str();
+            entry->m_width = texture->dims()->x();
+            entry->m_height = texture->dims()->y();
+
+            const auto type = static_cast<Mesh::ETextureType>(texture->type());
+            CookedTexture cooked;
+            cooked.m_data.assign(texture->data()->data(), texture->data()->data() + texture->data()->size());
+            cooked.m_format = texture->format();
+            cooked.m_mipCount = std::max<uint32_t>(1, texture->mip_count());
+            _cookedTextures.insert(eastl::make_pair(eastl::make_pair(static_cast<const TextureCache::Entry*>(entry.get()), type), eastl::move(cooked)));
+
+            _group.m_textureEntries.push_back(eastl::move(entry));
+            _group.m_textureTypes.push_back(type);
+        }
+
+        return true;
+    }
+
+    bool isSRGB(FlatBuffers::TextureFormat _format)
+    {
+        return _format == FlatBuffers::TextureFormat_RGBA8_SRGB || _format == FlatBuffers::TextureFormat_BC1_SRGB
+               || _format == FlatBuffers::TextureFormat_BC3_SRGB || _format == FlatBuffers::TextureFormat_BC7_SRGB;
+    }
+
+    // The top level of a cooked texture back to RGBA8 pixels, false when its data is too short for its dimensions
+    bool decodeTopLevel(const CookedTexture& _cooked, uint32_t _width, uint32_t _height, uint8_t* _rgba)
+    {
+        const size_t pixelCount = static_cast<size_t>(_width) * _height;
+        TextureCompression::EFormat format;
+        switch (_cooked.m_format)
+        {
+            case FlatBuffers::TextureFormat_RGBA8:
+            case FlatBuffers::TextureFormat_RGBA8_SRGB:
+                if(_cooked.m_data.size() < pixelCount * 4)
+                    return false;
+                memcpy(_rgba, _cooked.m_data.data(), pixelCount * 4);
+                return true;
+            case FlatBuffers::TextureFormat_R8:
+                if(_cooked.m_data.size() < pixelCount)
+                    return false;
+                // cookTexture only keeps the red channel of a roughness map
+                for(size_t i = 0; i < pixelCount; ++i)
+                {
+                    _rgba[i * 4] = _rgba[i * 4 + 1] = _rgba[i * 4 + 2] = _cooked.m_data[i];
+                    _rgba[i * 4 + 3] = 255;
+                }
+                return true;
+            case FlatBuffers::TextureFormat_BC1:
+            case FlatBuffers::TextureFormat_BC1_SRGB: format = TextureCompression::EFormat::BC1; break;
+            case FlatBuffers::TextureFormat_BC3:
+            case FlatBuffers::TextureFormat_BC3_SRGB: format = TextureCompression::EFormat::BC3; break;
+            case FlatBuffers::TextureFormat_BC4: format = TextureCompression::EFormat::BC4; break;
+            case FlatBuffers::TextureFormat_BC5: format = TextureCompression::EFormat::BC5; break;
+            case FlatBuffers::TextureFormat_BC7:
+            case FlatBuffers::TextureFormat_BC7_SRGB: format = TextureCompression::EFormat::BC7; break;
+            default: return false;
+        }
+
+        if(_cooked.m_data.size() < TextureCompression::getCompressedSize(format, _width, _height))
+            return false;
+        TextureCompression::decompress(format, _cooked.m_data.data(), _width, _height, _rgba);
+        return true;
+    }
+
+    // Oldest group version that can still be upgraded: the baseline raw flatbuffers, the schema only appended fields since
+    // and the half vertices kept their layout. Older ones are imported again.
+    constexpr uint32_t MIN_UPGRADABLE_VERSION = 9;
+
+    // Computes for an older group what the version m_version added to the groups, the steps run in order.
+    // The versions without a step only changed how a group is written and the fields they added default to what the older
+    // groups hold, buildGroup writes them the current way:
+    //   12: the geometry is encoded with the meshoptimizer codec
+    //   15: index_size, the older groups were all split to fit 16 bits indices
+    //   16: vertex_layout, the older groups all have the half one
+    // A VERSION that adds data to the groups adds its step here.
+    struct GroupUpgrade
+    {
+        uint32_t m_version;
+        void (*m_upgrade)(Mesh::Group&, CookedTextures&);
+    };
+    constexpr GroupUpgrade GROUP_UPGRADES[] =
+    {
+        // the texture format is stored, it defaults to RGBA8 but the albedo was sampled as sRGB
+        {10, [](Mesh::Group& _group, CookedTextures& _cookedTextures)
+        {
+            for(size_t i = 0; i < _group.m_textureEntries.size(); ++i)
+            {
+                auto cookedIt = _cookedTextures.find({_group.m_textureEntries[i].get(), _group.m_textureTypes[i]});
+                if(cookedIt != _cookedTextures.end() && _group.m_textureTypes[i] == Mesh::ETextureType::Albedo
+                   && cookedIt->second.m_format == FlatBuffers::TextureFormat_RGBA8)
+                {
+                    cookedIt->second.m_format = FlatBuffers::TextureFormat_RGBA8_SRGB;
+                }
+            }
+        }},
+        // mip chains: the single level textures are decoded and cooked again by buildGroup, which also block compresses
+        // the RGBA8 ones of version 9. The ones of version 10 were already compressed, they go through it twice.
+        {11, [](Mesh::Group& _group, CookedTextures& _cookedTextures)
+        {
+            for(size_t i = 0; i < _group.m_textureEntries.size(); ++i)
+            {
+                TextureCache::Entry& entry = *_group.m_textureEntries[i];
+                auto cookedIt = _cookedTextures.find({&entry, _group.m_textureTypes[i]});
+                if(cookedIt == _cookedTextures.end() || cookedIt->second.m_mipCount > 1)
+                    continue;
+
+                // freed with the entry by stbi_image_free, like the pixels of an image file
+                auto* pixels = static_cast<unsigned char*>(malloc(static_cast<size_t>(entry.m_width) * entry.m_height * 4));
+                if(!decodeTopLevel(cookedIt->second, entry.m_width, entry.m_height, pixels))
+                {
+                    free(pixels);
+                    continue;
+                }
+
+                entry.m_pixels = pixels;
+                entry.m_format = isSRGB(cookedIt->second.m_format) ? TEX_FORMAT_RGBA8_UNORM_SRGB : TEX_FORMAT_RGBA8_UNORM;
+                _cookedTextures.erase(cookedIt);
+            }
+        }},
+        // meshlets, on the quantized positions as the float ones are gone
+        {13, [](Mesh::Group& _group, CookedTextures&)
+        {
+            const eastl::vector<float3> positions = dequantizePositions(_group);
+            buildMeshlets(_group, &positions[0].x, positions.size(), sizeof(float3));
+        }},
+        // LODs
+        {14, [](Mesh::Group& _group, CookedTextures&)
+        {
+            const eastl::vector<float3> positions = dequantizePositions(_group);
+            buildLods(_group, &positions[0].x, positions.size(), sizeof(float3));
+        }},
+        // the occluder is cooked instead of simplified at every load
+        {17, [](Mesh::Group& _group, CookedTextures&) { buildOccluder(_group); }},
+    };
+
+    // The scene section layout didn't change since the container exists
+    constexpr uint32_t MIN_UPGRADABLE_SCENE_VERSION = 11;
+
+    bool isUpgradable(uint32_t _version, uint32_t _minVersion, uint32_t _currentVersion)
+    {
+        return _version >= _minVersion && _version <= _currentVersion;
+    }
+
+    // Rebuilds a group of _version as a section at VERSION, _mesh can point in _section as it is unpacked first
+    bool upgradeGroup(const FlatBuffers::Mesh* _mesh, uint32_t _version, eastl::vector<uint8_t>& _section)
+    {
+        ZoneScopedN("Upgrade Group");
+
+        Mesh::Group group;
+        CookedTextures cookedTextures;
+        if(!unpackGroup(_mesh, group, cookedTextures))
+            return false;
+
+        for(const GroupUpgrade& upgrade : GROUP_UPGRADES)
+        {
+            if(_version < upgrade.m_version)
+                upgrade.m_upgrade(group, cookedTextures);
+        }
+
+        flatbuffers::FlatBufferBuilder builder(group.m_vertices.size());
+        builder.Finish(buildGroup(builder, group, cookedTextures));
+        _section.assign(builder.GetBufferPointer(), builder.GetBufferPointer() + builder.GetSize());
+        return true;
+    }
+}
+
+// Remembers every file assimp opens (.mtl, .bin...), they are dependencies of the cooked mesh as much as the source
+class DependencyRecorder : public Assimp::DefaultIOSystem
+{
+public:
+    explicit DependencyRecorder(eastl::vector<eastl::string>& _files) : m_files(_files) {}
+
+    Assimp::IOStream* Open(const char* _file, const char* _mode) override
+    {
+        Assimp::IOStream* stream = Assimp::DefaultIOSystem::Open(_file, _mode);
+        if(stream && eastl::find(m_files.begin(), m_files.end(), _file) == m_files.end())
+        {
+            m_files.push_back(_file);
+        }
+        return stream;
+    }
+
+private:
+    eastl::vector<eastl::string>& m_files;
+};
+
+#if !defined(HEADLESS_COOKER)
+class ProgressHandler : public Assimp::ProgressHandler
+{
+public:
+
+    explicit ProgressHandler(const char* _name) {
+        m_id = Engine::instance->addImportProgress(_name);
+    };
+    ~ProgressHandler() override {
+        Engine::instance->removeImportProgress(m_id);
+    }
+
+    bool Update(float percentage) override
+    {
+        Engine::instance->updateImportProgress(m_id, percentage);
+        return true;
+    }
+
+private:
+    uint32_t m_id;
+};
+#endif
+
+Mesh::Mesh(RefCntAutoPtr<IRenderDevice> _device, const char *_path, bool _needsAfterLoadedActions, float3 _position, float _scale, float3 _angle,
+           bool _isUploadDeferred, bool _isCpuDataKept)
+: m_position(_position), m_scale(_scale), m_device(eastl::move(_device)), m_angle(_angle), m_id(idCount++), m_isUploadDeferred(_isUploadDeferred)
+{
+    ZoneScoped;
+    //ZoneScopedN("Loading Mesh");
+    ZoneName(_path, strlen(_path));
+    updateModel();
+
+    initPaths(_path);
+
+
+    bool isUploaded = false;
+    bool isCompressed = false;
+    bool isImportNeeded = false; // the import saves the .mesh, done once the file isn't mapped anymore so it can be replaced
+    eastl::vector<eastl::vector<uint8_t>> migratedSections;
+
+    {
+        const auto readStart = std::chrono::steady_clock::now();
+
+        // a packed scene is already mapped, the file of the mesh is only opened when it isn't in the archive
+        SceneArchive::View packed;
+        const bool isPacked = SceneArchive::getMounted().find(m_flatbufferPath, packed);
+
+        // Mapped: the mapping only lives for this scope, the gpu resources are created straight from it.
+        // Read: the whole file is copied in memory first.
+        const bool isMapped = loadMode == ELoadMode::Mapped;
+        MappedFile filefbs;
+        eastl::vector<uint8_t> buffer;
+        const uint8_t* bufferFbs = packed.m_data;
+        size_t sizeFbs = packed.m_size;
+        if(!isMapped)
+        {
+            if(isPacked)
+            {
+                buffer.assign(packed.m_data, packed.m_data + packed.m_size);
+            }
+            else
+            {
+                std::ifstream file(m_flatbufferPath.c_str(), std::ios_base::binary | std::ios_base::ate);
+                if(file.good())
+                {
+                    buffer.resize(static_cast<size_t>(file.tellg()));
+                    file.seekg(0, std::ios::beg);
+                    file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+                }
+            }
+            bufferFbs = buffer.data();
+            sizeFbs = buffer.size();
+        }
+        else if(!isPacked && filefbs.open(m_flatbufferPath.c_str()))
+        {
+            bufferFbs = filefbs.data();
+            sizeFbs = filefbs.size();
+        }
+        const bool isCooked = sizeFbs > 0;
+        if(isCooked)
+        {
+            // when mapped, the pages are mostly read by the decode
+            ImportTelemetry::record(m_name, ImportTelemetry::EStage::FileRead, readStart, sizeFbs, sizeFbs);
+        }
+
+#if FORCE_LOADING_FROM_DISK == 1
+        if(false)
+#else
+        if(isCooked)
+#endif
+        {
+            const MeshContainer::Reader container(bufferFbs, sizeFbs);
+            isCompressed = container.isValid();
+
+            {
+                ImportTelemetry::Scope decode(m_name, ImportTelemetry::EStage::Decode, sizeFbs);
+
+                // the sections of a container, or the groups of a raw flatbuffer, are checked one by one,
+                // outdated ones are upgraded instead of importing everything again
+                if(isCompressed)
+                {
+                    isUploaded = loadFromContainer(container, migratedSections);
+                }
+                else
+                {
+                    isUploaded = loadFromFlatbuffer(FlatBuffers::GetStaticMesh(bufferFbs), migratedSections);
+                }
+                decode.setBytesOut(getCpuBytes());
+            }
+
+            m_isCpuDataReloadable = isUploaded;
+            m_isCpuDataPacked = isUploaded && isPacked;
+            if(!isUploaded)
+            {
+                if(isPacked)
+                {
+                    // saved next to the source, the archive keeps the old one until the next AssetCooker --pak
+                    std::cout << _path << " is outdated in " << SceneArchive::FILE_NAME << ", run AssetCooker with --pak again" << std::endl;
+                }
+                m_meshes.clear();
+                migratedSections.clear();
+                isImportNeeded = true;
+            }
+        }
+        else
+        {
+            std::cout << _path << " is not cooked, importing it (AssetCooker does it offline)" << std::endl;
+            isImportNeeded = true;
+        }
+    }
+
+    // written once the file isn't mapped anymore
+    if(isImportNeeded)
+    {
+        LoadFromPath(_path);
+        save();
+    }
+    else if(!migratedSections.empty())
+    {
+        saveContainer(migratedSections);
+    }
+
+    if(!isUploaded && !m_isUploadDeferred)
+    {
+        for(Group& grp : m_meshes)
+        {
+            ImportTelemetry::Scope upload(m_name, ImportTelemetry::EStage::GpuUpload, getPendingUploadSize(grp));
+            createGPUBuffers(grp);
+            upload.setBytesOut(getPendingUploadSize(grp));
+        }
+    }
+
+    // saved and uploaded (or queued for it), the copies the load made are not needed anymore unless somebody reads them next
+    {
+        std::scoped_lock lock(m_mutexCpuData);
+        releasePixels();
+    }
+    if(!_isCpuDataKept)
+    {
+        releaseCpuData();
+    }
+
+    m_isLoaded = !_needsAfterLoadedActions;
+}
+
+Mesh::Mesh(const char* _path)
+: m_position(0), m_scale(1), m_angle(0), m_id(idCount++)
+{
+    m_model = float4x4::Identity();
+    initPaths(_path);
+}
+
+void Mesh::initPaths(const char* _path)
+{
+    eastl::string path(_path);
+
+    auto index = path.find_last_of('.');
+    auto nameWithoutExt = path.substr(0, index);
+    m_name = nameWithoutExt;
+    m_flatbufferPath = nameWithoutExt + ".mesh";
+    index = path.find_last_of('/') + 1; // +1 to include the /
+    m_basePath = path.substr(0, index);
+}
+
+bool Mesh::cook(const char* _path, eastl::vector<eastl::string>& _dependencies)
+{
+    ZoneScopedN("Cook Mesh");
+    ZoneText(_path, strlen(_path));
+
+    Mesh mesh(_path);
+    mesh.LoadFromPath(_path);
+    if(mesh.m_meshes.empty())
+        return false;
+
+    mesh.save();
+
+    _dependencies = mesh.m_importedFiles;
+    for(const Group& group : mesh.m_meshes)
+    {
+        for(const TextureCache::Handle& entry : group.m_textureEntries)
+        {
+            if(!entry->m_path.empty() && eastl::find(_dependencies.begin(), _dependencies.end(), entry->m_path) == _dependencies.end())
+            {
+                _dependencies.push_back(entry->m_path);
+            }
+        }
+    }
+
+    return true;
+}
+
+void Mesh::setLoadMode(ELoadMode _mode)
+{
+    loadMode = _mode;
+}
+
+void Mesh::setCookSettings(const CookSettings& _settings)
+{
+    cookSettings = _settings;
+}
+
+const Mesh::CookSettings& Mesh::getCookSettings()
+{
+    return cookSettings;
+}
+
+uint32_t Mesh::getImportFlags()
+{
+    return aiProcess_SortByPType | aiProcess_GenUVCoords | aiProcess_Triangulate | aiProcess_CalcTangentSpace | aiProcess_SplitLargeMeshes
+           | aiProcess_OptimizeMeshes | aiProcess_OptimizeGraph | aiProcess_GenSmoothNormals | aiProcess_GenBoundingBoxes | aiProcess_GlobalScale;
+}
+
+bool Mesh::loadFromFlatbuffer(const FlatBuffers::StaticMesh* _staticMesh, eastl::vector<eastl::vector<uint8_t>>& _migratedSections)
+{
+    ZoneScopedN("Loading From Flatbuffer");
+    auto meshes = _staticMesh->meshes();
+
+    // same rules as the group sections of a container
+    const unsigned int o = meshes->size();
+    uint32_t outdatedCount = 0;
+    for(uint32_t i = 0; i < o; ++i)
+    {
+        if(!isUpgradable(meshes->Get(i)->version(), MIN_UPGRADABLE_VERSION, VERSION))
+            return false;
+
+        outdatedCount += meshes->Get(i)->version() != VERSION;
+    }
+
+    // the file is rewritten as a container, its scene section is what the StaticMesh holds besides the groups
+    const bool isMigrating = outdatedCount > 0;
+    const auto migrateStart = std::chrono::steady_clock::now();
+    eastl::vector<eastl::vector<uint8_t>> sections(isMigrating ? o + 1 : 0);
+    if(isMigrating)
+    {
+        flatbuffers::FlatBufferBuilder builder;
+        builder.Finish(buildStaticMesh(builder, {}, _staticMesh->scale()));
+        sections[0].assign(builder.GetBufferPointer(), builder.GetBufferPointer() + builder.GetSize());
+    }
+
+    m_meshes.resize(o);
+    std::atomic<bool> isValid = true;
+
+    // the groups geometry is decoded on the workers
+    JobSystem::get().parallelFor(JobSystem::ESubsystem::Mesh, JobSystem::EPriority::High, o, 1, [&](uint32_t _first, uint32_t _last)
+    {
+        for(uint32_t i = _first; i < _last; ++i)
+        {
+            // the current groups become sections as well
+            const FlatBuffers::Mesh* mesh = meshes->Get(i);
+            if(isMigrating)
+            {
+                if(!upgradeGroup(mesh, mesh->version(), sections[i + 1]))
+                {
+                    isValid = false;
+                    continue;
+                }
+                mesh = flatbuffers::GetRoot<FlatBuffers::Mesh>(sections[i + 1].data());
+            }
+
+            if(!loadGroupFromFlatbuffer(mesh, m_meshes[i]))
+                isValid = false;
+        }
+    });
+
+    if(isValid && isMigrating)
+    {
+        const float migrateTimeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - migrateStart).count();
+        std::cout << "Upgraded " << outdatedCount << " of " << o << " groups of " << m_flatbufferPath.c_str() << " in " << migrateTimeMs << "ms" << std::endl;
+        _migratedSections = eastl::move(sections);
+    }
+
+    m_scale = _staticMesh->scale();
+    return isValid;
+}
+
+bool Mesh::loadFromContainer(const MeshContainer::Reader& _container, eastl::vector<eastl::vector<uint8_t>>& _migratedSections)
+{
+    ZoneScopedN("Loading From Container");
+
+    // a section too old to be upgraded, or cooked by a newer build, means importing the source again
+    const uint32_t sectionCount = _container.getSectionCount();
+    if(sectionCount < 2 || !isUpgradable(_container.getSectionVersion(0), MIN_UPGRADABLE_SCENE_VERSION, SCENE_VERSION))
+        return false;
+
+    uint32_t outdatedCount = _container.getSectionVersion(0) != SCENE_VERSION;
+    for(uint32_t i = 1; i < sectionCount; ++i)
+    {
+        if(!isUpgradable(_container.getSectionVersion(i), MIN_UPGRADABLE_VERSION, VERSION))
+            return false;
+
+        outdatedCount += _container.getSectionVersion(i) != VERSION;
+    }
+
+    // every section is kept to rewrite the file when one of them is upgraded
+    const bool isMigrating = outdatedCount > 0;
+    const auto migrateStart = std::chrono::steady_clock::now();
+    eastl::vector<eastl::vector<uint8_t>> sections(isMigrating ? sectionCount : 1);
+
+    // the scene section only holds what is shared by the groups
+    sections[0].resize(_container.getSectionSize(0));
+    if(!_container.decompress(0, sections[0].data()))
+        return false;
+
+    m_scale = FlatBuffers::GetStaticMesh(sections[0].data())->scale();
+
+    // every group is decoded and uploaded on its own, reading the pages of one overlaps with the decoding and upload of the others
+    const uint32_t groupCount = sectionCount - 1;
+    m_meshes.resize(groupCount);
+    std::atomic<bool> isValid = true;
+
+    JobSystem::get().parallelFor(JobSystem::ESubsystem::Mesh, JobSystem::EPriority::High, groupCount, 1, [&](uint32_t _first, uint32_t _last)
+    {
+        for(uint32_t i = _first; i < _last; ++i)
+        {
+            eastl::vector<uint8_t> localSection;
+            eastl::vector<uint8_t>& section = isMigrating ? sections[i + 1] : localSection;
+            section.resize(_container.getSectionSize(i + 1));
+            if(!_container.decompress(i + 1, section.data()))
+            {
+                isValid = false;
+                continue;
+            }
+
+            const uint32_t version = _container.getSectionVersion(i + 1);
+            if(version != VERSION && !upgradeGroup(flatbuffers::GetRoot<FlatBuffers::Mesh>(section.data()), version, section))
+            {
+                isValid = false;
+                continue;
+            }
+
+            if(!loadGroupFromFlatbuffer(flatbuffers::GetRoot<FlatBuffers::Mesh>(section.data()), m_meshes[i]))
+                isValid = false;
+        }
+    });
+
+    if(isValid && isMigrating)
+    {
+        const float migrateTimeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - migrateStart).count();
+        std::cout << "Upgraded " << outdatedCount << " of " << sectionCount << " sections of " << m_flatbufferPath.c_str() << " in "
+                  << migrateTimeMs << "ms" << std::endl;
+        _migratedSections = eastl::move(sections);
+    }
+
+    return isValid;
+}
+
+bool Mesh::loadGroupFromFlatbuffer(const FlatBuffers::Mesh* _mesh, Group& _group)
+{
+    ZoneScopedN("Loading Group From Flatbuffer");
+
+    // cooked by a newer build, the shaders can't read it
+    if(!getVertexLayout(_mesh, _group.m_vertexLayout))
+        return false;
+
+    // BLAS are built later on the render thread, so this is the only data that has to outlive the file
+    _group.m_verticesPosRaytrace.assign(reinterpret_cast<const float3*>(_mesh->vertex_unpacked()->data()),
+                                        reinterpret_cast<const float3*>(_mesh->vertex_unpacked()->data()) + _mesh->vertex_unpacked()->size());
+    _group.m_indicesRaytrace.assign(_mesh->indices_unpacked()->data(), _mesh->indices_unpacked()->data() + _mesh->indices_unpacked()->size());
+
+    if(_mesh->meshlets())
+    {
+        _group.m_meshlets.assign(reinterpret_cast<const Meshlet*>(_mesh->meshlets()->data()),
+                                 reinterpret_cast<const Meshlet*>(_mesh->meshlets()->data()) + _mesh->meshlets()->size());
+    }
+
+    if(_mesh->lods())
+    {
+        _group.m_lods.assign(reinterpret_cast<const Lod*>(_mesh->lods()->data()), reinterpret_cast<const Lod*>(_mesh->lods()->data()) + _mesh->lods()->size());
+    }
+
+    if(_mesh->occluder_vertices() && _mesh->occluder_indices())
+    {
+        _group.m_occluderVertices.assign(reinterpret_cast<const float3*>(_mesh->occluder_vertices()->data()),
+                                         reinterpret_cast<const float3*>(_mesh->occluder_vertices()->data()) + _mesh->occluder_vertices()->size());
+        _group.m_occluderIndices.assign(_mesh->occluder_indices()->data(), _mesh->occluder_indices()->data() + _mesh->occluder_indices()->size());
+    }
+
+    _group.m_indexType = _mesh->index_size() == sizeof(uint32_t) ? VT_UINT32 : VT_UINT16;
+
+    if(m_isUploadDeferred)
+    {
+        // the file is unmapped before the upload
+        if(!unpackGeometry(_mesh, _group))
+        {
+            std::cout << "Could not decode the geometry of " << _mesh->name()->c_str() << std::endl;
+            return false;
+        }
+    }
+    else if(_mesh->vertex_encoded() && _mesh->indices_encoded())
+    {
+        // decoded in a scratch copy straight to the width of the index buffer, the buffers are immutable and created with their data
+        const size_t indexSize = getIndexSize(_group.m_indexType);
+        eastl::vector<uint8_t> vertices(_mesh->vertex_count() * getVertexSize(_group.m_vertexLayout));
+        eastl::vector<uint8_t> indices(_mesh->index_count() * indexSize);
+        if(!GeometryCodec::decode(_mesh->vertex_encoded()->data(), _mesh->vertex_encoded()->size(), _mesh->vertex_count(), getVertexSize(_group.m_vertexLayout),
+                                  _mesh->indices_encoded()->data(), _mesh->indices_encoded()->size(), _mesh->index_count(), vertices.data(), indices.data(), indexSize))
+        {
+            std::cout << "Could not decode the geometry of " << _mesh->name()->c_str() << std::endl;
+            return false;
+        }
 
+        createGPUBuffers(_group, vertices.data(), _mesh->vertex_count(), indices.data(), _mesh->index_count());
+    }
+    else
+    {
+        size_t vertexCount;
+        const uint8_t* vertices = getRawVertices(_mesh, _group.m_vertexLayout, vertexCount);
+        if(_mesh->indices32())
+            createGPUBuffers(_group, vertices, vertexCount, _mesh->indices32()->data(), _mesh->indices32()->size());
+        else
+            createGPUBuffers(_group, vertices, vertexCount, _mesh->indices()->data(), _mesh->indices()->size());
+    }
 
-using namespace Diligent;
+    _group.m_aabb.Min = float3(_mesh->aabb_min()->x(), _mesh->aabb_min()->y(), _mesh->aabb_min()->z());
+    _group.m_aabb.Max = float3(_mesh->aabb_max()->x(), _mesh->aabb_max()->y(), _mesh->aabb_max()->z());
 
-class ProgressHandler : public Assimp::ProgressHandler
+    for (int indexTexture = 0; indexTexture < _mesh->textures()->size(); ++indexTexture)
+    {
+        auto texture = _mesh->textures()->Get(indexTexture);
+        TextureDesc desc;
+        desc.Width = texture->dims()->x();
+        desc.Height = texture->dims()->y();
+        desc.Type = Diligent::RESOURCE_DIM_TEX_2D;
+        desc.Name = texture->name()->c_str();
+        desc.Format = toTextureFormat(texture->format());
+        desc.BindFlags = BIND_SHADER_RESOURCE;
+        desc.Usage = USAGE_IMMUTABLE;
+
+        desc.MipLevels = std::max<Uint32>(1, texture->mip_count());
+
+        const auto type = static_cast<ETextureType>(texture->type());
+        if (m_isUploadDeferred)
+        {
+            PendingTexture pending;
+            pending.m_desc = desc;
+            pending.m_desc.Name = nullptr;
+            pending.m_name = texture->name()->c_str();
+            pending.m_data.assign(texture->data()->data(), texture->data()->data() + texture->data()->size());
+            pending.m_type = type;
+            _group.m_pendingTextures.push_back(eastl::move(pending));
+        }
+        else
+        {
+            createTexture(_group, desc, texture->data()->data(), texture->data()->size(), type);
+        }
+    }
+
+    _group.m_name = _mesh->name()->c_str();
+    return true;
+}
+
+void Mesh::createGPUBuffers(Group& _group, const void* _vertices, size_t _vertexCount, const void* _indices, size_t _indexCount)
 {
-public:
+    BufferDesc VertBuffDesc;
+    VertBuffDesc.Name = "Mesh vertex buffer";
+    VertBuffDesc.Usage = USAGE_IMMUTABLE;
+    VertBuffDesc.BindFlags = BIND_VERTEX_BUFFER;
+    VertBuffDesc.Size = getVertexSize(_group.m_vertexLayout) * _vertexCount;
+    BufferData VBData;
+    VBData.pData    = _vertices;
+    VBData.DataSize = VertBuffDesc.Size;
+
+    m_device->CreateBuffer(VertBuffDesc, &VBData, &_group.m_meshVertexBuffer);
+
+    BufferDesc IndexBuffDesc;
+    IndexBuffDesc.Name = "Mesh index buffer";
+    IndexBuffDesc.Usage = USAGE_IMMUTABLE;
+    IndexBuffDesc.BindFlags = BIND_INDEX_BUFFER;
+    IndexBuffDesc.Size = _indexCount * getIndexSize(_group.m_indexType);
+    BufferData IBData;
+    IBData.pData    = _indices;
+    IBData.DataSize = IndexBuffDesc.Size;
+
+    m_device->CreateBuffer(IndexBuffDesc, &IBData, &_group.m_meshIndexBuffer);
+
+    // the coarser LODs are after the full detail in the buffer
+    _group.m_indexCount = _group.m_lods.empty() ? static_cast<uint32_t>(_indexCount) : _group.m_lods[0].m_indexCount;
+}
 
-    explicit ProgressHandler(const char* _name) {
-        m_id = Engine::instance->addImportProgress(_name);
-    };
-    ~ProgressHandler() override {
-        Engine::instance->removeImportProgress(m_id);
-    }
+float4x4 Mesh::getDequantization(const Group& _group)
+{
+    if(_group.m_vertexLayout != EVertexLayout::Octahedral)
+        return float4x4::Identity();
 
-    bool Update(float percentage) override
+    const float3 extent = _group.m_aabb.Max - _group.m_aabb.Min;
+    return float4x4::Scale(extent.x / 65535.0f, extent.y / 65535.0f, extent.z / 65535.0f) * float4x4::Translation(_group.m_aabb.Min);
+}
+
+void Mesh::createGPUBuffers(Group& _group)
+{
+    if(_group.m_indexType == VT_UINT32)
     {
-        Engine::instance->updateImportProgress(m_id, percentage);
-        return true;
+        createGPUBuffers(_group, _group.m_vertices.data(), getVertexCount(_group), _group.m_indices.data(), _group.m_indices.size());
+        return;
     }
 
-private:
-    uint32_t m_id;
-};
+    const eastl::vector<uint16_t> indices(_group.m_indices.begin(), _group.m_indices.end());
+    createGPUBuffers(_group, _group.m_vertices.data(), getVertexCount(_group), indices.data(), indices.size());
+}
 
-Mesh::Mesh(RefCntAutoPtr<IRenderDevice> _device, const char *_path, bool _needsAfterLoadedActions, float3 _position, float _scale, float3 _angle)
-: m_position(_position), m_scale(_scale), m_device(eastl::move(_device)), m_angle(_angle), m_id(idCount++)
+void Mesh::createTexture(Group& _group, const TextureDesc& _desc, const uint8_t* _data, size_t _size, ETextureType _type)
 {
-    ZoneScoped;
-    //ZoneScopedN("Loading Mesh");
-    eastl::string path(_path);
-    ZoneName(path.c_str(), path.size());
-    m_model = float4x4::Scale(m_scale) * float4x4::Translation(m_position);
+    // levels are stored back to back, biggest first
+    eastl::vector<TextureSubResData> subResources(_desc.MipLevels);
+    const uint8_t* levelData = _data;
+    for (Uint32 level = 0; level < _desc.MipLevels; ++level)
+    {
+        const Uint32 width = std::max<Uint32>(1, _desc.Width >> level);
+        const Uint32 height = std::max<Uint32>(1, _desc.Height >> level);
+        subResources[level].pData = levelData;
+        subResources[level].Stride = getRowStride(_desc.Format, width);
+        levelData += getLevelSize(_desc.Format, width, height);
+    }
 
-    auto index = path.find_last_of('.');
-    auto nameWithoutExt = path.substr(0, index);
-    m_name = nameWithoutExt;
-    m_flatbufferPath = nameWithoutExt + ".mesh";
-    index = path.find_last_of('/') + 1; // +1 to include the /
-    m_basePath = path.substr(0, index);
+    TextureData texData;
+    texData.NumSubresources = _desc.MipLevels;
+    texData.pSubResources = subResources.data();
 
+    TextureCache::Handle entry = TextureCache::get().loadFromMemory(m_device, _desc, texData, _data, _size);
+    _group.m_textures.push_back(entry->m_texture);
+    _group.m_textureEntries.push_back(eastl::move(entry));
+    _group.m_textureTypes.push_back(_type);
+}
 
+size_t Mesh::getPendingUploadSize(const Group& _group)
+{
+    size_t size = _group.m_vertices.size() + _group.m_indices.size() * getIndexSize(_group.m_indexType);
+    for (const PendingTexture& texture : _group.m_pendingTextures)
     {
-        std::ifstream filefbs(m_flatbufferPath.c_str(), std::ios_base::binary);
-#if FORCE_LOADING_FROM_DISK == 1
-        if(false)
-#else
-        if(filefbs.good())
-#endif
-        {
-            filefbs.seekg(0, std::ios::end);
-            size_t length = filefbs.tellg();
-            filefbs.seekg(0, std::ios::beg);
+        size += texture.m_data.size();
+    }
+    return size;
+}
 
-            eastl::vector<char> buffer(length);
-            filefbs.read(buffer.data(), length);
+size_t Mesh::uploadGroup(Group& _group)
+{
+    ZoneScopedN("Upload Group");
+    const size_t size = getPendingUploadSize(_group);
+    ImportTelemetry::Scope telemetry(m_name, ImportTelemetry::EStage::GpuUpload, size);
+    telemetry.setBytesOut(size);
 
-            auto staticMesh = FlatBuffers::GetStaticMesh(buffer.data());
-            auto meshes = staticMesh->meshes();
+    createGPUBuffers(_group);
+    for (PendingTexture& texture : _group.m_pendingTextures)
+    {
+        texture.m_desc.Name = texture.m_name.c_str();
+        createTexture(_group, texture.m_desc, texture.m_data.data(), texture.m_data.size(), texture.m_type);
+    }
 
-            if(meshes->Get(0)->version() != VERSION)
-            {
-                LoadFromPath(_path);
-                save();
-            }
-            else
-            {
-                std::cout << "loading " << _path << " from flatbuffers" << std::endl;
+    // the copies only lived until the upload, the budget of the streaming counts them
+    _group.m_vertices.set_capacity(0);
+    _group.m_indices.set_capacity(0);
+    _group.m_pendingTextures.set_capacity(0);
+    return size;
+}
 
+bool Mesh::acquireCpuData()
+{
+    std::scoped_lock lock(m_mutexCpuData);
+    m_cpuDataUsers++;
+    if(!m_isCpuDataReleased)
+        return true;
 
-                const unsigned int o = meshes->size();
-                m_meshes.resize(o);
+    m_isCpuDataReleased = !reloadCpuData();
+    return !m_isCpuDataReleased;
+}
 
-                for(int i = 0; i < meshes->size(); ++i)
-                {
-                    auto mesh = meshes->Get(i);
+void Mesh::releaseCpuData()
+{
+    std::scoped_lock lock(m_mutexCpuData);
+    if(m_cpuDataUsers == 0 || --m_cpuDataUsers > 0)
+        return;
 
-                    auto& verticesUnpacked = m_meshes[i].m_verticesPosRaytrace;
-                    verticesUnpacked.resize(mesh->vertex_unpacked()->size());
+    releasePixels();
 
-                    auto& indicesUnpacked = m_meshes[i].m_indicesRaytrace;
-                    indicesUnpacked.resize(mesh->indices_unpacked()->size());
+    // otherwise they're the only copy
+    if(!m_isCpuDataReloadable)
+        return;
 
-                    auto& vertices = m_meshes[i].m_vertices;
-                    vertices.resize(mesh->vertex()->size());
+    for(Group& group : m_meshes)
+    {
+        // a deferred upload still needs its geometry, uploadGroup frees it
+        if(group.m_meshVertexBuffer)
+        {
+            group.m_vertices.set_capacity(0);
+            group.m_indices.set_capacity(0);
+        }
+        group.m_verticesPosRaytrace.set_capacity(0);
+        group.m_indicesRaytrace.set_capacity(0);
+    }
+    m_isCpuDataReleased = true;
+}
+
+void Mesh::releasePixels()
+{
+    // only the save needed them, it is done by now
+    if(m_arePixelsReleased)
+        return;
 
-                    auto& indices = m_meshes[i].m_indices;
-                    indices.resize(mesh->indices()->size());
+    for(Group& group : m_meshes)
+    {
+        for(const TextureCache::Handle& entry : group.m_textureEntries)
+        {
+            TextureCache::get().releasePixels(*entry);
+        }
+    }
+    m_arePixelsReleased = true;
+}
 
-                    memcpy_s(verticesUnpacked.data(),mesh->vertex_unpacked()->size() * sizeof(float3), mesh->vertex_unpacked()->data(), mesh->vertex_unpacked()->size() * sizeof(float3));
-                    memcpy_s(indicesUnpacked.data(),mesh->indices_unpacked()->size() * sizeof(uint32_t), mesh->indices_unpacked()->data(), mesh->indices_unpacked()->size() * sizeof(uint32_t));
-                    memcpy_s(vertices.data(),mesh->vertex()->size() * sizeof(VertexPacked), mesh->vertex()->data(), mesh->vertex()->size() * sizeof(VertexPacked));
-                    memcpy_s(indices.data(),mesh->indices()->size() * sizeof(uint16_t), mesh->indices()->data(), mesh->indices()->size()* sizeof(uint16_t));
+bool Mesh::reloadCpuData()
+{
+    ZoneScopedN("Reload CPU Data");
 
-                    m_meshes[i].m_aabb.Min = float3(mesh->aabb_min()->x(), mesh->aabb_min()->y(), mesh->aabb_min()->z());
-                    m_meshes[i].m_aabb.Max = float3(mesh->aabb_max()->x(), mesh->aabb_max()->y(), mesh->aabb_max()->z());
+    // only from where it was loaded or saved, the other one can be outdated
+    SceneArchive::View packed;
+    MappedFile file;
+    if(m_isCpuDataPacked)
+    {
+        if(!SceneArchive::getMounted().find(m_flatbufferPath, packed))
+        {
+            std::cout << "Could not reload the CPU data of " << m_name.c_str() << ", it is not in " << SceneArchive::FILE_NAME << " anymore" << std::endl;
+            return false;
+        }
+    }
+    else
+    {
+        if(!file.open(m_flatbufferPath.c_str()))
+        {
+            std::cout << "Could not reload the CPU data of " << m_name.c_str() << ", " << m_flatbufferPath.c_str() << " is gone" << std::endl;
+            return false;
+        }
+        packed.m_data = file.data();
+        packed.m_size = file.size();
+    }
 
-                    for (int indexTexture = 0; indexTexture < mesh->textures()->size(); ++indexTexture)
-                    {
-                        auto texture = mesh->textures()->Get(indexTexture);
-                        TextureDesc desc;
-                        desc.Width = texture->dims()->x();
-                        desc.Height = texture->dims()->y();
-                        desc.Type = Diligent::RESOURCE_DIM_TEX_2D;
-                        desc.Name = texture->name()->c_str();
-                        TEXTURE_FORMAT format;
-                        int stride = 0;
-                        switch (texture->type())
-                        {
-                            case FlatBuffers::TextureType_Albedo:
-                                format = TEX_FORMAT_RGBA8_UNORM_SRGB;
-                                stride = 4;
-                                break;
-                            case FlatBuffers::TextureType_Normal:
-                                format = TEX_FORMAT_RGBA8_UNORM;
-                                stride = 4;
-                                break;
-                            case FlatBuffers::TextureType_Roughness:
-                                format = TEX_FORMAT_R8_SNORM;
-                                stride = 1;
-                                break;
-                        }
-                        desc.Format = format;
-                        desc.BindFlags = BIND_SHADER_RESOURCE;
-
-                        TextureSubResData subData;
-                        subData.pData = texture->data();
-                        subData.Stride = stride * sizeof (char) * desc.Width;
-
-                        TextureData texData;
-                        texData.NumSubresources = 1;
-                        texData.pSubResources = &subData;
-                        //todo fsantoro handle caching textures when loading from flatbuffers
-                        RefCntAutoPtr<ITexture> tex;
-                        m_device->CreateTexture(desc, &texData, &tex);
-
-                        m_meshes[i].m_textures.push_back(tex);
-                    }
+    std::atomic<bool> isValid = true;
+    const MeshContainer::Reader container(packed.m_data, packed.m_size);
+    if(container.isValid())
+    {
+        if(container.getSectionCount() != m_meshes.size() + 1)
+            return false;
 
-                    m_meshes[i].m_name = mesh->name()->c_str();
+        // replaced since the load, unpacking another layout would read garbage
+        for(uint32_t i = 0; i < m_meshes.size(); ++i)
+        {
+            if(container.getSectionVersion(i + 1) != VERSION)
+                return false;
+        }
+
+        JobSystem::get().parallelFor(JobSystem::ESubsystem::Mesh, JobSystem::EPriority::High, static_cast<uint32_t>(m_meshes.size()), 1,
+                                     [&](uint32_t _first, uint32_t _last)
+        {
+            for(uint32_t i = _first; i < _last; ++i)
+            {
+                eastl::vector<uint8_t> section(container.getSectionSize(i + 1));
+                if(!container.decompress(i + 1, section.data()))
+                {
+                    isValid = false;
+                    continue;
                 }
 
-                m_scale = staticMesh->scale();
+                const FlatBuffers::Mesh* mesh = flatbuffers::GetRoot<FlatBuffers::Mesh>(section.data());
+                if(mesh->version() != VERSION || !unpackGeometry(mesh, m_meshes[i]))
+                    isValid = false;
             }
-        }
-        else
+        });
+    }
+    else
+    {
+        const auto* meshes = FlatBuffers::GetStaticMesh(packed.m_data)->meshes();
+        if(meshes->size() != m_meshes.size())
+            return false;
+
+        for(uint32_t i = 0; i < meshes->size(); ++i)
         {
-            LoadFromPath(_path);
-            save();
+            if(meshes->Get(i)->version() != VERSION || !unpackGeometry(meshes->Get(i), m_meshes[i]))
+                isValid = false;
         }
     }
 
-    for(Group& grp : m_meshes)
-    {
-        BufferDesc VertBuffDesc;
-        VertBuffDesc.Name = "Mesh vertex buffer";
-        VertBuffDesc.Usage = USAGE_IMMUTABLE;
-        VertBuffDesc.BindFlags = BIND_VERTEX_BUFFER;
-        VertBuffDesc.Size = sizeof(VertexPacked) * grp.m_vertices.size();
-        BufferData VBData;
-        VBData.pData    = grp.m_vertices.data();
-        VBData.DataSize = grp.m_vertices.size() * sizeof (VertexPacked);// AVOID THIS PLEEEASE
+    return isValid;
+}
+
+size_t Mesh::getCpuBytes() const
+{
+    std::scoped_lock lock(m_mutexCpuData);
 
-        m_device->CreateBuffer(VertBuffDesc, &VBData, &grp.m_meshVertexBuffer);
+    size_t size = 0;
+    for(const Group& group : m_meshes)
+    {
+        size += group.m_vertices.capacity() + group.m_indices.capacity() * sizeof(uint32_t)
+                + group.m_verticesPosRaytrace.capacity() * sizeof(float3) + group.m_indicesRaytrace.capacity() * sizeof(uint32_t)
+                + group.m_meshlets.capacity() * sizeof(Meshlet) + group.m_lods.capacity() * sizeof(Lod)
+                + group.m_occluderVertices.capacity() * sizeof(float3) + group.m_occluderIndices.capacity() * sizeof(uint32_t);
 
-        BufferDesc IndexBuffDesc;
-        IndexBuffDesc.Name = "Mesh index buffer";
-        IndexBuffDesc.Usage = USAGE_IMMUTABLE;
-        IndexBuffDesc.BindFlags = BIND_INDEX_BUFFER;
-        IndexBuffDesc.Size =  grp.m_indices.size() * sizeof(uint16_t);
-        BufferData IBData;
-        IBData.pData    = grp.m_indices.data();
-        IBData.DataSize = grp.m_indices.size() * sizeof (uint16_t);// AVOID THIS PLEEEASE
+        for(const PendingTexture& texture : group.m_pendingTextures)
+        {
+            size += texture.m_data.capacity();
+        }
 
-        m_device->CreateBuffer(IndexBuffDesc, &IBData, &grp.m_meshIndexBuffer);
+        // shared with the other meshes using the same texture
+        for(const TextureCache::Handle& entry : group.m_textureEntries)
+        {
+            if(entry->m_pixels)
+                size += static_cast<size_t>(entry->m_width) * entry->m_height * 4;
+        }
     }
 
-    m_isLoaded = !_needsAfterLoadedActions;
+    return size;
 }
 
 void Mesh::LoadFromPath(const char *_path)
@@ -210,52 +1527,92 @@ void Mesh::LoadFromPath(const char *_path)
 
         Assimp::Importer importer;
 
-        importer.SetPropertyInteger(AI_CONFIG_PP_SLM_VERTEX_LIMIT, 65534); // splitting to have only uint16 indices
+        // no AI_CONFIG_PP_SLM_VERTEX_LIMIT, the groups over 65536 vertices get 32 bits indices instead of being split,
+        // aiProcess_SplitLargeMeshes only kicks in at its default of a million vertices
 
+#if !defined(HEADLESS_COOKER)
         ProgressHandler handler(_path);
         importer.SetProgressHandler(&handler);
+#endif
+        DependencyRecorder recorder(m_importedFiles);
+        importer.SetIOHandler(&recorder);
         const aiScene* scene;
         {
             ZoneNamedN(loading, "Loading File", true);
+            std::error_code error;
+            const uintmax_t fileSize = std::filesystem::file_size(_path, error);
+            ImportTelemetry::Scope read(m_name, ImportTelemetry::EStage::AssimpRead, error ? 0 : fileSize);
 
-            uint32_t flags =  aiProcess_SortByPType | aiProcess_GenUVCoords | aiProcess_Triangulate | aiProcess_CalcTangentSpace | aiProcess_SplitLargeMeshes | aiProcess_OptimizeMeshes | aiProcess_OptimizeGraph | aiProcess_GenSmoothNormals
-                              | aiProcess_GenBoundingBoxes  | aiProcess_GlobalScale;
+            uint32_t flags = getImportFlags();
 
             assert(importer.ValidateFlags(flags));
             scene = importer.ReadFile(_path, flags);
-            importer.ApplyPostProcessing(aiProcess_CalcTangentSpace);
+            if(scene)
+            {
+                importer.ApplyPostProcessing(aiProcess_CalcTangentSpace);
+
+                // what the gather gets out of it, before remapping
+                uint64_t importedBytes = 0;
+                for(uint32_t i = 0; i < scene->mNumMeshes; ++i)
+                {
+                    importedBytes += scene->mMeshes[i]->mNumVertices * sizeof(Vertex) + scene->mMeshes[i]->mNumFaces * 3 * sizeof(uint32_t);
+                }
+                read.setBytesOut(importedBytes);
+            }
+        }
+        importer.SetIOHandler(nullptr);
+
+        if(!scene)
+        {
+            std::cout << "Could not import " << _path << ": " << importer.GetErrorString() << std::endl;
+            importer.SetProgressHandler(nullptr);
+            return;
         }
 
-        m_meshes.reserve(scene->mNumMeshes);
+        // Groups are gathered first so their order in m_meshes only depends on the scene, not on the scheduling
+        eastl::vector<const aiMesh*> meshesToLoad;
+        meshesToLoad.reserve(scene->mNumMeshes);
+        recursivelyLoadNode(scene->mRootNode, scene, meshesToLoad);
+
+        m_meshes.resize(meshesToLoad.size());
+        eastl::vector<GroupImport> imports(meshesToLoad.size());
+
+        tf::Taskflow taskflow("Mesh Import");
+        for(size_t i = 0; i < meshesToLoad.size(); ++i)
+        {
+            loadGroupFrom(*meshesToLoad[i], scene, m_meshes[i], imports[i], taskflow);
+        }
 
-        recursivelyLoadNode(scene->mRootNode, scene);
+        JobSystem::get().run(taskflow);
 
         importer.SetProgressHandler(nullptr);
         importer.FreeScene();
     }
 }
 
-void Mesh::recursivelyLoadNode(aiNode *pNode, const aiScene *pScene)
+void Mesh::recursivelyLoadNode(aiNode *pNode, const aiScene *pScene, eastl::vector<const aiMesh*>& _meshes)
 {
     for(int i = 0; i < pNode->mNumMeshes; i++)
     {
-        m_meshes.emplace_back(loadGroupFrom(*pScene->mMeshes[pNode->mMeshes[i]], pScene));
+        _meshes.push_back(pScene->mMeshes[pNode->mMeshes[i]]);
     }
 
     for(int i = 0; i < pNode->mNumChildren; i++)
     {
-        recursivelyLoadNode(pNode->mChildren[i], pScene);
+        recursivelyLoadNode(pNode->mChildren[i], pScene, _meshes);
     }
 }
 
-Mesh::Group Mesh::loadGroupFrom(const aiMesh& mesh, const aiScene *pScene)
+void Mesh::loadGroupFrom(const aiMesh& mesh, const aiScene *pScene, Group& group, GroupImport& _import, tf::Taskflow& _taskflow)
 {
-    Group group;
+    group.m_indices.reserve(mesh.mNumFaces * 3);
+
+    group.m_aabb.Min = float3(mesh.mAABB.mMin.x, mesh.mAABB.mMin.y, mesh.mAABB.mMin.z);
+    group.m_aabb.Max = float3(mesh.mAABB.mMax.x, mesh.mAABB.mMax.y, mesh.mAABB.mMax.z);
 
-    group.m_vertices.reserve(mesh.mNumVertices);
-    group.m_indices.reserve(mesh.mNumFaces);
+    group.m_name = mesh.mName.C_Str();
 
-    m_executor.silent_async([&](){
+    _taskflow.emplace([&, pScene](){
         ZoneScopedN("Loading Textures");
         ZoneText(m_basePath.c_str(), m_basePath.size());
         //we handle only one material per mesh for now
@@ -275,21 +1632,23 @@ Mesh::Group Mesh::loadGroupFrom(const aiMesh& mesh, const aiScene *pScene)
                     if(mat->GetTexture(type, i, &texPath) == aiReturn_SUCCESS)
                     {
                         eastl::string str = texPath.C_Str();
-                        addTexture(str, group);
+                        addTexture(str, group, getTextureType(type, str));
                     }
                 }
             }
         }
-    });
-    m_executor.silent_async([&](){
+    }).name("Texture decode");
+
+    tf::Task gather = _taskflow.emplace([&](){
       ZoneNamedN(loading, "Loading Vertices and Indices", true);
       ZoneTextV(loading, m_basePath.c_str(), m_basePath.size());
 
-      eastl::vector<Vertex> vertices; // NOT packed
+      eastl::vector<Vertex>& vertices = _import.m_vertices; // NOT packed
       vertices.reserve(mesh.mNumVertices);
         for(int i = 0; i < mesh.mNumVertices; ++i)
         {
             Vertex v{};
+            v.m_bitangentSign = 1.0f;
 
             v.m_position.x = mesh.mVertices[i].x;
             v.m_position.y = mesh.mVertices[i].y;
@@ -309,6 +1668,10 @@ Mesh::Group Mesh::loadGroupFrom(const aiMesh& mesh, const aiScene *pScene)
                     v.m_tangent.x = mesh.mTangents[i].x;
                     v.m_tangent.y = mesh.mTangents[i].y;
                     v.m_tangent.z = mesh.mTangents[i].z;
+
+                    // the shaders rebuild the bitangent as cross(tangent, normal), mirrored uvs need it flipped
+                    const float3 bitangent(mesh.mBitangents[i].x, mesh.mBitangents[i].y, mesh.mBitangents[i].z);
+                    v.m_bitangentSign = dot(cross(v.m_tangent, v.m_normal), bitangent) < 0.0f ? -1.0f : 1.0f;
                 }
             }
 
@@ -339,14 +1702,18 @@ Mesh::Group Mesh::loadGroupFrom(const aiMesh& mesh, const aiScene *pScene)
               group.m_indices.emplace_back(face.mIndices[j]);
           }
       }
+    }).name("Gather");
 
-      ZoneNamedN(optim, "Optimizations", true);
+    tf::Task remap = _taskflow.emplace([&](){
+      ZoneNamedN(optim, "Remap", true);
       ZoneTextV(optim, m_basePath.c_str(), m_basePath.size());
-     size_t index_count = group.m_indices.size();
+      eastl::vector<Vertex>& vertices = _import.m_vertices;
+      size_t index_count = group.m_indices.size();
+      ImportTelemetry::Scope telemetry(m_name, ImportTelemetry::EStage::Remap, vertices.size() * sizeof(Vertex) + index_count * sizeof(uint32_t));
       eastl::vector<unsigned int> remap(index_count); // allocate temporary memory for the remap table of indices
       size_t vertex_count = meshopt_generateVertexRemap(&remap[0], &group.m_indices[0], index_count, &vertices[0], index_count, sizeof(Vertex));
       eastl::vector<Vertex> verticesToBeRemapped(vertex_count);
-      eastl::vector<uint16_t> indicesToBeRemapped(index_count);
+      eastl::vector<uint32_t> indicesToBeRemapped(index_count);
 
       meshopt_remapIndexBuffer(&indicesToBeRemapped[0],  &group.m_indices[0], index_count, &remap[0]);
       meshopt_remapVertexBuffer(&verticesToBeRemapped[0], &vertices[0], index_count, sizeof(Vertex), &remap[0]);
@@ -354,50 +1721,92 @@ Mesh::Group Mesh::loadGroupFrom(const aiMesh& mesh, const aiScene *pScene)
       const size_t oldVertexCount = vertices.size();
       const size_t oldIndexCount = group.m_indices.size();
 
-      vertices = verticesToBeRemapped;
-      group.m_indices = indicesToBeRemapped;
+      vertices = eastl::move(verticesToBeRemapped);
+      group.m_indices = eastl::move(indicesToBeRemapped);
+      _import.m_vertexCount = vertex_count;
+      group.m_indexType = getIndexType(vertex_count);
+      telemetry.setBytesOut(vertex_count * sizeof(Vertex) + index_count * sizeof(uint32_t));
 #if defined(_DEBUG)
       std::cout << "Previous vertex count " << oldVertexCount << " new vertex count " << vertices.size() << "\n"
       << "Previous indices count " << oldIndexCount << " new indices count " << group.m_indices.size() << "\n"
       << "Improvements: vertex " <<  (float)oldVertexCount / vertices.size() << " index " <<  (float)oldIndexCount / group.m_indices.size() << std::endl;
 #endif
-      meshopt_optimizeVertexCache(&group.m_indices[0], &group.m_indices[0], index_count, vertex_count);
-
-      meshopt_optimizeOverdraw(&group.m_indices[0], &group.m_indices[0], index_count,(&vertices[0].m_position.x), vertex_count, sizeof(Vertex), 1.05f);
-      meshopt_optimizeVertexFetch( &vertices[0], &group.m_indices[0], index_count,  &vertices[0], vertex_count, sizeof(Vertex));
-
+    }).name("Remap");
+
+    tf::Task vertexCache = _taskflow.emplace([&](){
+      ZoneNamedN(optim, "Optimize Vertex Cache", true);
+      const uint64_t indexBytes = group.m_indices.size() * sizeof(uint32_t);
+      ImportTelemetry::Scope telemetry(m_name, ImportTelemetry::EStage::VertexCache, indexBytes);
+      telemetry.setBytesOut(indexBytes);
+      meshopt_optimizeVertexCache(&group.m_indices[0], &group.m_indices[0], group.m_indices.size(), _import.m_vertexCount);
+    }).name("Vertex cache");
+
+    tf::Task overdraw = _taskflow.emplace([&](){
+      ZoneNamedN(optim, "Optimize Overdraw", true);
+      auto& vertices = _import.m_vertices;
+      const size_t index_count = group.m_indices.size();
+      const uint64_t geometryBytes = _import.m_vertexCount * sizeof(Vertex) + index_count * sizeof(uint32_t);
+      ImportTelemetry::Scope telemetry(m_name, ImportTelemetry::EStage::Overdraw, geometryBytes);
+      telemetry.setBytesOut(geometryBytes);
+      meshopt_optimizeOverdraw(&group.m_indices[0], &group.m_indices[0], index_count,(&vertices[0].m_position.x), _import.m_vertexCount, sizeof(Vertex), 1.05f);
+      meshopt_optimizeVertexFetch( &vertices[0], &group.m_indices[0], index_count,  &vertices[0], _import.m_vertexCount, sizeof(Vertex));
+    }).name("Overdraw");
+
+    tf::Task meshlets = _taskflow.emplace([&](){
+      ZoneNamedN(clusters, "Build Meshlets", true);
+      ZoneTextV(clusters, m_basePath.c_str(), m_basePath.size());
+      ImportTelemetry::Scope telemetry(m_name, ImportTelemetry::EStage::Meshlets,
+                                       _import.m_vertexCount * sizeof(Vertex) + group.m_indices.size() * sizeof(uint32_t));
+      buildMeshlets(group, &_import.m_vertices[0].m_position.x, _import.m_vertexCount, sizeof(Vertex));
+      // the indices are reordered cluster by cluster
+      telemetry.setBytesOut(group.m_meshlets.size() * sizeof(Meshlet) + group.m_indices.size() * sizeof(uint32_t));
+    }).name("Meshlets");
+
+    tf::Task lods = _taskflow.emplace([&](){
+      ZoneNamedN(simplify, "Generate LODs", true);
+      ZoneTextV(simplify, m_basePath.c_str(), m_basePath.size());
+      ImportTelemetry::Scope telemetry(m_name, ImportTelemetry::EStage::Lods,
+                                       _import.m_vertexCount * sizeof(Vertex) + group.m_indices.size() * sizeof(uint32_t));
+      buildLods(group, &_import.m_vertices[0].m_position.x, _import.m_vertexCount, sizeof(Vertex));
+      // the coarser LODs are appended to the indices
+      telemetry.setBytesOut(group.m_lods.size() * sizeof(Lod) + group.m_indices.size() * sizeof(uint32_t));
+    }).name("LODs");
+
+    tf::Task occluder = _taskflow.emplace([&](){
+      ZoneNamedN(simplify, "Build Occluder", true);
+      ZoneTextV(simplify, m_basePath.c_str(), m_basePath.size());
+      ImportTelemetry::Scope telemetry(m_name, ImportTelemetry::EStage::Occluder,
+                                       group.m_verticesPosRaytrace.size() * sizeof(float3) + group.m_indicesRaytrace.size() * sizeof(uint32_t));
+      buildOccluder(group);
+      telemetry.setBytesOut(group.m_occluderVertices.size() * sizeof(float3) + group.m_occluderIndices.size() * sizeof(uint32_t));
+    }).name("Occluder");
+
+    tf::Task quantization = _taskflow.emplace([&](){
           ZoneNamedN(packing, "Quantization", true);
           ZoneTextV(packing, m_basePath.c_str(), m_basePath.size());
-          group.m_vertices.reserve(vertices.size());
-          for(const auto& v : vertices)
-          {
-              VertexPacked vertPacked;
-              vertPacked.m_position.x = meshopt_quantizeHalf(v.m_position.x);
-              vertPacked.m_position.x = meshopt_quantizeHalf(v.m_position.y) | vertPacked.m_position.x << 16;
-              vertPacked.m_position.y = meshopt_quantizeHalf(v.m_position.z);
-
-              // Z = cross(x, y)
-              vertPacked.m_normaluv.x = meshopt_quantizeHalf(v.m_normal.x) << 16 | meshopt_quantizeHalf(v.m_normal.y);
-
-              vertPacked.m_normaluv.y = meshopt_quantizeHalf(v.m_uv.x) << 16 | meshopt_quantizeHalf(v.m_uv.y);
-
-              vertPacked.m_tangent = meshopt_quantizeHalf(v.m_tangent.x) << 16 | meshopt_quantizeHalf(v.m_tangent.y);
-
-              group.m_vertices.emplace_back(vertPacked);
-          }
-    });
-
-    group.m_aabb.Min = float3(mesh.mAABB.mMin.x, mesh.mAABB.mMin.y, mesh.mAABB.mMin.z);
-    group.m_aabb.Max = float3(mesh.mAABB.mMax.x, mesh.mAABB.mMax.y, mesh.mAABB.mMax.z);
-
-    group.m_name = mesh.mName.C_Str();
-
-    m_executor.wait_for_all();
-
-    return group;
+          auto& vertices = _import.m_vertices;
+          ImportTelemetry::Scope telemetry(m_name, ImportTelemetry::EStage::Quantization, vertices.size() * sizeof(Vertex));
+          // AssetCooker --test-quantization checks the error of every layout
+          group.m_vertexLayout = cookSettings.m_vertexLayout;
+          group.m_vertices.resize(vertices.size() * getVertexSize(group.m_vertexLayout));
+          VertexQuantization::pack(group.m_vertexLayout, vertices.data(), vertices.size(), group.m_aabb, group.m_vertices.data());
+          telemetry.setBytesOut(group.m_vertices.size());
+
+          // The unpacked vertices are not needed anymore
+          vertices = eastl::vector<Vertex>();
+    }).name("Quantization");
+
+    gather.precede(remap);
+    // only reads the raytracing streams, next to the other steps
+    gather.precede(occluder);
+    remap.precede(vertexCache);
+    vertexCache.precede(overdraw);
+    overdraw.precede(meshlets);
+    meshlets.precede(lods);
+    lods.precede(quantization);
 }
 
-void Mesh::addTexture(eastl::string& _path, Group& _group)
+void Mesh::addTexture(eastl::string& _path, Group& _group, ETextureType _type)
 {
     auto pos = _path.find('\\');
     if( pos != eastl::string::npos)
@@ -406,65 +1815,56 @@ void Mesh::addTexture(eastl::string& _path, Group& _group)
     }
     eastl::string pathToTex = m_basePath + _path;
 
-    RefCntAutoPtr<ITexture> tex;
-
-    /*if(m_texturesLoaded.find(pathToTex) != m_texturesLoaded.end())
-    {
-        tex = m_texturesLoaded[pathToTex];
-        std::cout << "Found the texture... loading " << _path.c_str() << " Tex" << std::endl;
-    }
-    else*/
-    {
-        int width, height, cmps;
-        stbi_info(pathToTex.c_str(), &width, &height, &cmps);
-
-        {
-            TextureDesc desc;
-            desc.Name = _path.c_str();
-            desc.Height = height;
-            desc.Width = width;
-            desc.Type = Diligent::RESOURCE_DIM_TEX_2D;
-            desc.BindFlags = Diligent::BIND_SHADER_RESOURCE;
-
-            desc.Format = pathToTex.find("_A") != eastl::string::npos ? Diligent::TEX_FORMAT_RGBA8_UNORM_SRGB
-                    : Diligent::TEX_FORMAT_RGBA8_UNORM;
+    const TEXTURE_FORMAT format = pathToTex.find("_A") != eastl::string::npos ? Diligent::TEX_FORMAT_RGBA8_UNORM_SRGB
+            : Diligent::TEX_FORMAT_RGBA8_UNORM;
 
-            int x, y, chnls;
-            auto* data = stbi_load(pathToTex.c_str(), &width, &height, &chnls, 4);
-            TextureSubResData subResData;
-            subResData.pData = data;
-            subResData.Stride = sizeof(unsigned char) * 4 * width;
+    std::error_code error;
+    const uintmax_t fileSize = std::filesystem::file_size(pathToTex.c_str(), error);
+    ImportTelemetry::Scope telemetry(m_name, ImportTelemetry::EStage::TextureDecode, error ? 0 : fileSize);
 
-            TextureData textureData;
-            textureData.NumSubresources = 1;
-            textureData.pSubResources = &subResData;
+    // a texture shared by several meshes is decoded once, the others wait for it or get it right away
+    TextureCache::Handle entry = TextureCache::get().loadFromFile(m_device, pathToTex.c_str(), _path.c_str(), format, getMipFilter(_type));
+    if(!entry || !entry->isValid())
+        return;
+    telemetry.setBytesOut(static_cast<uint64_t>(entry->m_width) * entry->m_height * 4);
 
-            m_device->CreateTexture(desc, &textureData, &tex);
-
-            auto* dataSaved = new unsigned char[height * width * 4];
-            memcpy_s(dataSaved, sizeof(unsigned char) * width * height * 4, data, sizeof(unsigned char) * width * height * 4);
-            _group.m_texturesData.push_back(dataSaved);
-
-            stbi_image_free(data);
-        }
-
-        m_texturesLoaded[pathToTex] = tex;
-        std::cout << "Creating " << _path.c_str() << " Tex" << std::endl;
+    // added after the save, nothing will cook it
+    if(m_arePixelsReleased)
+    {
+        TextureCache::get().releasePixels(*entry);
     }
 
-    _group.m_textures.emplace_back(tex);
+    _group.m_textures.emplace_back(entry->m_texture);
+    _group.m_textureEntries.emplace_back(eastl::move(entry));
+    _group.m_textureTypes.emplace_back(_type);
 }
 
 void Mesh::addTexture(eastl::string &_path, int index)
 {
-    addTexture(_path, m_meshes[index]);
+    addTexture(_path, m_meshes[index], getTextureTypeFromPath(_path));
 }
 
 void Mesh::drawInspector()
 {
+#if !defined(HEADLESS_COOKER)
     static bool hasChanged = false;
     ImGui::PushID(m_id);
     ImGui::Text("%s", m_basePath.c_str());
+    ImGui::Text("CPU data: %.2fMB%s", ProcessMemory::toMB(getCpuBytes()), m_isCpuDataReleased ? " (geometry released)" : "");
+    if(ImGui::TreeNode("LODs"))
+    {
+        // the triangles of the full group then of each of its LODs, with their error in local space
+        for(const Group& group : m_meshes)
+        {
+            ImGui::Text("%s: %u", group.m_name.c_str(), group.m_indexCount / 3);
+            for(const Lod& lod : group.m_lods)
+            {
+                ImGui::SameLine();
+                ImGui::Text("> %u (%.4f)", lod.m_indexCount / 3, lod.m_error);
+            }
+        }
+        ImGui::TreePop();
+    }
         if(ImGui::DragFloat3("Translation", m_position.Data()))
         {
             hasChanged = true;
@@ -485,10 +1885,9 @@ void Mesh::drawInspector()
     ImGui::PopID();
     if(hasChanged)
     {
-        //Update matrix
-        //todo fsantoro: cache this somewhere -> m_rotation.ToMatrix()
-        m_model = float4x4::Scale(m_scale) * m_rotation.ToMatrix() * float4x4::Translation(m_position);
+        updateModel();
     }
+#endif
 }
 
 bool Mesh::isTransparent() const
@@ -506,10 +1905,10 @@ void Mesh::setTransparent(bool mIsTransparent)
 bool Mesh::isClicked(const float4x4& _mvp, const float3 &RayOrigin, const float3 &RayDirection, float &EnterDist,
                      float &ExitDist)
 {
+    updateWorldBounds();
     for(const auto& grp : m_meshes)
     {
-        const BoundBox box = grp.m_aabb.Transform(m_model);
-        if(IntersectRayAABB(RayOrigin, RayDirection, box, EnterDist, ExitDist))
+        if(IntersectRayAABB(RayOrigin, RayDirection, grp.m_aabbWorld, EnterDist, ExitDist))
             return true;
     }
 
@@ -520,99 +1919,234 @@ bool Mesh::isClicked(const float4x4& _mvp, const float3 &RayOrigin, const float3
 void Mesh::setTranslation(Vector3<float>& vector3)
 {
     m_position = vector3;
+    updateModel();
 }
 
 void Mesh::setScale(float scale)
 {
     m_scale = scale;
+    updateModel();
+}
+
+void Mesh::updateModel()
+{
+    m_model = float4x4::Scale(m_scale) * m_rotation.ToMatrix() * float4x4::Translation(m_position);
+    m_isTransformDirty = true;
+}
+
+uint32_t Mesh::updateWorldBounds()
+{
+    if(!m_isTransformDirty)
+        return 0;
+
+    ZoneScopedN("Update World Bounds");
+    m_isTransformDirty = false;
+
+    m_boundingBox.Min = float3(eastl::numeric_limits<float>::max());
+    m_boundingBox.Max = float3(eastl::numeric_limits<float>::lowest());
+    for(Group& group : m_meshes)
+    {
+        group.m_aabbWorld = group.m_aabb.Transform(m_model);
+
+        // the scale is uniform, the radius only scales
+        const float4 center = float4((group.m_aabb.Min + group.m_aabb.Max) * 0.5f, 1.0f) * m_model;
+        group.m_sphereCenterWorld = float3(center.x, center.y, center.z);
+        group.m_sphereRadiusWorld = length(group.m_aabb.Max - group.m_aabb.Min) * 0.5f * m_scale;
+
+        m_boundingBox.Min = std::min(group.m_aabb.Min * m_scale, m_boundingBox.Min);
+        m_boundingBox.Max = std::max(group.m_aabb.Max * m_scale, m_boundingBox.Max);
+    }
+
+    return static_cast<uint32_t>(m_meshes.size());
+}
+
+uint32_t Mesh::cullMeshlets(const float4x4& _viewProj, const float3& _cameraPosition)
+{
+    ZoneScopedN("Cull Meshlets");
+
+    // everything is tested in local space: the planes of model * viewProj are the frustum in local space,
+    // and as the scale is uniform the cones keep their angles
+    ViewFrustum frustum;
+    ExtractViewFrustumPlanesFromMatrix(m_model * _viewProj, frustum, false);
+
+    Plane3D planes[] = {frustum.LeftPlane, frustum.RightPlane, frustum.BottomPlane, frustum.TopPlane, frustum.NearPlane, frustum.FarPlane};
+    for(Plane3D& plane : planes)
+    {
+        // the extracted planes are not normalized, the spheres need the actual distance
+        const float invLength = 1.0f / length(plane.Normal);
+        plane.Normal *= invLength;
+        plane.Distance *= invLength;
+    }
+
+    const float4 cameraLocal = float4(_cameraPosition, 1.0f) * m_model.Inverse();
+    const float3 cameraPosition(cameraLocal.x, cameraLocal.y, cameraLocal.z);
+
+    uint32_t culledCount = 0;
+    for(Group& group : m_meshes)
+    {
+        group.m_visibleRanges.clear();
+
+        if(group.m_meshlets.empty())
+        {
+            group.m_visibleRanges.push_back({0, group.m_indexCount});
+            continue;
+        }
+
+        if(GetBoxVisibility(frustum, group.m_aabb) == BoxVisibility::Invisible)
+        {
+            culledCount += static_cast<uint32_t>(group.m_meshlets.size());
+            continue;
+        }
+
+        for(const Meshlet& meshlet : group.m_meshlets)
+        {
+            bool isVisible = dot(normalize(meshlet.m_coneApex - cameraPosition), meshlet.m_coneAxis) < meshlet.m_coneCutoff;
+            for(const Plane3D& plane : planes)
+            {
+                isVisible &= dot(plane.Normal, meshlet.m_center) + plane.Distance >= -meshlet.m_radius;
+            }
+
+            if(!isVisible)
+            {
+                ++culledCount;
+                continue;
+            }
+
+            // neighbours are merged so a group mostly visible is still a few draws
+            if(!group.m_visibleRanges.empty() && group.m_visibleRanges.back().m_firstIndex + group.m_visibleRanges.back().m_indexCount == meshlet.m_firstIndex)
+            {
+                group.m_visibleRanges.back().m_indexCount += meshlet.m_indexCount;
+            }
+            else
+            {
+                group.m_visibleRanges.push_back({meshlet.m_firstIndex, meshlet.m_indexCount});
+            }
+        }
+    }
+
+    return culledCount;
 }
 
-BoundBox Mesh::getBoundingBox()
+uint32_t Mesh::selectLod(const Group& _group, const float3& _cameraPosition, float _projectionScale, float _maxPixelError) const
 {
-    BoundBox aabb;
-    aabb.Min = float3(eastl::numeric_limits<float>::max());
-    aabb.Max = float3(eastl::numeric_limits<float>::min());
+    if(_group.m_lods.size() < 2)
+        return 0;
+
+    const float localRadius = length(_group.m_aabb.Max - _group.m_aabb.Min) * 0.5f;
+    const float radius = _group.m_sphereRadiusWorld;
 
-    for(auto& mesh : m_meshes)
+    // inside the sphere it covers the whole screen, full detail
+    const float distance = length(_group.m_sphereCenterWorld - _cameraPosition) - radius;
+    if(distance <= 0.0f || localRadius <= 0.0f)
+        return 0;
+
+    // the error of a LOD is a fraction of the sphere, so it covers that fraction of its projection
+    const float projectedRadius = radius * _projectionScale / distance;
+    for(uint32_t lod = static_cast<uint32_t>(_group.m_lods.size()) - 1; lod > 0; --lod)
     {
-        BoundBox b = mesh.m_aabb;
-        aabb.Min = std::min(b.Min * m_scale, aabb.Min);
-        aabb.Max = std::max(b.Max * m_scale, aabb.Max);
+        if(_group.m_lods[lod].m_error / localRadius * projectedRadius <= _maxPixelError)
+            return lod;
     }
 
-    return aabb;
+    return 0;
+}
+
+SceneStore::LodInfo Mesh::getLodInfo(const Group& _group)
+{
+    SceneStore::LodInfo info{};
+    const float localRadius = length(_group.m_aabb.Max - _group.m_aabb.Min) * 0.5f;
+
+    // a flat group keeps its full detail, like in selectLod
+    info.m_count = localRadius > 0.0f ? static_cast<uint32_t>(eastl::min<size_t>(_group.m_lods.size(), SceneStore::MAX_LODS)) : 0;
+    for(uint32_t lod = 0; lod < info.m_count; ++lod)
+    {
+        info.m_errorRatios[lod] = _group.m_lods[lod].m_error / localRadius;
+    }
+    return info;
 }
 
 void Mesh::save()
 {
-    flatbuffers::FlatBufferBuilder builder(m_meshes[0].m_vertices.size() * sizeof(VertexPacked));
-    eastl::vector<flatbuffers::Offset<FlatBuffers::Mesh>> meshesfbs;
-    FlatBuffers::Vec3 aabbMinStaticMesh(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
-    FlatBuffers::Vec3 aabbMaxStaticMesh(std::numeric_limits<float>::min(), std::numeric_limits<float>::min(), std::numeric_limits<float>::min());
+    ZoneScopedN("Save Mesh");
+    CookedTextures cookedTextures;
+
+    // the textures are cooked (mips and block compression) while the groups are built
+    ImportTelemetry::Scope telemetry(m_name, ImportTelemetry::EStage::FlatbufferBuild, getCpuBytes());
 
-    for (auto & mesh : m_meshes)
+    size_t fileSize = 0;
+    if(cookSettings.m_isCompressed)
     {
-        auto vecVerticesUnpacked = builder.CreateVectorOfStructs(reinterpret_cast<FlatBuffers::Vertex*>(mesh.m_verticesPosRaytrace.data()), mesh.m_verticesPosRaytrace.size());
-        auto vecIndicesUnpacked = builder.CreateVector(mesh.m_indicesRaytrace.data(), mesh.m_indicesRaytrace.size());
-        auto vecVertices = builder.CreateVectorOfStructs(reinterpret_cast<FlatBuffers::VertexPacked*>(mesh.m_vertices.data()), mesh.m_vertices.size());
-        auto vecIndices = builder.CreateVector(mesh.m_indices.data(), mesh.m_indices.size());
-        auto vecTexture = eastl::vector<flatbuffers::Offset<FlatBuffers::Texture>>();
-        for (int texIndex = 0; texIndex < mesh.m_textures.size(); ++texIndex)
+        // section 0 is the scene without its groups, then one flatbuffer per group so each one can be decoded on its own
+        eastl::vector<flatbuffers::DetachedBuffer> sections;
         {
-            auto& texture = mesh.m_textures[texIndex];
-            auto texDesc = texture->GetDesc();
+            flatbuffers::FlatBufferBuilder builder;
+            builder.Finish(buildStaticMesh(builder, {}, m_scale));
+            sections.push_back(builder.Release());
+        }
 
-            auto vecTexData = builder.CreateVector(mesh.m_texturesData[texIndex], texDesc.Width * texDesc.Height * 4);
-            auto nameTex = builder.CreateString(texDesc.Name);
-            auto texType = texDesc.Format == TEX_FORMAT_RGBA8_UNORM_SRGB ? FlatBuffers::TextureType::TextureType_Albedo :FlatBuffers::TextureType::TextureType_Normal;
-            auto dims = FlatBuffers::uint2(texDesc.Width, texDesc.Height);
+        for (auto & mesh : m_meshes)
+        {
+            flatbuffers::FlatBufferBuilder builder(mesh.m_vertices.size());
+            builder.Finish(buildGroup(builder, mesh, cookedTextures));
+            sections.push_back(builder.Release());
+        }
 
-            auto textureFbs = FlatBuffers::TextureBuilder(builder);
-            textureFbs.add_data(vecTexData);
-            textureFbs.add_name(nameTex);
-            textureFbs.add_type(texType);
-            textureFbs.add_dims(&dims);
+        eastl::vector<MeshContainer::SectionData> sectionsData;
+        for (const auto& section : sections)
+        {
+            sectionsData.push_back({section.data(), section.size(), sectionsData.empty() ? SCENE_VERSION : VERSION});
+        }
 
-            vecTexture.push_back(textureFbs.Finish());
+        fileSize = MeshContainer::write(m_flatbufferPath.c_str(), VERSION, sectionsData, cookSettings.m_compressionLevel);
+    }
+    else
+    {
+        flatbuffers::FlatBufferBuilder builder(m_meshes[0].m_vertices.size());
+        eastl::vector<flatbuffers::Offset<FlatBuffers::Mesh>> meshesfbs;
+
+        for (auto & mesh : m_meshes)
+        {
+            meshesfbs.push_back(buildGroup(builder, mesh, cookedTextures));
         }
 
-        auto vecTexFbs = builder.CreateVector(vecTexture.data(), vecTexture.size());
-        auto aabbMin = FlatBuffers::Vec3(mesh.m_aabb.Min.x, mesh.m_aabb.Min.y, mesh.m_aabb.Min.z);
-        auto aabbMax = FlatBuffers::Vec3(mesh.m_aabb.Max.x, mesh.m_aabb.Max.y, mesh.m_aabb.Max.z);
-        auto nameFbs = builder.CreateString(mesh.m_name.c_str());
-        auto meshFbs = FlatBuffers::MeshBuilder(builder);
-        meshFbs.add_textures(vecTexFbs);
+        builder.Finish(buildStaticMesh(builder, meshesfbs, m_scale));
 
-        meshFbs.add_version(VERSION);
-        meshFbs.add_vertex_unpacked(vecVerticesUnpacked);
-        meshFbs.add_indices_unpacked(vecIndicesUnpacked);
-        meshFbs.add_vertex(vecVertices);
-        meshFbs.add_indices(vecIndices);
-        meshFbs.add_aabb_min(&aabbMin);
-        meshFbs.add_aabb_max(&aabbMax);
+        auto* pointerBuffer = builder.GetBufferPointer();
+        auto sizeBuffer = builder.GetSize();
 
-        meshFbs.add_name(nameFbs);
+        std::ofstream fileWriter = std::ofstream(m_flatbufferPath.c_str(), std::ios_base::binary);
 
-        meshesfbs.push_back(meshFbs.Finish());
+        if (fileWriter.good())
+        {
+            fileWriter.write(reinterpret_cast<char *>(pointerBuffer), sizeBuffer);
+            fileSize = sizeBuffer;
+        }
     }
 
-    auto meshVectorFbs = builder.CreateVector(meshesfbs.data(), meshesfbs.size());
-    auto staticMeshBuilder = FlatBuffers::StaticMeshBuilder(builder);
-    staticMeshBuilder.add_meshes(meshVectorFbs);
-    staticMeshBuilder.add_aabb_max(&aabbMaxStaticMesh);
-    staticMeshBuilder.add_aabb_min(&aabbMinStaticMesh);
-    staticMeshBuilder.add_scale(m_scale);
+    telemetry.setBytesOut(fileSize);
 
-    builder.Finish(staticMeshBuilder.Finish());
+    // written next to the source, the archive still holds the old one
+    m_isCpuDataReloadable = fileSize > 0;
+    m_isCpuDataPacked = false;
+}
 
-    auto* pointerBuffer = builder.GetBufferPointer();
-    auto sizeBuffer = builder.GetSize();
+void Mesh::saveContainer(const eastl::vector<eastl::vector<uint8_t>>& _sections)
+{
+    ZoneScopedN("Save Mesh Container");
 
-    std::ofstream fileWriter = std::ofstream(m_flatbufferPath.c_str(), std::ios_base::binary);
+    // the sections are all at the current version, the scene first
+    eastl::vector<MeshContainer::SectionData> sectionsData;
+    for (const auto& section : _sections)
+    {
+        sectionsData.push_back({section.data(), section.size(), sectionsData.empty() ? SCENE_VERSION : VERSION});
+    }
 
-    if (fileWriter.good())
+    // the loose file is the only one at the current version now, the old one can't be read back either way
+    m_isCpuDataReloadable = MeshContainer::write(m_flatbufferPath.c_str(), VERSION, sectionsData, cookSettings.m_compressionLevel) > 0;
+    m_isCpuDataPacked = false;
+    if (!m_isCpuDataReloadable)
     {
-        fileWriter.write(reinterpret_cast<char *>(pointerBuffer), sizeBuffer);
+        std::cout << "Could not save the upgraded " << m_flatbufferPath.c_str() << ", it will be upgraded again next time" << std::endl;
     }
 }
 
@@ -5,52 +5,146 @@
 #ifndef GRAPHICSPLAYGROUND_MESH_H
 #define GRAPHICSPLAYGROUND_MESH_H
 
+#if defined(_WIN32)
 #define PLATFORM_WIN32 1
+#endif
 
+#include <atomic>
+#include <mutex>
 #include <assimp/scene.h>
 #include <EASTL/string.h>
 #include <EASTL/vector.h>
 #include <EASTL/unordered_map.h>
-#include "FirstPersonCamera.hpp"
+#include "Common/interface/BasicMath.hpp"
+#include "TextureCache.hpp"
 #include "RenderDevice.h"
 #include "Common/interface/RefCntAutoPtr.hpp"
-#include "taskflow/core/executor.hpp"
-#include "taskflow/taskflow.hpp"
 #include "Common/interface/AdvancedMath.hpp"
 #include "Graphics/GraphicsAccessories/interface/GraphicsAccessories.hpp"
+#include "SceneStore.hpp"
 
 
-static constexpr uint32_t VERSION = 9;
+// Every kind of section of the .mesh has its own version. Bump the one whose layout changes and, when it adds data, the step
+// computing it for the older ones in Mesh.cpp (GROUP_UPGRADES), the cooked files are then migrated when loaded instead of imported again.
+static constexpr uint32_t VERSION = 17; // of the groups (FlatBuffers::Mesh)
+static constexpr uint32_t SCENE_VERSION = 14; // of the scene (FlatBuffers::StaticMesh without its groups)
 
 using namespace Diligent;
 
-struct VertexPacked
+namespace FlatBuffers { struct StaticMesh; struct Mesh; }
+namespace MeshContainer { class Reader; }
+namespace tf { class Taskflow; }
+
+// Layout of the packed vertices, a cook setting (see Mesh::CookSettings) stored in every group of the .mesh.
+// Same values as FlatBuffers::VertexLayout, every mesh pipeline exists once per drawable layout (see Engine::getMeshPipelineName).
+enum class EVertexLayout : uint8_t
+{
+    Half = 0, // VertexHalf
+    Octahedral, // VertexOctahedral, the dequantization goes in the matrix of each draw (see Mesh::getDequantization)
+    Count
+};
+
+// half positions, normal/tangent x y in half with z rebuilt in the shader (20 bytes)
+struct VertexHalf
 {
     uint2 m_position;
     uint2 m_normaluv; // x 8 LMB y 8, z = cross(x,y)
     uint m_tangent;
 };
 
+// 16 bits unorm positions in the AABB of the group, octahedral normal/tangent and the bitangent sign (16 bytes)
+struct VertexOctahedral
+{
+    uint2 m_position; // x = x | y << 16, y = z | tangent << 16 with the tangent octahedral in 2x8 bits
+    uint2 m_normaluv; // x = normal octahedral in 2x15 bits | bitangent sign << 30, y = uv in half
+};
+
 struct Vertex
 {
     float3 m_position;
     float3 m_normal;
     float2 m_uv;
     float3 m_tangent;
+    float m_bitangentSign; // 1 when the bitangent is cross(tangent, normal), -1 for mirrored uvs
 };
 
 class Mesh {
 public:
+    // What a texture is used for, decides how it is compressed when cooking
+    enum class ETextureType : uint8_t
+    {
+        Albedo = 0,
+        Normal,
+        Roughness
+    };
+
+    // Cluster of up to MESHLET_MAX_TRIANGLES triangles, its triangles are contiguous in the group index buffer.
+    // Layout matches FlatBuffers::Meshlet.
+    struct Meshlet
+    {
+        float3 m_center; // bounding sphere, in local space
+        float m_radius;
+        float3 m_coneApex;
+        float3 m_coneAxis;
+        float m_coneCutoff; // the meshlet is back facing when dot(normalize(m_coneApex - camera), m_coneAxis) >= m_coneCutoff
+        uint32_t m_firstIndex;
+        uint32_t m_indexCount;
+    };
+
+    static constexpr size_t MESHLET_MAX_VERTICES = 64;
+    static constexpr size_t MESHLET_MAX_TRIANGLES = 124;
+
+    // Simplified version of a group, its indices are stored after the ones of the full detail in the same index buffer
+    struct Lod
+    {
+        uint32_t m_firstIndex;
+        uint32_t m_indexCount;
+        float m_error; // deviation from the full detail, in local space
+    };
+
+    static constexpr size_t LOD_MAX_COUNT = 5; // full detail included
+
+    struct IndexRange
+    {
+        uint32_t m_firstIndex;
+        uint32_t m_indexCount;
+    };
+
+    // Cooked texture whose GPU texture is only created by uploadGroup
+    struct PendingTexture
+    {
+        TextureDesc m_desc; // without its name, m_name can move
+        eastl::string m_name;
+        eastl::vector<uint8_t> m_data; // every mip back to back, biggest first
+        ETextureType m_type;
+    };
+
     struct Group
     {
         eastl::string m_name;
-        eastl::vector<VertexPacked> m_vertices;
-        eastl::vector<uint16_t> m_indices;
+        eastl::vector<uint8_t> m_vertices; // packed in m_vertexLayout, see getVertexCount
+        EVertexLayout m_vertexLayout = EVertexLayout::Half;
+        eastl::vector<uint32_t> m_indices; // always 32 bits on the CPU, m_indexType is the width of the index buffer
+        VALUE_TYPE m_indexType = VT_UINT16;
         eastl::vector<float3> m_verticesPosRaytrace; // used for raytracing
         eastl::vector<uint32_t> m_indicesRaytrace;
+        // simplified copy of the raytracing streams for the software occlusion culling, cooked in the .mesh and kept on the CPU for as long as the mesh lives.
+        // Empty when the group can't be simplified under the budget without growing past its silhouette
+        eastl::vector<float3> m_occluderVertices;
+        eastl::vector<uint32_t> m_occluderIndices;
         eastl::vector<RefCntAutoPtr<ITexture>> m_textures;
-        eastl::vector<unsigned char*> m_texturesData; // used to save textures on disk
+        eastl::vector<TextureCache::Handle> m_textureEntries; // keeps the cached textures alive, their pixels are used to save textures on disk
+        eastl::vector<ETextureType> m_textureTypes;
         BoundBox m_aabb; // In local space
+        BoundBox m_aabbWorld; // m_aabb through the model matrix, see updateWorldBounds
+        float3 m_sphereCenterWorld;
+        float m_sphereRadiusWorld = 0.0f;
+        uint32_t m_indexCount = 0; // of the full detail, m_indices can be empty when uploaded straight from the cooked file
+        eastl::vector<Lod> m_lods; // [0] is the full detail, empty for groups without LODs
+        eastl::vector<Meshlet> m_meshlets; // of the full detail, empty if the group wasn't split, it is then drawn in one go
+        eastl::vector<IndexRange> m_visibleRanges; // meshlets that survived the culling of the camera this frame, merged when contiguous
+        eastl::vector<PendingTexture> m_pendingTextures; // only when the upload is deferred, until uploadGroup
+        SceneStore::Handle m_instance; // its draw data once the mesh is in the scene
 
         RefCntAutoPtr<IPipelineState> m_pipeline;
 
@@ -73,19 +167,56 @@ public:
     inline static eastl::hash_map<Mesh*, uint32_t > meshLoaded;
     inline static std::atomic<uint32_t> idCount = 0;
 
+    // With _isUploadDeferred the groups are only decoded, their geometry and cooked textures stay on the CPU until uploadGroup is called
+    // (the StreamingManager does it on the render thread). Otherwise the GPU resources are created on the loading thread.
+    // With _isCpuDataKept the load keeps its hold on the CPU data, whoever reads it next (the BLAS build) calls releaseCpuData.
     Mesh(RefCntAutoPtr<IRenderDevice> _device, const char* _path, bool _needsAfterLoadedActions = false, float3 _position = float3(0), float _scale = 1
-            , float3 _angle = float3(0.0f));
+            , float3 _angle = float3(0.0f), bool _isUploadDeferred = false, bool _isCpuDataKept = false);
 
-    ~Mesh()
+    // Imports _path and saves its .mesh without any device, for offline cooking.
+    // _dependencies gets every file the result depends on (the source, its side files and textures).
+    static bool cook(const char* _path, eastl::vector<eastl::string>& _dependencies);
+
+    // How the constructor reads a cooked .mesh, mapped by default (USE_MAPPED_MESH_LOADING in Mesh.cpp).
+    // Not thread safe, set it before any mesh loads.
+    enum class ELoadMode : uint8_t
     {
-        for(auto& mesh : m_meshes)
-        {
-            for(const auto* texData : mesh.m_texturesData)
-            {
-                delete[] texData;
-            }
-        }
-    }
+        Mapped, // the GPU resources are created straight from the mapping
+        Read // the whole file is copied in memory first
+    };
+    static void setLoadMode(ELoadMode _mode);
+
+    // What the cooked .mesh are made of, the defaults are the macros at the top of Mesh.cpp. The AssetCooker sets them from its command line.
+    // Not thread safe, set them before any mesh is cooked.
+    struct CookSettings
+    {
+        bool m_isCompressed; // zstd compressed sections (MeshContainer) or one raw flatbuffer, both can be loaded
+        int m_compressionLevel; // of zstd, when m_isCompressed
+        bool m_isGeometryEncoded; // vertices and indices through the meshoptimizer codec (GeometryCodec) or raw, both can be loaded
+        bool m_isAlbedoBC7; // or BC1, BC3 when it has transparency
+        EVertexLayout m_vertexLayout;
+    };
+    static void setCookSettings(const CookSettings& _settings);
+    static const CookSettings& getCookSettings();
+
+    // assimp post processing flags of the import, part of what decides if a .mesh is outdated
+    static uint32_t getImportFlags();
+
+    // 16 bits indices as long as they can address every vertex, groups aren't split to fit them anymore
+    static VALUE_TYPE getIndexType(size_t _vertexCount) { return _vertexCount <= 65536 ? VT_UINT16 : VT_UINT32; }
+    static size_t getIndexSize(VALUE_TYPE _indexType) { return _indexType == VT_UINT32 ? sizeof(uint32_t) : sizeof(uint16_t); }
+
+    static size_t getVertexSize(EVertexLayout _layout) { return _layout == EVertexLayout::Octahedral ? sizeof(VertexOctahedral) : sizeof(VertexHalf); }
+    static size_t getVertexCount(const Group& _group) { return _group.m_vertices.size() / getVertexSize(_group.m_vertexLayout); }
+    // Octahedral only once the zprepass, csm and transparency shaders read their vertices through common/vertex.hlsl like the gbuffer one.
+    // Until then it can't be cooked, and a group in it is imported again.
+    static bool isVertexLayoutDrawable(EVertexLayout _layout) { return _layout == EVertexLayout::Half; }
+
+    // From the quantized positions of the group to its local space, to put before the model matrix of its draws
+    static float4x4 getDequantization(const Group& _group);
+
+    // The LODs of _group as the SceneStore selects them, same result as selectLod
+    static SceneStore::LodInfo getLodInfo(const Group& _group);
 
     bool operator<(Mesh* _other) const
     {
@@ -101,7 +232,7 @@ public:
     }
 
     //todo: make a string_view version of this
-    void addTexture(eastl::string& _path, Group& _group);
+    void addTexture(eastl::string& _path, Group& _group, ETextureType _type);
     void addTexture(eastl::string& _path, int index);
 
     //todo fsantoro, handle multiple mesh models
@@ -123,7 +254,21 @@ public:
                    float&          EnterDist,
                    float&          ExitDist);
 
-    BoundBox getBoundingBox();
+    // Of every group, scaled but in local space
+    const BoundBox& getBoundingBox() const { return m_boundingBox; }
+
+    // Recomputes the world bounds of the groups if the transform changed since the last call, returns the number of groups transformed.
+    // Once per frame before the passes, which then only read them.
+    uint32_t updateWorldBounds();
+
+    // Rejects the meshlets outside of the frustum or facing away from the camera and fills m_visibleRanges of every group.
+    // Returns the number of meshlets culled.
+    uint32_t cullMeshlets(const float4x4& _viewProj, const float3& _cameraPosition);
+
+    // Coarsest LOD of _group whose error, projected with its bounding sphere, stays under _maxPixelError.
+    // _projectionScale is proj[1][1] * viewport height / 2: the size in pixels of one unit seen at a distance of 1.
+    // Uses the world bounds, updateWorldBounds has to be called first.
+    [[nodiscard]] uint32_t selectLod(const Group& _group, const float3& _cameraPosition, float _projectionScale, float _maxPixelError) const;
 
     float3& getTranslation() { return m_position;}
     float getScale() { return m_scale;}
@@ -132,14 +277,33 @@ public:
 
     eastl::vector<Group>& getGroups(){ return m_meshes;}
 
+    // Creates the GPU resources of a group loaded with a deferred upload and frees its CPU copies, returns the bytes uploaded
+    size_t uploadGroup(Group& _group);
+    [[nodiscard]] static size_t getPendingUploadSize(const Group& _group);
+    [[nodiscard]] bool isUploadDeferred() const { return m_isUploadDeferred; }
+
+    // The CPU copies of the groups (geometry, raytracing streams, decoded pixels) are only kept while somebody holds them.
+    // The load holds them until the mesh is saved and uploaded, or hands its hold over (see _isCpuDataKept).
+    // Once released the geometry can be read back from the .mesh by acquireCpuData.
+    // Call releaseCpuData once done, even if acquireCpuData failed.
+    bool acquireCpuData();
+    void releaseCpuData();
+    // CPU side allocations of the groups, pixels shared with other meshes and occluders included
+    [[nodiscard]] size_t getCpuBytes() const;
+
 private:
     uint32_t m_id;
 
     bool m_isLoaded;
     bool m_isTransparent = false;
+    bool m_isUploadDeferred = false;
 
-    tf::Executor m_executor;
-    tf::Taskflow m_taskflow;
+    mutable std::mutex m_mutexCpuData;
+    uint32_t m_cpuDataUsers = 1; // the load
+    bool m_isCpuDataReleased = false;
+    bool m_isCpuDataReloadable = false; // the .mesh is there to read the geometry back
+    bool m_isCpuDataPacked = false; // read back from the mounted SceneArchive instead of the loose .mesh, only while it holds what was loaded
+    bool m_arePixelsReleased = false;
 
     float4x4 m_model;
     float3 m_position;
@@ -148,6 +312,12 @@ private:
 
     Quaternion<float> m_rotation = Quaternion<float>(0, 0, 0, 1);
 
+    bool m_isTransformDirty = true; // the world bounds don't match m_model anymore
+    BoundBox m_boundingBox;
+
+    // m_model from the position, rotation and scale
+    void updateModel();
+
     bool m_isSelected;
 
     RefCntAutoPtr<IRenderDevice> m_device;
@@ -158,13 +328,38 @@ private:
 
     eastl::vector<Group> m_meshes;
 
-    eastl::unordered_map<eastl::string, RefCntAutoPtr<ITexture>> m_texturesLoaded;
+    eastl::vector<eastl::string> m_importedFiles; // read by assimp during LoadFromPath
 
-    void recursivelyLoadNode(aiNode *pNode, const aiScene *pScene);
+    explicit Mesh(const char* _path); // only sets the paths up, for cook
 
-    Group loadGroupFrom(const aiMesh& mesh, const aiScene *pScene);
+    void initPaths(const char* _path);
+
+    // Intermediate data of a group while its import graph runs
+    struct GroupImport
+    {
+        eastl::vector<Vertex> m_vertices; // NOT packed
+        size_t m_vertexCount = 0;
+    };
+
+    void recursivelyLoadNode(aiNode *pNode, const aiScene *pScene, eastl::vector<const aiMesh*>& _meshes);
+
+    void loadGroupFrom(const aiMesh& mesh, const aiScene *pScene, Group& group, GroupImport& _import, tf::Taskflow& _taskflow);
 
     void LoadFromPath(const char *_path);
+
+    // _migratedSections gets every section when some had to be upgraded, to save them once the file isn't mapped anymore.
+    // A raw flatbuffer is split in sections for it, so it is rewritten as a container.
+    bool loadFromFlatbuffer(const FlatBuffers::StaticMesh* _staticMesh, eastl::vector<eastl::vector<uint8_t>>& _migratedSections);
+    bool loadFromContainer(const MeshContainer::Reader& _container, eastl::vector<eastl::vector<uint8_t>>& _migratedSections);
+    void saveContainer(const eastl::vector<eastl::vector<uint8_t>>& _sections);
+    bool loadGroupFromFlatbuffer(const FlatBuffers::Mesh* _mesh, Group& _group);
+    // _indices are of _group.m_indexType
+    void createGPUBuffers(Group& _group, const void* _vertices, size_t _vertexCount, const void* _indices, size_t _indexCount);
+    // from m_vertices and m_indices, narrowed to 16 bits when needed
+    void createGPUBuffers(Group& _group);
+    bool reloadCpuData(); // with m_mutexCpuData locked
+    void releasePixels(); // with m_mutexCpuData locked
+    void createTexture(Group& _group, const TextureDesc& _desc, const uint8_t* _data, size_t _size, ETextureType _type);
 };
 
 
@@ -0,0 +1,140 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#include "MeshContainer.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "zstd.h"
+
+#include "JobSystem.hpp"
+#include "tracy/Tracy.hpp"
+
+namespace MeshContainer
+{
+size_t write(const char* _path, uint32_t _version, const eastl::vector<SectionData>& _sections, int _compressionLevel)
+{
+    ZoneScopedN("Write Mesh Container");
+
+    const uint32_t sectionCount = static_cast<uint32_t>(_sections.size());
+    eastl::vector<eastl::vector<uint8_t>> frames(sectionCount);
+    eastl::vector<size_t> errors(sectionCount, 0);
+
+    JobSystem::get().parallelFor(JobSystem::ESubsystem::Mesh, JobSystem::EPriority::High, sectionCount, 1,
+                                 [&](uint32_t _first, uint32_t _last)
+    {
+        for (uint32_t i = _first; i < _last; ++i)
+        {
+            ZoneScopedN("Compress Section");
+            frames[i].resize(ZSTD_compressBound(_sections[i].m_size));
+            const size_t size = ZSTD_compress(frames[i].data(), frames[i].size(), _sections[i].m_data, _sections[i].m_size, _compressionLevel);
+            if (ZSTD_isError(size))
+            {
+                errors[i] = size;
+                continue;
+            }
+            frames[i].resize(size);
+        }
+    });
+
+    for (uint32_t i = 0; i < sectionCount; ++i)
+    {
+        if (errors[i] != 0)
+        {
+            std::cout << "Could not compress section " << i << " of " << _path << ": " << ZSTD_getErrorName(errors[i]) << std::endl;
+            return 0;
+        }
+    }
+
+    Header header{};
+    header.m_magic = MAGIC;
+    header.m_version = _version;
+    header.m_sectionCount = sectionCount;
+    header.m_layout = ELayout::Current;
+
+    eastl::vector<Section> toc(sectionCount);
+    uint64_t offset = sizeof(Header) + sizeof(Section) * sectionCount;
+    for (uint32_t i = 0; i < sectionCount; ++i)
+    {
+        toc[i].m_offset = offset;
+        toc[i].m_compressedSize = frames[i].size();
+        toc[i].m_size = _sections[i].m_size;
+        toc[i].m_version = _sections[i].m_version;
+        offset += frames[i].size();
+    }
+
+    std::ofstream file(_path, std::ios_base::binary);
+    if (!file.good())
+        return 0;
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(toc.data()), sizeof(Section) * toc.size());
+    for (const auto& frame : frames)
+    {
+        file.write(reinterpret_cast<const char*>(frame.data()), frame.size());
+    }
+
+    return file.good() ? offset : 0;
+}
+
+Reader::Reader(const uint8_t* _data, size_t _size)
+{
+    if (!_data || _size < sizeof(Header))
+        return;
+
+    const auto* header = reinterpret_cast<const Header*>(_data);
+    if (header->m_magic != MAGIC)
+        return;
+
+    const bool isLegacy = header->m_layout == ELayout::Legacy;
+    if (!isLegacy && header->m_layout != ELayout::SectionVersions)
+        return;
+
+    const size_t sectionSize = isLegacy ? sizeof(LegacySection) : sizeof(Section);
+    if (sizeof(Header) + sectionSize * header->m_sectionCount > _size)
+        return;
+
+    eastl::vector<Section> sections(header->m_sectionCount);
+    if (isLegacy)
+    {
+        const auto* legacySections = reinterpret_cast<const LegacySection*>(_data + sizeof(Header));
+        for (uint32_t i = 0; i < header->m_sectionCount; ++i)
+        {
+            sections[i] = {legacySections[i].m_offset, legacySections[i].m_compressedSize, legacySections[i].m_size, header->m_version, 0};
+        }
+    }
+    else
+    {
+        memcpy(sections.data(), _data + sizeof(Header), sectionSize * header->m_sectionCount);
+    }
+
+    // a truncated file is treated as not cooked
+    for (const Section& section : sections)
+    {
+        if (section.m_offset + section.m_compressedSize > _size)
+            return;
+    }
+
+    m_data = _data;
+    m_header = header;
+    m_sections = eastl::move(sections);
+}
+
+bool Reader::decompress(uint32_t _section, uint8_t* _destination) const
+{
+    ZoneScopedN("Decompress Section");
+    const Section& section = m_sections[_section];
+
+    const size_t size = ZSTD_decompress(_destination, section.m_size, m_data + section.m_offset, section.m_compressedSize);
+    if (ZSTD_isError(size) || size != section.m_size)
+    {
+        std::cout << "Could not decompress section " << _section << ": " << (ZSTD_isError(size) ? ZSTD_getErrorName(size) : "size mismatch") << std::endl;
+        return false;
+    }
+
+    return true;
+}
+}
@@ -0,0 +1,85 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#ifndef GRAPHICSPLAYGROUND_MESHCONTAINER_HPP
+#define GRAPHICSPLAYGROUND_MESHCONTAINER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include <EASTL/vector.h>
+
+// Compressed .mesh layout: a header, a table of contents and one zstd frame per section.
+// Every section is compressed on its own so they can be decoded in any order, on any thread.
+//
+// | Header | Section[sectionCount] | frame 0 | frame 1 | ...
+namespace MeshContainer
+{
+    static constexpr uint32_t MAGIC = 'G' | 'P' << 8 | 'M' << 16 | 'Z' << 24;
+
+    // Layout of the container itself, not of what is in the sections
+    enum class ELayout : uint32_t
+    {
+        Legacy = 0, // LegacySection, every section has the version of the header
+        SectionVersions, // Section, every section has its own version
+        Current = SectionVersions
+    };
+
+    struct Header
+    {
+        uint32_t m_magic;
+        uint32_t m_version; // VERSION of the data when cooked, not of the container
+        uint32_t m_sectionCount;
+        ELayout m_layout;
+    };
+
+    struct Section
+    {
+        uint64_t m_offset; // from the start of the file
+        uint64_t m_compressedSize;
+        uint64_t m_size;
+        uint32_t m_version; // of the data in the section, each kind of section evolves on its own
+        uint32_t m_padding;
+    };
+
+    struct LegacySection
+    {
+        uint64_t m_offset;
+        uint64_t m_compressedSize;
+        uint64_t m_size;
+    };
+
+    struct SectionData
+    {
+        const uint8_t* m_data;
+        size_t m_size;
+        uint32_t m_version;
+    };
+
+    // Compresses the sections on the job system workers then writes the file, returns the size written or 0 on failure
+    size_t write(const char* _path, uint32_t _version, const eastl::vector<SectionData>& _sections, int _compressionLevel);
+
+    // View over a container in memory (usually a mapped file), only the table of contents is copied
+    class Reader
+    {
+    public:
+        Reader(const uint8_t* _data, size_t _size);
+
+        [[nodiscard]] bool isValid() const { return m_header != nullptr; }
+        [[nodiscard]] uint32_t getVersion() const { return m_header->m_version; }
+        [[nodiscard]] uint32_t getSectionCount() const { return m_header->m_sectionCount; }
+        [[nodiscard]] size_t getSectionSize(uint32_t _section) const { return m_sections[_section].m_size; }
+        [[nodiscard]] uint32_t getSectionVersion(uint32_t _section) const { return m_sections[_section].m_version; }
+
+        // _destination must hold getSectionSize bytes, thread safe
+        bool decompress(uint32_t _section, uint8_t* _destination) const;
+
+    private:
+        const uint8_t* m_data = nullptr;
+        const Header* m_header = nullptr;
+        eastl::vector<Section> m_sections; // copied so both layouts look the same
+    };
+}
+
+#endif //GRAPHICSPLAYGROUND_MESHCONTAINER_HPP
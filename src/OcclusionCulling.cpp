@@ -0,0 +1,523 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#include "OcclusionCulling.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+#include "JobSystem.hpp"
+#include "tracy/Tracy.hpp"
+#include "util/CpuFeatures.hpp"
+
+static_assert(OcclusionCulling::TILE_WIDTH * OcclusionCulling::TILE_HEIGHT == 32, "A coverage mask is 32 bits");
+static_assert(OcclusionCulling::TILES_X % OcclusionCulling::BLOCK_SIZE == 0 && OcclusionCulling::TILES_Y % OcclusionCulling::BLOCK_SIZE == 0,
+              "The coarse level covers whole tiles");
+
+namespace
+{
+    constexpr uint32_t FULL_MASK = UINT32_MAX;
+    constexpr uint32_t TILE_WIDTH = OcclusionCulling::TILE_WIDTH;
+    constexpr uint32_t TILE_HEIGHT = OcclusionCulling::TILE_HEIGHT;
+
+    // x and y are clipped to +-GUARD_BAND * w instead of the sides of the frustum: few triangles need it, and the screen coordinates
+    // stay small enough for the edge functions in float
+    constexpr float GUARD_BAND = 4.0f;
+
+    // a vertex is kept on the side where dot(plane, vertex) >= 0
+    constexpr uint32_t CLIP_PLANE_COUNT = 5;
+    constexpr float CLIP_PLANES[CLIP_PLANE_COUNT][4] = {
+        {0.0f, 0.0f, 1.0f, 0.0f}, // near, z >= 0
+        {1.0f, 0.0f, 0.0f, GUARD_BAND},
+        {-1.0f, 0.0f, 0.0f, GUARD_BAND},
+        {0.0f, 1.0f, 0.0f, GUARD_BAND},
+        {0.0f, -1.0f, 0.0f, GUARD_BAND}};
+    constexpr uint32_t CLIP_MASK = (1 << CLIP_PLANE_COUNT) - 1;
+    // each plane adds one vertex at most
+    constexpr uint32_t MAX_CLIPPED_VERTICES = 3 + CLIP_PLANE_COUNT;
+
+    float getPlaneDistance(const float (&_plane)[4], const float4& _vertex)
+    {
+        return _plane[0] * _vertex.x + _plane[1] * _vertex.y + _plane[2] * _vertex.z + _plane[3] * _vertex.w;
+    }
+
+    // The clip planes the vertex is behind in the low bits, then the sides and the far plane of the frustum, only used to reject
+    // the triangles entirely behind one of them
+    uint32_t getOutCode(const float4& _vertex)
+    {
+        uint32_t code = 0;
+        for (uint32_t i = 0; i < CLIP_PLANE_COUNT; ++i)
+        {
+            code |= static_cast<uint32_t>(getPlaneDistance(CLIP_PLANES[i], _vertex) < 0.0f) << i;
+        }
+        code |= static_cast<uint32_t>(_vertex.x < -_vertex.w) << (CLIP_PLANE_COUNT + 0);
+        code |= static_cast<uint32_t>(_vertex.x > _vertex.w) << (CLIP_PLANE_COUNT + 1);
+        code |= static_cast<uint32_t>(_vertex.y < -_vertex.w) << (CLIP_PLANE_COUNT + 2);
+        code |= static_cast<uint32_t>(_vertex.y > _vertex.w) << (CLIP_PLANE_COUNT + 3);
+        code |= static_cast<uint32_t>(_vertex.z > _vertex.w) << (CLIP_PLANE_COUNT + 4);
+        return code;
+    }
+
+    // Sutherland-Hodgman against the clip planes in _planes, returns the vertex count left, a convex polygon
+    uint32_t clipPolygon(float4 (&_vertices)[MAX_CLIPPED_VERTICES], uint32_t _count, uint32_t _planes)
+    {
+        float4 input[MAX_CLIPPED_VERTICES];
+        for (uint32_t plane = 0; plane < CLIP_PLANE_COUNT && _count >= 3; ++plane)
+        {
+            if ((_planes & (1 << plane)) == 0)
+                continue;
+
+            std::copy(_vertices, _vertices + _count, input);
+            const uint32_t inputCount = _count;
+            _count = 0;
+            for (uint32_t i = 0; i < inputCount; ++i)
+            {
+                const float4& current = input[i];
+                const float4& next = input[(i + 1) % inputCount];
+                const float currentDistance = getPlaneDistance(CLIP_PLANES[plane], current);
+                const float nextDistance = getPlaneDistance(CLIP_PLANES[plane], next);
+                if (currentDistance >= 0.0f)
+                {
+                    _vertices[_count++] = current;
+                }
+                if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+                {
+                    _vertices[_count++] = current + (next - current) * (currentDistance / (currentDistance - nextDistance));
+                }
+            }
+        }
+        return _count >= 3 ? _count : 0;
+    }
+
+    // Coverage of the 8x4 pixels of a tile, bit x + y * TILE_WIDTH. Pixel (x, y) is inside when, for the 3 edges,
+    // _a * (_dx + x) + _b * (_dy + y) >= 0, with _dx and _dy from the edge to the first pixel. Every kernel does the same operations in
+    // the same order, no FMA, so they give the same masks.
+    uint32_t getCoverageScalar(const float (&_a)[3], const float (&_b)[3], const float (&_dx)[3], const float (&_dy)[3])
+    {
+        uint32_t mask = 0;
+        for (uint32_t y = 0; y < TILE_HEIGHT; ++y)
+        {
+            for (uint32_t x = 0; x < TILE_WIDTH; ++x)
+            {
+                bool isInside = true;
+                for (uint32_t edge = 0; edge < 3; ++edge)
+                {
+                    isInside &= _a[edge] * (_dx[edge] + static_cast<float>(x)) + _b[edge] * (_dy[edge] + static_cast<float>(y)) >= 0.0f;
+                }
+                mask |= static_cast<uint32_t>(isInside) << (x + y * TILE_WIDTH);
+            }
+        }
+        return mask;
+    }
+
+    uint32_t getCoverageSSE2(const float (&_a)[3], const float (&_b)[3], const float (&_dx)[3], const float (&_dy)[3])
+    {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 leftColumns = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+        const __m128 rightColumns = _mm_setr_ps(4.0f, 5.0f, 6.0f, 7.0f);
+
+        __m128 left[TILE_HEIGHT];
+        __m128 right[TILE_HEIGHT];
+        for (uint32_t edge = 0; edge < 3; ++edge)
+        {
+            const __m128 a = _mm_set1_ps(_a[edge]);
+            const __m128 dx = _mm_set1_ps(_dx[edge]);
+            const __m128 leftX = _mm_mul_ps(a, _mm_add_ps(dx, leftColumns));
+            const __m128 rightX = _mm_mul_ps(a, _mm_add_ps(dx, rightColumns));
+            for (uint32_t y = 0; y < TILE_HEIGHT; ++y)
+            {
+                const __m128 rowY = _mm_set1_ps(_b[edge] * (_dy[edge] + static_cast<float>(y)));
+                const __m128 leftInside = _mm_cmpge_ps(_mm_add_ps(leftX, rowY), zero);
+                const __m128 rightInside = _mm_cmpge_ps(_mm_add_ps(rightX, rowY), zero);
+                left[y] = edge == 0 ? leftInside : _mm_and_ps(left[y], leftInside);
+                right[y] = edge == 0 ? rightInside : _mm_and_ps(right[y], rightInside);
+            }
+        }
+
+        uint32_t mask = 0;
+        for (uint32_t y = 0; y < TILE_HEIGHT; ++y)
+        {
+            mask |= static_cast<uint32_t>(_mm_movemask_ps(left[y]) | _mm_movemask_ps(right[y]) << 4) << (y * TILE_WIDTH);
+        }
+        return mask;
+    }
+
+    TARGET_AVX2 uint32_t getCoverageAVX2(const float (&_a)[3], const float (&_b)[3], const float (&_dx)[3], const float (&_dy)[3])
+    {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 columns = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+
+        __m256 rows[TILE_HEIGHT];
+        for (uint32_t edge = 0; edge < 3; ++edge)
+        {
+            const __m256 x = _mm256_mul_ps(_mm256_set1_ps(_a[edge]), _mm256_add_ps(_mm256_set1_ps(_dx[edge]), columns));
+            for (uint32_t y = 0; y < TILE_HEIGHT; ++y)
+            {
+                const __m256 rowY = _mm256_set1_ps(_b[edge] * (_dy[edge] + static_cast<float>(y)));
+                const __m256 inside = _mm256_cmp_ps(_mm256_add_ps(x, rowY), zero, _CMP_GE_OQ);
+                rows[y] = edge == 0 ? inside : _mm256_and_ps(rows[y], inside);
+            }
+        }
+
+        uint32_t mask = 0;
+        for (uint32_t y = 0; y < TILE_HEIGHT; ++y)
+        {
+            mask |= static_cast<uint32_t>(_mm256_movemask_ps(rows[y])) << (y * TILE_WIDTH);
+        }
+        return mask;
+    }
+
+    using CoverageFunc = uint32_t (*)(const float (&)[3], const float (&)[3], const float (&)[3], const float (&)[3]);
+
+    CoverageFunc getCoverageFunc(FrustumCulling::EKernel _kernel)
+    {
+        switch (FrustumCulling::isSupported(_kernel) ? _kernel : FrustumCulling::EKernel::Scalar)
+        {
+            case FrustumCulling::EKernel::SSE2: return getCoverageSSE2;
+            case FrustumCulling::EKernel::AVX2: return getCoverageAVX2;
+            case FrustumCulling::EKernel::Scalar: break;
+        }
+        return getCoverageScalar;
+    }
+}
+
+OcclusionCulling::OcclusionCulling()
+    : m_tiles(TILES_X * TILES_Y, Tile{0, 0.0f, 1.0f}), m_blockDepths(BLOCKS_X * BLOCKS_Y, 1.0f), m_viewProj(float4x4::Identity())
+{
+}
+
+void OcclusionCulling::render(const float4x4& _viewProj, const eastl::vector<Occluder>& _occluders, FrustumCulling::EKernel _kernel)
+{
+    ZoneScopedN("Occlusion Render");
+    m_viewProj = _viewProj;
+
+    // every occluder in its own list so the bands still draw them in order
+    m_triangles.resize(_occluders.size());
+    JobSystem::get().parallelFor(JobSystem::ESubsystem::Engine, JobSystem::EPriority::High, static_cast<uint32_t>(_occluders.size()), 4,
+                                 [&](uint32_t _begin, uint32_t _end)
+    {
+        eastl::vector<float4> clipVertices;
+        for (uint32_t i = _begin; i < _end; ++i)
+        {
+            setupOccluder(_occluders[i], clipVertices, m_triangles[i]);
+        }
+    });
+
+    m_triangleCount = 0;
+    for (const eastl::vector<Triangle>& triangles : m_triangles)
+    {
+        m_triangleCount += static_cast<uint32_t>(triangles.size());
+    }
+
+    JobSystem::get().parallelFor(JobSystem::ESubsystem::Engine, JobSystem::EPriority::High, BLOCKS_Y, 1, [&](uint32_t _begin, uint32_t _end)
+    {
+        for (uint32_t band = _begin; band < _end; ++band)
+        {
+            rasterizeBand(band, _kernel);
+        }
+    });
+}
+
+void OcclusionCulling::setupOccluder(const Occluder& _occluder, eastl::vector<float4>& _clipVertices, eastl::vector<Triangle>& _triangles) const
+{
+    _triangles.clear();
+
+    const float4x4 worldViewProj = _occluder.m_world * m_viewProj;
+    _clipVertices.resize(_occluder.m_vertexCount);
+    for (uint32_t i = 0; i < _occluder.m_vertexCount; ++i)
+    {
+        _clipVertices[i] = float4(_occluder.m_vertices[i], 1.0f) * worldViewProj;
+    }
+
+    Triangle triangle;
+    for (uint32_t i = 0; i + 2 < _occluder.m_indexCount; i += 3)
+    {
+        const float4& v0 = _clipVertices[_occluder.m_indices[i]];
+        const float4& v1 = _clipVertices[_occluder.m_indices[i + 1]];
+        const float4& v2 = _clipVertices[_occluder.m_indices[i + 2]];
+        const uint32_t code0 = getOutCode(v0);
+        const uint32_t code1 = getOutCode(v1);
+        const uint32_t code2 = getOutCode(v2);
+        if ((code0 & code1 & code2) != 0)
+            continue;
+
+        const uint32_t planes = (code0 | code1 | code2) & CLIP_MASK;
+        if (planes == 0)
+        {
+            if (setupTriangle(v0, v1, v2, triangle))
+            {
+                _triangles.push_back(triangle);
+            }
+            continue;
+        }
+
+        // the clipped polygon is convex, a fan keeps the winding
+        float4 polygon[MAX_CLIPPED_VERTICES] = {v0, v1, v2};
+        const uint32_t count = clipPolygon(polygon, 3, planes);
+        for (uint32_t j = 2; j < count; ++j)
+        {
+            if (setupTriangle(polygon[0], polygon[j - 1], polygon[j], triangle))
+            {
+                _triangles.push_back(triangle);
+            }
+        }
+    }
+}
+
+bool OcclusionCulling::setupTriangle(const float4& _v0, const float4& _v1, const float4& _v2, Triangle& _triangle)
+{
+    const float4* vertices[3] = {&_v0, &_v1, &_v2};
+    float x[3];
+    float y[3];
+    float z[3];
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        const float4& vertex = *vertices[i];
+        if (vertex.w <= 0.0f)
+            return false;
+
+        // y goes down the screen
+        const float invW = 1.0f / vertex.w;
+        x[i] = (vertex.x * invW * 0.5f + 0.5f) * static_cast<float>(WIDTH);
+        y[i] = (0.5f - vertex.y * invW * 0.5f) * static_cast<float>(HEIGHT);
+        z[i] = vertex.z * invW;
+    }
+
+    // clockwise on screen, also rejects the degenerate ones and the NaN
+    const float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    if (!(area > 0.0f))
+        return false;
+
+    // the pixels whose center is in the bounds, the center of pixel i is at i + 0.5
+    const int32_t minPixelX = std::max(static_cast<int32_t>(std::ceil(std::min({x[0], x[1], x[2]}) - 0.5f)), 0);
+    const int32_t maxPixelX = std::min(static_cast<int32_t>(std::floor(std::max({x[0], x[1], x[2]}) - 0.5f)), static_cast<int32_t>(WIDTH) - 1);
+    const int32_t minPixelY = std::max(static_cast<int32_t>(std::ceil(std::min({y[0], y[1], y[2]}) - 0.5f)), 0);
+    const int32_t maxPixelY = std::min(static_cast<int32_t>(std::floor(std::max({y[0], y[1], y[2]}) - 0.5f)), static_cast<int32_t>(HEIGHT) - 1);
+    if (minPixelX > maxPixelX || minPixelY > maxPixelY)
+        return false;
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        const uint32_t next = (i + 1) % 3;
+        _triangle.m_edgeA[i] = y[i] - y[next];
+        _triangle.m_edgeB[i] = x[next] - x[i];
+        _triangle.m_edgeX[i] = x[i];
+        _triangle.m_edgeY[i] = y[i];
+    }
+
+    _triangle.m_depth = z[0];
+    _triangle.m_depthX = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+    _triangle.m_depthY = ((x[1] - x[0]) * (z[2] - z[0]) - (x[2] - x[0]) * (z[1] - z[0])) / area;
+    _triangle.m_maxDepth = std::max({z[0], z[1], z[2]});
+    _triangle.m_minPixelX = static_cast<uint32_t>(minPixelX);
+    _triangle.m_maxPixelX = static_cast<uint32_t>(maxPixelX);
+    _triangle.m_minPixelY = static_cast<uint32_t>(minPixelY);
+    _triangle.m_maxPixelY = static_cast<uint32_t>(maxPixelY);
+    return true;
+}
+
+void OcclusionCulling::rasterizeBand(uint32_t _band, FrustumCulling::EKernel _kernel)
+{
+    ZoneScopedN("Occlusion Band");
+    const CoverageFunc getCoverage = getCoverageFunc(_kernel);
+
+    const uint32_t firstTileY = _band * BLOCK_SIZE;
+    const uint32_t lastTileY = firstTileY + BLOCK_SIZE - 1;
+    std::fill(m_tiles.begin() + firstTileY * TILES_X, m_tiles.begin() + (lastTileY + 1) * TILES_X, Tile{0, 0.0f, 1.0f});
+
+    for (const eastl::vector<Triangle>& triangles : m_triangles)
+    {
+        for (const Triangle& triangle : triangles)
+        {
+            const uint32_t minTileY = std::max(triangle.m_minPixelY / TILE_HEIGHT, firstTileY);
+            const uint32_t maxTileY = std::min(triangle.m_maxPixelY / TILE_HEIGHT, lastTileY);
+            for (uint32_t tileY = minTileY; tileY <= maxTileY; ++tileY)
+            {
+                // the pixels of the triangle in this row of tiles, the depth is the farthest of the plane over them
+                const uint32_t minPixelY = std::max(triangle.m_minPixelY, tileY * TILE_HEIGHT);
+                const uint32_t maxPixelY = std::min(triangle.m_maxPixelY, tileY * TILE_HEIGHT + TILE_HEIGHT - 1);
+                const float depthY = triangle.m_depthY * (static_cast<float>(triangle.m_depthY > 0.0f ? maxPixelY : minPixelY) + 0.5f - triangle.m_edgeY[0]);
+
+                float dy[3];
+                for (uint32_t edge = 0; edge < 3; ++edge)
+                {
+                    dy[edge] = static_cast<float>(tileY * TILE_HEIGHT) + 0.5f - triangle.m_edgeY[edge];
+                }
+
+                for (uint32_t tileX = triangle.m_minPixelX / TILE_WIDTH; tileX <= triangle.m_maxPixelX / TILE_WIDTH; ++tileX)
+                {
+                    Tile& tile = m_tiles[tileX + tileY * TILES_X];
+
+                    const uint32_t minPixelX = std::max(triangle.m_minPixelX, tileX * TILE_WIDTH);
+                    const uint32_t maxPixelX = std::min(triangle.m_maxPixelX, tileX * TILE_WIDTH + TILE_WIDTH - 1);
+                    const float depthX = triangle.m_depthX * (static_cast<float>(triangle.m_depthX > 0.0f ? maxPixelX : minPixelX) + 0.5f - triangle.m_edgeX[0]);
+                    const float depth = std::min(triangle.m_depth + depthX + depthY, triangle.m_maxDepth);
+
+                    // nothing of it can be in front of what the tile has
+                    if (!(depth < tile.m_farDepth))
+                        continue;
+
+                    float dx[3];
+                    for (uint32_t edge = 0; edge < 3; ++edge)
+                    {
+                        dx[edge] = static_cast<float>(tileX * TILE_WIDTH) + 0.5f - triangle.m_edgeX[edge];
+                    }
+                    const uint32_t coverage = getCoverage(triangle.m_edgeA, triangle.m_edgeB, dx, dy);
+                    if (coverage == 0)
+                        continue;
+
+                    // the near layer is much further from this triangle than from the far layer, it isn't worth keeping
+                    if (tile.m_mask != 0 && tile.m_nearDepth - depth > tile.m_farDepth - tile.m_nearDepth)
+                    {
+                        tile.m_mask = 0;
+                    }
+
+                    tile.m_nearDepth = tile.m_mask == 0 ? depth : std::max(tile.m_nearDepth, depth);
+                    tile.m_mask |= coverage;
+                    if (tile.m_mask == FULL_MASK)
+                    {
+                        tile.m_farDepth = tile.m_nearDepth;
+                        tile.m_mask = 0;
+                    }
+                }
+            }
+        }
+    }
+
+    for (uint32_t blockX = 0; blockX < BLOCKS_X; ++blockX)
+    {
+        float blockDepth = 0.0f;
+        for (uint32_t tileY = firstTileY; tileY <= lastTileY; ++tileY)
+        {
+            for (uint32_t tileX = blockX * BLOCK_SIZE; tileX < (blockX + 1) * BLOCK_SIZE; ++tileX)
+            {
+                blockDepth = std::max(blockDepth, m_tiles[tileX + tileY * TILES_X].m_farDepth);
+            }
+        }
+        m_blockDepths[blockX + _band * BLOCKS_X] = blockDepth;
+    }
+}
+
+bool OcclusionCulling::isOccluded(const BoundBox& _bounds) const
+{
+    float minX = std::numeric_limits<float>::max();
+    float maxX = -std::numeric_limits<float>::max();
+    float minY = std::numeric_limits<float>::max();
+    float maxY = -std::numeric_limits<float>::max();
+    float minDepth = std::numeric_limits<float>::max();
+    for (uint32_t corner = 0; corner < 8; ++corner)
+    {
+        const float3 position((corner & 1) ? _bounds.Max.x : _bounds.Min.x, (corner & 2) ? _bounds.Max.y : _bounds.Min.y,
+                              (corner & 4) ? _bounds.Max.z : _bounds.Min.z);
+        const float4 clip = float4(position, 1.0f) * m_viewProj;
+
+        // in front of the near plane it can cover any pixel
+        if (!(clip.z >= 0.0f && clip.w > 0.0f))
+            return false;
+
+        const float invW = 1.0f / clip.w;
+        const float x = (clip.x * invW * 0.5f + 0.5f) * static_cast<float>(WIDTH);
+        const float y = (0.5f - clip.y * invW * 0.5f) * static_cast<float>(HEIGHT);
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        minDepth = std::min(minDepth, clip.z * invW);
+    }
+
+    // the pixels the box touches, not only the ones whose center it covers, and none at all when it is off screen
+    const int32_t minPixelX = std::max(static_cast<int32_t>(std::floor(minX)), 0);
+    const int32_t maxPixelX = std::min(static_cast<int32_t>(std::floor(maxX)), static_cast<int32_t>(WIDTH) - 1);
+    const int32_t minPixelY = std::max(static_cast<int32_t>(std::floor(minY)), 0);
+    const int32_t maxPixelY = std::min(static_cast<int32_t>(std::floor(maxY)), static_cast<int32_t>(HEIGHT) - 1);
+    if (minPixelX > maxPixelX || minPixelY > maxPixelY)
+        return true;
+
+    const uint32_t minTileX = minPixelX / TILE_WIDTH;
+    const uint32_t maxTileX = maxPixelX / TILE_WIDTH;
+    const uint32_t minTileY = minPixelY / TILE_HEIGHT;
+    const uint32_t maxTileY = maxPixelY / TILE_HEIGHT;
+    for (uint32_t blockY = minTileY / BLOCK_SIZE; blockY <= maxTileY / BLOCK_SIZE; ++blockY)
+    {
+        for (uint32_t blockX = minTileX / BLOCK_SIZE; blockX <= maxTileX / BLOCK_SIZE; ++blockX)
+        {
+            // every tile of the block is in front
+            if (m_blockDepths[blockX + blockY * BLOCKS_X] < minDepth)
+                continue;
+
+            const uint32_t lastTileY = std::min(maxTileY, blockY * BLOCK_SIZE + BLOCK_SIZE - 1);
+            const uint32_t lastTileX = std::min(maxTileX, blockX * BLOCK_SIZE + BLOCK_SIZE - 1);
+            for (uint32_t tileY = std::max(minTileY, blockY * BLOCK_SIZE); tileY <= lastTileY; ++tileY)
+            {
+                for (uint32_t tileX = std::max(minTileX, blockX * BLOCK_SIZE); tileX <= lastTileX; ++tileX)
+                {
+                    const Tile& tile = m_tiles[tileX + tileY * TILES_X];
+                    if (tile.m_farDepth < minDepth)
+                        continue;
+
+                    // the pixels of the box in this tile, they may all be in the near layer
+                    const uint32_t firstColumn = std::max<int32_t>(minPixelX - static_cast<int32_t>(tileX * TILE_WIDTH), 0);
+                    const uint32_t lastColumn = std::min<int32_t>(maxPixelX - static_cast<int32_t>(tileX * TILE_WIDTH), TILE_WIDTH - 1);
+                    const uint32_t firstRow = std::max<int32_t>(minPixelY - static_cast<int32_t>(tileY * TILE_HEIGHT), 0);
+                    const uint32_t lastRow = std::min<int32_t>(maxPixelY - static_cast<int32_t>(tileY * TILE_HEIGHT), TILE_HEIGHT - 1);
+                    const uint32_t rowMask = (0xFFu >> (TILE_WIDTH - 1 - lastColumn)) & (0xFFu << firstColumn);
+                    uint32_t boxMask = 0;
+                    for (uint32_t row = firstRow; row <= lastRow; ++row)
+                    {
+                        boxMask |= rowMask << (row * TILE_WIDTH);
+                    }
+
+                    if ((boxMask & ~tile.m_mask) != 0 || !(tile.m_nearDepth < minDepth))
+                        return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void OcclusionCulling::getDepth(eastl::vector<float>& _depth) const
+{
+    _depth.resize(WIDTH * HEIGHT);
+    for (uint32_t y = 0; y < HEIGHT; ++y)
+    {
+        for (uint32_t x = 0; x < WIDTH; ++x)
+        {
+            const Tile& tile = m_tiles[x / TILE_WIDTH + y / TILE_HEIGHT * TILES_X];
+            const uint32_t bit = 1u << (x % TILE_WIDTH + y % TILE_HEIGHT * TILE_WIDTH);
+            _depth[x + y * WIDTH] = (tile.m_mask & bit) != 0 ? tile.m_nearDepth : tile.m_farDepth;
+        }
+    }
+}
+
+bool OcclusionCulling::dumpDepth(const char* _path) const
+{
+    eastl::vector<float> depth;
+    getDepth(depth);
+
+    std::ofstream file(_path, std::ios_base::binary);
+    if (!file.good())
+    {
+        std::cout << "Could not write the occlusion depth to " << _path << std::endl;
+        return false;
+    }
+
+    // 16 bits PGM are big endian
+    file << "P5\n" << WIDTH << " " << HEIGHT << "\n65535\n";
+    for (float value : depth)
+    {
+        const auto texel = static_cast<uint16_t>(std::clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+        const char bytes[2] = {static_cast<char>(texel >> 8), static_cast<char>(texel & 0xFF)};
+        file.write(bytes, sizeof(bytes));
+    }
+
+    std::cout << "Occlusion depth written to " << _path << std::endl;
+    return file.good();
+}
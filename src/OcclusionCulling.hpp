@@ -0,0 +1,109 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#ifndef GRAPHICSPLAYGROUND_OCCLUSIONCULLING_HPP
+#define GRAPHICSPLAYGROUND_OCCLUSIONCULLING_HPP
+
+#include <cstdint>
+
+#include <EASTL/vector.h>
+
+#include "Common/interface/AdvancedMath.hpp"
+#include "Common/interface/BasicMath.hpp"
+#include "FrustumCulling.hpp"
+
+using namespace Diligent;
+
+// Software occlusion culling on the CPU, masked the way Intel's Masked Occlusion Culling does it.
+// A few big occluders are rasterized at low resolution in tiles of 8x4 pixels. Each tile keeps a far depth that bounds every pixel, and a
+// near one for the pixels of its coverage mask. The near layer becomes the far one once the mask is full. A tile never stores per pixel
+// depths, and a triangle only costs one coverage mask and one depth per tile it touches. The coverage is computed 4 or 8 pixels at once.
+// The screen is cut in bands of tile rows that are rasterized on the job system. Each band also writes its row of the coarse level:
+// the farthest depth of 4x4 tiles, to reject the big boxes quickly.
+// The pixels are sampled at their center like the GPU does, so an occluder thinner than a pixel of this buffer can hide slightly more than
+// it does at full resolution.
+class OcclusionCulling
+{
+public:
+    static constexpr uint32_t WIDTH = 320;
+    static constexpr uint32_t HEIGHT = 192;
+    static constexpr uint32_t TILE_WIDTH = 8;
+    static constexpr uint32_t TILE_HEIGHT = 4; // TILE_WIDTH * TILE_HEIGHT bits in a coverage mask
+    static constexpr uint32_t TILES_X = WIDTH / TILE_WIDTH;
+    static constexpr uint32_t TILES_Y = HEIGHT / TILE_HEIGHT;
+    static constexpr uint32_t BLOCK_SIZE = 4; // tiles per side of a texel of the coarse level, a band is one row of them
+    static constexpr uint32_t BLOCKS_X = TILES_X / BLOCK_SIZE;
+    static constexpr uint32_t BLOCKS_Y = TILES_Y / BLOCK_SIZE;
+
+    // Triangles in the local space of m_world, their front faces clockwise on screen like the pipelines of the scene
+    struct Occluder
+    {
+        const float3* m_vertices;
+        const uint32_t* m_indices;
+        uint32_t m_vertexCount;
+        uint32_t m_indexCount;
+        float4x4 m_world;
+    };
+
+    OcclusionCulling();
+
+    // Clears the depth and rasterizes _occluders in their order, the closest first works best. _viewProj has a [0, 1] depth range.
+    void render(const float4x4& _viewProj, const eastl::vector<Occluder>& _occluders, FrustumCulling::EKernel _kernel = FrustumCulling::getBestKernel());
+
+    // True when every pixel the world space box covers on screen is behind the occluders rendered last. A box crossing the near plane
+    // never is. Thread safe once render returned.
+    [[nodiscard]] bool isOccluded(const BoundBox& _bounds) const;
+
+    // WIDTH x HEIGHT depths row by row, the top one first. 1 where no occluder was drawn, and the far layer of a tile where its mask
+    // isn't set: the depth the tests use, not the one of the triangles.
+    void getDepth(eastl::vector<float>& _depth) const;
+    // getDepth as a 16 bits binary PGM, false if the file can't be written
+    bool dumpDepth(const char* _path) const;
+
+    // Of the last render, after the clipping and the back faces were removed
+    [[nodiscard]] uint32_t getTriangleCount() const { return m_triangleCount; }
+
+private:
+    struct Tile
+    {
+        uint32_t m_mask; // pixels whose depth is m_nearDepth or closer, bit x + y * TILE_WIDTH
+        float m_nearDepth; // only meaningful with some of the mask set, it is then closer than m_farDepth
+        float m_farDepth; // every pixel of the tile is at this depth or closer
+    };
+
+    // A triangle on screen, ready for the bands
+    struct Triangle
+    {
+        // edge i goes from vertex i to the next one, inside when m_edgeA[i] * (x - m_edgeX[i]) + m_edgeB[i] * (y - m_edgeY[i]) >= 0
+        float m_edgeA[3];
+        float m_edgeB[3];
+        float m_edgeX[3];
+        float m_edgeY[3];
+        // depth plane, m_depth + m_depthX * (x - m_edgeX[0]) + m_depthY * (y - m_edgeY[0])
+        float m_depth;
+        float m_depthX;
+        float m_depthY;
+        float m_maxDepth;
+        // the pixels whose center is in its bounds, on screen
+        uint32_t m_minPixelX;
+        uint32_t m_maxPixelX;
+        uint32_t m_minPixelY;
+        uint32_t m_maxPixelY;
+    };
+
+    eastl::vector<Tile> m_tiles;
+    eastl::vector<float> m_blockDepths; // the farthest m_farDepth of each block of tiles
+    eastl::vector<eastl::vector<Triangle>> m_triangles; // per occluder, reused from one render to the next
+    float4x4 m_viewProj;
+    uint32_t m_triangleCount = 0;
+
+    // Transforms, clips and sets up the triangles of _occluder, _clipVertices is scratch
+    void setupOccluder(const Occluder& _occluder, eastl::vector<float4>& _clipVertices, eastl::vector<Triangle>& _triangles) const;
+    // false when it faces away or covers no pixel center
+    static bool setupTriangle(const float4& _v0, const float4& _v1, const float4& _v2, Triangle& _triangle);
+    // Clears then draws the tiles of one row of blocks, and the blocks
+    void rasterizeBand(uint32_t _band, FrustumCulling::EKernel _kernel);
+};
+
+#endif //GRAPHICSPLAYGROUND_OCCLUSIONCULLING_HPP
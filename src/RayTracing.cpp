@@ -10,6 +10,8 @@
 #include "GraphicsTypesX.hpp"
 #include "Graphics/GraphicsTools/interface/MapHelper.hpp"
 #include "GPUMarkerScoped.hpp"
+#include "JobSystem.hpp"
+#include "tracy/Tracy.hpp"
 
 
 struct PrimitiveTable {
@@ -147,8 +149,21 @@ m_device(_device), m_immediateContext(_context)
 
 void RayTracing::addMeshToRayTrace(Mesh* _mesh)
 {
-    std::scoped_lock lock(addMutex);
-    m_meshToAdd.push_back(_mesh);
+    JobSystem::get().submit(JobSystem::ESubsystem::RayTracing, JobSystem::EPriority::Normal, [this, _mesh]()
+    {
+        ZoneScopedN("Raytracing - Prepare BLAS");
+
+        // the positions are copied in the BLAS buffers, they're only needed here
+        eastl::vector<PendingBLAS> pendings;
+        for(const auto& grp : _mesh->getGroups())
+        {
+            pendings.push_back(prepareBLAS(m_device, grp));
+        }
+        _mesh->releaseCpuData();
+
+        std::scoped_lock lock(addMutex);
+        m_blasToBuild.insert(m_blasToBuild.end(), pendings.begin(), pendings.end());
+    });
 }
 
 void RayTracing::createBlasIfNeeded()
@@ -157,20 +172,16 @@ void RayTracing::createBlasIfNeeded()
 
     std::scoped_lock lock(addMutex);
 
-    if(m_meshToAdd.empty())
+    if(m_blasToBuild.empty())
         return;
 
-    for (auto* mesh: m_meshToAdd)
+    for (auto& pending: m_blasToBuild)
     {
-        const auto& grps = mesh->getGroups();
-        for(const auto& grp : grps)
-        {
-            computeBLAS(m_device, m_immediateContext, grp);
-            m_meshGroups.push_back(&grp);
-        }
+        computeBLAS(m_device, m_immediateContext, pending);
+        m_meshGroups.push_back(pending.m_group);
     }
 
-    m_meshToAdd.clear();
+    m_blasToBuild.clear();
 
     createTLAS(BLASes, m_device, m_immediateContext);
     m_srb->GetVariableByName(Diligent::SHADER_TYPE_RAY_GEN, "g_TLAS")->Set(TLAS);
@@ -315,13 +326,13 @@ void RayTracing::render(RefCntAutoPtr<IDeviceContext>& _context, int height, int
     _context->TraceRays(attribs);
 }
 
-void RayTracing::computeBLAS(RefCntAutoPtr<Diligent::IRenderDevice> _device, RefCntAutoPtr<IDeviceContext> _context, const Mesh::Group& _grp)
+RayTracing::PendingBLAS RayTracing::prepareBLAS(RefCntAutoPtr<Diligent::IRenderDevice> _device, const Mesh::Group& _grp)
 {
     Diligent::BLASTriangleDesc triangleDesc;
     triangleDesc.GeometryName = _grp.m_name.c_str();
     triangleDesc.IndexType = Diligent::VT_UINT32;
     triangleDesc.MaxVertexCount = _grp.m_verticesPosRaytrace.size();
-    triangleDesc.MaxPrimitiveCount = _grp.m_indices.size() / 3;
+    triangleDesc.MaxPrimitiveCount = _grp.m_indicesRaytrace.size() / 3;
     triangleDesc.VertexComponentCount = 3;
     triangleDesc.VertexValueType = Diligent::VT_FLOAT32;
 
@@ -331,11 +342,10 @@ void RayTracing::computeBLAS(RefCntAutoPtr<Diligent::IRenderDevice> _device, Ref
     BLASDesc.pTriangles = &triangleDesc;
     BLASDesc.TriangleCount = 1;
 
-    RefCntAutoPtr<IBottomLevelAS> blas;
-    _device->CreateBLAS(BLASDesc, &blas);
+    PendingBLAS pending;
+    pending.m_group = &_grp;
 
-    RefCntAutoPtr<IBuffer> bufferIndices;
-    RefCntAutoPtr<IBuffer> bufferVertices;
+    _device->CreateBLAS(BLASDesc, &pending.m_blas);
 
     {
         BufferDesc desc;
@@ -347,7 +357,7 @@ void RayTracing::computeBLAS(RefCntAutoPtr<Diligent::IRenderDevice> _device, Ref
         data.DataSize = desc.Size;
         data.pData = _grp.m_verticesPosRaytrace.data();
 
-        _device->CreateBuffer(desc, &data, &bufferVertices);
+        _device->CreateBuffer(desc, &data, &pending.m_vertices);
     }
 
     {
@@ -360,9 +370,18 @@ void RayTracing::computeBLAS(RefCntAutoPtr<Diligent::IRenderDevice> _device, Ref
         data.DataSize = desc.Size;
         data.pData = _grp.m_indicesRaytrace.data();
 
-        _device->CreateBuffer(desc, &data, &bufferIndices);
+        _device->CreateBuffer(desc, &data, &pending.m_indices);
     }
 
+    return pending;
+}
+
+void RayTracing::computeBLAS(RefCntAutoPtr<Diligent::IRenderDevice> _device, RefCntAutoPtr<IDeviceContext> _context, PendingBLAS& _pending)
+{
+    const Mesh::Group& grp = *_pending.m_group;
+    auto& blas = _pending.m_blas;
+    const auto& triangleDesc = blas->GetDesc().pTriangles[0];
+
     if(blas->GetScratchBufferSizes().Build > m_scratchBuffer->GetDesc().Size)
     {
         m_scratchBuffer.Release();
@@ -377,13 +396,13 @@ void RayTracing::computeBLAS(RefCntAutoPtr<Diligent::IRenderDevice> _device, Ref
 
     Diligent::BLASBuildTriangleData triangleData;
     triangleData.Flags = Diligent::RAYTRACING_GEOMETRY_FLAG_OPAQUE;
-    triangleData.GeometryName = _grp.m_name.c_str();
-    triangleData.pVertexBuffer = bufferVertices;
+    triangleData.GeometryName = grp.m_name.c_str();
+    triangleData.pVertexBuffer = _pending.m_vertices;
     triangleData.VertexStride = sizeof(float3);
     triangleData.VertexCount = triangleDesc.MaxVertexCount;
     triangleData.VertexValueType = triangleDesc.VertexValueType;
     triangleData.VertexComponentCount = triangleDesc.VertexComponentCount;
-    triangleData.pIndexBuffer = bufferIndices;
+    triangleData.pIndexBuffer = _pending.m_indices;
     triangleData.PrimitiveCount = triangleDesc.MaxPrimitiveCount;
     triangleData.IndexType = triangleDesc.IndexType;
 
@@ -38,12 +38,24 @@ class RayTracing
 public:
     RayTracing(RefCntAutoPtr<Diligent::IRenderDevice> _device, RefCntAutoPtr<IDeviceContext> _context);
 
+    // Takes over the hold the load kept on the CPU data of _mesh (see StreamingManager::Request::m_isRayTraced) and releases it
+    // once the positions are copied in the BLAS buffers
     void addMeshToRayTrace(Mesh* _mesh);
     void createBlasIfNeeded();
     void render(RefCntAutoPtr<IDeviceContext>& _context, int height, int width);
 
 private:
-    void computeBLAS(RefCntAutoPtr<Diligent::IRenderDevice> _device, RefCntAutoPtr<IDeviceContext> _context, const Mesh::Group& _grp);
+    // Everything that can be created off the render thread, only the build itself needs the context
+    struct PendingBLAS
+    {
+        const Mesh::Group* m_group;
+        RefCntAutoPtr<IBottomLevelAS> m_blas;
+        RefCntAutoPtr<IBuffer> m_vertices;
+        RefCntAutoPtr<IBuffer> m_indices;
+    };
+
+    PendingBLAS prepareBLAS(RefCntAutoPtr<Diligent::IRenderDevice> _device, const Mesh::Group& _grp);
+    void computeBLAS(RefCntAutoPtr<Diligent::IRenderDevice> _device, RefCntAutoPtr<IDeviceContext> _context, PendingBLAS& _pending);
     /*
      * We need
      * 0: A mesh desc
@@ -58,7 +70,7 @@ private:
 
     std::mutex addMutex;
 
-    eastl::vector<Mesh*> m_meshToAdd;
+    eastl::vector<PendingBLAS> m_blasToBuild;
 
     eastl::vector<RefCntAutoPtr<IBottomLevelAS>> BLASes;
     RefCntAutoPtr<ITopLevelAS> TLAS;
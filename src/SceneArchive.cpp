@@ -0,0 +1,202 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#include "SceneArchive.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "tracy/Tracy.hpp"
+#include "util/meow_hash_x64_aesni.h"
+
+namespace SceneArchive
+{
+namespace
+{
+    uint64_t align(uint64_t _offset)
+    {
+        return (_offset + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    }
+
+    void hash(const uint8_t* _data, size_t _size, uint64_t (&_hash)[2])
+    {
+        const meow_u128 value = MeowHash(MeowDefaultSeed, _size, const_cast<uint8_t*>(_data));
+        _hash[0] = MeowU64From(value, 0);
+        _hash[1] = MeowU64From(value, 1);
+    }
+
+    Reader& getMountedArchive()
+    {
+        static Reader reader;
+        return reader;
+    }
+}
+
+size_t write(const char* _path, const eastl::vector<File>& _files)
+{
+    ZoneScopedN("Write Scene Archive");
+
+    const uint32_t entryCount = static_cast<uint32_t>(_files.size());
+    eastl::vector<Entry> toc(entryCount);
+    eastl::string names;
+    for (uint32_t i = 0; i < entryCount; ++i)
+    {
+        toc[i].m_nameOffset = static_cast<uint32_t>(names.size());
+        toc[i].m_nameSize = static_cast<uint32_t>(_files[i].m_name.size());
+        names += _files[i].m_name;
+    }
+
+    Header header{};
+    header.m_magic = MAGIC;
+    header.m_formatVersion = FORMAT_VERSION;
+    header.m_entryCount = entryCount;
+    header.m_namesSize = static_cast<uint32_t>(names.size());
+
+    // the sizes are only known once the files are open, they stay mapped until everything is written
+    eastl::vector<MappedFile> files(entryCount);
+    uint64_t offset = align(sizeof(Header) + sizeof(Entry) * entryCount + names.size());
+    for (uint32_t i = 0; i < entryCount; ++i)
+    {
+        if (!files[i].open(_files[i].m_path.c_str()))
+        {
+            std::cout << "Could not pack " << _files[i].m_path.c_str() << " in " << _path << std::endl;
+            return 0;
+        }
+
+        toc[i].m_offset = offset;
+        toc[i].m_size = files[i].size();
+        hash(files[i].data(), files[i].size(), toc[i].m_hash);
+        offset = align(offset + files[i].size());
+    }
+
+    std::ofstream file(_path, std::ios_base::binary);
+    if (!file.good())
+        return 0;
+
+    const char padding[ALIGNMENT] = {};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(toc.data()), sizeof(Entry) * toc.size());
+    file.write(names.data(), names.size());
+
+    uint64_t written = sizeof(Header) + sizeof(Entry) * entryCount + names.size();
+    for (uint32_t i = 0; i < entryCount; ++i)
+    {
+        file.write(padding, toc[i].m_offset - written);
+        file.write(reinterpret_cast<const char*>(files[i].data()), files[i].size());
+        written = toc[i].m_offset + toc[i].m_size;
+    }
+
+    // the last entry is padded too, so the size of the archive is a multiple of ALIGNMENT
+    file.write(padding, offset - written);
+    return file.good() ? offset : 0;
+}
+
+bool Reader::open(const char* _path)
+{
+    ZoneScopedN("Open Scene Archive");
+    close();
+
+    if (!m_file.open(_path))
+        return false;
+
+    const uint8_t* data = m_file.data();
+    const size_t size = m_file.size();
+    const auto* header = reinterpret_cast<const Header*>(data);
+    if (size < sizeof(Header) || header->m_magic != MAGIC || header->m_formatVersion != FORMAT_VERSION
+        || size < sizeof(Header) + sizeof(Entry) * static_cast<uint64_t>(header->m_entryCount) + header->m_namesSize)
+    {
+        std::cout << _path << " is not a scene archive or was written by another version of AssetCooker" << std::endl;
+        close();
+        return false;
+    }
+
+    // the table of contents is small and read right away, the entries are read ahead while it is parsed
+    m_file.prefetch(0, size);
+
+    m_entries.resize(header->m_entryCount);
+    memcpy(m_entries.data(), data + sizeof(Header), sizeof(Entry) * m_entries.size());
+    const char* names = reinterpret_cast<const char*>(data + sizeof(Header) + sizeof(Entry) * m_entries.size());
+
+    for (uint32_t i = 0; i < m_entries.size(); ++i)
+    {
+        const Entry& entry = m_entries[i];
+        if (entry.m_offset + entry.m_size > size || entry.m_nameOffset + static_cast<uint64_t>(entry.m_nameSize) > header->m_namesSize)
+        {
+            std::cout << _path << " is truncated" << std::endl;
+            close();
+            return false;
+        }
+        m_lookup[eastl::string(names + entry.m_nameOffset, entry.m_nameSize)] = i;
+    }
+
+    const eastl::string path(_path);
+    const size_t separator = path.find_last_of("/\\");
+    m_root = separator == eastl::string::npos ? eastl::string() : path.substr(0, separator + 1);
+    return true;
+}
+
+void Reader::close()
+{
+    m_file.close();
+    m_root.clear();
+    m_entries.clear();
+    m_lookup.clear();
+}
+
+const Entry* Reader::findEntry(const eastl::string& _path) const
+{
+    if (!isOpen() || _path.compare(0, m_root.size(), m_root) != 0)
+        return nullptr;
+
+    auto it = m_lookup.find_as(_path.c_str() + m_root.size());
+    return it != m_lookup.end() ? &m_entries[it->second] : nullptr;
+}
+
+bool Reader::find(const eastl::string& _path, View& _view) const
+{
+    const Entry* entry = findEntry(_path);
+    if (!entry)
+        return false;
+
+    // the mesh reads every byte anyway, hashing them first costs little next to the decompression
+    uint64_t entryHash[2];
+    hash(m_file.data() + entry->m_offset, entry->m_size, entryHash);
+    if (entryHash[0] != entry->m_hash[0] || entryHash[1] != entry->m_hash[1])
+    {
+        std::cout << _path.c_str() << " is damaged in the scene archive, loading it from its own file" << std::endl;
+        return false;
+    }
+
+    _view.m_data = m_file.data() + entry->m_offset;
+    _view.m_size = entry->m_size;
+    return true;
+}
+
+size_t Reader::getEntrySize(const eastl::string& _path) const
+{
+    const Entry* entry = findEntry(_path);
+    return entry ? entry->m_size : 0;
+}
+
+bool mount(const char* _path)
+{
+    Reader& reader = getMountedArchive();
+    if (!reader.open(_path))
+        return false;
+
+    std::cout << "Mounted " << _path << ": " << reader.getEntryCount() << " meshes, " << (reader.getSize() >> 20) << "MB" << std::endl;
+    return true;
+}
+
+void unmount()
+{
+    getMountedArchive().close();
+}
+
+const Reader& getMounted()
+{
+    return getMountedArchive();
+}
+}
@@ -0,0 +1,93 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#ifndef GRAPHICSPLAYGROUND_SCENEARCHIVE_HPP
+#define GRAPHICSPLAYGROUND_SCENEARCHIVE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include <EASTL/hash_map.h>
+#include <EASTL/string.h>
+#include <EASTL/vector.h>
+
+#include "util/MappedFile.hpp"
+
+// Every cooked .mesh of a scene (geometry and textures) in one file, written by AssetCooker --pak.
+// The whole archive is mapped once and read ahead in a few large requests instead of opening, mapping and faulting one file per mesh.
+// Entries start on a 4K boundary so each one is page and sector aligned, they hold the .mesh bytes untouched.
+//
+// | Header | Entry[entryCount] | names | pad | mesh 0 | pad | mesh 1 | ...
+namespace SceneArchive
+{
+    static constexpr uint32_t MAGIC = 'G' | 'P' << 8 | 'A' << 16 | 'K' << 24;
+    static constexpr uint32_t FORMAT_VERSION = 1; // of the archive itself, the meshes carry their own VERSION
+    static constexpr uint64_t ALIGNMENT = 4096;
+    static constexpr const char* FILE_NAME = "scene.pak";
+
+    struct Header
+    {
+        uint32_t m_magic;
+        uint32_t m_formatVersion;
+        uint32_t m_entryCount;
+        uint32_t m_namesSize;
+    };
+
+    struct Entry
+    {
+        uint64_t m_offset; // from the start of the archive, multiple of ALIGNMENT
+        uint64_t m_size;
+        uint64_t m_hash[2]; // meow hash of the bytes of the entry
+        uint32_t m_nameOffset; // in the names block, names are relative to the directory of the archive
+        uint32_t m_nameSize;
+    };
+
+    struct File
+    {
+        eastl::string m_name; // key the meshes look the entry up with, relative to the archive
+        eastl::string m_path; // where the cooker reads it from
+    };
+
+    // Returns the size written or 0 on failure
+    size_t write(const char* _path, const eastl::vector<File>& _files);
+
+    struct View
+    {
+        const uint8_t* m_data = nullptr;
+        size_t m_size = 0;
+    };
+
+    class Reader
+    {
+    public:
+        // Maps the archive and starts reading all of it, false if it's missing or not an archive
+        bool open(const char* _path);
+        void close();
+
+        [[nodiscard]] bool isOpen() const { return m_file.isOpen(); }
+        [[nodiscard]] uint32_t getEntryCount() const { return static_cast<uint32_t>(m_entries.size()); }
+        [[nodiscard]] size_t getSize() const { return m_file.size(); }
+
+        // _path is the one the meshes use (relative to the working directory), the view lives as long as the archive is open.
+        // The bytes are checked against the hash of the table of contents, a damaged entry isn't returned. Thread safe.
+        bool find(const eastl::string& _path, View& _view) const;
+        [[nodiscard]] size_t getEntrySize(const eastl::string& _path) const;
+
+    private:
+        const Entry* findEntry(const eastl::string& _path) const;
+
+        MappedFile m_file;
+        eastl::string m_root; // directory of the archive, with its trailing /
+        eastl::vector<Entry> m_entries;
+        eastl::hash_map<eastl::string, uint32_t> m_lookup;
+    };
+
+    // The archive the meshes load from, mounted once before any load starts and read only afterwards.
+    // Unmounted, find fails and every mesh goes back to its own .mesh file.
+    bool mount(const char* _path);
+    void unmount();
+    const Reader& getMounted();
+}
+
+#endif //GRAPHICSPLAYGROUND_SCENEARCHIVE_HPP
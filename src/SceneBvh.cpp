@@ -0,0 +1,561 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#include "SceneBvh.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include "tracy/Tracy.hpp"
+
+namespace
+{
+    constexpr uint32_t BIN_COUNT = 12;
+
+    BoundBox getEmptyBounds()
+    {
+        return {float3(std::numeric_limits<float>::max()), float3(std::numeric_limits<float>::lowest())};
+    }
+
+    void grow(BoundBox& _bounds, const BoundBox& _other)
+    {
+        _bounds.Min = std::min(_bounds.Min, _other.Min);
+        _bounds.Max = std::max(_bounds.Max, _other.Max);
+    }
+
+    // half of it, only compared
+    float getArea(const BoundBox& _bounds)
+    {
+        const float3 size = _bounds.Max - _bounds.Min;
+        return size.x * size.y + size.y * size.z + size.z * size.x;
+    }
+
+    float3 getCentroid(const BoundBox& _bounds)
+    {
+        return (_bounds.Min + _bounds.Max) * 0.5f;
+    }
+
+    uint32_t getLongestAxis(const BoundBox& _bounds)
+    {
+        const float3 size = _bounds.Max - _bounds.Min;
+        return size.x >= size.y && size.x >= size.z ? 0 : (size.y >= size.z ? 1 : 2);
+    }
+
+    bool isEqual(const BoundBox& _a, const BoundBox& _b)
+    {
+        return _a.Min == _b.Min && _a.Max == _b.Max;
+    }
+}
+
+void SceneBvh::build(const uint32_t* _ids, const BoundBox* _bounds, uint32_t _count)
+{
+    ZoneScopedN("Build Scene BVH");
+    clear();
+
+    for (uint32_t i = 0; i < _count; ++i)
+    {
+        setItem(_ids[i], _bounds[i], INVALID);
+    }
+    m_itemCount = _count;
+    if (_count == 0)
+        return;
+
+    // about one leaf per 2 or 3 boxes, as many internal nodes
+    m_nodes.reserve(_count);
+    m_nodes.push_back({getEmptyBounds(), INVALID, INVALID, 0, {}});
+
+    eastl::vector<BuildItem> items(_count);
+    for (uint32_t i = 0; i < _count; ++i)
+    {
+        items[i] = {_bounds[i], getCentroid(_bounds[i]), _ids[i]};
+    }
+    buildNode(0, items.data(), _count);
+}
+
+void SceneBvh::rebuild()
+{
+    eastl::vector<uint32_t> ids;
+    eastl::vector<BoundBox> bounds;
+    ids.reserve(m_itemCount);
+    bounds.reserve(m_itemCount);
+    for (uint32_t id = 0; id < m_itemLeaves.size(); ++id)
+    {
+        if (m_itemLeaves[id] != INVALID)
+        {
+            ids.push_back(id);
+            bounds.push_back(m_itemBounds[id]);
+        }
+    }
+    build(ids.data(), bounds.data(), static_cast<uint32_t>(ids.size()));
+}
+
+void SceneBvh::clear()
+{
+    m_nodes.clear();
+    m_freePairs.clear();
+    m_itemBounds.clear();
+    m_itemLeaves.clear();
+    m_itemCount = 0;
+    m_changesSinceBuild = 0;
+}
+
+void SceneBvh::buildNode(uint32_t _node, BuildItem* _items, uint32_t _count)
+{
+    if (_count <= MAX_LEAF_SIZE)
+    {
+        Node& leaf = m_nodes[_node];
+        leaf.m_child = INVALID;
+        leaf.m_count = _count;
+        leaf.m_bounds = getEmptyBounds();
+        for (uint32_t i = 0; i < _count; ++i)
+        {
+            leaf.m_items[i] = _items[i].m_id;
+            grow(leaf.m_bounds, _items[i].m_bounds);
+            m_itemLeaves[_items[i].m_id] = _node;
+        }
+        return;
+    }
+
+    BoundBox centroids = getEmptyBounds();
+    for (uint32_t i = 0; i < _count; ++i)
+    {
+        grow(centroids, {_items[i].m_centroid, _items[i].m_centroid});
+    }
+    const uint32_t axis = getLongestAxis(centroids);
+    const float extent = centroids.Max[axis] - centroids.Min[axis];
+
+    // the split between bins with the lowest surface area cost, over the longest axis of the centroids
+    uint32_t split = 0;
+    if (extent > 0.0f)
+    {
+        struct Bin
+        {
+            BoundBox m_bounds = getEmptyBounds();
+            uint32_t m_count = 0;
+        };
+        Bin bins[BIN_COUNT];
+        const float scale = static_cast<float>(BIN_COUNT) / extent;
+        auto getBin = [&](const BuildItem& _item)
+        {
+            return std::min(BIN_COUNT - 1, static_cast<uint32_t>((_item.m_centroid[axis] - centroids.Min[axis]) * scale));
+        };
+
+        for (uint32_t i = 0; i < _count; ++i)
+        {
+            Bin& bin = bins[getBin(_items[i])];
+            grow(bin.m_bounds, _items[i].m_bounds);
+            bin.m_count++;
+        }
+
+        float rightAreas[BIN_COUNT];
+        uint32_t rightCounts[BIN_COUNT];
+        BoundBox right = getEmptyBounds();
+        uint32_t rightCount = 0;
+        for (uint32_t i = BIN_COUNT - 1; i > 0; --i)
+        {
+            grow(right, bins[i].m_bounds);
+            rightCount += bins[i].m_count;
+            rightAreas[i] = rightCount > 0 ? getArea(right) : 0.0f;
+            rightCounts[i] = rightCount;
+        }
+
+        float bestCost = std::numeric_limits<float>::max();
+        uint32_t bestBin = BIN_COUNT;
+        BoundBox left = getEmptyBounds();
+        uint32_t leftCount = 0;
+        for (uint32_t i = 0; i < BIN_COUNT - 1; ++i)
+        {
+            grow(left, bins[i].m_bounds);
+            leftCount += bins[i].m_count;
+            if (leftCount == 0 || rightCounts[i + 1] == 0)
+                continue;
+
+            const float cost = getArea(left) * static_cast<float>(leftCount) + rightAreas[i + 1] * static_cast<float>(rightCounts[i + 1]);
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestBin = i;
+            }
+        }
+
+        if (bestBin < BIN_COUNT)
+        {
+            split = static_cast<uint32_t>(std::partition(_items, _items + _count, [&](const BuildItem& _item) { return getBin(_item) <= bestBin; }) - _items);
+        }
+    }
+
+    // every centroid in the same bin, halves around the median
+    if (split == 0 || split == _count)
+    {
+        split = _count / 2;
+        std::nth_element(_items, _items + split, _items + _count, [axis](const BuildItem& _a, const BuildItem& _b)
+        {
+            return _a.m_centroid[axis] < _b.m_centroid[axis];
+        });
+    }
+
+    // the nodes can move while the children are built, no reference kept across the calls
+    const uint32_t child = allocatePair();
+    m_nodes[child].m_parent = _node;
+    m_nodes[child + 1].m_parent = _node;
+    m_nodes[_node].m_child = child;
+    m_nodes[_node].m_count = 0;
+
+    buildNode(child, _items, split);
+    buildNode(child + 1, _items + split, _count - split);
+    m_nodes[_node].m_bounds = computeBounds(m_nodes[_node]);
+}
+
+uint32_t SceneBvh::allocatePair()
+{
+    if (!m_freePairs.empty())
+    {
+        const uint32_t pair = m_freePairs.back();
+        m_freePairs.pop_back();
+        return pair;
+    }
+
+    const uint32_t pair = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.push_back({getEmptyBounds(), INVALID, INVALID, 0, {}});
+    m_nodes.push_back({getEmptyBounds(), INVALID, INVALID, 0, {}});
+    return pair;
+}
+
+void SceneBvh::insert(uint32_t _id, const BoundBox& _bounds)
+{
+    if (contains(_id))
+    {
+        update(_id, _bounds);
+        return;
+    }
+
+    m_itemCount++;
+    m_changesSinceBuild++;
+    if (m_nodes.empty())
+    {
+        m_nodes.push_back({getEmptyBounds(), INVALID, INVALID, 0, {}});
+    }
+
+    // down the child that grows the least
+    uint32_t node = 0;
+    while (m_nodes[node].m_child != INVALID)
+    {
+        const uint32_t child = m_nodes[node].m_child;
+        BoundBox left = m_nodes[child].m_bounds;
+        BoundBox right = m_nodes[child + 1].m_bounds;
+        const float leftArea = getArea(left);
+        const float rightArea = getArea(right);
+        grow(left, _bounds);
+        grow(right, _bounds);
+        node = getArea(left) - leftArea <= getArea(right) - rightArea ? child : child + 1;
+    }
+
+    if (m_nodes[node].m_count < MAX_LEAF_SIZE)
+    {
+        Node& leaf = m_nodes[node];
+        leaf.m_items[leaf.m_count++] = _id;
+        setItem(_id, _bounds, node);
+        refit(node);
+        return;
+    }
+
+    // a full leaf becomes the parent of two, built like any other node
+    setItem(_id, _bounds, node);
+    BuildItem items[MAX_LEAF_SIZE + 1];
+    for (uint32_t i = 0; i <= MAX_LEAF_SIZE; ++i)
+    {
+        const uint32_t id = i < MAX_LEAF_SIZE ? m_nodes[node].m_items[i] : _id;
+        items[i] = {m_itemBounds[id], getCentroid(m_itemBounds[id]), id};
+    }
+    buildNode(node, items, MAX_LEAF_SIZE + 1);
+    refit(m_nodes[node].m_parent);
+}
+
+void SceneBvh::remove(uint32_t _id)
+{
+    if (!contains(_id))
+        return;
+
+    const uint32_t leafIndex = m_itemLeaves[_id];
+    Node& leaf = m_nodes[leafIndex];
+    for (uint32_t i = 0; i < leaf.m_count; ++i)
+    {
+        if (leaf.m_items[i] == _id)
+        {
+            leaf.m_items[i] = leaf.m_items[--leaf.m_count];
+            break;
+        }
+    }
+    m_itemLeaves[_id] = INVALID;
+    m_itemCount--;
+    m_changesSinceBuild++;
+
+    if (leaf.m_count > 0 || leaf.m_parent == INVALID)
+    {
+        refit(leafIndex);
+        return;
+    }
+
+    // the empty leaf goes away and its sibling takes the place of their parent
+    const uint32_t parent = leaf.m_parent;
+    const uint32_t pair = m_nodes[parent].m_child;
+    const uint32_t sibling = leafIndex == pair ? pair + 1 : pair;
+    const uint32_t grandParent = m_nodes[parent].m_parent;
+    m_nodes[parent] = m_nodes[sibling];
+    m_nodes[parent].m_parent = grandParent;
+
+    const Node& moved = m_nodes[parent];
+    if (moved.m_child != INVALID)
+    {
+        m_nodes[moved.m_child].m_parent = parent;
+        m_nodes[moved.m_child + 1].m_parent = parent;
+    }
+    for (uint32_t i = 0; i < moved.m_count; ++i)
+    {
+        m_itemLeaves[moved.m_items[i]] = parent;
+    }
+
+    m_freePairs.push_back(pair);
+    refit(grandParent);
+}
+
+void SceneBvh::update(uint32_t _id, const BoundBox& _bounds)
+{
+    if (!contains(_id))
+        return;
+
+    // a small move only grows the leaf a bit, a jump elsewhere would stretch every node up to the root
+    const BoundBox& previous = m_itemBounds[_id];
+    const bool isOverlapping = _bounds.Min.x <= previous.Max.x && _bounds.Max.x >= previous.Min.x && _bounds.Min.y <= previous.Max.y
+                               && _bounds.Max.y >= previous.Min.y && _bounds.Min.z <= previous.Max.z && _bounds.Max.z >= previous.Min.z;
+    if (!isOverlapping)
+    {
+        remove(_id);
+        insert(_id, _bounds);
+        return;
+    }
+
+    m_itemBounds[_id] = _bounds;
+    refit(m_itemLeaves[_id]);
+}
+
+bool SceneBvh::needsRebuild() const
+{
+    return m_changesSinceBuild > std::max(64u, m_itemCount / 2);
+}
+
+void SceneBvh::refit(uint32_t _node)
+{
+    while (_node != INVALID)
+    {
+        const BoundBox bounds = computeBounds(m_nodes[_node]);
+        if (isEqual(bounds, m_nodes[_node].m_bounds))
+            return;
+
+        m_nodes[_node].m_bounds = bounds;
+        _node = m_nodes[_node].m_parent;
+    }
+}
+
+void SceneBvh::setItem(uint32_t _id, const BoundBox& _bounds, uint32_t _leaf)
+{
+    if (_id >= m_itemLeaves.size())
+    {
+        m_itemLeaves.resize(_id + 1, INVALID);
+        m_itemBounds.resize(_id + 1);
+    }
+    m_itemBounds[_id] = _bounds;
+    m_itemLeaves[_id] = _leaf;
+}
+
+BoundBox SceneBvh::computeBounds(const Node& _node) const
+{
+    BoundBox bounds = getEmptyBounds();
+    if (_node.m_child != INVALID)
+    {
+        grow(bounds, m_nodes[_node.m_child].m_bounds);
+        grow(bounds, m_nodes[_node.m_child + 1].m_bounds);
+    }
+    for (uint32_t i = 0; i < _node.m_count; ++i)
+    {
+        grow(bounds, m_itemBounds[_node.m_items[i]]);
+    }
+    return bounds;
+}
+
+void SceneBvh::queryFrustum(const ViewFrustum& _frustum, eastl::vector<uint32_t>& _ids) const
+{
+    ZoneScopedN("Scene BVH Frustum");
+    _ids.clear();
+    if (m_itemCount == 0)
+        return;
+
+    // nodes inside the frustum are pushed with this bit, their whole subtree is kept without testing it
+    constexpr uint32_t INSIDE_BIT = 1u << 31;
+
+    eastl::vector<uint32_t> stack;
+    stack.reserve(64);
+    stack.push_back(0);
+    while (!stack.empty())
+    {
+        const uint32_t entry = stack.back();
+        stack.pop_back();
+        const Node& node = m_nodes[entry & ~INSIDE_BIT];
+
+        // a box inside another can't get further behind a plane, or closer to it from the front, even with the rounding
+        uint32_t inside = entry & INSIDE_BIT;
+        if (inside == 0)
+        {
+            const BoxVisibility visibility = GetBoxVisibility(_frustum, node.m_bounds);
+            if (visibility == BoxVisibility::Invisible)
+                continue;
+
+            inside = visibility == BoxVisibility::FullyVisible ? INSIDE_BIT : 0;
+        }
+
+        if (node.m_child != INVALID)
+        {
+            stack.push_back(node.m_child | inside);
+            stack.push_back((node.m_child + 1) | inside);
+            continue;
+        }
+
+        for (uint32_t i = 0; i < node.m_count; ++i)
+        {
+            if (inside != 0 || GetBoxVisibility(_frustum, m_itemBounds[node.m_items[i]]) != BoxVisibility::Invisible)
+            {
+                _ids.push_back(node.m_items[i]);
+            }
+        }
+    }
+}
+
+bool SceneBvh::raycast(const float3& _origin, const float3& _direction, float _maxDistance, RayHit& _hit) const
+{
+    ZoneScopedN("Scene BVH Raycast");
+    _hit = {INVALID, _maxDistance};
+    if (m_itemCount == 0)
+        return false;
+
+    // where the ray enters the box, counted from the origin when it starts inside
+    auto enter = [&](const BoundBox& _bounds, float& _distance)
+    {
+        float enterDistance = 0.0f;
+        float exitDistance = 0.0f;
+        if (!IntersectRayAABB(_origin, _direction, _bounds, enterDistance, exitDistance))
+            return false;
+
+        _distance = std::max(enterDistance, 0.0f);
+        return _distance <= _hit.m_distance;
+    };
+
+    struct Entry
+    {
+        uint32_t m_node;
+        float m_distance;
+    };
+    eastl::vector<Entry> stack;
+    float rootDistance = 0.0f;
+    if (enter(m_nodes[0].m_bounds, rootDistance))
+    {
+        stack.push_back({0, rootDistance});
+    }
+
+    // the closest child first, the other is skipped if a hit was found before reaching it
+    while (!stack.empty())
+    {
+        const Entry entry = stack.back();
+        stack.pop_back();
+        if (entry.m_distance > _hit.m_distance)
+            continue;
+
+        const Node& node = m_nodes[entry.m_node];
+        if (node.m_child == INVALID)
+        {
+            for (uint32_t i = 0; i < node.m_count; ++i)
+            {
+                float distance = 0.0f;
+                if (enter(m_itemBounds[node.m_items[i]], distance) && (distance < _hit.m_distance || _hit.m_id == INVALID))
+                {
+                    _hit = {node.m_items[i], distance};
+                }
+            }
+            continue;
+        }
+
+        float leftDistance = 0.0f;
+        float rightDistance = 0.0f;
+        const bool isLeftHit = enter(m_nodes[node.m_child].m_bounds, leftDistance);
+        const bool isRightHit = enter(m_nodes[node.m_child + 1].m_bounds, rightDistance);
+        if (isLeftHit && isRightHit)
+        {
+            const bool isLeftCloser = leftDistance <= rightDistance;
+            stack.push_back(isLeftCloser ? Entry{node.m_child + 1, rightDistance} : Entry{node.m_child, leftDistance});
+            stack.push_back(isLeftCloser ? Entry{node.m_child, leftDistance} : Entry{node.m_child + 1, rightDistance});
+        }
+        else if (isLeftHit)
+        {
+            stack.push_back({node.m_child, leftDistance});
+        }
+        else if (isRightHit)
+        {
+            stack.push_back({node.m_child + 1, rightDistance});
+        }
+    }
+
+    return _hit.m_id != INVALID;
+}
+
+template <typename Overlap>
+void SceneBvh::queryOverlap(const Overlap& _overlap, eastl::vector<uint32_t>& _ids) const
+{
+    _ids.clear();
+    if (m_itemCount == 0)
+        return;
+
+    eastl::vector<uint32_t> stack;
+    stack.push_back(0);
+    while (!stack.empty())
+    {
+        const Node& node = m_nodes[stack.back()];
+        stack.pop_back();
+        if (!_overlap(node.m_bounds))
+            continue;
+
+        if (node.m_child != INVALID)
+        {
+            stack.push_back(node.m_child);
+            stack.push_back(node.m_child + 1);
+        }
+        for (uint32_t i = 0; i < node.m_count; ++i)
+        {
+            if (_overlap(m_itemBounds[node.m_items[i]]))
+            {
+                _ids.push_back(node.m_items[i]);
+            }
+        }
+    }
+}
+
+void SceneBvh::queryBox(const BoundBox& _box, eastl::vector<uint32_t>& _ids) const
+{
+    ZoneScopedN("Scene BVH Box");
+    queryOverlap([&_box](const BoundBox& _bounds)
+    {
+        return _bounds.Min.x <= _box.Max.x && _bounds.Max.x >= _box.Min.x && _bounds.Min.y <= _box.Max.y && _bounds.Max.y >= _box.Min.y
+               && _bounds.Min.z <= _box.Max.z && _bounds.Max.z >= _box.Min.z;
+    }, _ids);
+}
+
+void SceneBvh::querySphere(const float3& _center, float _radius, eastl::vector<uint32_t>& _ids) const
+{
+    ZoneScopedN("Scene BVH Sphere");
+    const float radiusSquared = _radius * _radius;
+    queryOverlap([&_center, radiusSquared](const BoundBox& _bounds)
+    {
+        // from the center to the closest point of the box
+        const float3 offset = _center - std::max(_bounds.Min, std::min(_center, _bounds.Max));
+        return dot(offset, offset) <= radiusSquared;
+    }, _ids);
+}
@@ -0,0 +1,92 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#ifndef GRAPHICSPLAYGROUND_SCENEBVH_HPP
+#define GRAPHICSPLAYGROUND_SCENEBVH_HPP
+
+#include <cstdint>
+
+#include <EASTL/vector.h>
+
+#include "Common/interface/AdvancedMath.hpp"
+#include "Common/interface/BasicMath.hpp"
+
+using namespace Diligent;
+
+// Bounding volume hierarchy over world space boxes, each one with a user id (the SceneStore uses the index of its handles).
+// build() splits with a binned SAH. insert, remove and update keep it valid as the scene changes: a new box goes down the child
+// whose area grows the least, a moved one refits its leaf and the ancestors whose bounds change (or is inserted again when it jumped
+// somewhere else). The greedy inserts drift from SAH, once enough boxes came and went since the last build needsRebuild() says so.
+// The queries are const and can run on several threads at once.
+class SceneBvh
+{
+public:
+    static constexpr uint32_t MAX_LEAF_SIZE = 4;
+    static constexpr uint32_t INVALID = UINT32_MAX;
+
+    struct RayHit
+    {
+        uint32_t m_id = INVALID;
+        float m_distance = 0.0f; // along the direction, 0 when the origin is inside the box
+    };
+
+    // Replaces everything with _count boxes, _ids[i] has _bounds[i]
+    void build(const uint32_t* _ids, const BoundBox* _bounds, uint32_t _count);
+    void rebuild();
+    void clear();
+
+    void insert(uint32_t _id, const BoundBox& _bounds);
+    void remove(uint32_t _id);
+    void update(uint32_t _id, const BoundBox& _bounds);
+
+    [[nodiscard]] bool needsRebuild() const;
+    [[nodiscard]] bool contains(uint32_t _id) const { return _id < m_itemLeaves.size() && m_itemLeaves[_id] != INVALID; }
+    [[nodiscard]] uint32_t getCount() const { return m_itemCount; }
+    [[nodiscard]] uint32_t getNodeCount() const { return static_cast<uint32_t>(m_nodes.size() - m_freePairs.size() * 2); }
+
+    // Ids of the boxes GetBoxVisibility doesn't find Invisible, in no particular order. The same set as testing every box:
+    // a node is skipped only when its farthest corner is behind a plane and the ones of its boxes can't be further in front.
+    void queryFrustum(const ViewFrustum& _frustum, eastl::vector<uint32_t>& _ids) const;
+    // The closest box the ray enters within _maxDistance, false if none
+    bool raycast(const float3& _origin, const float3& _direction, float _maxDistance, RayHit& _hit) const;
+    // Ids of the boxes overlapping _box or _center/_radius, in no particular order
+    void queryBox(const BoundBox& _box, eastl::vector<uint32_t>& _ids) const;
+    void querySphere(const float3& _center, float _radius, eastl::vector<uint32_t>& _ids) const;
+
+private:
+    struct Node
+    {
+        BoundBox m_bounds;
+        uint32_t m_parent; // INVALID for the root
+        uint32_t m_child; // the left child of an internal node, the right one is the next node
+        uint32_t m_count; // boxes of a leaf, 0 for an internal node
+        uint32_t m_items[MAX_LEAF_SIZE];
+    };
+
+    // what the build sorts, contiguous so the passes over a node don't jump around the boxes
+    struct BuildItem
+    {
+        BoundBox m_bounds;
+        float3 m_centroid;
+        uint32_t m_id;
+    };
+
+    eastl::vector<Node> m_nodes; // [0] is the root
+    eastl::vector<uint32_t> m_freePairs; // left node of the children freed by remove
+    eastl::vector<BoundBox> m_itemBounds; // by id
+    eastl::vector<uint32_t> m_itemLeaves; // by id, INVALID when not in the tree
+    uint32_t m_itemCount = 0;
+    uint32_t m_changesSinceBuild = 0;
+
+    void buildNode(uint32_t _node, BuildItem* _items, uint32_t _count);
+    uint32_t allocatePair();
+    template <typename Overlap>
+    void queryOverlap(const Overlap& _overlap, eastl::vector<uint32_t>& _ids) const;
+    // Recomputes the bounds of _node then of its ancestors, up to the first one that doesn't change
+    void refit(uint32_t _node);
+    void setItem(uint32_t _id, const BoundBox& _bounds, uint32_t _leaf);
+    BoundBox computeBounds(const Node& _node) const;
+};
+
+#endif //GRAPHICSPLAYGROUND_SCENEBVH_HPP
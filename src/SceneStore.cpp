@@ -0,0 +1,249 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#include "SceneStore.hpp"
+
+#include <limits>
+
+#include <EASTL/algorithm.h>
+#include <EASTL/sort.h>
+
+#include "Mesh.h"
+#include "tracy/Tracy.hpp"
+
+static_assert(SceneStore::MAX_LODS == Mesh::LOD_MAX_COUNT, "Every LOD of a group fits in its LodInfo");
+
+SceneStore::Handle SceneStore::create(Mesh* _owner, uint32_t _group, const BoundBox& _localBounds, const LodInfo& _lods, uint32_t _materialId,
+                                      uint8_t _flags)
+{
+    Handle handle;
+    if (!m_freeHandles.empty())
+    {
+        handle.m_index = m_freeHandles.back();
+        m_freeHandles.pop_back();
+    }
+    else
+    {
+        handle.m_index = static_cast<uint32_t>(m_instances.size());
+        m_instances.push_back(UINT32_MAX);
+        m_generations.push_back(0);
+    }
+    handle.m_generation = m_generations[handle.m_index];
+    m_instances[handle.m_index] = getCount();
+
+    // at the origin until the owner pushes its transform
+    m_worldMinX.push_back(_localBounds.Min.x);
+    m_worldMinY.push_back(_localBounds.Min.y);
+    m_worldMinZ.push_back(_localBounds.Min.z);
+    m_worldMaxX.push_back(_localBounds.Max.x);
+    m_worldMaxY.push_back(_localBounds.Max.y);
+    m_worldMaxZ.push_back(_localBounds.Max.z);
+    m_spheres.push_back(float4((_localBounds.Min + _localBounds.Max) * 0.5f, length(_localBounds.Max - _localBounds.Min) * 0.5f));
+    m_lods.push_back(_lods);
+    m_materialIds.push_back(_materialId);
+    m_flags.push_back(_flags);
+    m_worldMatrices.push_back(float4x4::Identity());
+    m_localBounds.push_back(_localBounds);
+    m_owners.push_back(_owner);
+    m_groups.push_back(_group);
+    m_handles.push_back(handle.m_index);
+
+    m_bvh.insert(handle.m_index, _localBounds);
+    if (m_bvh.needsRebuild())
+    {
+        m_bvh.rebuild();
+    }
+    return handle;
+}
+
+void SceneStore::destroy(Handle _handle)
+{
+    if (!isAlive(_handle))
+        return;
+
+    // the last instance takes the place of the removed one so the arrays stay packed
+    const uint32_t instance = m_instances[_handle.m_index];
+    const uint32_t last = getCount() - 1;
+    if (instance != last)
+    {
+        setWorldBounds(instance, getWorldBounds(last));
+        m_spheres[instance] = m_spheres[last];
+        m_lods[instance] = m_lods[last];
+        m_materialIds[instance] = m_materialIds[last];
+        m_flags[instance] = m_flags[last];
+        m_worldMatrices[instance] = m_worldMatrices[last];
+        m_localBounds[instance] = m_localBounds[last];
+        m_owners[instance] = m_owners[last];
+        m_groups[instance] = m_groups[last];
+        m_handles[instance] = m_handles[last];
+        m_instances[m_handles[instance]] = instance;
+    }
+
+    m_worldMinX.pop_back();
+    m_worldMinY.pop_back();
+    m_worldMinZ.pop_back();
+    m_worldMaxX.pop_back();
+    m_worldMaxY.pop_back();
+    m_worldMaxZ.pop_back();
+    m_spheres.pop_back();
+    m_lods.pop_back();
+    m_materialIds.pop_back();
+    m_flags.pop_back();
+    m_worldMatrices.pop_back();
+    m_localBounds.pop_back();
+    m_owners.pop_back();
+    m_groups.pop_back();
+    m_handles.pop_back();
+
+    // the old handles of this slot are recognized as dead from now on
+    m_instances[_handle.m_index] = UINT32_MAX;
+    m_generations[_handle.m_index]++;
+    m_freeHandles.push_back(_handle.m_index);
+
+    m_bvh.remove(_handle.m_index);
+    if (m_bvh.needsRebuild())
+    {
+        m_bvh.rebuild();
+    }
+}
+
+bool SceneStore::isAlive(Handle _handle) const
+{
+    return _handle.m_index < m_instances.size() && m_generations[_handle.m_index] == _handle.m_generation
+           && m_instances[_handle.m_index] != UINT32_MAX;
+}
+
+void SceneStore::setTransform(Handle _handle, const float4x4& _world, float _scale)
+{
+    if (!isAlive(_handle))
+        return;
+
+    const uint32_t instance = m_instances[_handle.m_index];
+    const BoundBox& local = m_localBounds[instance];
+    m_worldMatrices[instance] = _world;
+    setWorldBounds(instance, local.Transform(_world));
+    m_bvh.update(_handle.m_index, getWorldBounds(instance));
+    if (m_bvh.needsRebuild())
+    {
+        m_bvh.rebuild();
+    }
+
+    const float4 center = float4((local.Min + local.Max) * 0.5f, 1.0f) * _world;
+    m_spheres[instance] = float4(center.x, center.y, center.z, length(local.Max - local.Min) * 0.5f * _scale);
+}
+
+void SceneStore::cull(const ViewFrustum& _frustum, uint8_t _flags, eastl::vector<uint32_t>& _visible, ECullMethod _method,
+                      FrustumCulling::EKernel _kernel) const
+{
+    ZoneScopedN("Scene Store Cull");
+    if (_method == ECullMethod::Hierarchy)
+    {
+        m_bvh.queryFrustum(_frustum, _visible);
+        toInstances(_visible);
+        _visible.erase(eastl::remove_if(_visible.begin(), _visible.end(), [this, _flags](uint32_t _instance) { return (m_flags[_instance] & _flags) == 0; }),
+                       _visible.end());
+        eastl::sort(_visible.begin(), _visible.end());
+        return;
+    }
+
+    const FrustumCulling::Boxes boxes{m_worldMinX.data(), m_worldMinY.data(), m_worldMinZ.data(), m_worldMaxX.data(), m_worldMaxY.data(),
+                                      m_worldMaxZ.data(), m_flags.data(), getCount()};
+    FrustumCulling::cull(_frustum, boxes, _flags, _visible, _kernel);
+}
+
+void SceneStore::selectLods(const eastl::vector<uint32_t>& _visible, const float3& _cameraPosition, float _projectionScale, float _maxPixelError,
+                            eastl::vector<uint8_t>& _lods) const
+{
+    ZoneScopedN("Scene Store LODs");
+    _lods.resize(_visible.size());
+
+    for (size_t i = 0; i < _visible.size(); ++i)
+    {
+        const uint32_t instance = _visible[i];
+        const LodInfo& lods = m_lods[instance];
+        const float4& sphere = m_spheres[instance];
+
+        // inside the sphere it covers the whole screen, full detail
+        const float distance = length(float3(sphere.x, sphere.y, sphere.z) - _cameraPosition) - sphere.w;
+        uint8_t lod = 0;
+        if (lods.m_count > 1 && distance > 0.0f)
+        {
+            const float projectedRadius = sphere.w * _projectionScale / distance;
+            for (uint32_t l = lods.m_count - 1; l > 0; --l)
+            {
+                if (lods.m_errorRatios[l] * projectedRadius <= _maxPixelError)
+                {
+                    lod = static_cast<uint8_t>(l);
+                    break;
+                }
+            }
+        }
+        _lods[i] = lod;
+    }
+}
+
+void SceneStore::buildDrawList(const eastl::vector<uint32_t>& _visible, const eastl::vector<uint8_t>& _lods, eastl::vector<DrawItem>& _drawList) const
+{
+    ZoneScopedN("Scene Store Draw List");
+    _drawList.resize(_visible.size());
+
+    for (size_t i = 0; i < _visible.size(); ++i)
+    {
+        const uint32_t instance = _visible[i];
+        _drawList[i] = {instance, _lods.empty() ? 0u : _lods[i], m_materialIds[instance]};
+    }
+
+    // the same textures back to back, in instance order inside a material so the groups of a mesh stay together
+    eastl::sort(_drawList.begin(), _drawList.end(), [](const DrawItem& _a, const DrawItem& _b)
+    {
+        return _a.m_materialId != _b.m_materialId ? _a.m_materialId < _b.m_materialId : _a.m_instance < _b.m_instance;
+    });
+}
+
+bool SceneStore::raycast(const float3& _origin, const float3& _direction, uint32_t& _instance, float& _distance) const
+{
+    SceneBvh::RayHit hit;
+    if (!m_bvh.raycast(_origin, _direction, std::numeric_limits<float>::max(), hit))
+        return false;
+
+    _instance = m_instances[hit.m_id];
+    _distance = hit.m_distance;
+    return true;
+}
+
+void SceneStore::queryBox(const BoundBox& _box, eastl::vector<uint32_t>& _instances) const
+{
+    m_bvh.queryBox(_box, _instances);
+    toInstances(_instances);
+}
+
+void SceneStore::querySphere(const float3& _center, float _radius, eastl::vector<uint32_t>& _instances) const
+{
+    m_bvh.querySphere(_center, _radius, _instances);
+    toInstances(_instances);
+}
+
+void SceneStore::toInstances(eastl::vector<uint32_t>& _ids) const
+{
+    for (uint32_t& id : _ids)
+    {
+        id = m_instances[id];
+    }
+}
+
+BoundBox SceneStore::getWorldBounds(uint32_t _instance) const
+{
+    return {float3(m_worldMinX[_instance], m_worldMinY[_instance], m_worldMinZ[_instance]),
+            float3(m_worldMaxX[_instance], m_worldMaxY[_instance], m_worldMaxZ[_instance])};
+}
+
+void SceneStore::setWorldBounds(uint32_t _instance, const BoundBox& _bounds)
+{
+    m_worldMinX[_instance] = _bounds.Min.x;
+    m_worldMinY[_instance] = _bounds.Min.y;
+    m_worldMinZ[_instance] = _bounds.Min.z;
+    m_worldMaxX[_instance] = _bounds.Max.x;
+    m_worldMaxY[_instance] = _bounds.Max.y;
+    m_worldMaxZ[_instance] = _bounds.Max.z;
+}
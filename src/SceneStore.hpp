@@ -0,0 +1,131 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#ifndef GRAPHICSPLAYGROUND_SCENESTORE_HPP
+#define GRAPHICSPLAYGROUND_SCENESTORE_HPP
+
+#include <cstdint>
+
+#include <EASTL/vector.h>
+
+#include "Common/interface/AdvancedMath.hpp"
+#include "Common/interface/BasicMath.hpp"
+#include "FrustumCulling.hpp"
+#include "SceneBvh.hpp"
+
+using namespace Diligent;
+
+class Mesh;
+
+// What the per frame loops need from every instance of the scene (one per group of a mesh), in contiguous arrays:
+// world matrices, world bounds, LOD errors, material ids and flags. Mesh stays the authoring object and pushes its transform
+// when it moves, the culling and the draw lists stream through these arrays and only touch the Group of what ends up drawn.
+// Instances are kept packed, removing one moves the last one in its place, the handles go through an indirection so they stay valid.
+// A SceneBvh over the world bounds, keyed by the index of the handles, answers the culling of the views that see little of the scene
+// and the ray and overlap queries.
+class SceneStore
+{
+public:
+    static constexpr uint32_t MAX_LODS = 5; // Mesh::LOD_MAX_COUNT
+
+    struct Handle
+    {
+        uint32_t m_index = UINT32_MAX; // in the indirection, not in the arrays
+        uint32_t m_generation = 0;
+
+        [[nodiscard]] bool isValid() const { return m_index != UINT32_MAX; }
+    };
+
+    enum class ECullMethod : uint8_t
+    {
+        Linear = 0, // every instance through the FrustumCulling kernels, the fastest when a good part of the scene is visible
+        Hierarchy // down the BVH, the fastest when few instances are visible
+    };
+
+    enum EFlags : uint8_t
+    {
+        FLAG_OPAQUE = 1 << 0,
+        FLAG_TRANSPARENT = 1 << 1,
+        FLAG_CAST_SHADOW = 1 << 2
+    };
+
+    // LOD l is kept as long as m_errorRatios[l] * the projected radius of the instance stays under the max pixel error
+    struct LodInfo
+    {
+        float m_errorRatios[MAX_LODS]; // error of the LOD over the radius of the local bounds
+        uint32_t m_count;
+    };
+
+    struct DrawItem
+    {
+        uint32_t m_instance; // in the arrays, valid until the next create or destroy
+        uint32_t m_lod;
+        uint32_t m_materialId;
+    };
+
+    Handle create(Mesh* _owner, uint32_t _group, const BoundBox& _localBounds, const LodInfo& _lods, uint32_t _materialId, uint8_t _flags);
+    void destroy(Handle _handle);
+    [[nodiscard]] bool isAlive(Handle _handle) const;
+
+    // The world bounds are computed here, once per move. The scale is uniform, it scales the radius of the bounding sphere.
+    void setTransform(Handle _handle, const float4x4& _world, float _scale);
+
+    // Instances with one of _flags touching the frustum, as increasing indices in the arrays. Both methods give the same list.
+    void cull(const ViewFrustum& _frustum, uint8_t _flags, eastl::vector<uint32_t>& _visible, ECullMethod _method = ECullMethod::Linear,
+              FrustumCulling::EKernel _kernel = FrustumCulling::getBestKernel()) const;
+
+    // The instance whose world bounds the ray enters first, false if none. _distance is in units of _direction.
+    bool raycast(const float3& _origin, const float3& _direction, uint32_t& _instance, float& _distance) const;
+    // Instances whose world bounds overlap, in no particular order
+    void queryBox(const BoundBox& _box, eastl::vector<uint32_t>& _instances) const;
+    void querySphere(const float3& _center, float _radius, eastl::vector<uint32_t>& _instances) const;
+
+    // Coarsest LOD of each visible instance whose error projects under _maxPixelError, see Mesh::selectLod.
+    // _projectionScale is proj[1][1] * viewport height / 2.
+    void selectLods(const eastl::vector<uint32_t>& _visible, const float3& _cameraPosition, float _projectionScale, float _maxPixelError,
+                    eastl::vector<uint8_t>& _lods) const;
+
+    // Visible instances sorted by material then instance, _lods can be empty for the full detail everywhere
+    void buildDrawList(const eastl::vector<uint32_t>& _visible, const eastl::vector<uint8_t>& _lods, eastl::vector<DrawItem>& _drawList) const;
+
+    [[nodiscard]] uint32_t getCount() const { return static_cast<uint32_t>(m_flags.size()); }
+    [[nodiscard]] Mesh* getOwner(uint32_t _instance) const { return m_owners[_instance]; }
+    [[nodiscard]] uint32_t getGroup(uint32_t _instance) const { return m_groups[_instance]; }
+    [[nodiscard]] const float4x4& getWorldMatrix(uint32_t _instance) const { return m_worldMatrices[_instance]; }
+    [[nodiscard]] BoundBox getWorldBounds(uint32_t _instance) const;
+    [[nodiscard]] const SceneBvh& getHierarchy() const { return m_bvh; }
+
+private:
+    // hot, read every frame. The world bounds are split per coordinate for the culling kernels
+    eastl::vector<float> m_worldMinX;
+    eastl::vector<float> m_worldMinY;
+    eastl::vector<float> m_worldMinZ;
+    eastl::vector<float> m_worldMaxX;
+    eastl::vector<float> m_worldMaxY;
+    eastl::vector<float> m_worldMaxZ;
+    eastl::vector<float4> m_spheres; // world center and radius
+    eastl::vector<LodInfo> m_lods;
+    eastl::vector<uint32_t> m_materialIds;
+    eastl::vector<uint8_t> m_flags;
+
+    // read when drawn or moved
+    eastl::vector<float4x4> m_worldMatrices;
+    eastl::vector<BoundBox> m_localBounds;
+    eastl::vector<Mesh*> m_owners;
+    eastl::vector<uint32_t> m_groups;
+    eastl::vector<uint32_t> m_handles; // index in the indirection of each instance, to fix it up when the last one moves
+
+    // indirection from the handles to the arrays
+    eastl::vector<uint32_t> m_instances;
+    eastl::vector<uint32_t> m_generations;
+    eastl::vector<uint32_t> m_freeHandles;
+
+    SceneBvh m_bvh;
+
+    // the BVH gives the index of the handles, they become indices in the arrays
+    void toInstances(eastl::vector<uint32_t>& _ids) const;
+    void setWorldBounds(uint32_t _instance, const BoundBox& _bounds);
+};
+
+#endif //GRAPHICSPLAYGROUND_SCENESTORE_HPP
@@ -0,0 +1,250 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#include "StreamingManager.hpp"
+
+#include <chrono>
+#include <filesystem>
+
+#include <EASTL/sort.h>
+
+#include "Mesh.h"
+#include "SceneArchive.hpp"
+#include "tracy/Tracy.hpp"
+
+namespace
+{
+    // a decoded mesh weighs a few times its zstd + meshopt compressed file
+    constexpr size_t COOKED_EXPANSION = 4;
+}
+
+StreamingManager::StreamingManager(RefCntAutoPtr<IRenderDevice> _device) : m_device(eastl::move(_device))
+{
+}
+
+StreamingManager::~StreamingManager()
+{
+    JobSystem::get().wait(m_counter);
+
+    Loaded loaded;
+    while (m_loaded.pop(loaded))
+    {
+        delete loaded.m_mesh;
+    }
+
+    for (Uploading& uploading : m_uploading)
+    {
+        delete uploading.m_loaded.m_mesh;
+    }
+}
+
+StreamingManager::Handle StreamingManager::request(Request _request)
+{
+    Pending pending;
+    pending.m_handle = m_nextHandle++;
+    pending.m_estimatedSize = estimateSize(_request.m_path);
+    pending.m_request = eastl::move(_request);
+    m_pending.push_back(eastl::move(pending));
+    return m_pending.back().m_handle;
+}
+
+void StreamingManager::cancel(Handle _handle)
+{
+    auto it = eastl::find_if(m_pending.begin(), m_pending.end(), [_handle](const Pending& _pending) { return _pending.m_handle == _handle; });
+    if (it != m_pending.end())
+    {
+        m_pending.erase(it);
+        m_stats.m_cancelledCount++;
+        return;
+    }
+
+    auto uploading = eastl::find_if(m_uploading.begin(), m_uploading.end(), [_handle](const Uploading& _uploading) { return _uploading.m_loaded.m_handle == _handle; });
+    if (uploading != m_uploading.end())
+    {
+        const auto& groups = uploading->m_loaded.m_mesh->getGroups();
+        for (uint32_t i = uploading->m_nextGroup; i < groups.size(); ++i)
+        {
+            m_residentBytes -= eastl::min(m_residentBytes, Mesh::getPendingUploadSize(groups[i]));
+        }
+        delete uploading->m_loaded.m_mesh;
+        m_uploading.erase(uploading);
+        m_stats.m_cancelledCount++;
+        return;
+    }
+
+    // still on a worker, dropped when it arrives
+    if (_handle < m_nextHandle)
+    {
+        m_cancelled.insert(_handle);
+    }
+}
+
+void StreamingManager::update(const float3& _cameraPosition, const ViewFrustum& _frustum)
+{
+    ZoneScopedN("Streaming");
+
+    receiveLoaded();
+    uploadGroups();
+    startLoads(_cameraPosition, _frustum);
+
+    m_stats.m_pendingCount = static_cast<uint32_t>(m_pending.size());
+    m_stats.m_loadingCount = m_loadingCount;
+    m_stats.m_uploadingCount = static_cast<uint32_t>(m_uploading.size());
+    m_stats.m_residentBytes = m_residentBytes;
+}
+
+size_t StreamingManager::estimateSize(const eastl::string& _path)
+{
+    std::error_code error;
+    std::filesystem::path cooked = _path.c_str();
+    cooked.replace_extension(".mesh");
+
+    // the table of contents of the archive already knows, no need to touch the file system
+    const size_t packedSize = SceneArchive::getMounted().getEntrySize(cooked.generic_string().c_str());
+    if (packedSize > 0)
+        return packedSize * COOKED_EXPANSION;
+
+    const uintmax_t cookedSize = std::filesystem::file_size(cooked, error);
+    if (!error)
+        return static_cast<size_t>(cookedSize) * COOKED_EXPANSION;
+
+    // not cooked, the import is much bigger than the source but it is only a starting point, corrected once decoded
+    const uintmax_t sourceSize = std::filesystem::file_size(_path.c_str(), error);
+    return error ? 0 : static_cast<size_t>(sourceSize) * COOKED_EXPANSION;
+}
+
+void StreamingManager::receiveLoaded()
+{
+    Loaded loaded;
+    while (m_loaded.pop(loaded))
+    {
+        m_loadingCount--;
+
+        // the reservation is replaced by what the mesh really weighs
+        m_residentBytes -= eastl::min(m_residentBytes, loaded.m_estimatedSize);
+
+        auto cancelled = m_cancelled.find(loaded.m_handle);
+        if (cancelled != m_cancelled.end())
+        {
+            m_cancelled.erase(cancelled);
+            delete loaded.m_mesh;
+            m_stats.m_cancelledCount++;
+            continue;
+        }
+
+        m_residentBytes += loaded.m_size;
+        m_uploading.push_back({eastl::move(loaded), 0});
+    }
+}
+
+void StreamingManager::uploadGroups()
+{
+    const auto start = std::chrono::steady_clock::now();
+    size_t uploadedBytes = 0;
+    uint32_t uploadedGroups = 0;
+
+    while (!m_uploading.empty())
+    {
+        Uploading& uploading = m_uploading.front();
+        auto& groups = uploading.m_loaded.m_mesh->getGroups();
+
+        if (uploading.m_nextGroup < groups.size())
+        {
+            Mesh::Group& group = groups[uploading.m_nextGroup];
+            const size_t size = Mesh::getPendingUploadSize(group);
+            if (uploadedGroups > 0 && uploadedBytes + size > m_uploadBudgetPerFrame)
+                break;
+
+            uploading.m_loaded.m_mesh->uploadGroup(group);
+            m_residentBytes -= eastl::min(m_residentBytes, size);
+            uploadedBytes += size;
+            uploadedGroups++;
+            uploading.m_nextGroup++;
+        }
+
+        if (uploading.m_nextGroup == groups.size())
+        {
+            Loaded loaded = eastl::move(uploading.m_loaded);
+            m_uploading.pop_front();
+            m_stats.m_readyCount++;
+
+            if (loaded.m_onReady)
+            {
+                loaded.m_onReady(loaded.m_mesh);
+            }
+        }
+    }
+
+    m_stats.m_uploadedBytesLastFrame = uploadedBytes;
+    m_stats.m_uploadedGroupsLastFrame = uploadedGroups;
+    m_stats.m_uploadTimeMsLastFrame = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void StreamingManager::startLoads(const float3& _cameraPosition, const ViewFrustum& _frustum)
+{
+    if (m_pending.empty())
+        return;
+
+    for (Pending& pending : m_pending)
+    {
+        const Request& request = pending.m_request;
+        BoundBox bounds;
+        bounds.Min = request.m_position - float3(request.m_radius);
+        bounds.Max = request.m_position + float3(request.m_radius);
+        pending.m_isVisible = GetBoxVisibility(_frustum, bounds) != BoxVisibility::Invisible;
+        pending.m_distance = eastl::max(0.0f, length(request.m_position - _cameraPosition) - request.m_radius);
+    }
+
+    // critical first, then visible, then the closest, at the back so they're popped first
+    eastl::sort(m_pending.begin(), m_pending.end(), [](const Pending& _a, const Pending& _b)
+    {
+        if (_a.m_request.m_isCritical != _b.m_request.m_isCritical)
+            return _b.m_request.m_isCritical;
+        if (_a.m_isVisible != _b.m_isVisible)
+            return _b.m_isVisible;
+        return _a.m_distance > _b.m_distance;
+    });
+
+    // jobs can't be reordered once submitted, so only as many as the workers take at once leave the queue
+    auto& jobSystem = JobSystem::get();
+    const uint32_t maxLoading = eastl::max(1u, jobSystem.getConcurrencyCap(JobSystem::ESubsystem::Mesh));
+
+    while (!m_pending.empty() && m_loadingCount < maxLoading)
+    {
+        Pending& next = m_pending.back();
+
+        // something always loads so a mesh bigger than the budget still ends up in the scene
+        const bool isEmpty = m_loadingCount == 0 && m_uploading.empty();
+        if (!isEmpty && m_residentBytes + next.m_estimatedSize > m_memoryBudget)
+            break;
+
+        m_residentBytes += next.m_estimatedSize;
+        m_loadingCount++;
+
+        const auto priority = next.m_request.m_isCritical ? JobSystem::EPriority::High : JobSystem::EPriority::Normal;
+        jobSystem.submit(JobSystem::ESubsystem::Mesh, priority, [this, handle = next.m_handle, estimatedSize = next.m_estimatedSize,
+                                                                 request = eastl::move(next.m_request)]()
+        {
+            auto* mesh = new Mesh(m_device, request.m_path.c_str(), request.m_needsAfterLoadedActions, request.m_position, request.m_scale,
+                                  float3(0.0f), true, request.m_isRayTraced);
+            if (request.m_onLoaded)
+            {
+                request.m_onLoaded(*mesh);
+            }
+
+            Loaded loaded;
+            loaded.m_handle = handle;
+            loaded.m_mesh = mesh;
+            loaded.m_estimatedSize = estimatedSize;
+            loaded.m_onReady = request.m_onReady;
+            for (const Mesh::Group& group : mesh->getGroups())
+            {
+                loaded.m_size += Mesh::getPendingUploadSize(group);
+            }
+            m_loaded.push(eastl::move(loaded));
+        }, &m_counter);
+
+        m_pending.pop_back();
+    }
+}
@@ -0,0 +1,129 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#ifndef GRAPHICSPLAYGROUND_STREAMINGMANAGER_HPP
+#define GRAPHICSPLAYGROUND_STREAMINGMANAGER_HPP
+
+#include <functional>
+
+#include <EASTL/deque.h>
+#include <EASTL/string.h>
+#include <EASTL/vector.h>
+#include <EASTL/vector_set.h>
+
+#include "Common/interface/AdvancedMath.hpp"
+#include "Common/interface/BasicMath.hpp"
+#include "Common/interface/RefCntAutoPtr.hpp"
+#include "RenderDevice.h"
+
+#include "JobSystem.hpp"
+#include "util/MpscQueue.hpp"
+
+using namespace Diligent;
+
+class Mesh;
+
+// Loads the meshes of the scene in the background, closest/visible first.
+// Meshes are decoded on the job system workers with a deferred upload, then handed to the render thread through a lock free queue
+// where their groups are uploaded under a byte budget per frame, so a big scene pops in progressively instead of hitching.
+// The CPU memory of the meshes being loaded or waiting for their upload is capped, new loads only start when there is room.
+class StreamingManager
+{
+public:
+    using Handle = uint32_t;
+
+    struct Request
+    {
+        eastl::string m_path;
+        float3 m_position = float3(0);
+        float m_scale = 1.0f;
+        float m_radius = 0.0f; // rough size around m_position, the bounds aren't known before the mesh is loaded
+        bool m_isCritical = false; // goes before the others whatever its distance
+        bool m_needsAfterLoadedActions = false;
+        bool m_isRayTraced = false; // the CPU data stays after the load for RayTracing::addMeshToRayTrace, called from m_onReady
+
+        std::function<void(Mesh&)> m_onLoaded; // on the worker that loaded it, before the upload (textures, flags...)
+        std::function<void(Mesh*)> m_onReady; // on the render thread once every group is uploaded, the mesh belongs to the callback
+    };
+
+    struct Stats
+    {
+        uint32_t m_pendingCount = 0; // not started yet
+        uint32_t m_loadingCount = 0; // on the workers
+        uint32_t m_uploadingCount = 0; // decoded, waiting for their groups to be uploaded
+        uint32_t m_readyCount = 0;
+        uint32_t m_cancelledCount = 0;
+        size_t m_residentBytes = 0; // CPU memory of the meshes in flight, estimated until they're decoded
+        size_t m_uploadedBytesLastFrame = 0;
+        uint32_t m_uploadedGroupsLastFrame = 0;
+        float m_uploadTimeMsLastFrame = 0.0f;
+    };
+
+    explicit StreamingManager(RefCntAutoPtr<IRenderDevice> _device);
+    ~StreamingManager();
+
+    StreamingManager(const StreamingManager&) = delete;
+    StreamingManager& operator=(const StreamingManager&) = delete;
+
+    // Render thread only, like update
+    Handle request(Request _request);
+
+    // A mesh already being loaded is thrown away when it arrives, one already handed to m_onReady is not affected
+    void cancel(Handle _handle);
+
+    // Once per frame on the render thread: uploads what arrived within the budget then starts the most important pending loads
+    void update(const float3& _cameraPosition, const ViewFrustum& _frustum);
+
+    [[nodiscard]] bool isIdle() const { return m_pending.empty() && m_loadingCount == 0 && m_uploading.empty(); }
+    [[nodiscard]] const Stats& getStats() const { return m_stats; }
+
+    size_t m_memoryBudget = 512ull << 20; // CPU bytes of the meshes in flight
+    size_t m_uploadBudgetPerFrame = 32ull << 20; // at least one group is uploaded per frame, whatever its size
+
+private:
+    struct Pending
+    {
+        Handle m_handle;
+        Request m_request;
+        size_t m_estimatedSize;
+        bool m_isVisible = false;
+        float m_distance = 0.0f;
+    };
+
+    struct Loaded
+    {
+        Handle m_handle = 0;
+        Mesh* m_mesh = nullptr;
+        size_t m_size = 0; // what the CPU copies waiting for the upload weigh
+        size_t m_estimatedSize = 0; // what was reserved when the load started
+        std::function<void(Mesh*)> m_onReady;
+    };
+
+    struct Uploading
+    {
+        Loaded m_loaded;
+        uint32_t m_nextGroup = 0;
+    };
+
+    RefCntAutoPtr<IRenderDevice> m_device;
+
+    Handle m_nextHandle = 1;
+    eastl::vector<Pending> m_pending; // sorted by update, the most important last
+    eastl::vector_set<Handle> m_cancelled; // already loading when cancelled
+    uint32_t m_loadingCount = 0;
+    MpscQueue<Loaded> m_loaded; // from the workers
+    eastl::deque<Uploading> m_uploading;
+
+    size_t m_residentBytes = 0;
+    JobSystem::Counter m_counter;
+    Stats m_stats;
+
+    static size_t estimateSize(const eastl::string& _path);
+
+    void receiveLoaded();
+    void uploadGroups();
+    void startLoads(const float3& _cameraPosition, const ViewFrustum& _frustum);
+};
+
+#endif //GRAPHICSPLAYGROUND_STREAMINGMANAGER_HPP
@@ -0,0 +1,198 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#include "TextureCache.hpp"
+
+#include <cstring>
+#include <iostream>
+
+#include <stb/stb_image.h>
+
+#include "tracy/Tracy.hpp"
+#include "util/MappedFile.hpp"
+#include "util/meow_hash_x64_aesni.h"
+
+TextureCache::Entry::~Entry()
+{
+    if(m_pixels)
+        stbi_image_free(m_pixels);
+}
+
+TextureCache& TextureCache::get()
+{
+    static TextureCache cache;
+    return cache;
+}
+
+TextureCache::Handle TextureCache::loadFromFile(IRenderDevice* _device, const char* _path, const char* _name, TEXTURE_FORMAT _format,
+                                                TextureMips::EFilter _mipFilter)
+{
+    ZoneScopedN("Texture Cache - Load From File");
+    ZoneText(_path, strlen(_path));
+
+    // the same bytes are used for the key and the decoding, the file is only read once
+    MappedFile file(_path);
+    if(!file.isOpen())
+    {
+        std::cout << "Could not open texture " << _path << std::endl;
+        return nullptr;
+    }
+
+    bool isOwner;
+    Handle entry = acquire(makeKey(file.data(), file.size(), _format), isOwner);
+    if(!isOwner)
+    {
+        std::cout << "Found the texture... loading " << _name << " Tex" << std::endl;
+
+        std::scoped_lock lock(m_mutex);
+        if(entry->m_pixelUsers++ == 0 && !entry->m_pixels)
+        {
+            // released by its previous users, this one may cook it
+            int width, height, channels;
+            entry->m_pixels = stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &width, &height, &channels, 4);
+        }
+        return entry;
+    }
+
+    int width, height, channels;
+    entry->m_pixels = stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &width, &height, &channels, 4);
+    entry->m_pixelUsers = 1;
+    entry->m_format = _format;
+    entry->m_name = _name;
+    entry->m_path = _path;
+
+    if(entry->m_pixels && !_device)
+    {
+        entry->m_width = width;
+        entry->m_height = height;
+    }
+    else if(entry->m_pixels)
+    {
+        entry->m_width = width;
+        entry->m_height = height;
+
+        eastl::vector<uint8_t> mipChain;
+        const eastl::vector<TextureMips::Level> levels = TextureMips::generate(_mipFilter, entry->m_pixels, width, height, mipChain);
+
+        TextureDesc desc;
+        desc.Name = _name;
+        desc.Width = width;
+        desc.Height = height;
+        desc.MipLevels = static_cast<Uint32>(levels.size());
+        desc.Type = Diligent::RESOURCE_DIM_TEX_2D;
+        desc.BindFlags = Diligent::BIND_SHADER_RESOURCE;
+        desc.Format = _format;
+
+        eastl::vector<TextureSubResData> subResources(levels.size());
+        for(size_t level = 0; level < levels.size(); ++level)
+        {
+            subResources[level].pData = levels[level].m_pixels;
+            subResources[level].Stride = sizeof(unsigned char) * 4 * levels[level].m_width;
+        }
+
+        TextureData textureData;
+        textureData.NumSubresources = static_cast<Uint32>(subResources.size());
+        textureData.pSubResources = subResources.data();
+
+        _device->CreateTexture(desc, &textureData, &entry->m_texture);
+        std::cout << "Creating " << _name << " Tex" << std::endl;
+    }
+    else
+    {
+        std::cout << "Could not decode texture " << _path << ": " << stbi_failure_reason() << std::endl;
+    }
+
+    publish(*entry);
+    return entry;
+}
+
+void TextureCache::releasePixels(Entry& _entry)
+{
+    std::scoped_lock lock(m_mutex);
+    if(_entry.m_pixelUsers == 0 || --_entry.m_pixelUsers > 0 || !_entry.m_pixels)
+        return;
+
+    stbi_image_free(_entry.m_pixels);
+    _entry.m_pixels = nullptr;
+}
+
+TextureCache::Handle TextureCache::loadFromMemory(IRenderDevice* _device, const TextureDesc& _desc, const TextureData& _data,
+                                                  const void* _contents, size_t _contentsSize)
+{
+    ZoneScopedN("Texture Cache - Load From Memory");
+
+    bool isOwner;
+    Handle entry = acquire(makeKey(_contents, _contentsSize, _desc.Format), isOwner);
+    if(!isOwner)
+        return entry;
+
+    entry->m_width = _desc.Width;
+    entry->m_height = _desc.Height;
+    entry->m_format = _desc.Format;
+    entry->m_name = _desc.Name ? _desc.Name : "";
+    _device->CreateTexture(_desc, &_data, &entry->m_texture);
+
+    publish(*entry);
+    return entry;
+}
+
+size_t TextureCache::getLiveCount()
+{
+    std::scoped_lock lock(m_mutex);
+
+    size_t count = 0;
+    for(const auto& keyAndEntry : m_entries)
+    {
+        if(!keyAndEntry.second.expired())
+            ++count;
+    }
+
+    return count;
+}
+
+TextureCache::Key TextureCache::makeKey(const void* _contents, size_t _size, TEXTURE_FORMAT _format)
+{
+    ZoneScopedN("Texture Cache - Hash");
+    const meow_u128 hash = MeowHash(MeowDefaultSeed, _size, const_cast<void*>(_contents));
+
+    Key key;
+    key.m_hash[0] = MeowU64From(hash, 0);
+    key.m_hash[1] = MeowU64From(hash, 1);
+    key.m_format = _format;
+    return key;
+}
+
+TextureCache::Handle TextureCache::acquire(const Key& _key, bool& _isOwner)
+{
+    std::unique_lock lock(m_mutex);
+
+    auto it = m_entries.find(_key);
+    if(it != m_entries.end())
+    {
+        if(Handle entry = it->second.lock())
+        {
+            m_hits++;
+            _isOwner = false;
+            // somebody else is decoding it right now, wait for it instead of doing the work twice
+            m_readyCondition.wait(lock, [&entry]() { return entry->m_isReady; });
+            return entry;
+        }
+    }
+
+    m_misses++;
+    _isOwner = true;
+    Handle entry = eastl::make_shared<Entry>();
+    m_entries[_key] = entry; // also replaces an expired entry
+    return entry;
+}
+
+void TextureCache::publish(Entry& _entry)
+{
+    {
+        std::scoped_lock lock(m_mutex);
+        _entry.m_isReady = true;
+    }
+
+    m_readyCondition.notify_all();
+}
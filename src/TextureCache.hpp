@@ -0,0 +1,108 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#ifndef GRAPHICSPLAYGROUND_TEXTURECACHE_HPP
+#define GRAPHICSPLAYGROUND_TEXTURECACHE_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+#include <EASTL/hash_map.h>
+#include <EASTL/string.h>
+#include <EASTL/shared_ptr.h>
+#include <EASTL/weak_ptr.h>
+
+#include "RenderDevice.h"
+#include "Common/interface/RefCntAutoPtr.hpp"
+#include "TextureMips.hpp"
+
+using namespace Diligent;
+
+// Process wide texture cache, shared by every mesh.
+// Textures are keyed by the hash of their content + their format, so the same image referenced by different paths
+// (or by different cooked meshes) is only decoded and uploaded once.
+// Entries live as long as someone holds their handle.
+class TextureCache
+{
+public:
+    struct Entry
+    {
+        ~Entry();
+
+        RefCntAutoPtr<ITexture> m_texture; // null when loaded without a device
+
+        // RGBA8 pixels of the top level, only for textures decoded from an image file as they are needed to cook the mesh.
+        // Every loadFromFile holds them until releasePixels, they're decoded again if needed after being freed.
+        unsigned char* m_pixels = nullptr;
+        uint32_t m_width = 0;
+        uint32_t m_height = 0;
+        TEXTURE_FORMAT m_format = TEX_FORMAT_UNKNOWN;
+        eastl::string m_name;
+        eastl::string m_path; // only for textures decoded from an image file
+
+        [[nodiscard]] bool isValid() const { return m_texture != nullptr || m_pixels != nullptr; }
+
+    private:
+        friend class TextureCache;
+        bool m_isReady = false; // guarded by the cache mutex
+        uint32_t m_pixelUsers = 0; // guarded by the cache mutex
+    };
+
+    using Handle = eastl::shared_ptr<Entry>;
+
+    static TextureCache& get();
+
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    // Decodes the image file into a RGBA8 texture, its mips are generated with _mipFilter.
+    // Without a device only the pixels are decoded, enough to cook.
+    Handle loadFromFile(IRenderDevice* _device, const char* _path, const char* _name, TEXTURE_FORMAT _format, TextureMips::EFilter _mipFilter);
+
+    // Gives back the pixels held by a loadFromFile, they're freed when nobody needs them anymore
+    void releasePixels(Entry& _entry);
+
+    // Creates the texture from already decoded data, _contents are the bytes identifying it (usually what the subresources point into)
+    Handle loadFromMemory(IRenderDevice* _device, const TextureDesc& _desc, const TextureData& _data, const void* _contents, size_t _contentsSize);
+
+    [[nodiscard]] uint32_t getHitCount() const { return m_hits; }
+    [[nodiscard]] uint32_t getMissCount() const { return m_misses; }
+    [[nodiscard]] size_t getLiveCount();
+
+private:
+    TextureCache() = default;
+
+    struct Key
+    {
+        uint64_t m_hash[2];
+        TEXTURE_FORMAT m_format;
+
+        bool operator==(const Key& _other) const
+        {
+            return m_hash[0] == _other.m_hash[0] && m_hash[1] == _other.m_hash[1] && m_format == _other.m_format;
+        }
+    };
+
+    struct KeyHasher
+    {
+        size_t operator()(const Key& _key) const { return static_cast<size_t>(_key.m_hash[0] ^ _key.m_format); }
+    };
+
+    static Key makeKey(const void* _contents, size_t _size, TEXTURE_FORMAT _format);
+
+    // Returns the entry for this key, _isOwner is true when the caller has to fill it and then call publish.
+    // If another thread is already filling it, waits until it's done.
+    Handle acquire(const Key& _key, bool& _isOwner);
+    void publish(Entry& _entry);
+
+    std::mutex m_mutex;
+    std::condition_variable m_readyCondition;
+    eastl::hash_map<Key, eastl::weak_ptr<Entry>, KeyHasher> m_entries;
+
+    std::atomic<uint32_t> m_hits = 0;
+    std::atomic<uint32_t> m_misses = 0;
+};
+
+#endif //GRAPHICSPLAYGROUND_TEXTURECACHE_HPP
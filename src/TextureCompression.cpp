@@ -0,0 +1,866 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#include "TextureCompression.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#include <emmintrin.h>
+
+#include "JobSystem.hpp"
+#include "tracy/Tracy.hpp"
+
+namespace TextureCompression
+{
+namespace
+{
+    constexpr uint32_t BLOCK_DIM = 4;
+    constexpr uint32_t BLOCK_PIXELS = BLOCK_DIM * BLOCK_DIM;
+
+    // BC7 4 bits indices interpolation weights, out of 64
+    constexpr uint32_t BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    // A 4x4 block with one array per channel, this way 4 pixels fit in a register
+    struct Block
+    {
+        alignas(16) float m_channels[4][BLOCK_PIXELS];
+    };
+
+    float horizontalSum(__m128 _v)
+    {
+        __m128 shuffled = _mm_shuffle_ps(_v, _v, _MM_SHUFFLE(2, 3, 0, 1));
+        __m128 sums = _mm_add_ps(_v, shuffled);
+        shuffled = _mm_movehl_ps(shuffled, sums);
+        sums = _mm_add_ss(sums, shuffled);
+        return _mm_cvtss_f32(sums);
+    }
+
+    float horizontalMin(__m128 _v)
+    {
+        _v = _mm_min_ps(_v, _mm_shuffle_ps(_v, _v, _MM_SHUFFLE(2, 3, 0, 1)));
+        _v = _mm_min_ps(_v, _mm_shuffle_ps(_v, _v, _MM_SHUFFLE(1, 0, 3, 2)));
+        return _mm_cvtss_f32(_v);
+    }
+
+    float horizontalMax(__m128 _v)
+    {
+        _v = _mm_max_ps(_v, _mm_shuffle_ps(_v, _v, _MM_SHUFFLE(2, 3, 0, 1)));
+        _v = _mm_max_ps(_v, _mm_shuffle_ps(_v, _v, _MM_SHUFFLE(1, 0, 3, 2)));
+        return _mm_cvtss_f32(_v);
+    }
+
+    void loadBlock(const uint8_t* _rgba, uint32_t _width, uint32_t _height, uint32_t _blockX, uint32_t _blockY, Block& _block)
+    {
+        const uint32_t startX = _blockX * BLOCK_DIM;
+        const uint32_t startY = _blockY * BLOCK_DIM;
+
+        if (startX + BLOCK_DIM <= _width && startY + BLOCK_DIM <= _height)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            for (uint32_t y = 0; y < BLOCK_DIM; ++y)
+            {
+                // a row of the block is 4 RGBA8 pixels, widened to floats then transposed to one register per channel
+                const __m128i row = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_rgba + (static_cast<size_t>(startY + y) * _width + startX) * 4));
+                const __m128i low = _mm_unpacklo_epi8(row, zero);
+                const __m128i high = _mm_unpackhi_epi8(row, zero);
+                __m128 r = _mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero));
+                __m128 g = _mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero));
+                __m128 b = _mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero));
+                __m128 a = _mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero));
+                _MM_TRANSPOSE4_PS(r, g, b, a);
+
+                _mm_store_ps(&_block.m_channels[0][y * BLOCK_DIM], r);
+                _mm_store_ps(&_block.m_channels[1][y * BLOCK_DIM], g);
+                _mm_store_ps(&_block.m_channels[2][y * BLOCK_DIM], b);
+                _mm_store_ps(&_block.m_channels[3][y * BLOCK_DIM], a);
+            }
+            return;
+        }
+
+        // partial block on the border, the last row/column is repeated
+        for (uint32_t y = 0; y < BLOCK_DIM; ++y)
+        {
+            const uint32_t py = std::min(startY + y, _height - 1);
+            for (uint32_t x = 0; x < BLOCK_DIM; ++x)
+            {
+                const uint32_t px = std::min(startX + x, _width - 1);
+                const uint8_t* pixel = _rgba + (static_cast<size_t>(py) * _width + px) * 4;
+                for (uint32_t c = 0; c < 4; ++c)
+                {
+                    _block.m_channels[c][y * BLOCK_DIM + x] = pixel[c];
+                }
+            }
+        }
+    }
+
+    // Mean and principal axis of the first _channelCount channels
+    void computePrincipalAxis(const Block& _block, uint32_t _channelCount, float* _mean, float* _axis)
+    {
+        __m128 centered[4][BLOCK_PIXELS / 4];
+        for (uint32_t c = 0; c < _channelCount; ++c)
+        {
+            __m128 sum = _mm_setzero_ps();
+            for (uint32_t i = 0; i < BLOCK_PIXELS; i += 4)
+            {
+                sum = _mm_add_ps(sum, _mm_load_ps(&_block.m_channels[c][i]));
+            }
+            _mean[c] = horizontalSum(sum) / BLOCK_PIXELS;
+
+            const __m128 mean = _mm_set1_ps(_mean[c]);
+            for (uint32_t i = 0; i < BLOCK_PIXELS; i += 4)
+            {
+                centered[c][i / 4] = _mm_sub_ps(_mm_load_ps(&_block.m_channels[c][i]), mean);
+            }
+        }
+
+        float covariance[4][4] = {};
+        for (uint32_t i = 0; i < _channelCount; ++i)
+        {
+            for (uint32_t j = i; j < _channelCount; ++j)
+            {
+                __m128 sum = _mm_setzero_ps();
+                for (uint32_t k = 0; k < BLOCK_PIXELS / 4; ++k)
+                {
+                    sum = _mm_add_ps(sum, _mm_mul_ps(centered[i][k], centered[j][k]));
+                }
+                covariance[i][j] = covariance[j][i] = horizontalSum(sum);
+            }
+        }
+
+        // power iteration, converges fast enough for 16 points
+        float axis[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+        for (uint32_t iteration = 0; iteration < 8; ++iteration)
+        {
+            float next[4] = {};
+            float lengthSq = 0.0f;
+            for (uint32_t i = 0; i < _channelCount; ++i)
+            {
+                for (uint32_t j = 0; j < _channelCount; ++j)
+                {
+                    next[i] += covariance[i][j] * axis[j];
+                }
+                lengthSq += next[i] * next[i];
+            }
+
+            if (lengthSq < 1e-12f)
+                break; // flat block, any axis works
+
+            const float invLength = 1.0f / std::sqrt(lengthSq);
+            for (uint32_t i = 0; i < _channelCount; ++i)
+            {
+                axis[i] = next[i] * invLength;
+            }
+        }
+
+        memcpy(_axis, axis, sizeof(float) * _channelCount);
+    }
+
+    // Endpoints at the extremes of the block projected on its principal axis
+    void computeEndpoints(const Block& _block, uint32_t _channelCount, float* _e0, float* _e1)
+    {
+        float mean[4], axis[4];
+        computePrincipalAxis(_block, _channelCount, mean, axis);
+
+        __m128 tMin = _mm_set1_ps(FLT_MAX);
+        __m128 tMax = _mm_set1_ps(-FLT_MAX);
+        for (uint32_t i = 0; i < BLOCK_PIXELS; i += 4)
+        {
+            __m128 t = _mm_setzero_ps();
+            for (uint32_t c = 0; c < _channelCount; ++c)
+            {
+                const __m128 centered = _mm_sub_ps(_mm_load_ps(&_block.m_channels[c][i]), _mm_set1_ps(mean[c]));
+                t = _mm_add_ps(t, _mm_mul_ps(centered, _mm_set1_ps(axis[c])));
+            }
+            tMin = _mm_min_ps(tMin, t);
+            tMax = _mm_max_ps(tMax, t);
+        }
+
+        const float minT = horizontalMin(tMin);
+        const float maxT = horizontalMax(tMax);
+        for (uint32_t c = 0; c < _channelCount; ++c)
+        {
+            _e0[c] = std::clamp(mean[c] + axis[c] * maxT, 0.0f, 255.0f);
+            _e1[c] = std::clamp(mean[c] + axis[c] * minT, 0.0f, 255.0f);
+        }
+    }
+
+    // Position of every pixel on the segment, clamped to [0, 1]
+    void projectOnSegment(const Block& _block, uint32_t _channelCount, const float* _e0, const float* _e1, float* _t)
+    {
+        float direction[4];
+        float lengthSq = 0.0f;
+        for (uint32_t c = 0; c < _channelCount; ++c)
+        {
+            direction[c] = _e1[c] - _e0[c];
+            lengthSq += direction[c] * direction[c];
+        }
+
+        if (lengthSq < 1e-6f)
+        {
+            std::fill(_t, _t + BLOCK_PIXELS, 0.0f);
+            return;
+        }
+
+        const __m128 invLengthSq = _mm_set1_ps(1.0f / lengthSq);
+        for (uint32_t i = 0; i < BLOCK_PIXELS; i += 4)
+        {
+            __m128 dot = _mm_setzero_ps();
+            for (uint32_t c = 0; c < _channelCount; ++c)
+            {
+                const __m128 offset = _mm_sub_ps(_mm_load_ps(&_block.m_channels[c][i]), _mm_set1_ps(_e0[c]));
+                dot = _mm_add_ps(dot, _mm_mul_ps(offset, _mm_set1_ps(direction[c])));
+            }
+            const __m128 t = _mm_min_ps(_mm_max_ps(_mm_mul_ps(dot, invLengthSq), _mm_setzero_ps()), _mm_set1_ps(1.0f));
+            _mm_storeu_ps(_t + i, t);
+        }
+    }
+
+    // Squared error of the block against e0 + (e1 - e0) * weight
+    float computeError(const Block& _block, uint32_t _channelCount, const float* _e0, const float* _e1, const float* _weights)
+    {
+        __m128 error = _mm_setzero_ps();
+        for (uint32_t i = 0; i < BLOCK_PIXELS; i += 4)
+        {
+            const __m128 weights = _mm_loadu_ps(_weights + i);
+            for (uint32_t c = 0; c < _channelCount; ++c)
+            {
+                const __m128 reconstructed = _mm_add_ps(_mm_set1_ps(_e0[c]), _mm_mul_ps(_mm_set1_ps(_e1[c] - _e0[c]), weights));
+                const __m128 difference = _mm_sub_ps(_mm_load_ps(&_block.m_channels[c][i]), reconstructed);
+                error = _mm_add_ps(error, _mm_mul_ps(difference, difference));
+            }
+        }
+
+        return horizontalSum(error);
+    }
+
+    // Least squares endpoints for the given per pixel weights, false if the system is degenerate
+    bool refineEndpoints(const Block& _block, uint32_t _channelCount, const float* _weights, float* _e0, float* _e1)
+    {
+        __m128 aa = _mm_setzero_ps(), ab = _mm_setzero_ps(), bb = _mm_setzero_ps();
+        __m128 ax[4], bx[4];
+        for (uint32_t c = 0; c < _channelCount; ++c)
+        {
+            ax[c] = bx[c] = _mm_setzero_ps();
+        }
+
+        for (uint32_t i = 0; i < BLOCK_PIXELS; i += 4)
+        {
+            const __m128 b = _mm_loadu_ps(_weights + i);
+            const __m128 a = _mm_sub_ps(_mm_set1_ps(1.0f), b);
+            aa = _mm_add_ps(aa, _mm_mul_ps(a, a));
+            ab = _mm_add_ps(ab, _mm_mul_ps(a, b));
+            bb = _mm_add_ps(bb, _mm_mul_ps(b, b));
+            for (uint32_t c = 0; c < _channelCount; ++c)
+            {
+                const __m128 value = _mm_load_ps(&_block.m_channels[c][i]);
+                ax[c] = _mm_add_ps(ax[c], _mm_mul_ps(a, value));
+                bx[c] = _mm_add_ps(bx[c], _mm_mul_ps(b, value));
+            }
+        }
+
+        const float sumAA = horizontalSum(aa), sumAB = horizontalSum(ab), sumBB = horizontalSum(bb);
+        const float determinant = sumAA * sumBB - sumAB * sumAB;
+        if (std::abs(determinant) < 1e-6f)
+            return false;
+
+        const float invDeterminant = 1.0f / determinant;
+        for (uint32_t c = 0; c < _channelCount; ++c)
+        {
+            const float sumAX = horizontalSum(ax[c]), sumBX = horizontalSum(bx[c]);
+            _e0[c] = std::clamp((sumBB * sumAX - sumAB * sumBX) * invDeterminant, 0.0f, 255.0f);
+            _e1[c] = std::clamp((sumAA * sumBX - sumAB * sumAX) * invDeterminant, 0.0f, 255.0f);
+        }
+
+        return true;
+    }
+
+    uint16_t packRGB565(const float* _color)
+    {
+        const uint32_t r = static_cast<uint32_t>(_color[0] * (31.0f / 255.0f) + 0.5f);
+        const uint32_t g = static_cast<uint32_t>(_color[1] * (63.0f / 255.0f) + 0.5f);
+        const uint32_t b = static_cast<uint32_t>(_color[2] * (31.0f / 255.0f) + 0.5f);
+        return static_cast<uint16_t>(r << 11 | g << 5 | b);
+    }
+
+    void unpackRGB565(uint16_t _color, uint8_t* _rgb)
+    {
+        const uint32_t r = (_color >> 11) & 31;
+        const uint32_t g = (_color >> 5) & 63;
+        const uint32_t b = _color & 31;
+        _rgb[0] = static_cast<uint8_t>(r << 3 | r >> 2);
+        _rgb[1] = static_cast<uint8_t>(g << 2 | g >> 4);
+        _rgb[2] = static_cast<uint8_t>(b << 3 | b >> 2);
+    }
+
+    struct BC1Block
+    {
+        uint16_t m_color0;
+        uint16_t m_color1;
+        uint32_t m_indices;
+    };
+
+    // Quantizes the endpoints and snaps the pixels on the 4 colors palette, returns the squared error
+    float fitBC1(const Block& _block, const float* _e0, const float* _e1, BC1Block& _out, float* _weights)
+    {
+        _out.m_color0 = packRGB565(_e0);
+        _out.m_color1 = packRGB565(_e1);
+        // 4 colors mode needs color0 > color1
+        if (_out.m_color0 < _out.m_color1)
+            std::swap(_out.m_color0, _out.m_color1);
+
+        uint8_t rgb0[3], rgb1[3];
+        unpackRGB565(_out.m_color0, rgb0);
+        unpackRGB565(_out.m_color1, rgb1);
+        const float q0[3] = {static_cast<float>(rgb0[0]), static_cast<float>(rgb0[1]), static_cast<float>(rgb0[2])};
+        const float q1[3] = {static_cast<float>(rgb1[0]), static_cast<float>(rgb1[1]), static_cast<float>(rgb1[2])};
+
+        _out.m_indices = 0;
+        if (_out.m_color0 == _out.m_color1)
+        {
+            std::fill(_weights, _weights + BLOCK_PIXELS, 0.0f);
+            return computeError(_block, 3, q0, q1, _weights);
+        }
+
+        alignas(16) float t[BLOCK_PIXELS];
+        projectOnSegment(_block, 3, q0, q1, t);
+
+        // palette order is color0, color1, 2/3 color0 + 1/3 color1, 1/3 color0 + 2/3 color1
+        static constexpr uint32_t LEVEL_TO_INDEX[4] = {0, 2, 3, 1};
+        alignas(16) int32_t levels[BLOCK_PIXELS];
+        for (uint32_t i = 0; i < BLOCK_PIXELS; i += 4)
+        {
+            const __m128i level = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(t + i), _mm_set1_ps(3.0f)));
+            _mm_store_si128(reinterpret_cast<__m128i*>(levels + i), level);
+            _mm_storeu_ps(_weights + i, _mm_mul_ps(_mm_cvtepi32_ps(level), _mm_set1_ps(1.0f / 3.0f)));
+        }
+
+        for (uint32_t i = 0; i < BLOCK_PIXELS; ++i)
+        {
+            _out.m_indices |= LEVEL_TO_INDEX[levels[i]] << (i * 2);
+        }
+
+        return computeError(_block, 3, q0, q1, _weights);
+    }
+
+    void encodeBC1(const Block& _block, uint8_t* _out)
+    {
+        float e0[3], e1[3];
+        computeEndpoints(_block, 3, e0, e1);
+
+        BC1Block best;
+        alignas(16) float weights[BLOCK_PIXELS];
+        float bestError = fitBC1(_block, e0, e1, best, weights);
+
+        if (bestError > 0.0f && refineEndpoints(_block, 3, weights, e0, e1))
+        {
+            BC1Block refined;
+            if (fitBC1(_block, e0, e1, refined, weights) < bestError)
+                best = refined;
+        }
+
+        memcpy(_out, &best.m_color0, sizeof(uint16_t));
+        memcpy(_out + 2, &best.m_color1, sizeof(uint16_t));
+        memcpy(_out + 4, &best.m_indices, sizeof(uint32_t));
+    }
+
+    void encodeBC4(const float* _values, uint8_t* _out)
+    {
+        __m128 minValues = _mm_load_ps(_values);
+        __m128 maxValues = minValues;
+        for (uint32_t i = 4; i < BLOCK_PIXELS; i += 4)
+        {
+            const __m128 values = _mm_load_ps(_values + i);
+            minValues = _mm_min_ps(minValues, values);
+            maxValues = _mm_max_ps(maxValues, values);
+        }
+
+        const uint8_t minValue = static_cast<uint8_t>(horizontalMin(minValues));
+        const uint8_t maxValue = static_cast<uint8_t>(horizontalMax(maxValues));
+
+        // 8 values mode, max first
+        _out[0] = maxValue;
+        _out[1] = minValue;
+        memset(_out + 2, 0, 6);
+        if (maxValue == minValue)
+            return;
+
+        alignas(16) int32_t levels[BLOCK_PIXELS];
+        const __m128 scale = _mm_set1_ps(7.0f / static_cast<float>(maxValue - minValue));
+        for (uint32_t i = 0; i < BLOCK_PIXELS; i += 4)
+        {
+            const __m128 offset = _mm_sub_ps(_mm_load_ps(_values + i), _mm_set1_ps(minValue));
+            _mm_store_si128(reinterpret_cast<__m128i*>(levels + i), _mm_cvtps_epi32(_mm_mul_ps(offset, scale)));
+        }
+
+        // level 7 is max (index 0), level 0 is min (index 1), the 6 others are interpolated from max to min
+        uint64_t indices = 0;
+        for (uint32_t i = 0; i < BLOCK_PIXELS; ++i)
+        {
+            const int32_t level = levels[i];
+            const uint64_t index = level == 7 ? 0 : level == 0 ? 1 : 8 - level;
+            indices |= index << (i * 3);
+        }
+
+        for (uint32_t i = 0; i < 6; ++i)
+        {
+            _out[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+        }
+    }
+
+    struct BC7Block
+    {
+        uint8_t m_endpoints[2][4]; // 7 bits
+        uint8_t m_pBits[2];
+        uint8_t m_indices[BLOCK_PIXELS];
+    };
+
+    // 7 bits per channel + a p-bit shared by the 4 channels, keeps the p-bit with the lowest error
+    void quantizeBC7Endpoint(const float* _endpoint, uint8_t* _quantized, uint8_t& _pBit, float* _reconstructed)
+    {
+        float bestError = FLT_MAX;
+        for (uint32_t pBit = 0; pBit < 2; ++pBit)
+        {
+            uint8_t quantized[4];
+            float error = 0.0f;
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                const float value = std::round((_endpoint[c] - static_cast<float>(pBit)) * 0.5f);
+                quantized[c] = static_cast<uint8_t>(std::clamp(value, 0.0f, 127.0f));
+                const float difference = static_cast<float>(quantized[c] << 1 | pBit) - _endpoint[c];
+                error += difference * difference;
+            }
+
+            if (error < bestError)
+            {
+                bestError = error;
+                _pBit = static_cast<uint8_t>(pBit);
+                memcpy(_quantized, quantized, sizeof(quantized));
+            }
+        }
+
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            _reconstructed[c] = static_cast<float>(_quantized[c] << 1 | _pBit);
+        }
+    }
+
+    float fitBC7(const Block& _block, const float* _e0, const float* _e1, BC7Block& _out, float* _weights)
+    {
+        float q0[4], q1[4];
+        quantizeBC7Endpoint(_e0, _out.m_endpoints[0], _out.m_pBits[0], q0);
+        quantizeBC7Endpoint(_e1, _out.m_endpoints[1], _out.m_pBits[1], q1);
+
+        alignas(16) float t[BLOCK_PIXELS];
+        projectOnSegment(_block, 4, q0, q1, t);
+
+        for (uint32_t i = 0; i < BLOCK_PIXELS; ++i)
+        {
+            // the weights are almost evenly spaced, round then pick the closest neighbour
+            const float weight = t[i] * 64.0f;
+            uint32_t index = static_cast<uint32_t>(t[i] * 15.0f + 0.5f);
+            if (index > 0 && std::abs(BC7_WEIGHTS[index - 1] - weight) < std::abs(BC7_WEIGHTS[index] - weight))
+                --index;
+            else if (index < 15 && std::abs(BC7_WEIGHTS[index + 1] - weight) < std::abs(BC7_WEIGHTS[index] - weight))
+                ++index;
+
+            _out.m_indices[i] = static_cast<uint8_t>(index);
+            _weights[i] = BC7_WEIGHTS[index] / 64.0f;
+        }
+
+        const float error = computeError(_block, 4, q0, q1, _weights);
+
+        // the first index is stored on 3 bits, its top bit has to be 0
+        if (_out.m_indices[0] >= 8)
+        {
+            std::swap(_out.m_endpoints[0], _out.m_endpoints[1]);
+            std::swap(_out.m_pBits[0], _out.m_pBits[1]);
+            for (auto& index : _out.m_indices)
+            {
+                index = static_cast<uint8_t>(15 - index);
+            }
+        }
+
+        return error;
+    }
+
+    class BitWriter
+    {
+    public:
+        explicit BitWriter(uint8_t* _data) : m_data(_data) {}
+
+        void write(uint32_t _value, uint32_t _bitCount)
+        {
+            for (uint32_t i = 0; i < _bitCount; ++i, ++m_position)
+            {
+                m_data[m_position >> 3] |= static_cast<uint8_t>(((_value >> i) & 1) << (m_position & 7));
+            }
+        }
+
+    private:
+        uint8_t* m_data;
+        uint32_t m_position = 0;
+    };
+
+    class BitReader
+    {
+    public:
+        explicit BitReader(const uint8_t* _data) : m_data(_data) {}
+
+        uint32_t read(uint32_t _bitCount)
+        {
+            uint32_t value = 0;
+            for (uint32_t i = 0; i < _bitCount; ++i, ++m_position)
+            {
+                value |= ((m_data[m_position >> 3] >> (m_position & 7)) & 1u) << i;
+            }
+            return value;
+        }
+
+    private:
+        const uint8_t* m_data;
+        uint32_t m_position = 0;
+    };
+
+    void encodeBC7(const Block& _block, uint8_t* _out)
+    {
+        float e0[4], e1[4];
+        computeEndpoints(_block, 4, e0, e1);
+
+        BC7Block best;
+        alignas(16) float weights[BLOCK_PIXELS];
+        const float bestError = fitBC7(_block, e0, e1, best, weights);
+
+        if (bestError > 0.0f && refineEndpoints(_block, 4, weights, e0, e1))
+        {
+            BC7Block refined;
+            if (fitBC7(_block, e0, e1, refined, weights) < bestError)
+                best = refined;
+        }
+
+        memset(_out, 0, 16);
+        BitWriter writer(_out);
+        writer.write(1 << 6, 7); // mode 6
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            writer.write(best.m_endpoints[0][c], 7);
+            writer.write(best.m_endpoints[1][c], 7);
+        }
+        writer.write(best.m_pBits[0], 1);
+        writer.write(best.m_pBits[1], 1);
+        writer.write(best.m_indices[0], 3);
+        for (uint32_t i = 1; i < BLOCK_PIXELS; ++i)
+        {
+            writer.write(best.m_indices[i], 4);
+        }
+    }
+
+    void encodeBlock(EFormat _format, const Block& _block, uint8_t* _out)
+    {
+        switch (_format)
+        {
+            case EFormat::BC1:
+                encodeBC1(_block, _out);
+                break;
+            case EFormat::BC3:
+                encodeBC4(_block.m_channels[3], _out);
+                encodeBC1(_block, _out + 8);
+                break;
+            case EFormat::BC4:
+                encodeBC4(_block.m_channels[0], _out);
+                break;
+            case EFormat::BC5:
+                encodeBC4(_block.m_channels[0], _out);
+                encodeBC4(_block.m_channels[1], _out + 8);
+                break;
+            case EFormat::BC7:
+                encodeBC7(_block, _out);
+                break;
+            case EFormat::Max:
+                break;
+        }
+    }
+
+    // Decoders write the 16 pixels of the block as RGBA8
+    void decodeBC1(const uint8_t* _block, uint8_t* _pixels)
+    {
+        uint16_t color0, color1;
+        uint32_t indices;
+        memcpy(&color0, _block, sizeof(uint16_t));
+        memcpy(&color1, _block + 2, sizeof(uint16_t));
+        memcpy(&indices, _block + 4, sizeof(uint32_t));
+
+        uint8_t palette[4][4];
+        unpackRGB565(color0, palette[0]);
+        unpackRGB565(color1, palette[1]);
+        palette[0][3] = palette[1][3] = 255;
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            if (color0 > color1)
+            {
+                palette[2][c] = static_cast<uint8_t>((2 * palette[0][c] + palette[1][c]) / 3);
+                palette[3][c] = static_cast<uint8_t>((palette[0][c] + 2 * palette[1][c]) / 3);
+            }
+            else
+            {
+                palette[2][c] = static_cast<uint8_t>((palette[0][c] + palette[1][c]) / 2);
+                palette[3][c] = 0;
+            }
+        }
+        palette[2][3] = 255;
+        palette[3][3] = color0 > color1 ? 255 : 0;
+
+        for (uint32_t i = 0; i < BLOCK_PIXELS; ++i)
+        {
+            memcpy(_pixels + i * 4, palette[(indices >> (i * 2)) & 3], 4);
+        }
+    }
+
+    void decodeBC4(const uint8_t* _block, uint8_t* _pixels, uint32_t _channel)
+    {
+        const uint32_t value0 = _block[0];
+        const uint32_t value1 = _block[1];
+
+        uint8_t palette[8];
+        palette[0] = static_cast<uint8_t>(value0);
+        palette[1] = static_cast<uint8_t>(value1);
+        if (value0 > value1)
+        {
+            for (uint32_t i = 1; i < 7; ++i)
+            {
+                palette[i + 1] = static_cast<uint8_t>(((7 - i) * value0 + i * value1) / 7);
+            }
+        }
+        else
+        {
+            for (uint32_t i = 1; i < 5; ++i)
+            {
+                palette[i + 1] = static_cast<uint8_t>(((5 - i) * value0 + i * value1) / 5);
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+
+        uint64_t indices = 0;
+        for (uint32_t i = 0; i < 6; ++i)
+        {
+            indices |= static_cast<uint64_t>(_block[2 + i]) << (i * 8);
+        }
+
+        for (uint32_t i = 0; i < BLOCK_PIXELS; ++i)
+        {
+            _pixels[i * 4 + _channel] = palette[(indices >> (i * 3)) & 7];
+        }
+    }
+
+    void decodeBC7(const uint8_t* _block, uint8_t* _pixels)
+    {
+        BitReader reader(_block);
+        if (reader.read(7) != 1 << 6)
+        {
+            // only mode 6 is ever written by the encoder
+            memset(_pixels, 0, BLOCK_PIXELS * 4);
+            return;
+        }
+
+        uint32_t endpoints[2][4];
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            endpoints[0][c] = reader.read(7) << 1;
+            endpoints[1][c] = reader.read(7) << 1;
+        }
+        const uint32_t pBit0 = reader.read(1);
+        const uint32_t pBit1 = reader.read(1);
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            endpoints[0][c] |= pBit0;
+            endpoints[1][c] |= pBit1;
+        }
+
+        for (uint32_t i = 0; i < BLOCK_PIXELS; ++i)
+        {
+            const uint32_t weight = BC7_WEIGHTS[reader.read(i == 0 ? 3 : 4)];
+            for (uint32_t c = 0; c < 4; ++c)
+            {
+                _pixels[i * 4 + c] = static_cast<uint8_t>(((64 - weight) * endpoints[0][c] + weight * endpoints[1][c] + 32) >> 6);
+            }
+        }
+    }
+
+    void decodeBlock(EFormat _format, const uint8_t* _block, uint8_t* _pixels)
+    {
+        switch (_format)
+        {
+            case EFormat::BC1:
+                decodeBC1(_block, _pixels);
+                break;
+            case EFormat::BC3:
+                decodeBC1(_block + 8, _pixels);
+                decodeBC4(_block, _pixels, 3);
+                break;
+            case EFormat::BC4:
+                memset(_pixels, 0, BLOCK_PIXELS * 4);
+                decodeBC4(_block, _pixels, 0);
+                break;
+            case EFormat::BC5:
+                memset(_pixels, 0, BLOCK_PIXELS * 4);
+                decodeBC4(_block, _pixels, 0);
+                decodeBC4(_block + 8, _pixels, 1);
+                break;
+            case EFormat::BC7:
+                decodeBC7(_block, _pixels);
+                break;
+            case EFormat::Max:
+                break;
+        }
+    }
+
+    uint32_t getChannelCount(EFormat _format)
+    {
+        switch (_format)
+        {
+            case EFormat::BC1: return 3;
+            case EFormat::BC3: return 4;
+            case EFormat::BC4: return 1;
+            case EFormat::BC5: return 2;
+            case EFormat::BC7: return 4;
+            case EFormat::Max: return 0;
+        }
+
+        return 0;
+    }
+}
+
+uint32_t getBlockSize(EFormat _format)
+{
+    return _format == EFormat::BC1 || _format == EFormat::BC4 ? 8 : 16;
+}
+
+size_t getCompressedSize(EFormat _format, uint32_t _width, uint32_t _height)
+{
+    const size_t blocksX = (_width + BLOCK_DIM - 1) / BLOCK_DIM;
+    const size_t blocksY = (_height + BLOCK_DIM - 1) / BLOCK_DIM;
+    return blocksX * blocksY * getBlockSize(_format);
+}
+
+bool canCompress(uint32_t _width, uint32_t _height)
+{
+    return _width > 0 && _height > 0 && _width % BLOCK_DIM == 0 && _height % BLOCK_DIM == 0;
+}
+
+void compress(EFormat _format, const uint8_t* _rgba, uint32_t _width, uint32_t _height, uint8_t* _blocks)
+{
+    ZoneScopedN("Texture Compression");
+    ZoneText(getName(_format), strlen(getName(_format)));
+
+    const uint32_t blocksX = (_width + BLOCK_DIM - 1) / BLOCK_DIM;
+    const uint32_t blocksY = (_height + BLOCK_DIM - 1) / BLOCK_DIM;
+    const uint32_t blockSize = getBlockSize(_format);
+
+    JobSystem::get().parallelFor(JobSystem::ESubsystem::Texture, JobSystem::EPriority::High, blocksY, 1, [=](uint32_t _firstRow, uint32_t _lastRow)
+    {
+        ZoneScopedN("Compress Blocks");
+        Block block;
+        for (uint32_t y = _firstRow; y < _lastRow; ++y)
+        {
+            for (uint32_t x = 0; x < blocksX; ++x)
+            {
+                loadBlock(_rgba, _width, _height, x, y, block);
+                encodeBlock(_format, block, _blocks + (static_cast<size_t>(y) * blocksX + x) * blockSize);
+            }
+        }
+    });
+}
+
+void decompress(EFormat _format, const uint8_t* _blocks, uint32_t _width, uint32_t _height, uint8_t* _rgba)
+{
+    ZoneScopedN("Texture Decompression");
+    const uint32_t blocksX = (_width + BLOCK_DIM - 1) / BLOCK_DIM;
+    const uint32_t blocksY = (_height + BLOCK_DIM - 1) / BLOCK_DIM;
+    const uint32_t blockSize = getBlockSize(_format);
+
+    uint8_t pixels[BLOCK_PIXELS * 4];
+    for (uint32_t blockY = 0; blockY < blocksY; ++blockY)
+    {
+        for (uint32_t blockX = 0; blockX < blocksX; ++blockX)
+        {
+            decodeBlock(_format, _blocks + (static_cast<size_t>(blockY) * blocksX + blockX) * blockSize, pixels);
+
+            for (uint32_t y = 0; y < BLOCK_DIM && blockY * BLOCK_DIM + y < _height; ++y)
+            {
+                for (uint32_t x = 0; x < BLOCK_DIM && blockX * BLOCK_DIM + x < _width; ++x)
+                {
+                    const size_t pixel = static_cast<size_t>(blockY * BLOCK_DIM + y) * _width + blockX * BLOCK_DIM + x;
+                    memcpy(_rgba + pixel * 4, pixels + (y * BLOCK_DIM + x) * 4, 4);
+                }
+            }
+        }
+    }
+}
+
+float computePSNR(EFormat _format, const uint8_t* _rgba, const uint8_t* _blocks, uint32_t _width, uint32_t _height)
+{
+    ZoneScopedN("Texture PSNR");
+    const size_t pixelCount = static_cast<size_t>(_width) * _height;
+    // BC4/BC5 store the first channels, BC1 drops alpha
+    const uint32_t channelCount = getChannelCount(_format);
+
+    uint8_t* decoded = new uint8_t[pixelCount * 4];
+    decompress(_format, _blocks, _width, _height, decoded);
+
+    double squaredError = 0.0;
+    for (size_t i = 0; i < pixelCount; ++i)
+    {
+        for (uint32_t c = 0; c < channelCount; ++c)
+        {
+            const double difference = static_cast<double>(_rgba[i * 4 + c]) - decoded[i * 4 + c];
+            squaredError += difference * difference;
+        }
+    }
+    delete[] decoded;
+
+    const double meanSquaredError = squaredError / static_cast<double>(pixelCount * channelCount);
+    if (meanSquaredError <= 0.0)
+        return 100.0f; // lossless
+
+    return static_cast<float>(10.0 * std::log10(255.0 * 255.0 / meanSquaredError));
+}
+
+bool isOpaque(const uint8_t* _rgba, size_t _pixelCount)
+{
+    const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+    size_t i = 0;
+    for (; i + 4 <= _pixelCount; i += 4)
+    {
+        const __m128i alpha = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(_rgba + i * 4)), alphaMask);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, alphaMask)) != 0xFFFF)
+            return false;
+    }
+
+    for (; i < _pixelCount; ++i)
+    {
+        if (_rgba[i * 4 + 3] != 255)
+            return false;
+    }
+
+    return true;
+}
+
+const char* getName(EFormat _format)
+{
+    switch (_format)
+    {
+        case EFormat::BC1: return "BC1";
+        case EFormat::BC3: return "BC3";
+        case EFormat::BC4: return "BC4";
+        case EFormat::BC5: return "BC5";
+        case EFormat::BC7: return "BC7";
+        case EFormat::Max: return "";
+    }
+
+    return "";
+}
+}
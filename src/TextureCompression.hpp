@@ -0,0 +1,48 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#ifndef GRAPHICSPLAYGROUND_TEXTURECOMPRESSION_HPP
+#define GRAPHICSPLAYGROUND_TEXTURECOMPRESSION_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// CPU block compression used when cooking the meshes, everything works on tightly packed RGBA8 pixels.
+// Blocks are fitted along the principal axis of their colors then refined once with a least squares pass,
+// the per pixel work is done 4 pixels at a time with SSE.
+namespace TextureCompression
+{
+    enum class EFormat : uint8_t
+    {
+        BC1 = 0, // RGB
+        BC3,     // RGBA, BC1 color + BC4 alpha
+        BC4,     // R
+        BC5,     // RG, two BC4 blocks
+        BC7,     // RGBA, only mode 6 is used
+        Max
+    };
+
+    uint32_t getBlockSize(EFormat _format);
+    size_t getCompressedSize(EFormat _format, uint32_t _width, uint32_t _height);
+
+    // The top level of a BC texture has to be a multiple of the block size
+    bool canCompress(uint32_t _width, uint32_t _height);
+
+    // Rows of blocks are spread on the job system workers, fine to call from a worker
+    void compress(EFormat _format, const uint8_t* _rgba, uint32_t _width, uint32_t _height, uint8_t* _blocks);
+    void decompress(EFormat _format, const uint8_t* _blocks, uint32_t _width, uint32_t _height, uint8_t* _rgba);
+
+    // Under this PSNR the artifacts are easy to spot, the cook warns about it and AssetCooker --test-textures fails
+    constexpr float MIN_PSNR = 30.0f;
+
+    // Peak signal to noise ratio over the channels stored by the format, in dB
+    float computePSNR(EFormat _format, const uint8_t* _rgba, const uint8_t* _blocks, uint32_t _width, uint32_t _height);
+
+    // True when every alpha is 255, a texture without transparency can drop its alpha channel
+    bool isOpaque(const uint8_t* _rgba, size_t _pixelCount);
+
+    const char* getName(EFormat _format);
+}
+
+#endif //GRAPHICSPLAYGROUND_TEXTURECOMPRESSION_HPP
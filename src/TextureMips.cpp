@@ -0,0 +1,218 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#include "TextureMips.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <emmintrin.h>
+
+#include "JobSystem.hpp"
+#include "tracy/Tracy.hpp"
+
+namespace TextureMips
+{
+namespace
+{
+    constexpr uint32_t LINEAR_TO_SRGB_SIZE = 4096;
+
+    struct SRGBTables
+    {
+        SRGBTables()
+        {
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                const float value = static_cast<float>(i) / 255.0f;
+                m_toLinear[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+            }
+
+            for (uint32_t i = 0; i < LINEAR_TO_SRGB_SIZE; ++i)
+            {
+                const float value = static_cast<float>(i) / (LINEAR_TO_SRGB_SIZE - 1);
+                const float srgb = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+                m_toSRGB[i] = static_cast<uint8_t>(std::clamp(srgb * 255.0f + 0.5f, 0.0f, 255.0f));
+            }
+        }
+
+        float m_toLinear[256];
+        uint8_t m_toSRGB[LINEAR_TO_SRGB_SIZE];
+    };
+
+    const SRGBTables& getSRGBTables()
+    {
+        static const SRGBTables tables;
+        return tables;
+    }
+
+    __m128 loadPixel(const uint8_t* _pixel)
+    {
+        int32_t value;
+        memcpy(&value, _pixel, sizeof(value));
+
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i bytes = _mm_cvtsi32_si128(value);
+        return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero));
+    }
+
+    void storePixel(__m128 _pixel, uint8_t* _destination)
+    {
+        __m128i value = _mm_cvtps_epi32(_pixel);
+        value = _mm_packs_epi32(value, value);
+        value = _mm_packus_epi16(value, value); // saturates to [0, 255]
+
+        const int32_t packed = _mm_cvtsi128_si32(value);
+        memcpy(_destination, &packed, sizeof(packed));
+    }
+
+    __m128 loadLinearPixel(const uint8_t* _pixel, const SRGBTables& _tables)
+    {
+        return _mm_set_ps(_pixel[3] * (1.0f / 255.0f), _tables.m_toLinear[_pixel[2]], _tables.m_toLinear[_pixel[1]], _tables.m_toLinear[_pixel[0]]);
+    }
+
+    void storeLinearPixel(__m128 _pixel, uint8_t* _destination, const SRGBTables& _tables)
+    {
+        alignas(16) int32_t indices[4];
+        const __m128 scaled = _mm_mul_ps(_pixel, _mm_set_ps(255.0f, LINEAR_TO_SRGB_SIZE - 1, LINEAR_TO_SRGB_SIZE - 1, LINEAR_TO_SRGB_SIZE - 1));
+        _mm_store_si128(reinterpret_cast<__m128i*>(indices), _mm_cvtps_epi32(scaled));
+
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            _destination[c] = _tables.m_toSRGB[std::clamp<int32_t>(indices[c], 0, LINEAR_TO_SRGB_SIZE - 1)];
+        }
+        _destination[3] = static_cast<uint8_t>(std::clamp<int32_t>(indices[3], 0, 255));
+    }
+
+    __m128 renormalize(__m128 _normal)
+    {
+        // xyz are the vector, w is the alpha and is left alone
+        const __m128 xyzMask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+        const __m128 vector = _mm_and_ps(_normal, xyzMask);
+        __m128 lengthSq = _mm_mul_ps(vector, vector);
+        lengthSq = _mm_add_ps(lengthSq, _mm_shuffle_ps(lengthSq, lengthSq, _MM_SHUFFLE(2, 3, 0, 1)));
+        lengthSq = _mm_add_ps(lengthSq, _mm_shuffle_ps(lengthSq, lengthSq, _MM_SHUFFLE(1, 0, 3, 2)));
+
+        if (_mm_cvtss_f32(lengthSq) < 1e-8f)
+            return _mm_or_ps(_mm_set_ps(0.0f, 1.0f, 0.0f, 0.0f), _mm_andnot_ps(xyzMask, _normal)); // canceled out, points up
+
+        const __m128 scale = _mm_or_ps(_mm_and_ps(_mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lengthSq)), xyzMask),
+                                       _mm_andnot_ps(xyzMask, _mm_set1_ps(1.0f)));
+        return _mm_mul_ps(_normal, scale);
+    }
+
+    void downsampleRows(EFilter _filter, const uint8_t* _source, uint32_t _width, uint32_t _height, uint8_t* _destination,
+                        uint32_t _firstRow, uint32_t _lastRow)
+    {
+        const uint32_t destinationWidth = std::max(1u, _width / 2);
+        const SRGBTables& tables = getSRGBTables();
+
+        // vectors are stored as [0, 255] for [-1, 1], alpha keeps its [0, 255] range
+        const __m128 toVectorScale = _mm_set_ps(1.0f, 2.0f / 255.0f, 2.0f / 255.0f, 2.0f / 255.0f);
+        const __m128 toVectorBias = _mm_set_ps(0.0f, -1.0f, -1.0f, -1.0f);
+        const __m128 fromVectorScale = _mm_set_ps(1.0f, 127.5f, 127.5f, 127.5f);
+        const __m128 fromVectorBias = _mm_set_ps(0.0f, 127.5f, 127.5f, 127.5f);
+        const __m128 quarter = _mm_set1_ps(0.25f);
+
+        for (uint32_t y = _firstRow; y < _lastRow; ++y)
+        {
+            // odd sizes repeat the last row/column
+            const uint8_t* row0 = _source + static_cast<size_t>(std::min(y * 2, _height - 1)) * _width * 4;
+            const uint8_t* row1 = _source + static_cast<size_t>(std::min(y * 2 + 1, _height - 1)) * _width * 4;
+            uint8_t* destination = _destination + static_cast<size_t>(y) * destinationWidth * 4;
+
+            for (uint32_t x = 0; x < destinationWidth; ++x)
+            {
+                const size_t x0 = static_cast<size_t>(std::min(x * 2, _width - 1)) * 4;
+                const size_t x1 = static_cast<size_t>(std::min(x * 2 + 1, _width - 1)) * 4;
+
+                switch (_filter)
+                {
+                    case EFilter::Linear:
+                    {
+                        const __m128 sum = _mm_add_ps(_mm_add_ps(loadPixel(row0 + x0), loadPixel(row0 + x1)),
+                                                      _mm_add_ps(loadPixel(row1 + x0), loadPixel(row1 + x1)));
+                        storePixel(_mm_mul_ps(sum, quarter), destination + x * 4);
+                        break;
+                    }
+                    case EFilter::SRGB:
+                    {
+                        const __m128 sum = _mm_add_ps(_mm_add_ps(loadLinearPixel(row0 + x0, tables), loadLinearPixel(row0 + x1, tables)),
+                                                      _mm_add_ps(loadLinearPixel(row1 + x0, tables), loadLinearPixel(row1 + x1, tables)));
+                        storeLinearPixel(_mm_mul_ps(sum, quarter), destination + x * 4, tables);
+                        break;
+                    }
+                    case EFilter::Normal:
+                    {
+                        __m128 sum = _mm_add_ps(_mm_add_ps(loadPixel(row0 + x0), loadPixel(row0 + x1)),
+                                                _mm_add_ps(loadPixel(row1 + x0), loadPixel(row1 + x1)));
+                        sum = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sum, quarter), toVectorScale), toVectorBias);
+                        storePixel(_mm_add_ps(_mm_mul_ps(renormalize(sum), fromVectorScale), fromVectorBias), destination + x * 4);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+uint32_t getLevelCount(uint32_t _width, uint32_t _height)
+{
+    uint32_t count = 1;
+    for (uint32_t size = std::max(_width, _height); size > 1; size /= 2)
+    {
+        ++count;
+    }
+    return count;
+}
+
+eastl::vector<Level> generate(EFilter _filter, const uint8_t* _rgba, uint32_t _width, uint32_t _height, eastl::vector<uint8_t>& _chain)
+{
+    ZoneScopedN("Generate Mips");
+    const uint32_t levelCount = getLevelCount(_width, _height);
+
+    eastl::vector<Level> levels;
+    levels.reserve(levelCount);
+    levels.push_back({_width, _height, _rgba});
+
+    // sized up front, the level pointers stay valid
+    size_t chainSize = 0;
+    for (uint32_t width = _width, height = _height, level = 1; level < levelCount; ++level)
+    {
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+        chainSize += static_cast<size_t>(width) * height * 4;
+    }
+    _chain.resize(chainSize);
+
+    uint8_t* destination = _chain.data();
+    for (uint32_t level = 1; level < levelCount; ++level)
+    {
+        const Level& previous = levels.back();
+        const uint32_t width = std::max(1u, previous.m_width / 2);
+        const uint32_t height = std::max(1u, previous.m_height / 2);
+
+        downsample(_filter, previous.m_pixels, previous.m_width, previous.m_height, destination);
+        levels.push_back({width, height, destination});
+        destination += static_cast<size_t>(width) * height * 4;
+    }
+
+    return levels;
+}
+
+void downsample(EFilter _filter, const uint8_t* _source, uint32_t _width, uint32_t _height, uint8_t* _destination)
+{
+    const uint32_t destinationWidth = std::max(1u, _width / 2);
+    const uint32_t destinationHeight = std::max(1u, _height / 2);
+
+    // small levels are not worth a job
+    const uint32_t rowsPerJob = std::max(1u, 16384 / destinationWidth);
+    JobSystem::get().parallelFor(JobSystem::ESubsystem::Texture, JobSystem::EPriority::High, destinationHeight, rowsPerJob,
+                                 [=](uint32_t _firstRow, uint32_t _lastRow)
+    {
+        ZoneScopedN("Downsample Rows");
+        downsampleRows(_filter, _source, _width, _height, _destination, _firstRow, _lastRow);
+    });
+}
+}
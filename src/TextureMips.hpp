@@ -0,0 +1,40 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#ifndef GRAPHICSPLAYGROUND_TEXTUREMIPS_HPP
+#define GRAPHICSPLAYGROUND_TEXTUREMIPS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include <EASTL/vector.h>
+
+// CPU mip chain generation on RGBA8 pixels, each level is a 2x2 box filter of the previous one.
+namespace TextureMips
+{
+    enum class EFilter : uint8_t
+    {
+        Linear = 0, // plain average
+        SRGB,       // color averaged in linear space, alpha stays linear
+        Normal      // averaged as vectors then renormalized, alpha stays linear
+    };
+
+    struct Level
+    {
+        uint32_t m_width;
+        uint32_t m_height;
+        const uint8_t* m_pixels;
+    };
+
+    uint32_t getLevelCount(uint32_t _width, uint32_t _height);
+
+    // Whole chain, down to 1x1. Level 0 points to the source, the other ones are packed back to back in _chain.
+    // Rows are spread on the job system workers.
+    eastl::vector<Level> generate(EFilter _filter, const uint8_t* _rgba, uint32_t _width, uint32_t _height, eastl::vector<uint8_t>& _chain);
+
+    // One level down, _destination is max(1, _width / 2) x max(1, _height / 2)
+    void downsample(EFilter _filter, const uint8_t* _source, uint32_t _width, uint32_t _height, uint8_t* _destination);
+}
+
+#endif //GRAPHICSPLAYGROUND_TEXTUREMIPS_HPP
@@ -0,0 +1,321 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#include "VertexQuantization.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+#include <immintrin.h>
+
+#include "meshoptimizer.h"
+#include "tracy/Tracy.hpp"
+#include "util/CpuFeatures.hpp"
+
+namespace VertexQuantization
+{
+namespace
+{
+    static_assert(sizeof(VertexHalf) == 20 && offsetof(VertexHalf, m_normaluv) == 8 && offsetof(VertexHalf, m_tangent) == 16,
+                  "The kernels write m_position and m_normaluv as one 16 bytes block");
+    static_assert(offsetof(Vertex, m_normal) == 12 && offsetof(Vertex, m_uv) == 24 && offsetof(Vertex, m_tangent) == 32 && sizeof(Vertex) >= 48,
+                  "The kernels read position, normal and uv as 8 floats then the tangent as 4");
+
+    // meshopt_quantizeHalf on 4 lanes, one half per 32 bits lane
+    __m128i quantizeHalf4(__m128 _values)
+    {
+        const __m128i bits = _mm_castps_si128(_values);
+        const __m128i sign = _mm_and_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(0x8000));
+        const __m128i em = _mm_and_si128(bits, _mm_set1_epi32(0x7fffffff));
+
+        // bias the exponent and round to nearest, ties up
+        __m128i half = _mm_srli_epi32(_mm_add_epi32(em, _mm_set1_epi32((1 << 12) - (112 << 23))), 13);
+
+        const __m128i underflow = _mm_cmplt_epi32(em, _mm_set1_epi32(113 << 23));
+        const __m128i overflow = _mm_cmpgt_epi32(em, _mm_set1_epi32((143 << 23) - 1));
+        const __m128i nan = _mm_cmpgt_epi32(em, _mm_set1_epi32(255 << 23));
+
+        half = _mm_andnot_si128(underflow, half);
+        half = _mm_or_si128(_mm_and_si128(overflow, _mm_set1_epi32(0x7c00)), _mm_andnot_si128(overflow, half));
+        half = _mm_or_si128(_mm_and_si128(nan, _mm_set1_epi32(0x7e00)), _mm_andnot_si128(nan, half));
+        return _mm_or_si128(sign, half);
+    }
+
+    TARGET_AVX2 __m256i quantizeHalf8(__m256 _values)
+    {
+        const __m256i bits = _mm256_castps_si256(_values);
+        const __m256i sign = _mm256_and_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(0x8000));
+        const __m256i em = _mm256_and_si256(bits, _mm256_set1_epi32(0x7fffffff));
+
+        __m256i half = _mm256_srli_epi32(_mm256_add_epi32(em, _mm256_set1_epi32((1 << 12) - (112 << 23))), 13);
+
+        const __m256i underflow = _mm256_cmpgt_epi32(_mm256_set1_epi32(113 << 23), em);
+        const __m256i overflow = _mm256_cmpgt_epi32(em, _mm256_set1_epi32((143 << 23) - 1));
+        const __m256i nan = _mm256_cmpgt_epi32(em, _mm256_set1_epi32(255 << 23));
+
+        half = _mm256_andnot_si256(underflow, half);
+        half = _mm256_blendv_epi8(half, _mm256_set1_epi32(0x7c00), overflow);
+        half = _mm256_blendv_epi8(half, _mm256_set1_epi32(0x7e00), nan);
+        return _mm256_or_si256(sign, half);
+    }
+
+    void packHalfScalar(const Vertex* _vertices, size_t _count, VertexHalf* _packed)
+    {
+        for (size_t i = 0; i < _count; ++i)
+        {
+            const Vertex& v = _vertices[i];
+            VertexHalf& vertPacked = _packed[i];
+            vertPacked.m_position.x = meshopt_quantizeHalf(v.m_position.x);
+            vertPacked.m_position.x = meshopt_quantizeHalf(v.m_position.y) | vertPacked.m_position.x << 16;
+            vertPacked.m_position.y = meshopt_quantizeHalf(v.m_position.z);
+
+            // Z = cross(x, y)
+            vertPacked.m_normaluv.x = meshopt_quantizeHalf(v.m_normal.x) << 16 | meshopt_quantizeHalf(v.m_normal.y);
+
+            vertPacked.m_normaluv.y = meshopt_quantizeHalf(v.m_uv.x) << 16 | meshopt_quantizeHalf(v.m_uv.y);
+
+            vertPacked.m_tangent = meshopt_quantizeHalf(v.m_tangent.x) << 16 | meshopt_quantizeHalf(v.m_tangent.y);
+        }
+    }
+
+    void packHalfSSE2(const Vertex* _vertices, size_t _count, VertexHalf* _packed)
+    {
+        // keeps the lanes that get a half in their upper 16 bits
+        const __m128i highMask = _mm_set_epi32(-1, -1, 0, -1);
+
+        for (size_t i = 0; i < _count; ++i)
+        {
+            const float* v = &_vertices[i].m_position.x;
+            const __m128i a = quantizeHalf4(_mm_loadu_ps(v)); // position xyz, normal x
+            const __m128i b = quantizeHalf4(_mm_loadu_ps(v + 4)); // normal yz, uv
+            const __m128i t = quantizeHalf4(_mm_loadu_ps(v + 8)); // tangent, bitangent sign
+
+            // [y, z, normal y, v] | [x, 0, normal x, u] << 16
+            const __m128i low = _mm_unpacklo_epi64(_mm_shuffle_epi32(a, _MM_SHUFFLE(3, 3, 2, 1)), _mm_shuffle_epi32(b, _MM_SHUFFLE(3, 3, 3, 0)));
+            const __m128i high = _mm_unpacklo_epi64(a, _mm_unpacklo_epi32(_mm_shuffle_epi32(a, _MM_SHUFFLE(3, 3, 3, 3)), _mm_shuffle_epi32(b, _MM_SHUFFLE(2, 2, 2, 2))));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&_packed[i].m_position), _mm_or_si128(low, _mm_slli_epi32(_mm_and_si128(high, highMask), 16)));
+
+            _packed[i].m_tangent = static_cast<uint32_t>(_mm_cvtsi128_si32(t)) << 16 | static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(t, 4)));
+        }
+    }
+
+    TARGET_AVX2 void packHalfAVX2(const Vertex* _vertices, size_t _count, VertexHalf* _packed)
+    {
+        // 16 bits halves [x, y, z, normal xyz, u, v] to [y | x << 16, z, normal y | normal x << 16, v | u << 16]
+        const __m128i order = _mm_setr_epi8(2, 3, 0, 1, 4, 5, -1, -1, 8, 9, 6, 7, 14, 15, 12, 13);
+
+        for (size_t i = 0; i < _count; ++i)
+        {
+            const float* v = &_vertices[i].m_position.x;
+            const __m256i halves = quantizeHalf8(_mm256_loadu_ps(v));
+            // through the 8 lanes version too, the SSE one isn't VEX encoded and switching costs more than the wasted lanes
+            const __m128i t = _mm256_castsi256_si128(quantizeHalf8(_mm256_castps128_ps256(_mm_loadu_ps(v + 8))));
+
+            // the halves fit in 16 bits, packus keeps them as is but per 128 bits lane
+            const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(halves, halves), _MM_SHUFFLE(3, 1, 2, 0));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&_packed[i].m_position), _mm_shuffle_epi8(_mm256_castsi256_si128(packed), order));
+
+            _packed[i].m_tangent = static_cast<uint32_t>(_mm_cvtsi128_si32(t)) << 16 | static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(t, 4)));
+        }
+    }
+
+    float dequantizeHalf(uint16_t _half)
+    {
+        const uint32_t sign = (_half & 0x8000u) << 16;
+        const uint32_t exponent = (_half >> 10) & 0x1fu;
+        const uint32_t mantissa = _half & 0x3ffu;
+
+        uint32_t bits;
+        if(exponent == 0)
+        {
+            // zero and subnormals
+            const float value = static_cast<float>(mantissa) * (1.0f / 16777216.0f);
+            memcpy(&bits, &value, sizeof(bits));
+            bits |= sign;
+        }
+        else if(exponent == 31)
+        {
+            bits = sign | 0x7f800000u | mantissa << 13;
+        }
+        else
+        {
+            bits = sign | (exponent + 112) << 23 | mantissa << 13;
+        }
+
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    uint32_t quantizeUnorm(float _value, uint32_t _bits)
+    {
+        const float max = static_cast<float>((1u << _bits) - 1);
+        return static_cast<uint32_t>(std::clamp(_value, 0.0f, 1.0f) * max + 0.5f);
+    }
+
+    float dequantizeUnorm(uint32_t _value, uint32_t _bits)
+    {
+        return static_cast<float>(_value) / static_cast<float>((1u << _bits) - 1);
+    }
+
+    // Unit vector to the octahedron unfolded on [-1, 1]^2, the lower half folded over the corners
+    float2 encodeOctahedral(float3 _direction)
+    {
+        const float sum = std::abs(_direction.x) + std::abs(_direction.y) + std::abs(_direction.z);
+        if(sum == 0.0f)
+            return float2(0.0f, 0.0f);
+
+        _direction /= sum;
+        if(_direction.z >= 0.0f)
+            return float2(_direction.x, _direction.y);
+
+        return float2((1.0f - std::abs(_direction.y)) * (_direction.x >= 0.0f ? 1.0f : -1.0f),
+                      (1.0f - std::abs(_direction.x)) * (_direction.y >= 0.0f ? 1.0f : -1.0f));
+    }
+
+    // Same as octDecode in common/vertexOctahedral.hlsl
+    float3 decodeOctahedral(float2 _encoded)
+    {
+        float3 direction(_encoded.x, _encoded.y, 1.0f - std::abs(_encoded.x) - std::abs(_encoded.y));
+        const float fold = std::max(-direction.z, 0.0f);
+        direction.x += direction.x >= 0.0f ? -fold : fold;
+        direction.y += direction.y >= 0.0f ? -fold : fold;
+        return normalize(direction);
+    }
+
+    uint32_t packOctahedral(const float3& _direction, uint32_t _bits)
+    {
+        const float2 encoded = encodeOctahedral(_direction);
+        return quantizeUnorm(encoded.x * 0.5f + 0.5f, _bits) | quantizeUnorm(encoded.y * 0.5f + 0.5f, _bits) << _bits;
+    }
+
+    float3 unpackOctahedral(uint32_t _packed, uint32_t _bits)
+    {
+        const uint32_t mask = (1u << _bits) - 1;
+        return decodeOctahedral(float2(dequantizeUnorm(_packed & mask, _bits) * 2.0f - 1.0f, dequantizeUnorm(_packed >> _bits & mask, _bits) * 2.0f - 1.0f));
+    }
+}
+
+EKernel getBestKernel()
+{
+    static const EKernel best = CpuFeatures::hasAVX2() ? EKernel::AVX2 : EKernel::SSE2;
+    return best;
+}
+
+bool isSupported(EKernel _kernel)
+{
+    return _kernel != EKernel::AVX2 || getBestKernel() == EKernel::AVX2;
+}
+
+const char* getName(EKernel _kernel)
+{
+    switch (_kernel)
+    {
+        case EKernel::Scalar: return "scalar";
+        case EKernel::SSE2: return "SSE2";
+        case EKernel::AVX2: return "AVX2";
+    }
+    return "unknown";
+}
+
+void packHalf(const Vertex* _vertices, size_t _count, VertexHalf* _packed, EKernel _kernel)
+{
+    ZoneScopedN("Pack Vertices");
+
+    switch (_kernel)
+    {
+        case EKernel::Scalar: packHalfScalar(_vertices, _count, _packed); break;
+        case EKernel::SSE2: packHalfSSE2(_vertices, _count, _packed); break;
+        case EKernel::AVX2: packHalfAVX2(_vertices, _count, _packed); break;
+    }
+}
+
+void packOctahedral(const Vertex* _vertices, size_t _count, const BoundBox& _aabb, VertexOctahedral* _packed)
+{
+    ZoneScopedN("Pack Vertices Octahedral");
+
+    const float3 extent = _aabb.Max - _aabb.Min;
+    for (size_t i = 0; i < _count; ++i)
+    {
+        const Vertex& v = _vertices[i];
+        VertexOctahedral& vertPacked = _packed[i];
+        const float3 relative((extent.x > 0.0f ? (v.m_position.x - _aabb.Min.x) / extent.x : 0.0f),
+                              (extent.y > 0.0f ? (v.m_position.y - _aabb.Min.y) / extent.y : 0.0f),
+                              (extent.z > 0.0f ? (v.m_position.z - _aabb.Min.z) / extent.z : 0.0f));
+        vertPacked.m_position.x = quantizeUnorm(relative.x, 16) | quantizeUnorm(relative.y, 16) << 16;
+        vertPacked.m_position.y = quantizeUnorm(relative.z, 16) | packOctahedral(v.m_tangent, 8) << 16;
+
+        vertPacked.m_normaluv.x = packOctahedral(v.m_normal, 15) | (v.m_bitangentSign < 0.0f ? 1u : 0u) << 30;
+        vertPacked.m_normaluv.y = meshopt_quantizeHalf(v.m_uv.x) << 16 | meshopt_quantizeHalf(v.m_uv.y);
+    }
+}
+
+void pack(EVertexLayout _layout, const Vertex* _vertices, size_t _count, const BoundBox& _aabb, uint8_t* _packed)
+{
+    if (_layout == EVertexLayout::Octahedral)
+        packOctahedral(_vertices, _count, _aabb, reinterpret_cast<VertexOctahedral*>(_packed));
+    else
+        packHalf(_vertices, _count, reinterpret_cast<VertexHalf*>(_packed));
+}
+
+Vertex unpack(EVertexLayout _layout, const uint8_t* _packed, size_t _index, const BoundBox& _aabb)
+{
+    Vertex vertex;
+    if (_layout == EVertexLayout::Octahedral)
+    {
+        VertexOctahedral packed;
+        memcpy(&packed, _packed + _index * sizeof(VertexOctahedral), sizeof(packed));
+        vertex.m_uv = float2(dequantizeHalf(packed.m_normaluv.y >> 16), dequantizeHalf(packed.m_normaluv.y & 0xffff));
+        const float3 relative(dequantizeUnorm(packed.m_position.x & 0xffff, 16), dequantizeUnorm(packed.m_position.x >> 16, 16),
+                              dequantizeUnorm(packed.m_position.y & 0xffff, 16));
+        vertex.m_position = _aabb.Min + relative * (_aabb.Max - _aabb.Min);
+        vertex.m_tangent = unpackOctahedral(packed.m_position.y >> 16, 8);
+        vertex.m_normal = unpackOctahedral(packed.m_normaluv.x & 0x3fffffff, 15);
+        vertex.m_bitangentSign = packed.m_normaluv.x >> 30 & 1 ? -1.0f : 1.0f;
+        return vertex;
+    }
+
+    VertexHalf packed;
+    memcpy(&packed, _packed + _index * sizeof(VertexHalf), sizeof(packed));
+    vertex.m_uv = float2(dequantizeHalf(packed.m_normaluv.y >> 16), dequantizeHalf(packed.m_normaluv.y & 0xffff));
+    vertex.m_position = float3(dequantizeHalf(packed.m_position.x >> 16), dequantizeHalf(packed.m_position.x & 0xffff), dequantizeHalf(packed.m_position.y & 0xffff));
+
+    // the sign of z is lost
+    const float2 normal(dequantizeHalf(packed.m_normaluv.x >> 16), dequantizeHalf(packed.m_normaluv.x & 0xffff));
+    const float2 tangent(dequantizeHalf(packed.m_tangent >> 16), dequantizeHalf(packed.m_tangent & 0xffff));
+    vertex.m_normal = float3(normal.x, normal.y, std::sqrt(std::max(0.0f, 1.0f - dot(normal, normal))));
+    vertex.m_tangent = float3(tangent.x, tangent.y, std::sqrt(std::max(0.0f, 1.0f - dot(tangent, tangent))));
+    vertex.m_bitangentSign = 1.0f;
+    return vertex;
+}
+
+Error measureError(EVertexLayout _layout, const Vertex* _vertices, size_t _count, const uint8_t* _packed, const BoundBox& _aabb)
+{
+    ZoneScopedN("Measure Quantization Error");
+
+    Error error = {};
+    for (size_t i = 0; i < _count; ++i)
+    {
+        const Vertex& original = _vertices[i];
+        const Vertex unpacked = unpack(_layout, _packed, i, _aabb);
+
+        const float3 positionDelta = abs(unpacked.m_position - original.m_position);
+        error.m_position = std::max({error.m_position, positionDelta.x, positionDelta.y, positionDelta.z});
+        if (length(original.m_normal) > 0.0f)
+        {
+            error.m_normal = std::max(error.m_normal, std::acos(std::clamp(dot(normalize(original.m_normal), unpacked.m_normal), -1.0f, 1.0f)));
+        }
+        if (length(original.m_tangent) > 0.0f)
+        {
+            error.m_tangent = std::max(error.m_tangent, std::acos(std::clamp(dot(normalize(original.m_tangent), unpacked.m_tangent), -1.0f, 1.0f)));
+        }
+        error.m_flippedSigns += (original.m_bitangentSign < 0.0f) != (unpacked.m_bitangentSign < 0.0f);
+    }
+
+    error.m_normal *= 57.2957795f;
+    error.m_tangent *= 57.2957795f;
+    return error;
+}
+}
@@ -0,0 +1,51 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#ifndef GRAPHICSPLAYGROUND_VERTEXQUANTIZATION_HPP
+#define GRAPHICSPLAYGROUND_VERTEXQUANTIZATION_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Mesh.h"
+
+// Vertex -> packed vertices of every EVertexLayout, the last step of the import, and back for the checks and the upgrades.
+// The half layout is packed in batches. Every kernel gives the exact same bytes as meshopt_quantizeHalf: the SIMD ones redo its integer
+// rounding on 4 or 8 lanes (round half up, flush to zero under 2^-14) instead of using F16C, whose round to nearest even and denormals would differ.
+namespace VertexQuantization
+{
+    enum class EKernel : uint8_t
+    {
+        Scalar = 0, // meshopt_quantizeHalf per component, the reference
+        SSE2,
+        AVX2
+    };
+
+    // The fastest kernel this CPU runs
+    EKernel getBestKernel();
+    bool isSupported(EKernel _kernel);
+    const char* getName(EKernel _kernel);
+
+    void packHalf(const Vertex* _vertices, size_t _count, VertexHalf* _packed, EKernel _kernel = getBestKernel());
+    // _aabb is the one of the group, the positions are quantized in it
+    void packOctahedral(const Vertex* _vertices, size_t _count, const BoundBox& _aabb, VertexOctahedral* _packed);
+    // _packed holds _count vertices of getVertexSize(_layout) bytes
+    void pack(EVertexLayout _layout, const Vertex* _vertices, size_t _count, const BoundBox& _aabb, uint8_t* _packed);
+
+    // What the vertex shader reads out of the packed vertex _index, in the local space of the mesh. The half layout loses the sign of the
+    // z of the normal and the tangent, and the bitangent sign.
+    Vertex unpack(EVertexLayout _layout, const uint8_t* _packed, size_t _index, const BoundBox& _aabb);
+
+    // Worst difference between _vertices and their packed copy, the angles in degrees
+    struct Error
+    {
+        float m_position;
+        float m_normal;
+        float m_tangent;
+        uint32_t m_flippedSigns; // of the bitangent
+    };
+    Error measureError(EVertexLayout _layout, const Vertex* _vertices, size_t _count, const uint8_t* _packed, const BoundBox& _aabb);
+}
+
+#endif //GRAPHICSPLAYGROUND_VERTEXQUANTIZATION_HPP
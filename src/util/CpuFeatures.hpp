@@ -0,0 +1,45 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#ifndef GRAPHICSPLAYGROUND_CPUFEATURES_HPP
+#define GRAPHICSPLAYGROUND_CPUFEATURES_HPP
+
+#if defined(_MSC_VER)
+#    include <intrin.h>
+#    include <immintrin.h>
+#endif
+
+// MSVC compiles any intrinsic, gcc and clang only in functions built for the instruction set
+#if defined(_MSC_VER)
+#    define TARGET_AVX2
+#else
+#    define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace CpuFeatures
+{
+    // SSE2 is always there on x64, AVX2 is picked at runtime by the kernels that have a version for it
+    inline bool hasAVX2()
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+
+        // the OS has to save the ymm registers too
+        __cpuid(info, 1);
+        const bool hasOSXSave = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0;
+        if (!hasOSXSave || (_xgetbv(0) & 0x6) != 0x6)
+            return false;
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+}
+
+#endif //GRAPHICSPLAYGROUND_CPUFEATURES_HPP
@@ -0,0 +1,167 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#ifndef GRAPHICSPLAYGROUND_MAPPEDFILE_HPP
+#define GRAPHICSPLAYGROUND_MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_WIN32)
+#    ifndef WIN32_LEAN_AND_MEAN
+#        define WIN32_LEAN_AND_MEAN
+#    endif
+#    ifndef NOMINMAX
+#        define NOMINMAX
+#    endif
+#    include <Windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+// Read only view of a whole file, the OS pages it in on demand.
+// The view is released when the object dies, so keep it alive only while the data is read.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    explicit MappedFile(const char* _path) { open(_path); }
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& _other) noexcept { *this = static_cast<MappedFile&&>(_other); }
+    MappedFile& operator=(MappedFile&& _other) noexcept
+    {
+        if (this != &_other)
+        {
+            close();
+            m_data = _other.m_data;
+            m_size = _other.m_size;
+#if defined(_WIN32)
+            m_file = _other.m_file;
+            m_mapping = _other.m_mapping;
+            _other.m_file = INVALID_HANDLE_VALUE;
+            _other.m_mapping = nullptr;
+#endif
+            _other.m_data = nullptr;
+            _other.m_size = 0;
+        }
+        return *this;
+    }
+
+    bool open(const char* _path)
+    {
+        close();
+#if defined(_WIN32)
+        m_file = CreateFileA(_path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+        {
+            close();
+            return false;
+        }
+
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!m_mapping)
+        {
+            close();
+            return false;
+        }
+
+        m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        m_size = static_cast<size_t>(size.QuadPart);
+#else
+        const int fd = ::open(_path, O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat st{};
+        if (fstat(fd, &st) != 0 || st.st_size == 0)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // the mapping keeps its own reference on the file
+
+        if (data == MAP_FAILED)
+            return false;
+
+        madvise(data, st.st_size, MADV_SEQUENTIAL);
+        m_data = static_cast<const uint8_t*>(data);
+        m_size = static_cast<size_t>(st.st_size);
+#endif
+        if (!m_data)
+        {
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void close()
+    {
+#if defined(_WIN32)
+        if (m_data)
+            UnmapViewOfFile(m_data);
+        if (m_mapping)
+            CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE)
+            CloseHandle(m_file);
+
+        m_mapping = nullptr;
+        m_file = INVALID_HANDLE_VALUE;
+#else
+        if (m_data)
+            munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    // Asks the OS to read a range now, in large sequential requests, instead of one page fault at a time later
+    void prefetch(size_t _offset, size_t _size) const
+    {
+        if (!m_data || _offset >= m_size)
+            return;
+
+        _size = _size < m_size - _offset ? _size : m_size - _offset;
+#if defined(_WIN32)
+        WIN32_MEMORY_RANGE_ENTRY range;
+        range.VirtualAddress = const_cast<uint8_t*>(m_data + _offset);
+        range.NumberOfBytes = _size;
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+        // madvise wants a page aligned start
+        const size_t pageOffset = _offset & ~static_cast<size_t>(sysconf(_SC_PAGESIZE) - 1);
+        madvise(const_cast<uint8_t*>(m_data) + pageOffset, _size + (_offset - pageOffset), MADV_WILLNEED);
+#endif
+    }
+
+    [[nodiscard]] bool isOpen() const { return m_data != nullptr; }
+    [[nodiscard]] const uint8_t* data() const { return m_data; }
+    [[nodiscard]] size_t size() const { return m_size; }
+
+private:
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+
+#if defined(_WIN32)
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+#endif
+};
+
+#endif //GRAPHICSPLAYGROUND_MAPPEDFILE_HPP
@@ -0,0 +1,70 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#ifndef GRAPHICSPLAYGROUND_MPSCQUEUE_HPP
+#define GRAPHICSPLAYGROUND_MPSCQUEUE_HPP
+
+#include <atomic>
+
+// Lock free queue with any number of producers and a single consumer.
+// Producers push on an intrusive stack with a CAS, the consumer takes the whole stack at once and reverses it,
+// so items come out in the order they were pushed and nobody ever waits on a lock.
+template<typename T>
+class MpscQueue
+{
+public:
+    MpscQueue() = default;
+    ~MpscQueue()
+    {
+        T item;
+        while (pop(item)) {}
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // Any thread
+    void push(T _item)
+    {
+        Node* node = new Node{static_cast<T&&>(_item), m_head.load(std::memory_order_relaxed)};
+        while (!m_head.compare_exchange_weak(node->m_next, node, std::memory_order_release, std::memory_order_relaxed)) {}
+    }
+
+    // Consumer thread only
+    bool pop(T& _item)
+    {
+        if (!m_pending)
+        {
+            Node* node = m_head.exchange(nullptr, std::memory_order_acquire);
+            while (node)
+            {
+                Node* next = node->m_next;
+                node->m_next = m_pending;
+                m_pending = node;
+                node = next;
+            }
+
+            if (!m_pending)
+                return false;
+        }
+
+        Node* node = m_pending;
+        m_pending = node->m_next;
+        _item = static_cast<T&&>(node->m_item);
+        delete node;
+        return true;
+    }
+
+private:
+    struct Node
+    {
+        T m_item;
+        Node* m_next;
+    };
+
+    std::atomic<Node*> m_head = nullptr;
+    Node* m_pending = nullptr; // already taken from m_head, oldest first
+};
+
+#endif //GRAPHICSPLAYGROUND_MPSCQUEUE_HPP
@@ -0,0 +1,43 @@
+//
+// Created by fab on 16/10/2026.
+//
+
+#ifndef GRAPHICSPLAYGROUND_PROCESSMEMORY_HPP
+#define GRAPHICSPLAYGROUND_PROCESSMEMORY_HPP
+
+#include <cstddef>
+
+#if defined(_WIN32)
+#    ifndef WIN32_LEAN_AND_MEAN
+#        define WIN32_LEAN_AND_MEAN
+#    endif
+#    ifndef NOMINMAX
+#        define NOMINMAX
+#    endif
+#    include <Windows.h>
+#    include <psapi.h>
+#else
+#    include <sys/resource.h>
+#endif
+
+namespace ProcessMemory
+{
+    // Peak resident set size of the process, in bytes
+    inline size_t getPeakResident()
+    {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return counters.PeakWorkingSetSize;
+        return 0;
+#else
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return static_cast<size_t>(usage.ru_maxrss) * 1024; // KiB on linux
+#endif
+    }
+
+    inline float toMB(size_t _bytes) { return static_cast<float>(_bytes) / (1024.0f * 1024.0f); }
+}
+
+#endif //GRAPHICSPLAYGROUND_PROCESSMEMORY_HPP
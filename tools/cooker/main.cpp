@@ -0,0 +1,1585 @@
+//
+// Created by FanyMontpell on 16/10/2026.
+//
+
+// Headless asset cooker: turns every source asset of a directory into its .mesh, without a window or a device,
+// so the app only ever loads cooked data. Assets are cooked in parallel on the job system.
+// An asset is skipped when the bytes of its source and dependencies, the import flags, the cook settings and the versions didn't change
+// since the last run, they are tracked in <directory>/cook_manifest.txt. The time of every import stage ends in <directory>/import_telemetry.json.
+//
+// AssetCooker <directory> [--force] [--pak] [--raw] [--octahedral], --pak also packs every .mesh of the directory in <directory>/scene.pak,
+//     --raw saves them as raw flatbuffers instead of zstd compressed sections, --octahedral packs the vertices in the octahedral layout,
+//     refused until every mesh shader can draw it (see Mesh::isVertexLayoutDrawable)
+// AssetCooker --test-textures [image...], PSNR of the block compression of reference textures and of the images, fails when it regressed
+// AssetCooker --test-codec, round trip of the meshoptimizer geometry codec, fails when a vertex or an index differs
+// AssetCooker --test-quantization [vertex count], worst error of every vertex layout, fails when one is above what the layout keeps
+// AssetCooker --benchmark-quantization [vertex count], vertices/s of every VertexQuantization kernel against the scalar one
+// AssetCooker --benchmark-load <directory>, cold cache load time, peak RSS and size of the cooked assets, read in memory or mapped,
+//     in the zstd container or as raw flatbuffers
+// AssetCooker --benchmark-pak <directory>, cold cache read of the scene from its .mesh files against scene.pak
+// AssetCooker --benchmark-culling [box count], boxes/s of every FrustumCulling kernel against GetBoxVisibility
+// AssetCooker --benchmark-bvh [box count], SceneBvh build, frustum, ray and overlap queries against testing every box
+// AssetCooker --benchmark-scene [instance count], culling and LOD selection of the groups walked one by one against the SceneStore
+// AssetCooker --benchmark-occlusion [depth.pgm], OcclusionCulling of a town seen from its street, checked with rays, the depth dumped when asked
+
+#include <mimalloc.h>
+#include <mimalloc-new-delete.h>
+
+#include "tracy/Tracy.hpp"
+
+// EASTL allocates through these
+void* operator new[](size_t size, const char* pName, int flags, unsigned debugFlags, const char* file, int line)
+{
+    auto ptr = mi_new(size);
+    TracySecureAlloc(ptr, size);
+    return ptr;
+}
+void* operator new[](size_t size, size_t alignment, size_t alignmentOffset, const char* pName, int flags, unsigned debugFlags, const char* file, int line)
+{
+    auto ptr = mi_new_aligned(size, alignment);
+    TracySecureAlloc(ptr, size);
+    return ptr;
+}
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <string>
+
+#include <EASTL/hash_map.h>
+#include <EASTL/sort.h>
+#include <EASTL/string.h>
+#include <EASTL/unique_ptr.h>
+#include <EASTL/vector.h>
+
+#include "FrustumCulling.hpp"
+#include "GeometryCodec.hpp"
+#include "ImportTelemetry.hpp"
+#include "JobSystem.hpp"
+#include "Mesh.h"
+#include "OcclusionCulling.hpp"
+#include "SceneArchive.hpp"
+#include "SceneBvh.hpp"
+#include "SceneStore.hpp"
+#include "TextureCompression.hpp"
+#include "VertexQuantization.hpp"
+#include "util/MappedFile.hpp"
+#include "util/ProcessMemory.hpp"
+#include "util/meow_hash_x64_aesni.h"
+
+namespace
+{
+    constexpr const char* MANIFEST_NAME = "cook_manifest.txt";
+    constexpr const char* SOURCE_EXTENSIONS[] = {".obj", ".fbx", ".gltf", ".glb"};
+
+    struct ManifestEntry
+    {
+        eastl::string m_hash;
+        eastl::vector<eastl::string> m_dependencies; // relative to the cooked directory
+    };
+
+    // key is the source, relative to the cooked directory
+    using Manifest = eastl::hash_map<eastl::string, ManifestEntry>;
+
+    enum class EStatus
+    {
+        Cooked,
+        UpToDate,
+        Failed
+    };
+
+    struct Result
+    {
+        eastl::string m_path;
+        EStatus m_status = EStatus::Failed;
+        float m_timeMs = 0.0f;
+        ManifestEntry m_entry;
+    };
+
+    // manifest format, one block per asset:
+    // asset <hash> <source>
+    // dep <dependency>
+    Manifest loadManifest(const std::filesystem::path& _path)
+    {
+        Manifest manifest;
+        std::ifstream file(_path);
+        std::string line;
+        ManifestEntry* current = nullptr;
+        while(std::getline(file, line))
+        {
+            if(line.rfind("asset ", 0) == 0)
+            {
+                const size_t hashEnd = line.find(' ', 6);
+                if(hashEnd == std::string::npos)
+                    continue;
+
+                current = &manifest[line.substr(hashEnd + 1).c_str()];
+                current->m_hash = line.substr(6, hashEnd - 6).c_str();
+            }
+            else if(line.rfind("dep ", 0) == 0 && current)
+            {
+                current->m_dependencies.push_back(line.substr(4).c_str());
+            }
+        }
+
+        return manifest;
+    }
+
+    void saveManifest(const std::filesystem::path& _path, const Manifest& _manifest)
+    {
+        // sorted so the file diffs nicely
+        eastl::vector<const Manifest::value_type*> entries;
+        for(const auto& entry : _manifest)
+        {
+            entries.push_back(&entry);
+        }
+        eastl::sort(entries.begin(), entries.end(), [](const auto* _a, const auto* _b) { return _a->first < _b->first; });
+
+        std::ofstream file(_path);
+        file << "# written by AssetCooker\n";
+        for(const auto* entry : entries)
+        {
+            file << "asset " << entry->second.m_hash.c_str() << " " << entry->first.c_str() << "\n";
+            for(const eastl::string& dependency : entry->second.m_dependencies)
+            {
+                file << "dep " << dependency.c_str() << "\n";
+            }
+        }
+    }
+
+    // Hash of everything the .mesh is made of, empty if a dependency is missing
+    eastl::string hashInputs(const std::filesystem::path& _root, eastl::vector<eastl::string> _dependencies)
+    {
+        eastl::sort(_dependencies.begin(), _dependencies.end());
+
+        meow_state state;
+        MeowBegin(&state, MeowDefaultSeed);
+
+        // everything that changes the bytes of the .mesh
+        const Mesh::CookSettings& cookSettings = Mesh::getCookSettings();
+        uint32_t settings[] = {VERSION,
+                               SCENE_VERSION,
+                               Mesh::getImportFlags(),
+                               static_cast<uint32_t>(cookSettings.m_vertexLayout),
+                               cookSettings.m_isCompressed,
+                               static_cast<uint32_t>(cookSettings.m_compressionLevel),
+                               cookSettings.m_isGeometryEncoded,
+                               cookSettings.m_isAlbedoBC7};
+        MeowAbsorb(&state, sizeof(settings), settings);
+
+        for(const eastl::string& dependency : _dependencies)
+        {
+            MappedFile file((_root / dependency.c_str()).string().c_str());
+            if(!file.isOpen())
+                return "";
+
+            // the path too, renaming a texture changes the cooked names
+            MeowAbsorb(&state, dependency.size(), const_cast<char*>(dependency.data()));
+            MeowAbsorb(&state, file.size(), const_cast<uint8_t*>(file.data()));
+        }
+
+        const meow_u128 hash = MeowEnd(&state, nullptr);
+        char text[33];
+        snprintf(text, sizeof(text), "%016llx%016llx", static_cast<unsigned long long>(MeowU64From(hash, 1)),
+                 static_cast<unsigned long long>(MeowU64From(hash, 0)));
+        return text;
+    }
+
+    bool isSource(const std::filesystem::path& _path)
+    {
+        std::string extension = _path.extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](char _c) { return static_cast<char>(tolower(_c)); });
+        return std::any_of(std::begin(SOURCE_EXTENSIONS), std::end(SOURCE_EXTENSIONS), [&](const char* _ext) { return extension == _ext; });
+    }
+
+    eastl::vector<std::filesystem::path> findSources(const std::filesystem::path& _root)
+    {
+        eastl::vector<std::filesystem::path> sources;
+        for(const auto& file : std::filesystem::recursive_directory_iterator(_root))
+        {
+            if(file.is_regular_file() && isSource(file.path()))
+            {
+                sources.push_back(file.path());
+            }
+        }
+        return sources;
+    }
+
+    eastl::string toManifestPath(const std::filesystem::path& _root, const std::filesystem::path& _path)
+    {
+        return std::filesystem::relative(_path, _root).generic_string().c_str();
+    }
+
+    // Random vertices of the ranges of a scene, plus every special case of the half conversion at the start
+    eastl::vector<Vertex> generateBenchmarkVertices(size_t _count)
+    {
+        std::mt19937 random(42);
+        std::uniform_real_distribution<float> positions(-1000.0f, 1000.0f);
+        std::uniform_real_distribution<float> directions(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> uvs(-4.0f, 4.0f);
+
+        eastl::vector<Vertex> vertices(_count);
+        for(Vertex& vertex : vertices)
+        {
+            vertex.m_position = float3(positions(random), positions(random), positions(random));
+            vertex.m_normal = normalize(float3(directions(random), directions(random), directions(random)) + float3(0.0f, 0.0f, 1e-3f));
+            vertex.m_uv = float2(uvs(random), uvs(random));
+            vertex.m_tangent = normalize(float3(directions(random), directions(random), directions(random)) + float3(1e-3f, 0.0f, 0.0f));
+            vertex.m_bitangentSign = directions(random) < 0.0f ? -1.0f : 1.0f;
+        }
+
+        // zeros, denormals, the smallest normal half and around it, rounding ties, overflow, infinities and NaN
+        const float specials[] = {0.0f, -0.0f, 1e-40f, -1e-40f, 6.1035156e-5f, 6.1e-5f, 5.96e-8f, 1.0f + 1.0f / 2048.0f,
+                                  -1.0f - 3.0f / 2048.0f, 65504.0f, 65519.0f, 65520.0f, -1e30f, std::numeric_limits<float>::infinity(),
+                                  -std::numeric_limits<float>::infinity(), std::numeric_limits<float>::quiet_NaN()};
+        for(size_t i = 0; i < std::size(specials) && i < _count; ++i)
+        {
+            float* components = &vertices[i].m_position.x;
+            for(size_t j = 0; j < sizeof(Vertex) / sizeof(float); ++j)
+            {
+                components[j] = specials[(i + j) % std::size(specials)];
+            }
+        }
+
+        return vertices;
+    }
+
+    // The fastest of _runCount runs, the others are the caches and the frequency warming up
+    template<typename Run>
+    float getBestMs(uint32_t _runCount, const Run& _run)
+    {
+        float bestMs = std::numeric_limits<float>::max();
+        for(uint32_t run = 0; run < _runCount; ++run)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            _run();
+            bestMs = std::min(bestMs, std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        return bestMs;
+    }
+
+    // Random boxes in a cube of _sceneExtent around the origin, the same on every machine, and their columns for FrustumCulling
+    struct BenchmarkBoxes
+    {
+        eastl::vector<BoundBox> m_boxes;
+        eastl::vector<float> m_minX, m_minY, m_minZ, m_maxX, m_maxY, m_maxZ;
+        eastl::vector<uint8_t> m_flags;
+
+        // Copies m_boxes in the columns, again after they were changed
+        FrustumCulling::Boxes updateColumns()
+        {
+            for(size_t i = 0; i < m_boxes.size(); ++i)
+            {
+                m_minX[i] = m_boxes[i].Min.x;
+                m_minY[i] = m_boxes[i].Min.y;
+                m_minZ[i] = m_boxes[i].Min.z;
+                m_maxX[i] = m_boxes[i].Max.x;
+                m_maxY[i] = m_boxes[i].Max.y;
+                m_maxZ[i] = m_boxes[i].Max.z;
+            }
+            return {m_minX.data(), m_minY.data(), m_minZ.data(), m_maxX.data(), m_maxY.data(), m_maxZ.data(), m_flags.data(),
+                    static_cast<uint32_t>(m_boxes.size())};
+        }
+    };
+
+    // Every box opaque, with a half size between _minSize and _maxSize on each axis
+    BenchmarkBoxes makeBoxes(size_t _count, float _sceneExtent, float _minSize, float _maxSize)
+    {
+        std::mt19937 random(42);
+        std::uniform_real_distribution<float> position(-_sceneExtent * 0.5f, _sceneExtent * 0.5f);
+        std::uniform_real_distribution<float> size(_minSize, _maxSize);
+
+        BenchmarkBoxes boxes;
+        boxes.m_boxes.resize(_count);
+        for(BoundBox& box : boxes.m_boxes)
+        {
+            const float3 center(position(random), position(random), position(random));
+            const float3 extent(size(random), size(random), size(random));
+            box = {center - extent, center + extent};
+        }
+        for(eastl::vector<float>* column : {&boxes.m_minX, &boxes.m_minY, &boxes.m_minZ, &boxes.m_maxX, &boxes.m_maxY, &boxes.m_maxZ})
+        {
+            column->resize(_count);
+        }
+        boxes.m_flags.resize(_count, SceneStore::FLAG_OPAQUE);
+        return boxes;
+    }
+
+    int benchmarkQuantization(size_t _vertexCount)
+    {
+        constexpr uint32_t RUN_COUNT = 10;
+        const eastl::vector<Vertex> vertices = generateBenchmarkVertices(_vertexCount);
+
+        eastl::vector<VertexHalf> reference(_vertexCount);
+        VertexQuantization::packHalf(vertices.data(), vertices.size(), reference.data(), VertexQuantization::EKernel::Scalar);
+
+        bool isValid = true;
+        for(auto kernel : {VertexQuantization::EKernel::Scalar, VertexQuantization::EKernel::SSE2, VertexQuantization::EKernel::AVX2})
+        {
+            if(!VertexQuantization::isSupported(kernel))
+            {
+                std::cout << VertexQuantization::getName(kernel) << ": not supported by this CPU" << std::endl;
+                continue;
+            }
+
+            eastl::vector<VertexHalf> packed(_vertexCount);
+            const float bestMs = getBestMs(RUN_COUNT, [&]() { VertexQuantization::packHalf(vertices.data(), vertices.size(), packed.data(), kernel); });
+
+            const bool isIdentical = memcmp(packed.data(), reference.data(), sizeof(VertexHalf) * _vertexCount) == 0;
+            isValid &= isIdentical;
+            std::cout << VertexQuantization::getName(kernel) << ": " << static_cast<double>(_vertexCount) / bestMs * 1e-3 << "M vertices/s ("
+                      << bestMs << "ms for " << _vertexCount << ")" << (isIdentical ? "" : ", DIFFERS FROM THE SCALAR KERNEL") << std::endl;
+        }
+
+        return isValid ? 0 : 1;
+    }
+
+    // Random vertices of a box packed in every layout and read back the way the vertex shader does. The half layout keeps neither the sign
+    // of the z of the normals and tangents nor the bitangent sign, its vertices face +z. The bounds are what each layout is able to keep:
+    // half floats for the half one, 16 bits in the AABB, 15 bits normals and 8 bits tangents for the octahedral one.
+    int testQuantization(size_t _vertexCount)
+    {
+        constexpr float BOX_SIZE = 1000.0f;
+        std::mt19937 random(42);
+        std::uniform_real_distribution<float> positions(-BOX_SIZE, BOX_SIZE);
+        std::uniform_real_distribution<float> directions(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> uvs(-4.0f, 4.0f);
+
+        eastl::vector<Vertex> vertices(_vertexCount);
+        BoundBox aabb;
+        aabb.Min = float3(std::numeric_limits<float>::max());
+        aabb.Max = float3(std::numeric_limits<float>::lowest());
+        for(Vertex& vertex : vertices)
+        {
+            vertex.m_position = float3(positions(random), positions(random), positions(random));
+            vertex.m_normal = normalize(float3(directions(random), directions(random), directions(random)) + float3(0.0f, 0.0f, 1e-3f));
+            vertex.m_uv = float2(uvs(random), uvs(random));
+            vertex.m_tangent = normalize(float3(directions(random), directions(random), directions(random)) + float3(1e-3f, 0.0f, 0.0f));
+            vertex.m_bitangentSign = directions(random) < 0.0f ? -1.0f : 1.0f;
+            aabb.Min = std::min(aabb.Min, vertex.m_position);
+            aabb.Max = std::max(aabb.Max, vertex.m_position);
+        }
+
+        eastl::vector<Vertex> verticesFacingZ = vertices;
+        for(Vertex& vertex : verticesFacingZ)
+        {
+            vertex.m_normal.z = std::abs(vertex.m_normal.z);
+            vertex.m_tangent.z = std::abs(vertex.m_tangent.z);
+            vertex.m_bitangentSign = 1.0f;
+        }
+
+        struct Layout
+        {
+            EVertexLayout m_layout;
+            const char* m_name;
+            const eastl::vector<Vertex>* m_vertices;
+            float m_maxPosition;
+            float m_maxNormal; // degrees
+            float m_maxTangent; // degrees
+        };
+        const float3 extent = aabb.Max - aabb.Min;
+        const Layout layouts[] = {
+                // 11 bits of mantissa, the z rebuilt from x and y is the least precise near the xy plane
+                {EVertexLayout::Half, "half", &verticesFacingZ, BOX_SIZE / 1024.0f, 3.0f, 3.0f},
+                {EVertexLayout::Octahedral, "octahedral", &vertices, std::max({extent.x, extent.y, extent.z}) / 65535.0f, 0.05f, 2.0f},
+        };
+
+        bool isValid = true;
+        for(const Layout& layout : layouts)
+        {
+            eastl::vector<uint8_t> packed(_vertexCount * Mesh::getVertexSize(layout.m_layout));
+            VertexQuantization::pack(layout.m_layout, layout.m_vertices->data(), _vertexCount, aabb, packed.data());
+            const VertexQuantization::Error error = VertexQuantization::measureError(layout.m_layout, layout.m_vertices->data(), _vertexCount, packed.data(), aabb);
+
+            const bool isLayoutValid = error.m_position <= layout.m_maxPosition && error.m_normal <= layout.m_maxNormal && error.m_tangent <= layout.m_maxTangent
+                                       && error.m_flippedSigns == 0;
+            isValid &= isLayoutValid;
+            std::cout << layout.m_name << ", " << Mesh::getVertexSize(layout.m_layout) << " bytes: position " << error.m_position << " (at most "
+                      << layout.m_maxPosition << "), normal " << error.m_normal << " degrees (at most " << layout.m_maxNormal << "), tangent "
+                      << error.m_tangent << " degrees (at most " << layout.m_maxTangent << "), " << error.m_flippedSigns << " flipped bitangents"
+                      << (isLayoutValid ? "" : ", QUANTIZATION REGRESSED") << std::endl;
+        }
+
+        return isValid ? 0 : 1;
+    }
+
+    struct ReferenceTexture
+    {
+        eastl::string m_name;
+        eastl::vector<uint8_t> m_pixels; // RGBA8
+        uint32_t m_width;
+        uint32_t m_height;
+        eastl::vector<eastl::pair<TextureCompression::EFormat, float>> m_minPSNRs; // the formats it is compressed to and the PSNR they must reach
+    };
+
+    // 256x256 textures of every type with what the encoder reaches on them today, minus 1dB: a drop of more than that is a regression.
+    // Generated so they are the same on every machine.
+    eastl::vector<ReferenceTexture> generateReferenceTextures()
+    {
+        constexpr uint32_t SIZE = 256;
+        enum EReference { Gradient, Pattern, NormalMap, Roughness, Count };
+        const char* names[Count] = {"gradient", "pattern", "normal map", "roughness"};
+
+        eastl::vector<ReferenceTexture> references(Count);
+        std::mt19937 random(42);
+        std::uniform_int_distribution<int> noise(-6, 6);
+        const auto addNoise = [&](float _value) { return static_cast<uint8_t>(std::clamp(static_cast<int>(_value) + noise(random), 0, 255)); };
+        for(uint32_t reference = 0; reference < Count; ++reference)
+        {
+            references[reference].m_name = names[reference];
+            references[reference].m_width = SIZE;
+            references[reference].m_height = SIZE;
+            eastl::vector<uint8_t>& pixels = references[reference].m_pixels;
+            pixels.resize(SIZE * SIZE * 4);
+            for(uint32_t y = 0; y < SIZE; ++y)
+            {
+                for(uint32_t x = 0; x < SIZE; ++x)
+                {
+                    uint8_t* pixel = &pixels[(y * SIZE + x) * 4];
+                    const float u = static_cast<float>(x) / (SIZE - 1);
+                    const float v = static_cast<float>(y) / (SIZE - 1);
+                    switch(reference)
+                    {
+                        case Gradient: // smooth colors and alpha, the worst case of the banding
+                            pixel[0] = static_cast<uint8_t>(255.0f * u + 0.5f);
+                            pixel[1] = static_cast<uint8_t>(255.0f * v + 0.5f);
+                            pixel[2] = static_cast<uint8_t>(255.0f * (1.0f - u) * v + 0.5f);
+                            pixel[3] = static_cast<uint8_t>(255.0f * (1.0f - v) + 0.5f);
+                            break;
+                        case Pattern: // opaque, detailed and noisy like a photo
+                            pixel[0] = addNoise(128.0f + 90.0f * std::sin(u * 19.0f) * std::cos(v * 7.0f));
+                            pixel[1] = addNoise(120.0f + 80.0f * std::sin((u + v) * 11.0f));
+                            pixel[2] = addNoise(100.0f + 60.0f * std::cos(v * 23.0f));
+                            pixel[3] = 255;
+                            break;
+                        case NormalMap: // bumps, every direction of the upper hemisphere
+                        {
+                            const float3 normal = normalize(float3(std::cos(u * 2.0f * PI_F * 8.0f) * 0.5f, std::cos(v * 2.0f * PI_F * 8.0f) * 0.5f, 1.0f));
+                            pixel[0] = static_cast<uint8_t>((normal.x * 0.5f + 0.5f) * 255.0f + 0.5f);
+                            pixel[1] = static_cast<uint8_t>((normal.y * 0.5f + 0.5f) * 255.0f + 0.5f);
+                            pixel[2] = static_cast<uint8_t>((normal.z * 0.5f + 0.5f) * 255.0f + 0.5f);
+                            pixel[3] = 255;
+                            break;
+                        }
+                        case Roughness:
+                            pixel[0] = pixel[1] = pixel[2] = addNoise(64.0f + 160.0f * u * v + 20.0f * std::sin(static_cast<float>(x) * 0.3f));
+                            pixel[3] = 255;
+                            break;
+                    }
+                }
+            }
+        }
+
+        // the formats the cook picks for their type, BC7 being the option of the albedo
+        references[Gradient].m_minPSNRs = {{TextureCompression::EFormat::BC3, 44.0f}, {TextureCompression::EFormat::BC7, 49.0f}};
+        references[Pattern].m_minPSNRs = {{TextureCompression::EFormat::BC1, 35.0f}, {TextureCompression::EFormat::BC7, 37.5f}};
+        references[NormalMap].m_minPSNRs = {{TextureCompression::EFormat::BC5, 47.0f}};
+        references[Roughness].m_minPSNRs = {{TextureCompression::EFormat::BC4, 48.0f}};
+        return references;
+    }
+
+    // Compresses the reference textures and the images of _paths (as albedos, to the formats the cook would pick), fails when one of them
+    // is under its PSNR. The images only have to reach TextureCompression::MIN_PSNR, where the cook warns.
+    int testTextures(const eastl::vector<const char*>& _paths)
+    {
+        eastl::vector<ReferenceTexture> references = generateReferenceTextures();
+        for(const char* path : _paths)
+        {
+            int width, height, channels;
+            uint8_t* pixels = stbi_load(path, &width, &height, &channels, 4);
+            if(!pixels || !TextureCompression::canCompress(width, height))
+            {
+                std::cout << path << " can't be loaded or isn't a multiple of the block size" << std::endl;
+                stbi_image_free(pixels);
+                return 1;
+            }
+
+            ReferenceTexture& reference = references.push_back();
+            reference.m_name = path;
+            reference.m_width = width;
+            reference.m_height = height;
+            reference.m_pixels.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+            const bool isOpaque = TextureCompression::isOpaque(pixels, static_cast<size_t>(width) * height);
+            reference.m_minPSNRs = {{isOpaque ? TextureCompression::EFormat::BC1 : TextureCompression::EFormat::BC3, TextureCompression::MIN_PSNR},
+                                    {TextureCompression::EFormat::BC7, TextureCompression::MIN_PSNR}};
+            stbi_image_free(pixels);
+        }
+
+        bool isValid = true;
+        for(const ReferenceTexture& reference : references)
+        {
+            for(const auto& formatPSNR : reference.m_minPSNRs)
+            {
+                const TextureCompression::EFormat format = formatPSNR.first;
+                const float minPSNR = formatPSNR.second;
+                eastl::vector<uint8_t> blocks(TextureCompression::getCompressedSize(format, reference.m_width, reference.m_height));
+                const auto start = std::chrono::steady_clock::now();
+                TextureCompression::compress(format, reference.m_pixels.data(), reference.m_width, reference.m_height, blocks.data());
+                const float timeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+                const float psnr = TextureCompression::computePSNR(format, reference.m_pixels.data(), blocks.data(), reference.m_width, reference.m_height);
+                isValid &= psnr >= minPSNR;
+                std::cout << reference.m_name.c_str() << " " << TextureCompression::getName(format) << ": " << psnr << "dB (at least " << minPSNR << "dB) in "
+                          << timeMs << "ms" << (psnr >= minPSNR ? "" : ", QUALITY REGRESSED") << std::endl;
+            }
+        }
+
+        return isValid ? 0 : 1;
+    }
+
+    // Round trip of GeometryCodec on a smooth grid, the kind of vertices the cook encodes, and on random bytes, the worst case of the codec.
+    // Every vertex layout stride, the 16 and 32 bits indices, and the edge cases of one vertex and of more than 16 bits of them.
+    // A truncated buffer must not decode. Fails on the first difference.
+    int testCodec()
+    {
+        constexpr size_t strides[] = {sizeof(VertexOctahedral), sizeof(VertexHalf)};
+        constexpr size_t vertexCounts[] = {1, 3, 1000, 70000};
+        std::mt19937 random(42);
+
+        bool isValid = true;
+        for(const size_t stride : strides)
+        {
+            for(const size_t vertexCount : vertexCounts)
+            {
+                for(const bool isRandom : {false, true})
+                {
+                    // a grid of vertexCount vertices, the columns of one row slowly changing like the positions and normals of a mesh
+                    const size_t width = std::max<size_t>(static_cast<size_t>(std::sqrt(static_cast<double>(vertexCount))), 1);
+                    eastl::vector<uint8_t> vertices(vertexCount * stride);
+                    for(size_t vertex = 0; vertex < vertexCount; ++vertex)
+                    {
+                        uint16_t* halves = reinterpret_cast<uint16_t*>(&vertices[vertex * stride]);
+                        for(size_t i = 0; i < stride / sizeof(uint16_t); ++i)
+                        {
+                            halves[i] = isRandom ? static_cast<uint16_t>(random()) : static_cast<uint16_t>((vertex % width) * 7 + (vertex / width) * 13 + i * 1000);
+                        }
+                    }
+
+                    // the triangles of the grid, or a soup of random ones
+                    eastl::vector<uint32_t> indices;
+                    if(isRandom || width == 1 || vertexCount < width + 2)
+                    {
+                        std::uniform_int_distribution<uint32_t> index(0, static_cast<uint32_t>(vertexCount - 1));
+                        indices.resize(vertexCount < 3 ? 3 : vertexCount / 3 * 3);
+                        for(uint32_t& i : indices)
+                        {
+                            i = index(random);
+                        }
+                    }
+                    else
+                    {
+                        for(size_t y = 0; y + 1 < vertexCount / width; ++y)
+                        {
+                            for(size_t x = 0; x + 1 < width; ++x)
+                            {
+                                const uint32_t corner = static_cast<uint32_t>(y * width + x);
+                                const uint32_t quad[] = {corner, corner + 1, corner + static_cast<uint32_t>(width),
+                                                         corner + 1, corner + static_cast<uint32_t>(width) + 1, corner + static_cast<uint32_t>(width)};
+                                indices.insert(indices.end(), quad, quad + 6);
+                            }
+                        }
+                    }
+
+                    const GeometryCodec::Encoded encoded = GeometryCodec::encode(vertices.data(), vertexCount, stride, indices.data(), indices.size());
+
+                    eastl::vector<uint8_t> decodedVertices(vertices.size());
+                    eastl::vector<uint32_t> decoded32(indices.size());
+                    bool isCase = GeometryCodec::decode(encoded.m_vertices.data(), encoded.m_vertices.size(), vertexCount, stride, encoded.m_indices.data(),
+                                                        encoded.m_indices.size(), indices.size(), decodedVertices.data(), decoded32.data(), sizeof(uint32_t))
+                                  && memcmp(decodedVertices.data(), vertices.data(), vertices.size()) == 0
+                                  && memcmp(decoded32.data(), indices.data(), indices.size() * sizeof(uint32_t)) == 0;
+
+                    // the meshes of up to 65536 vertices have 16 bits indices
+                    if(vertexCount <= 65536)
+                    {
+                        eastl::vector<uint16_t> decoded16(indices.size());
+                        eastl::vector<uint16_t> indices16(indices.begin(), indices.end());
+                        isCase &= GeometryCodec::decode(encoded.m_vertices.data(), encoded.m_vertices.size(), vertexCount, stride, encoded.m_indices.data(),
+                                                        encoded.m_indices.size(), indices.size(), decodedVertices.data(), decoded16.data(), sizeof(uint16_t))
+                                  && memcmp(decoded16.data(), indices16.data(), indices16.size() * sizeof(uint16_t)) == 0;
+                    }
+
+                    // a cooked file cut short must be rejected, not read past its end
+                    isCase &= !GeometryCodec::decode(encoded.m_vertices.data(), encoded.m_vertices.size() / 2, vertexCount, stride, encoded.m_indices.data(),
+                                                     encoded.m_indices.size(), indices.size(), decodedVertices.data(), decoded32.data(), sizeof(uint32_t));
+                    isCase &= !GeometryCodec::decode(encoded.m_vertices.data(), encoded.m_vertices.size(), vertexCount, stride, encoded.m_indices.data(),
+                                                     encoded.m_indices.size() / 2, indices.size(), decodedVertices.data(), decoded32.data(), sizeof(uint32_t));
+
+                    isValid &= isCase;
+                    std::cout << (isRandom ? "random" : "grid") << ", " << vertexCount << " vertices of " << stride << " bytes, " << indices.size() << " indices: "
+                              << vertices.size() + indices.size() * sizeof(uint32_t) << " -> " << encoded.m_vertices.size() + encoded.m_indices.size() << " bytes"
+                              << (isCase ? "" : ", ROUND TRIP FAILED") << std::endl;
+                }
+            }
+        }
+
+        return isValid ? 0 : 1;
+    }
+
+    eastl::vector<std::filesystem::path> findCookedFiles(const std::filesystem::path& _root)
+    {
+        eastl::vector<std::filesystem::path> files;
+        for(const auto& file : std::filesystem::recursive_directory_iterator(_root))
+        {
+            if(file.is_regular_file() && file.path().extension() == ".mesh")
+            {
+                files.push_back(file.path());
+            }
+        }
+
+        // sorted so the archive is the same from one run to the other
+        eastl::sort(files.begin(), files.end());
+        return files;
+    }
+
+    bool writeSceneArchive(const std::filesystem::path& _root)
+    {
+        eastl::vector<SceneArchive::File> files;
+        for(const std::filesystem::path& path : findCookedFiles(_root))
+        {
+            files.push_back({toManifestPath(_root, path), path.generic_string().c_str()});
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        const std::filesystem::path archivePath = _root / SceneArchive::FILE_NAME;
+        const size_t size = SceneArchive::write(archivePath.string().c_str(), files);
+        if(size == 0)
+        {
+            std::cout << "Could not write " << archivePath << std::endl;
+            return false;
+        }
+
+        std::cout << "Packed " << files.size() << " meshes in " << archivePath << ": " << (size >> 20) << "MB in "
+                  << std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count() << "ms" << std::endl;
+        return true;
+    }
+
+    // Drops the file from the page cache so the next read comes from the disk, false when the OS doesn't let us
+    bool evictFromCache(const std::filesystem::path& _path)
+    {
+#if defined(_WIN32)
+        return false;
+#else
+        const int fd = open(_path.c_str(), O_RDONLY);
+        if(fd < 0)
+            return false;
+
+        const bool isEvicted = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+        close(fd);
+        return isEvicted;
+#endif
+    }
+
+    // Startup cost of the I/O only: every byte of the scene is read and hashed, the way the meshes read it before decoding
+    int benchmarkSceneArchive(const std::filesystem::path& _root)
+    {
+        constexpr uint32_t RUN_COUNT = 5;
+        const eastl::vector<std::filesystem::path> cookedFiles = findCookedFiles(_root);
+        const std::filesystem::path archivePath = _root / SceneArchive::FILE_NAME;
+        if(cookedFiles.empty() || !std::filesystem::exists(archivePath))
+        {
+            std::cout << "Cook " << _root << " with --pak first" << std::endl;
+            return 1;
+        }
+
+        bool isCold = true;
+        float looseMs = 0.0f;
+        float packedMs = 0.0f;
+        size_t looseBytes = 0;
+        size_t packedBytes = 0;
+        for(uint32_t run = 0; run < RUN_COUNT; ++run)
+        {
+            for(const std::filesystem::path& path : cookedFiles)
+            {
+                isCold &= evictFromCache(path);
+            }
+            isCold &= evictFromCache(archivePath);
+
+            auto start = std::chrono::steady_clock::now();
+            looseBytes = 0;
+            for(const std::filesystem::path& path : cookedFiles)
+            {
+                MappedFile file(path.string().c_str());
+                if(!file.isOpen())
+                    return 1;
+
+                MeowHash(MeowDefaultSeed, file.size(), const_cast<uint8_t*>(file.data()));
+                looseBytes += file.size();
+            }
+            looseMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            start = std::chrono::steady_clock::now();
+            SceneArchive::Reader archive;
+            if(!archive.open(archivePath.generic_string().c_str()))
+                return 1;
+
+            // find checks the hash of the entry, the same work as above
+            packedBytes = 0;
+            for(const std::filesystem::path& path : cookedFiles)
+            {
+                SceneArchive::View view;
+                if(!archive.find((_root / toManifestPath(_root, path).c_str()).generic_string().c_str(), view))
+                {
+                    std::cout << path << " is missing from " << archivePath << ", cook with --pak again" << std::endl;
+                    return 1;
+                }
+                packedBytes += view.m_size;
+            }
+            packedMs += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        if(!isCold)
+        {
+            std::cout << "The page cache could not be emptied, the timings are warm ones" << std::endl;
+        }
+
+        looseMs /= RUN_COUNT;
+        packedMs /= RUN_COUNT;
+        std::cout << cookedFiles.size() << " .mesh files: " << looseMs << "ms, " << static_cast<double>(looseBytes) / 1048576.0 / (looseMs * 1e-3) << "MB/s" << std::endl;
+        std::cout << SceneArchive::FILE_NAME << ": " << packedMs << "ms, " << static_cast<double>(packedBytes) / 1048576.0 / (packedMs * 1e-3) << "MB/s" << std::endl;
+        return 0;
+    }
+
+    constexpr const char* LOAD_RESULT_TAG = "load result ";
+
+    const char* getName(Mesh::ELoadMode _mode)
+    {
+        return _mode == Mesh::ELoadMode::Mapped ? "mapped" : "read";
+    }
+
+    // One run of --benchmark-load, in a process of its own so the peak RSS is the one of this run only.
+    // Every cooked asset of _root is loaded the way the app does, with the upload deferred as there is no device here.
+    // Each mesh is freed before the next one loads, the peak is the one of the biggest load.
+    int runLoadBenchmark(const std::filesystem::path& _root, Mesh::ELoadMode _mode)
+    {
+        eastl::vector<std::filesystem::path> sources;
+        bool isCold = true;
+        size_t fileBytes = 0;
+        for(const std::filesystem::path& source : findSources(_root))
+        {
+            std::filesystem::path cookedPath = source;
+            cookedPath.replace_extension(".mesh");
+            if(!std::filesystem::exists(cookedPath))
+                continue;
+
+            sources.push_back(source);
+            fileBytes += std::filesystem::file_size(cookedPath);
+            isCold &= evictFromCache(cookedPath);
+        }
+
+        Mesh::setLoadMode(_mode);
+        uint32_t importedCount = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for(const std::filesystem::path& source : sources)
+        {
+            std::filesystem::path cookedPath = source;
+            cookedPath.replace_extension(".mesh");
+            const auto cookedTime = std::filesystem::last_write_time(cookedPath);
+
+            Mesh mesh(RefCntAutoPtr<IRenderDevice>(), source.generic_string().c_str(), false, float3(0.0f), 1.0f, float3(0.0f), true);
+            // an outdated .mesh is imported and saved again instead of loaded
+            importedCount += mesh.getGroups().empty() || std::filesystem::last_write_time(cookedPath) != cookedTime;
+        }
+        const float timeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << LOAD_RESULT_TAG << timeMs << " " << ProcessMemory::getPeakResident() << " " << fileBytes << " " << sources.size() << " "
+                  << importedCount << " " << isCold << std::endl;
+        return 0;
+    }
+
+    struct LoadResult
+    {
+        float m_timeMs = 0.0f;
+        size_t m_peakResident = 0;
+        size_t m_fileBytes = 0;
+        uint32_t m_meshCount = 0;
+        uint32_t m_importedCount = 0;
+        bool m_isCold = false;
+    };
+
+    // Runs the AssetCooker again with _arguments and parses the result line of runLoadBenchmark, false if there is none
+    bool runCooker(const char* _executable, const eastl::string& _arguments, LoadResult& _result)
+    {
+        eastl::string command = eastl::string("\"") + _executable + "\" " + _arguments;
+#if defined(_WIN32)
+        // cmd /c strips the quotes around the whole command
+        command = "\"" + command + "\"";
+        FILE* pipe = _popen(command.c_str(), "r");
+#else
+        FILE* pipe = popen(command.c_str(), "r");
+#endif
+        if(!pipe)
+            return false;
+
+        bool isFound = false;
+        char line[1024];
+        while(fgets(line, sizeof(line), pipe))
+        {
+            if(strncmp(line, LOAD_RESULT_TAG, strlen(LOAD_RESULT_TAG)) != 0)
+                continue;
+
+            unsigned long long peakResident = 0;
+            unsigned long long fileBytes = 0;
+            int isCold = 0;
+            isFound = sscanf(line + strlen(LOAD_RESULT_TAG), "%f %llu %llu %u %u %d", &_result.m_timeMs, &peakResident, &fileBytes, &_result.m_meshCount,
+                             &_result.m_importedCount, &isCold) == 6;
+            _result.m_peakResident = static_cast<size_t>(peakResident);
+            _result.m_fileBytes = static_cast<size_t>(fileBytes);
+            _result.m_isCold = isCold != 0;
+        }
+
+#if defined(_WIN32)
+        _pclose(pipe);
+#else
+        pclose(pipe);
+#endif
+        return isFound;
+    }
+
+    // Load time and peak RSS of the cooked assets of _root read in memory against mapped, each run in its own process on a cold cache.
+    // The directory is also copied and cooked again as raw flatbuffers (--raw), to compare the formats as well.
+    int benchmarkLoad(const char* _executable, const std::filesystem::path& _root)
+    {
+        constexpr uint32_t RUN_COUNT = 3;
+        constexpr Mesh::ELoadMode MODES[] = {Mesh::ELoadMode::Read, Mesh::ELoadMode::Mapped};
+
+        const std::filesystem::path rawRoot = std::filesystem::temp_directory_path() / "AssetCookerBenchmarkRaw";
+        std::filesystem::remove_all(rawRoot);
+        std::filesystem::copy(_root, rawRoot, std::filesystem::copy_options::recursive);
+        std::cout << "Cooking " << rawRoot << " as raw flatbuffers" << std::endl;
+        const int cookResult = std::system((eastl::string("\"") + _executable + "\" \"" + rawRoot.string().c_str() + "\" --force --raw").c_str());
+
+        // the raw flatbuffers read in memory first is how the meshes were loaded before the container and the mapping
+        struct Format
+        {
+            const char* m_name;
+            std::filesystem::path m_root;
+        };
+        const Format formats[] = {{"raw", rawRoot}, {"zstd", _root}};
+
+        LoadResult results[std::size(formats)][std::size(MODES)];
+        bool isCold = true;
+        bool isValid = cookResult == 0;
+        for(size_t format = 0; format < std::size(formats) && isValid; ++format)
+        {
+            for(size_t mode = 0; mode < std::size(MODES) && isValid; ++mode)
+            {
+                // the fastest run and the highest peak, the others are noise from the rest of the system
+                LoadResult& best = results[format][mode];
+                best.m_timeMs = std::numeric_limits<float>::max();
+                for(uint32_t run = 0; run < RUN_COUNT && isValid; ++run)
+                {
+                    LoadResult result;
+                    const eastl::string arguments = eastl::string("--benchmark-load-run ") + getName(MODES[mode]) + " \"" + formats[format].m_root.string().c_str() + "\"";
+                    if(!runCooker(_executable, arguments, result))
+                    {
+                        std::cout << "The " << getName(MODES[mode]) << " run of " << formats[format].m_root << " failed" << std::endl;
+                        isValid = false;
+                    }
+                    else if(result.m_meshCount == 0 || result.m_importedCount > 0)
+                    {
+                        std::cout << result.m_importedCount << " of " << result.m_meshCount << " assets of " << formats[format].m_root
+                                  << " were imported instead of loaded, cook the directory first" << std::endl;
+                        isValid = false;
+                    }
+
+                    best.m_timeMs = std::min(best.m_timeMs, result.m_timeMs);
+                    best.m_peakResident = std::max(best.m_peakResident, result.m_peakResident);
+                    best.m_fileBytes = result.m_fileBytes;
+                    best.m_meshCount = result.m_meshCount;
+                    isCold &= result.m_isCold;
+                }
+            }
+        }
+
+        std::filesystem::remove_all(rawRoot);
+        if(!isValid)
+            return 1;
+
+        if(!isCold)
+        {
+            std::cout << "The page cache could not be emptied, the timings are warm ones" << std::endl;
+        }
+
+        const LoadResult& reference = results[0][0];
+        std::cout << reference.m_meshCount << " assets" << std::endl;
+        for(size_t format = 0; format < std::size(formats); ++format)
+        {
+            std::cout << formats[format].m_name << ": " << ProcessMemory::toMB(results[format][0].m_fileBytes) << "MB of .mesh ("
+                      << static_cast<float>(results[format][0].m_fileBytes) / static_cast<float>(reference.m_fileBytes) << "x)" << std::endl;
+            for(size_t mode = 0; mode < std::size(MODES); ++mode)
+            {
+                const LoadResult& result = results[format][mode];
+                std::cout << "    " << getName(MODES[mode]) << ": " << result.m_timeMs << "ms (" << result.m_timeMs / reference.m_timeMs << "x), peak RSS "
+                          << ProcessMemory::toMB(result.m_peakResident) << "MB ("
+                          << static_cast<float>(result.m_peakResident) / static_cast<float>(reference.m_peakResident) << "x)" << std::endl;
+            }
+        }
+        return 0;
+    }
+
+    // A camera in the middle of boxes spread around it, some of them flat, empty or right on a plane so the edge cases are compared too
+    int benchmarkCulling(size_t _boxCount)
+    {
+        constexpr uint32_t RUN_COUNT = 20;
+        constexpr float SCENE_EXTENT = 1000.0f;
+
+        const float4x4 viewProj = float4x4::Projection(PI_F / 3.0f, 16.0f / 9.0f, 0.1f, SCENE_EXTENT * 0.5f, false);
+        ViewFrustum frustum;
+        ExtractViewFrustumPlanesFromMatrix(viewProj, frustum, false);
+
+        BenchmarkBoxes scene = makeBoxes(_boxCount, SCENE_EXTENT, 0.0f, 8.0f);
+        eastl::vector<BoundBox>& boxes = scene.m_boxes;
+        for(size_t i = 0; i < _boxCount; ++i)
+        {
+            // flat, no height at all
+            if(i % 7 == 0)
+            {
+                boxes[i].Max.y = boxes[i].Min.y;
+            }
+
+            // touching the near plane from behind, the distance to it is exactly 0 for one corner
+            if(i % 101 == 0)
+            {
+                boxes[i].Max.z = 0.1f;
+                boxes[i].Min.z = std::min(boxes[i].Min.z, 0.0f);
+            }
+
+            scene.m_flags[i] = i % 5 == 0 ? SceneStore::FLAG_TRANSPARENT : SceneStore::FLAG_OPAQUE;
+        }
+        const FrustumCulling::Boxes soa = scene.updateColumns();
+
+        eastl::vector<uint32_t> reference;
+        const float referenceMs = getBestMs(RUN_COUNT, [&]()
+        {
+            reference.clear();
+            for(uint32_t i = 0; i < _boxCount; ++i)
+            {
+                if((scene.m_flags[i] & SceneStore::FLAG_OPAQUE) != 0 && GetBoxVisibility(frustum, boxes[i]) != BoxVisibility::Invisible)
+                {
+                    reference.push_back(i);
+                }
+            }
+        });
+        std::cout << _boxCount << " boxes, " << reference.size() << " visible" << std::endl;
+        std::cout << "GetBoxVisibility: " << static_cast<double>(_boxCount) / referenceMs * 1e-3 << "M boxes/s (" << referenceMs << "ms)" << std::endl;
+
+        bool isValid = true;
+        for(auto kernel : {FrustumCulling::EKernel::Scalar, FrustumCulling::EKernel::SSE2, FrustumCulling::EKernel::AVX2})
+        {
+            if(!FrustumCulling::isSupported(kernel))
+            {
+                std::cout << FrustumCulling::getName(kernel) << ": not supported by this CPU" << std::endl;
+                continue;
+            }
+
+            eastl::vector<uint32_t> visible;
+            const float bestMs = getBestMs(RUN_COUNT, [&]() { FrustumCulling::cull(frustum, soa, SceneStore::FLAG_OPAQUE, visible, kernel); });
+
+            const bool isIdentical = visible == reference;
+            isValid &= isIdentical;
+            std::cout << FrustumCulling::getName(kernel) << ": " << static_cast<double>(_boxCount) / bestMs * 1e-3 << "M boxes/s (" << bestMs << "ms, "
+                      << referenceMs / bestMs << "x)" << (isIdentical ? "" : ", DIFFERS FROM GetBoxVisibility") << std::endl;
+        }
+
+        return isValid ? 0 : 1;
+    }
+
+    // Boxes spread in a cube, a camera on one side looking through it with a far plane cutting more and more of the scene.
+    // Every query is checked against testing every box, the frustum ones against the SIMD culling the views use otherwise.
+    int benchmarkBvh(size_t _boxCount)
+    {
+        constexpr uint32_t RUN_COUNT = 10;
+        constexpr float SCENE_EXTENT = 1000.0f;
+
+        std::mt19937 random(42);
+        std::uniform_real_distribution<float> direction(-1.0f, 1.0f);
+
+        BenchmarkBoxes scene = makeBoxes(_boxCount, SCENE_EXTENT, 0.5f, 8.0f);
+        eastl::vector<BoundBox>& boxes = scene.m_boxes;
+        const FrustumCulling::Boxes soa = scene.updateColumns();
+        eastl::vector<uint32_t> ids(_boxCount);
+        for(uint32_t i = 0; i < _boxCount; ++i)
+        {
+            ids[i] = i;
+        }
+
+        SceneBvh bvh;
+        const float buildMs = getBestMs(RUN_COUNT, [&]() { bvh.build(ids.data(), boxes.data(), static_cast<uint32_t>(_boxCount)); });
+        std::cout << _boxCount << " boxes: build " << buildMs << "ms, " << bvh.getNodeCount() << " nodes" << std::endl;
+
+        bool isValid = true;
+        const float3 cameraPosition(0.0f, 0.0f, -SCENE_EXTENT * 0.5f);
+        for(float farPlane : {SCENE_EXTENT * 2.0f, SCENE_EXTENT * 0.3f, SCENE_EXTENT * 0.1f})
+        {
+            const float4x4 viewProj = float4x4::Translation(-cameraPosition) * float4x4::Projection(PI_F / 3.0f, 16.0f / 9.0f, 0.1f, farPlane, false);
+            ViewFrustum frustum;
+            ExtractViewFrustumPlanesFromMatrix(viewProj, frustum, false);
+
+            eastl::vector<uint32_t> linear;
+            eastl::vector<uint32_t> hierarchy;
+            const float linearMs = getBestMs(RUN_COUNT, [&]() { FrustumCulling::cull(frustum, soa, SceneStore::FLAG_OPAQUE, linear); });
+            const float hierarchyMs = getBestMs(RUN_COUNT, [&]()
+            {
+                bvh.queryFrustum(frustum, hierarchy);
+                eastl::sort(hierarchy.begin(), hierarchy.end());
+            });
+
+            const bool isIdentical = linear == hierarchy;
+            isValid &= isIdentical;
+            std::cout << "  frustum to " << farPlane << ": " << linear.size() << " visible, " << FrustumCulling::getName(FrustumCulling::getBestKernel())
+                      << " " << linearMs << "ms, BVH " << hierarchyMs << "ms sorted" << (isIdentical ? "" : ", DIFFERS FROM THE LINEAR CULLING") << std::endl;
+        }
+
+        // from the middle of the scene, where the closest box is the hardest to find
+        constexpr uint32_t RAY_COUNT = 1000;
+        eastl::vector<float3> rays(RAY_COUNT);
+        for(float3& ray : rays)
+        {
+            ray = normalize(float3(direction(random), direction(random), direction(random)) + float3(0.0f, 0.0f, 1e-3f));
+        }
+        eastl::vector<SceneBvh::RayHit> hits(RAY_COUNT);
+        const float raysMs = getBestMs(RUN_COUNT, [&]()
+        {
+            for(uint32_t i = 0; i < RAY_COUNT; ++i)
+            {
+                bvh.raycast(float3(0.0f), rays[i], std::numeric_limits<float>::max(), hits[i]);
+            }
+        });
+
+        uint32_t rayMismatchCount = 0;
+        const auto linearRaysStart = std::chrono::steady_clock::now();
+        for(uint32_t i = 0; i < RAY_COUNT; ++i)
+        {
+            float closest = std::numeric_limits<float>::max();
+            for(const BoundBox& box : boxes)
+            {
+                float enterDistance = 0.0f;
+                float exitDistance = 0.0f;
+                if(IntersectRayAABB(float3(0.0f), rays[i], box, enterDistance, exitDistance))
+                {
+                    closest = std::min(closest, std::max(enterDistance, 0.0f));
+                }
+            }
+            rayMismatchCount += closest != hits[i].m_distance;
+        }
+        const float linearRaysMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - linearRaysStart).count();
+        isValid &= rayMismatchCount == 0;
+        std::cout << "  " << RAY_COUNT << " closest hits: BVH " << raysMs << "ms, every box " << linearRaysMs << "ms"
+                  << (rayMismatchCount == 0 ? "" : ", SOME DIFFER FROM TESTING EVERY BOX") << std::endl;
+
+        const BoundBox queryBox{float3(-SCENE_EXTENT * 0.05f), float3(SCENE_EXTENT * 0.05f)};
+        eastl::vector<uint32_t> overlaps;
+        const float boxMs = getBestMs(RUN_COUNT, [&]() { bvh.queryBox(queryBox, overlaps); });
+        size_t linearOverlapCount = 0;
+        for(const BoundBox& box : boxes)
+        {
+            linearOverlapCount += box.Min.x <= queryBox.Max.x && box.Max.x >= queryBox.Min.x && box.Min.y <= queryBox.Max.y && box.Max.y >= queryBox.Min.y
+                                  && box.Min.z <= queryBox.Max.z && box.Max.z >= queryBox.Min.z;
+        }
+        isValid &= overlaps.size() == linearOverlapCount;
+        const float sphereMs = getBestMs(RUN_COUNT, [&]() { bvh.querySphere(float3(0.0f), SCENE_EXTENT * 0.05f, overlaps); });
+        std::cout << "  overlaps: box " << boxMs << "ms (" << linearOverlapCount << "), sphere " << sphereMs << "ms (" << overlaps.size() << ")" << std::endl;
+
+        // a tenth of the scene moves a little, like animated objects
+        std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+        const float refitMs = getBestMs(RUN_COUNT, [&]()
+        {
+            for(uint32_t i = 0; i < _boxCount; i += 10)
+            {
+                const float3 move(offset(random), offset(random), offset(random));
+                boxes[i] = {boxes[i].Min + move, boxes[i].Max + move};
+                bvh.update(i, boxes[i]);
+            }
+        });
+        std::cout << "  refit of " << _boxCount / 10 << " moved boxes: " << refitMs << "ms" << std::endl;
+
+        return isValid ? 0 : 1;
+    }
+
+    // The frustum culling and LOD selection of a frame: every group allocated on its own and read through its world bounds and LODs,
+    // the way the engine did it, against the packed arrays of the SceneStore. Same scene and camera for both, the results have to match.
+    int benchmarkSceneStore(size_t _instanceCount)
+    {
+        constexpr uint32_t RUN_COUNT = 20;
+        constexpr float SCENE_EXTENT = 1000.0f;
+        constexpr float PROJECTION_SCALE = 540.0f;
+        constexpr float MAX_PIXEL_ERROR = 1.0f;
+
+        std::mt19937 random(42);
+        std::uniform_real_distribution<float> position(-SCENE_EXTENT * 0.5f, SCENE_EXTENT * 0.5f);
+        std::uniform_real_distribution<float> size(0.5f, 8.0f);
+        std::uniform_int_distribution<uint32_t> material(1, 64);
+
+        eastl::vector<eastl::unique_ptr<Mesh::Group>> groups(_instanceCount);
+        SceneStore store;
+        for(size_t i = 0; i < _instanceCount; ++i)
+        {
+            groups[i] = eastl::make_unique<Mesh::Group>();
+            Mesh::Group& group = *groups[i];
+            group.m_name.sprintf("group %zu", i);
+            group.m_aabb = {float3(-size(random), -size(random), -size(random)), float3(size(random), size(random), size(random))};
+            const float localRadius = length(group.m_aabb.Max - group.m_aabb.Min) * 0.5f;
+            for(uint32_t lod = 0; lod < 4; ++lod)
+            {
+                group.m_lods.push_back({0, 0, localRadius * 0.01f * static_cast<float>(lod * lod)});
+            }
+
+            const float4x4 world = float4x4::Translation(position(random), position(random), position(random));
+            group.m_aabbWorld = group.m_aabb.Transform(world);
+            const float4 center = float4((group.m_aabb.Min + group.m_aabb.Max) * 0.5f, 1.0f) * world;
+            group.m_sphereCenterWorld = float3(center.x, center.y, center.z);
+            group.m_sphereRadiusWorld = localRadius;
+
+            group.m_instance = store.create(nullptr, static_cast<uint32_t>(i), group.m_aabb, Mesh::getLodInfo(group), material(random), SceneStore::FLAG_OPAQUE);
+            store.setTransform(group.m_instance, world, 1.0f);
+        }
+
+        const float3 cameraPosition(0.0f, 0.0f, -SCENE_EXTENT * 0.5f);
+        const float4x4 viewProj = float4x4::Translation(-cameraPosition) * float4x4::Projection(PI_F / 3.0f, 16.0f / 9.0f, 0.1f, SCENE_EXTENT * 2.0f, false);
+        ViewFrustum frustum;
+        ExtractViewFrustumPlanesFromMatrix(viewProj, frustum, false);
+
+        eastl::vector<uint32_t> groupLods;
+        const float groupsMs = getBestMs(RUN_COUNT, [&]()
+        {
+            groupLods.clear();
+            for(const auto& group : groups)
+            {
+                if(GetBoxVisibility(frustum, group->m_aabbWorld) == BoxVisibility::Invisible)
+                    continue;
+
+                // Mesh::selectLod
+                const float localRadius = length(group->m_aabb.Max - group->m_aabb.Min) * 0.5f;
+                const float distance = length(group->m_sphereCenterWorld - cameraPosition) - group->m_sphereRadiusWorld;
+                uint32_t lod = 0;
+                if(group->m_lods.size() > 1 && distance > 0.0f && localRadius > 0.0f)
+                {
+                    const float projectedRadius = group->m_sphereRadiusWorld * PROJECTION_SCALE / distance;
+                    for(uint32_t l = static_cast<uint32_t>(group->m_lods.size()) - 1; l > 0; --l)
+                    {
+                        if(group->m_lods[l].m_error / localRadius * projectedRadius <= MAX_PIXEL_ERROR)
+                        {
+                            lod = l;
+                            break;
+                        }
+                    }
+                }
+                groupLods.push_back(lod);
+            }
+        });
+
+        eastl::vector<uint32_t> visible;
+        eastl::vector<uint8_t> lods;
+        eastl::vector<SceneStore::DrawItem> drawList;
+        const float storeMs = getBestMs(RUN_COUNT, [&]()
+        {
+            store.cull(frustum, SceneStore::FLAG_OPAQUE, visible);
+            store.selectLods(visible, cameraPosition, PROJECTION_SCALE, MAX_PIXEL_ERROR, lods);
+            store.buildDrawList(visible, lods, drawList);
+        });
+
+        // the instances were created in the order of the groups and never removed, their indices match
+        bool isIdentical = visible.size() == groupLods.size();
+        for(size_t i = 0; isIdentical && i < visible.size(); ++i)
+        {
+            isIdentical = lods[i] == groupLods[i];
+        }
+
+        std::cout << _instanceCount << " instances, " << visible.size() << " visible: groups " << groupsMs << "ms, scene store " << storeMs
+                  << "ms with the sorted draw list (" << groupsMs / storeMs << "x)" << (isIdentical ? "" : ", RESULTS DIFFER") << std::endl;
+        return isIdentical ? 0 : 1;
+    }
+
+    // Street level in a town of box buildings, the occluders, with small boxes scattered between them. Every kernel has to give the
+    // same depth, and a box found occluded can't be hit first by the ray through the center of any pixel it touches.
+    // _dumpPath gets the depth when given, see OcclusionCulling::dumpDepth.
+    int benchmarkOcclusion(const char* _dumpPath)
+    {
+        constexpr uint32_t RUN_COUNT = 20;
+        constexpr uint32_t BOX_COUNT = 20000;
+        constexpr float SCENE_EXTENT = 400.0f;
+        constexpr float CELL_SIZE = 40.0f;
+        constexpr float STREET_HALF_WIDTH = 6.0f;
+
+        std::mt19937 random(42);
+        std::uniform_real_distribution<float> height(8.0f, 60.0f);
+        std::uniform_real_distribution<float> positionX(-SCENE_EXTENT * 0.5f, SCENE_EXTENT * 0.5f);
+        std::uniform_real_distribution<float> positionZ(1.0f, SCENE_EXTENT);
+        std::uniform_real_distribution<float> positionY(0.0f, 2.0f);
+        std::uniform_real_distribution<float> size(0.2f, 1.5f);
+
+        // the camera stands in the street along z, the other ones cross it every CELL_SIZE
+        const float3 cameraPosition(0.0f, 1.7f, 0.0f);
+        eastl::vector<BoundBox> buildings;
+        for(float x = -SCENE_EXTENT * 0.5f; x < SCENE_EXTENT * 0.5f; x += CELL_SIZE)
+        {
+            for(float z = 0.0f; z < SCENE_EXTENT; z += CELL_SIZE)
+            {
+                buildings.push_back({float3(x + STREET_HALF_WIDTH, 0.0f, z + STREET_HALF_WIDTH),
+                                     float3(x + CELL_SIZE - STREET_HALF_WIDTH, height(random), z + CELL_SIZE - STREET_HALF_WIDTH)});
+            }
+        }
+        eastl::sort(buildings.begin(), buildings.end(), [&cameraPosition](const BoundBox& _a, const BoundBox& _b)
+        {
+            return length((_a.Min + _a.Max) * 0.5f - cameraPosition) < length((_b.Min + _b.Max) * 0.5f - cameraPosition);
+        });
+
+        eastl::vector<BoundBox> boxes(BOX_COUNT);
+        for(BoundBox& box : boxes)
+        {
+            const float3 center(positionX(random), positionY(random), positionZ(random));
+            const float3 extent(size(random), size(random), size(random));
+            box = {center - extent, center + extent};
+        }
+
+        // every building is the unit cube scaled in place, its faces clockwise seen from outside
+        eastl::vector<float3> cubeVertices(8);
+        for(uint32_t corner = 0; corner < 8; ++corner)
+        {
+            cubeVertices[corner] = float3(static_cast<float>(corner & 1), static_cast<float>((corner >> 1) & 1), static_cast<float>((corner >> 2) & 1));
+        }
+        const uint32_t faces[6][4] = {{0, 2, 6, 4}, {1, 5, 7, 3}, {0, 4, 5, 1}, {2, 3, 7, 6}, {0, 1, 3, 2}, {4, 6, 7, 5}};
+        eastl::vector<uint32_t> cubeIndices;
+        for(const auto& face : faces)
+        {
+            for(uint32_t triangle : {1, 2})
+            {
+                uint32_t a = face[0], b = face[triangle], c = face[triangle + 1];
+                const float3 center = (cubeVertices[face[0]] + cubeVertices[face[2]]) * 0.5f;
+                if(dot(cross(cubeVertices[b] - cubeVertices[a], cubeVertices[c] - cubeVertices[a]), center - float3(0.5f)) < 0.0f)
+                {
+                    std::swap(b, c);
+                }
+                cubeIndices.insert(cubeIndices.end(), {a, b, c});
+            }
+        }
+
+        eastl::vector<OcclusionCulling::Occluder> occluders;
+        for(const BoundBox& building : buildings)
+        {
+            const float3 extent = building.Max - building.Min;
+            occluders.push_back({cubeVertices.data(), cubeIndices.data(), static_cast<uint32_t>(cubeVertices.size()), static_cast<uint32_t>(cubeIndices.size()),
+                                 float4x4::Scale(extent.x, extent.y, extent.z) * float4x4::Translation(building.Min)});
+        }
+
+        const float4x4 projection = float4x4::Projection(PI_F / 3.0f, 16.0f / 9.0f, 0.1f, SCENE_EXTENT * 1.5f, false);
+        const float4x4 viewProj = float4x4::Translation(-cameraPosition) * projection;
+        ViewFrustum frustum;
+        ExtractViewFrustumPlanesFromMatrix(viewProj, frustum, false);
+        eastl::vector<uint32_t> visible;
+        for(uint32_t i = 0; i < BOX_COUNT; ++i)
+        {
+            if(GetBoxVisibility(frustum, boxes[i]) != BoxVisibility::Invisible)
+            {
+                visible.push_back(i);
+            }
+        }
+
+        OcclusionCulling occlusion;
+        eastl::vector<float> referenceDepth;
+        bool isValid = true;
+        for(auto kernel : {FrustumCulling::EKernel::Scalar, FrustumCulling::EKernel::SSE2, FrustumCulling::EKernel::AVX2})
+        {
+            if(!FrustumCulling::isSupported(kernel))
+            {
+                std::cout << FrustumCulling::getName(kernel) << ": not supported by this CPU" << std::endl;
+                continue;
+            }
+
+            const float renderMs = getBestMs(RUN_COUNT, [&]() { occlusion.render(viewProj, occluders, kernel); });
+
+            eastl::vector<float> depth;
+            occlusion.getDepth(depth);
+            if(referenceDepth.empty())
+            {
+                referenceDepth = depth;
+            }
+            const bool isIdentical = depth == referenceDepth;
+            isValid &= isIdentical;
+            std::cout << FrustumCulling::getName(kernel) << ": " << occluders.size() << " occluders, " << occlusion.getTriangleCount() << " triangles drawn in "
+                      << renderMs << "ms" << (isIdentical ? "" : ", DEPTH DIFFERS FROM THE SCALAR ONE") << std::endl;
+        }
+
+        eastl::vector<uint32_t> occluded;
+        const float testMs = getBestMs(RUN_COUNT, [&]()
+        {
+            occluded.clear();
+            for(uint32_t i : visible)
+            {
+                if(occlusion.isOccluded(boxes[i]))
+                {
+                    occluded.push_back(i);
+                }
+            }
+        });
+
+        // the ray through every pixel center the box touches has to hit a building before it
+        SceneBvh bvh;
+        eastl::vector<uint32_t> ids(buildings.size());
+        for(uint32_t i = 0; i < ids.size(); ++i)
+        {
+            ids[i] = i;
+        }
+        bvh.build(ids.data(), buildings.data(), static_cast<uint32_t>(buildings.size()));
+
+        uint32_t rayCount = 0;
+        uint32_t wrongCount = 0;
+        for(uint32_t i : occluded)
+        {
+            float minX = std::numeric_limits<float>::max(), maxX = -minX, minY = minX, maxY = -minX;
+            for(uint32_t corner = 0; corner < 8; ++corner)
+            {
+                const float3 position((corner & 1) ? boxes[i].Max.x : boxes[i].Min.x, (corner & 2) ? boxes[i].Max.y : boxes[i].Min.y,
+                                      (corner & 4) ? boxes[i].Max.z : boxes[i].Min.z);
+                const float4 clip = float4(position, 1.0f) * viewProj;
+                minX = std::min(minX, (clip.x / clip.w * 0.5f + 0.5f) * OcclusionCulling::WIDTH);
+                maxX = std::max(maxX, (clip.x / clip.w * 0.5f + 0.5f) * OcclusionCulling::WIDTH);
+                minY = std::min(minY, (0.5f - clip.y / clip.w * 0.5f) * OcclusionCulling::HEIGHT);
+                maxY = std::max(maxY, (0.5f - clip.y / clip.w * 0.5f) * OcclusionCulling::HEIGHT);
+            }
+
+            bool isWrong = false;
+            for(int32_t y = std::max(static_cast<int32_t>(minY), 0); y <= std::min(static_cast<int32_t>(maxY), static_cast<int32_t>(OcclusionCulling::HEIGHT) - 1); ++y)
+            {
+                for(int32_t x = std::max(static_cast<int32_t>(minX), 0); x <= std::min(static_cast<int32_t>(maxX), static_cast<int32_t>(OcclusionCulling::WIDTH) - 1); ++x)
+                {
+                    const float ndcX = (static_cast<float>(x) + 0.5f) / OcclusionCulling::WIDTH * 2.0f - 1.0f;
+                    const float ndcY = 1.0f - (static_cast<float>(y) + 0.5f) / OcclusionCulling::HEIGHT * 2.0f;
+                    const float3 direction(ndcX / projection[0][0], ndcY / projection[1][1], 1.0f);
+
+                    float enter = 0.0f;
+                    float exit = 0.0f;
+                    SceneBvh::RayHit hit;
+                    rayCount++;
+                    if(IntersectRayAABB(cameraPosition, direction, boxes[i], enter, exit)
+                       && (!bvh.raycast(cameraPosition, direction, std::numeric_limits<float>::max(), hit) || hit.m_distance >= enter))
+                    {
+                        isWrong = true;
+                    }
+                }
+            }
+            wrongCount += isWrong;
+        }
+        isValid &= wrongCount == 0;
+
+        std::cout << BOX_COUNT << " boxes, " << visible.size() << " in the frustum, " << occluded.size() << " occluded, tested in " << testMs << "ms. "
+                  << rayCount << " rays checked, " << wrongCount << " boxes occluded by mistake" << std::endl;
+
+        if(_dumpPath && !occlusion.dumpDepth(_dumpPath))
+            return 1;
+        return isValid ? 0 : 1;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+    {
+        std::cout << "Usage: AssetCooker <directory> [--force] [--pak] [--raw] [--octahedral]" << std::endl;
+        std::cout << "       AssetCooker --test-textures [image...]" << std::endl;
+        std::cout << "       AssetCooker --test-codec" << std::endl;
+        std::cout << "       AssetCooker --test-quantization [vertex count]" << std::endl;
+        std::cout << "       AssetCooker --benchmark-quantization [vertex count]" << std::endl;
+        std::cout << "       AssetCooker --benchmark-load <directory>" << std::endl;
+        std::cout << "       AssetCooker --benchmark-pak <directory>" << std::endl;
+        std::cout << "       AssetCooker --benchmark-culling [box count]" << std::endl;
+        std::cout << "       AssetCooker --benchmark-bvh [box count]" << std::endl;
+        std::cout << "       AssetCooker --benchmark-scene [instance count]" << std::endl;
+        std::cout << "       AssetCooker --benchmark-occlusion [depth.pgm]" << std::endl;
+        return 1;
+    }
+
+    if(strcmp(argv[1], "--test-textures") == 0)
+    {
+        return testTextures(eastl::vector<const char*>(argv + 2, argv + argc));
+    }
+
+    if(strcmp(argv[1], "--test-codec") == 0)
+    {
+        return testCodec();
+    }
+
+    if(strcmp(argv[1], "--test-quantization") == 0)
+    {
+        return testQuantization(argc > 2 ? std::stoull(argv[2]) : 100000);
+    }
+
+    if(strcmp(argv[1], "--benchmark-quantization") == 0)
+    {
+        return benchmarkQuantization(argc > 2 ? std::stoull(argv[2]) : 1000000);
+    }
+
+    if(strcmp(argv[1], "--benchmark-load") == 0)
+    {
+        return argc > 2 ? benchmarkLoad(argv[0], argv[2]) : 1;
+    }
+
+    if(strcmp(argv[1], "--benchmark-load-run") == 0)
+    {
+        return argc > 3 ? runLoadBenchmark(argv[3], strcmp(argv[2], "mapped") == 0 ? Mesh::ELoadMode::Mapped : Mesh::ELoadMode::Read) : 1;
+    }
+
+    if(strcmp(argv[1], "--benchmark-pak") == 0)
+    {
+        return argc > 2 ? benchmarkSceneArchive(argv[2]) : 1;
+    }
+
+    if(strcmp(argv[1], "--benchmark-culling") == 0)
+    {
+        return benchmarkCulling(argc > 2 ? std::stoull(argv[2]) : 100000);
+    }
+
+    if(strcmp(argv[1], "--benchmark-bvh") == 0)
+    {
+        if(argc > 2)
+            return benchmarkBvh(std::stoull(argv[2]));
+
+        int result = 0;
+        for(size_t boxCount : {1000, 10000, 100000, 1000000})
+        {
+            result |= benchmarkBvh(boxCount);
+        }
+        return result;
+    }
+
+    if(strcmp(argv[1], "--benchmark-scene") == 0)
+    {
+        if(argc > 2)
+            return benchmarkSceneStore(std::stoull(argv[2]));
+
+        int result = 0;
+        for(size_t instanceCount : {10000, 30000, 100000})
+        {
+            result |= benchmarkSceneStore(instanceCount);
+        }
+        return result;
+    }
+
+    if(strcmp(argv[1], "--benchmark-occlusion") == 0)
+    {
+        return benchmarkOcclusion(argc > 2 ? argv[2] : nullptr);
+    }
+
+    const std::filesystem::path root = argv[1];
+    bool isForced = false;
+    bool isPacking = false;
+    Mesh::CookSettings settings = Mesh::getCookSettings();
+    for(int i = 2; i < argc; ++i)
+    {
+        isForced |= strcmp(argv[i], "--force") == 0;
+        isPacking |= strcmp(argv[i], "--pak") == 0;
+        settings.m_isCompressed &= strcmp(argv[i], "--raw") != 0;
+        if(strcmp(argv[i], "--octahedral") == 0)
+        {
+            settings.m_vertexLayout = EVertexLayout::Octahedral;
+        }
+    }
+    if(!Mesh::isVertexLayoutDrawable(settings.m_vertexLayout))
+    {
+        std::cout << "The octahedral layout can't be cooked yet, the zprepass, csm and transparency shaders don't read it (see common/vertex.hlsl)" << std::endl;
+        return 1;
+    }
+    Mesh::setCookSettings(settings);
+    if(!std::filesystem::is_directory(root))
+    {
+        std::cout << root << " is not a directory" << std::endl;
+        return 1;
+    }
+
+    const eastl::vector<std::filesystem::path> sources = findSources(root);
+
+    const std::filesystem::path manifestPath = root / MANIFEST_NAME;
+    const Manifest previousManifest = isForced ? Manifest() : loadManifest(manifestPath);
+
+    auto& jobSystem = JobSystem::get();
+    std::cout << "Cooking " << sources.size() << " assets of " << root << " on " << jobSystem.getWorkerCount() << " worker threads" << std::endl;
+
+    eastl::vector<Result> results(sources.size());
+    std::mutex mutexOutput;
+    JobSystem::Counter counter;
+    const auto start = std::chrono::steady_clock::now();
+
+    for(size_t i = 0; i < sources.size(); ++i)
+    {
+        jobSystem.submit(JobSystem::ESubsystem::Mesh, JobSystem::EPriority::Normal, [&, i]()
+        {
+            Result& result = results[i];
+            result.m_path = toManifestPath(root, sources[i]);
+            const auto assetStart = std::chrono::steady_clock::now();
+
+            std::filesystem::path cookedPath = sources[i];
+            cookedPath.replace_extension(".mesh");
+
+            auto previous = previousManifest.find(result.m_path);
+            if(previous != previousManifest.end() && std::filesystem::exists(cookedPath)
+               && hashInputs(root, previous->second.m_dependencies) == previous->second.m_hash)
+            {
+                result.m_status = EStatus::UpToDate;
+                result.m_entry = previous->second;
+            }
+            else
+            {
+                eastl::vector<eastl::string> dependencies;
+                if(Mesh::cook(sources[i].generic_string().c_str(), dependencies))
+                {
+                    for(const eastl::string& dependency : dependencies)
+                    {
+                        result.m_entry.m_dependencies.push_back(toManifestPath(root, dependency.c_str()));
+                    }
+                    result.m_entry.m_hash = hashInputs(root, result.m_entry.m_dependencies);
+                    result.m_status = EStatus::Cooked;
+                }
+            }
+
+            result.m_timeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - assetStart).count();
+
+            std::scoped_lock lock(mutexOutput);
+            const char* status = result.m_status == EStatus::Cooked ? "cooked" : result.m_status == EStatus::UpToDate ? "up to date" : "FAILED";
+            std::cout << "[" << status << "] " << result.m_path.c_str() << " in " << result.m_timeMs << "ms" << std::endl;
+        }, &counter);
+    }
+
+    jobSystem.wait(counter);
+    const float totalMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    Manifest manifest;
+    uint32_t counts[3] = {};
+    float cookTimeMs = 0.0f;
+    for(const Result& result : results)
+    {
+        counts[static_cast<size_t>(result.m_status)]++;
+        if(result.m_status != EStatus::Failed)
+        {
+            manifest[result.m_path] = result.m_entry;
+        }
+        if(result.m_status == EStatus::Cooked)
+        {
+            cookTimeMs += result.m_timeMs;
+        }
+    }
+    saveManifest(manifestPath, manifest);
+    ImportTelemetry::dumpJson((root / "import_telemetry.json").string().c_str());
+
+    // the sum of the cook times over the wall time is how well the import pipeline scales on this machine
+    std::cout << "Cooked " << counts[static_cast<size_t>(EStatus::Cooked)] << ", up to date " << counts[static_cast<size_t>(EStatus::UpToDate)]
+              << ", failed " << counts[static_cast<size_t>(EStatus::Failed)] << " in " << totalMs << "ms (" << cookTimeMs << "ms of cooking)" << std::endl;
+
+    // packed even when nothing changed, a previous run may have cooked without --pak
+    if(isPacking && !writeSceneArchive(root))
+        return 1;
+
+    return counts[static_cast<size_t>(EStatus::Failed)] == 0 ? 0 : 1;
+}